@@ -0,0 +1,383 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  async_logger.hpp — asynchronous low-latency logger on top of fast_queue_spsc
+// =====================================================================================
+//
+// std::println on a trading thread formats the message, takes the stdio lock and (line
+// buffered or not) eventually makes a write(2) syscall - hundreds of nanoseconds on a good
+// day, tens of microseconds when the page cache or the terminal pushes back. This logger moves
+// ALL of that off the hot thread:
+//
+//  - the hot thread writes a record of [site pointer][timestamp][raw argument bytes] straight
+//    into its OWN fast_queue_spsc ring through the zero-copy reserve/commit path. No
+//    formatting, no locks, no syscalls, no allocation. The record size is a compile-time
+//    constant per call site.
+//  - a background thread sweeps every ring, formats the records into one buffer and writes it
+//    with a single write(2) per batch.
+//
+// -------------------------------------------------------------------------------------
+//  Call sites
+// -------------------------------------------------------------------------------------
+//      async_logger::logger<> log{"/tmp/app.log"};
+//      auto w = log.make_writer();                      // once, on the hot thread
+//      w.log<"order {} px {} qty {}">(id, px, qty);     // hot path
+//
+//  The format string is a template argument, so it is checked against the argument types at
+//  compile time (std::format_string) and each (format, types) pair gets one static `log_site`
+//  whose ADDRESS is the format-string id written into the record - no registry, no lookup.
+//  The site also carries the function that decodes that exact argument pack and formats it.
+//
+//  Arguments are copied as raw bytes, so they must be trivially copyable. A `const char *` is
+//  copied as a pointer and dereferenced later on the background thread: pass only string
+//  literals or other storage that outlives the logger.
+//
+// -------------------------------------------------------------------------------------
+//  Full rings and ordering
+// -------------------------------------------------------------------------------------
+//  A hot thread never waits for the logger: when its ring is full the message is dropped and
+//  counted, and the background thread reports the count in the log. Lines from one writer are
+//  in order; lines from different writers are interleaved batch by batch, each stamped with
+//  its own TSC time.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "posix_io.hpp"
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace async_logger {
+
+// Per-writer ring. 64 KiB holds ~2000 typical records: enough to absorb a burst while the
+// background thread is sleeping between sweeps.
+constexpr std::size_t WRITER_QUEUE_SIZE = std::size_t{1} << 16;
+
+// The background thread writes once its buffer passes this size, or when a sweep finds
+// nothing new, whichever comes first.
+constexpr std::size_t FLUSH_BYTES = std::size_t{1} << 16;
+
+// Records taken from one ring per visit, so a chatty writer cannot starve the others.
+constexpr std::size_t SWEEP_BATCH = 256;
+
+// How long the background thread sleeps after a sweep that found every ring empty.
+constexpr std::chrono::microseconds IDLE_SLEEP{50};
+
+// A string literal usable as a template argument.
+template <std::size_t N> struct fixed_string {
+  char data[N]{};
+  consteval fixed_string(const char (&s)[N]) { std::copy_n(s, N, data); }
+  constexpr std::string_view view() const noexcept { return {data, N - 1}; }
+};
+
+using format_fn = void (*)(std::string &out, std::string_view fmt, const std::byte *args);
+
+// Everything the background thread needs to turn a record back into text.
+struct log_site {
+  std::string_view fmt;
+  format_fn format;
+};
+
+// One argument back from its packed bytes. bit_cast needs T trivially copyable, which log()
+// checks, and not default-constructible.
+template <class T> T load_arg(const std::byte *p) noexcept {
+  std::array<std::byte, sizeof(T)> raw;
+  std::memcpy(raw.data(), p, sizeof(T));
+  return std::bit_cast<T>(raw);
+}
+
+// Decode the packed argument bytes back into Args... and format them.
+template <class... Args> void format_record(std::string &out, std::string_view fmt,
+                                            const std::byte *args) {
+  constexpr auto offsets = [] {
+    std::array<std::size_t, sizeof...(Args)> o{};
+    std::size_t at = 0;
+    std::size_t i = 0;
+    ((o[i++] = at, at += sizeof(Args)), ...);
+    return o;
+  }();
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    std::tuple<Args...> values{load_arg<Args>(args + offsets[I])...};
+    std::apply(
+        [&](Args &...a) {
+          std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(a...));
+        },
+        values);
+  }(std::index_sequence_for<Args...>{});
+}
+
+template <fixed_string Fmt, class... Args>
+inline constexpr log_site site_v{Fmt.view(), &format_record<Args...>};
+
+// Record layout: [const log_site *][std::uint64_t tsc][args...], no padding.
+constexpr std::size_t RECORD_HEADER = sizeof(const log_site *) + sizeof(std::uint64_t);
+
+template <class... Args>
+constexpr std::size_t record_size_v = RECORD_HEADER + (sizeof(Args) + ... + 0);
+
+/**
+ * One hot thread's channel: its ring plus both ends. The producer end is only touched by the
+ * writer thread, the consumer end only by the background thread.
+ */
+template <std::size_t QueueSize> struct channel {
+  fast_queue_spsc::fast_queue_t<QueueSize> queue;
+  fast_queue_spsc::producer prod;
+  fast_queue_spsc::consumer cons;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> dropped{0}; // written by the writer only
+  std::atomic<bool> closed{false}; // writer gone: free once drained
+  std::uint64_t dropped_reported{0}; // background thread's bookkeeping
+};
+
+/**
+ * The hot-thread handle. Movable, not copyable; one per thread. Destroying it closes the
+ * channel - the background thread still drains what is in it.
+ */
+template <std::size_t QueueSize> class writer {
+public:
+  explicit writer(channel<QueueSize> *ch) noexcept : ch_{ch} {}
+  writer(writer &&other) noexcept : ch_{std::exchange(other.ch_, nullptr)} {}
+  writer &operator=(writer &&other) noexcept {
+    if (this != &other) {
+      close();
+      ch_ = std::exchange(other.ch_, nullptr);
+    }
+    return *this;
+  }
+  writer(const writer &) = delete;
+  writer &operator=(const writer &) = delete;
+  ~writer() { close(); }
+
+  /**
+   * Log one message. Returns false (and counts a drop) when this writer's ring is full.
+   * Arguments are taken by value so string literals decay to `const char *`.
+   */
+  template <fixed_string Fmt, class... Args> bool log(Args... args) noexcept {
+    static_assert((std::is_trivially_copyable_v<Args> && ...),
+                  "log arguments are copied as raw bytes: they must be trivially copyable");
+    // Compile-time check of the format string against the argument types.
+    [[maybe_unused]] constexpr std::format_string<Args...> checked{Fmt.view()};
+    constexpr std::size_t size = record_size_v<Args...>;
+    const log_site *site = &site_v<Fmt, Args...>;
+    const std::uint64_t now = tsc::read_tsc();
+
+    auto view = ch_->prod.try_reserve(ch_->queue, size);
+    if (!view) [[unlikely]] {
+      // Single writer: a plain load + store is enough, no RMW on the hot path.
+      ch_->dropped.store(ch_->dropped.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+      return false;
+    }
+    if (!view->wrapped()) [[likely]] {
+      encode(view->first.data(), site, now, args...); // straight into the ring
+    } else {
+      std::array<std::byte, size> staged;
+      encode(staged.data(), site, now, args...);
+      std::memcpy(view->first.data(), staged.data(), view->first.size());
+      std::memcpy(view->second.data(), staged.data() + view->first.size(), view->second.size());
+    }
+    ch_->prod.commit_write(ch_->queue);
+    return true;
+  }
+
+  // Records this writer has dropped on a full channel; 0 once it was moved from or closed.
+  std::uint64_t dropped() const noexcept {
+    return ch_ != nullptr ? ch_->dropped.load(std::memory_order_relaxed) : 0;
+  }
+
+private:
+  template <class... Args>
+  static void encode(std::byte *p, const log_site *site, std::uint64_t tsc,
+                     const Args &...args) noexcept {
+    std::memcpy(p, &site, sizeof(site));
+    std::memcpy(p + sizeof(site), &tsc, sizeof(tsc));
+    p += RECORD_HEADER;
+    ((std::memcpy(p, &args, sizeof(args)), p += sizeof(args)), ...);
+  }
+
+  void close() noexcept {
+    if (ch_ != nullptr) {
+      ch_->closed.store(true, std::memory_order_release);
+      ch_ = nullptr;
+    }
+  }
+
+  channel<QueueSize> *ch_;
+};
+
+/**
+ * Owns the channels and the background thread. Must outlive every writer it hands out. The
+ * destructor drains all rings, flushes and closes the file.
+ */
+template <std::size_t QueueSize = WRITER_QUEUE_SIZE> class logger {
+public:
+  // Appends to `path` (created if missing). "/dev/stdout" works too.
+  explicit logger(const std::string &path)
+      : fd_{::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)},
+        tsc0_{tsc::read_tsc()},
+        ticks_per_ns_{tsc::calibrate_ticks_per_ns()} {
+    out_.reserve(2 * FLUSH_BYTES);
+    background_ = std::thread([this] { run(); });
+  }
+
+  logger(const logger &) = delete;
+  logger &operator=(const logger &) = delete;
+
+  ~logger() {
+    stop_.store(true, std::memory_order_release);
+    background_.join();
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  bool ok() const noexcept { return fd_ >= 0; }
+
+  // Registers a new channel; call on (or for) the thread that will log. Not a hot-path call.
+  writer<QueueSize> make_writer() {
+    auto ch = std::make_unique<channel<QueueSize>>();
+    auto *raw = ch.get();
+    std::lock_guard lock{mutex_};
+    channels_.push_back(std::move(ch));
+    return writer<QueueSize>{raw};
+  }
+
+  // Lines written to the file so far (for tests and benchmarks).
+  std::uint64_t lines_written() const noexcept { return lines_.load(std::memory_order_acquire); }
+
+private:
+  void run() {
+    while (!stop_.load(std::memory_order_acquire)) {
+      if (sweep() == 0) {
+        flush();
+        std::this_thread::sleep_for(IDLE_SLEEP);
+      }
+    }
+    // Writers may have logged right up to the stop: drain everything that is left.
+    while (sweep() != 0) {
+    }
+    flush();
+  }
+
+  // One pass over every channel; returns the number of records formatted.
+  std::size_t sweep() {
+    std::size_t total = 0;
+    std::lock_guard lock{mutex_};
+    for (auto it = channels_.begin(); it != channels_.end();) {
+      auto &ch = **it;
+      // Read `closed` BEFORE draining: if it was set, every record was committed before it.
+      const bool closed = ch.closed.load(std::memory_order_acquire);
+      const std::size_t n = drain(ch);
+      total += n;
+      report_drops(ch);
+      if (closed && n < SWEEP_BATCH) {
+        it = channels_.erase(it); // writer gone and ring empty
+      } else {
+        ++it;
+      }
+      if (out_.size() >= FLUSH_BYTES) {
+        flush();
+      }
+    }
+    return total;
+  }
+
+  std::size_t drain(channel<QueueSize> &ch) {
+    std::size_t n = 0;
+    for (; n < SWEEP_BATCH; ++n) {
+      auto view = ch.cons.try_read_view(ch.queue);
+      if (!view) {
+        break;
+      }
+      const std::byte *p = view->first.data();
+      if (view->wrapped()) { // reassemble the rare record that straddles the end
+        scratch_.resize(view->size());
+        std::memcpy(scratch_.data(), view->first.data(), view->first.size());
+        std::memcpy(scratch_.data() + view->first.size(), view->second.data(),
+                    view->second.size());
+        p = scratch_.data();
+      }
+      const log_site *site{};
+      std::uint64_t tsc{};
+      std::memcpy(&site, p, sizeof(site));
+      std::memcpy(&tsc, p + sizeof(site), sizeof(tsc));
+      append_timestamp(tsc);
+      site->format(out_, site->fmt, p + RECORD_HEADER);
+      out_.push_back('\n');
+      ch.cons.commit_read(ch.queue);
+    }
+    lines_pending_ += n;
+    return n;
+  }
+
+  void report_drops(channel<QueueSize> &ch) {
+    const std::uint64_t dropped = ch.dropped.load(std::memory_order_relaxed);
+    if (dropped != ch.dropped_reported) {
+      append_timestamp(tsc::read_tsc());
+      std::format_to(std::back_inserter(out_), "async_logger: dropped {} messages (ring full)\n",
+                     dropped - ch.dropped_reported);
+      ch.dropped_reported = dropped;
+      ++lines_pending_;
+    }
+  }
+
+  // "[seconds.nanoseconds] " since the logger started.
+  void append_timestamp(std::uint64_t tsc) {
+    const auto ns = tsc > tsc0_ ? static_cast<std::uint64_t>(static_cast<double>(tsc - tsc0_) /
+                                                             ticks_per_ns_)
+                                : 0;
+    std::format_to(std::back_inserter(out_), "[{}.{:09}] ", ns / 1'000'000'000,
+                   ns % 1'000'000'000);
+  }
+
+  void flush() {
+    if (!out_.empty()) {
+      if (fd_ >= 0) {
+        posix_io::write_all(fd_, out_.data(), out_.size());
+      }
+      out_.clear();
+    }
+    lines_.store(lines_.load(std::memory_order_relaxed) + lines_pending_,
+                 std::memory_order_release);
+    lines_pending_ = 0;
+  }
+
+  int fd_;
+  std::uint64_t tsc0_;
+  double ticks_per_ns_;
+  std::mutex mutex_; // guards channels_ (registration vs sweep); never taken on the hot path
+  std::vector<std::unique_ptr<channel<QueueSize>>> channels_;
+  std::atomic<bool> stop_{false};
+  std::atomic<std::uint64_t> lines_{0};
+  // Background thread only.
+  std::string out_;
+  std::vector<std::byte> scratch_;
+  std::uint64_t lines_pending_{0};
+  std::thread background_; // started in the constructor body, once everything is initialised
+};
+
+} // namespace async_logger
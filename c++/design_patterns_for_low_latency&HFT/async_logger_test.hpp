@@ -0,0 +1,173 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for async_logger.hpp: a multi-writer round trip through the file, and
+// the per-call cost on the logging thread against std::println, at p50 and p99.9.
+//
+
+#pragma once
+
+#include "async_logger.hpp"
+#include "percentile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace async_logger {
+
+// Two writers log interleaved messages; every accepted line must reach the file, complete and
+// in per-writer order, once the logger has been destroyed (which drains and flushes).
+inline void test_round_trip() {
+  std::println("--- test_async_logger_round_trip ---");
+  constexpr std::uint64_t N = 100'000;
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "async_logger_test.log").string();
+  std::filesystem::remove(path);
+
+  std::uint64_t accepted[2]{};
+  {
+    logger<> log{path};
+    assert(log.ok() && "could not open the log file");
+    auto worker = [&](int id) {
+      auto w = log.make_writer();
+      for (std::uint64_t seq = 0; seq < N; ++seq) {
+        if (w.log<"writer {} seq {} tag {}">(id, seq, "abc")) {
+          ++accepted[id];
+        } else {
+          std::this_thread::yield(); // give the background thread a chance, then move on
+        }
+      }
+      assert(accepted[id] + w.dropped() == N);
+    };
+    std::thread a(worker, 0);
+    std::thread b(worker, 1);
+    a.join();
+    b.join();
+  }
+
+  std::ifstream in{path};
+  std::string line;
+  std::uint64_t seen[2]{};
+  [[maybe_unused]] std::int64_t last[2]{-1, -1};
+  while (std::getline(in, line)) {
+    const auto at = line.find("writer ");
+    if (at == std::string::npos) {
+      continue; // a drop report
+    }
+    int id = -1;
+    long long seq = -1;
+    char tag[4]{};
+    [[maybe_unused]] const int parsed =
+        std::sscanf(line.c_str() + at, "writer %d seq %lld tag %3s", &id, &seq, tag);
+    assert(parsed == 3 && (id == 0 || id == 1) && "malformed line");
+    assert(std::string{tag} == "abc");
+    assert(seq > last[id] && "lines of one writer out of order");
+    last[id] = seq;
+    ++seen[id];
+  }
+  assert(seen[0] == accepted[0] && seen[1] == accepted[1] && "accepted lines lost");
+  std::println("test_async_logger_round_trip PASSED ({} + {} lines, {} dropped)", seen[0],
+               seen[1], 2 * N - seen[0] - seen[1]);
+}
+
+// The background thread's decode: packed bytes back into the arguments, including a type with
+// no default constructor (which a default-constructed tuple could not hold).
+inline void test_format_record() {
+  std::println("--- test_async_logger_format_record ---");
+  struct no_default {
+    explicit no_default(std::int64_t v) : value{v} {}
+    std::int64_t value;
+  };
+  std::array<std::byte, sizeof(int) + sizeof(std::uint64_t) + sizeof(const char *)> packed;
+  const int a = -7;
+  const std::uint64_t b = 42;
+  const char *c = "xyz";
+  std::memcpy(packed.data(), &a, sizeof(a));
+  std::memcpy(packed.data() + sizeof(a), &b, sizeof(b));
+  std::memcpy(packed.data() + sizeof(a) + sizeof(b), &c, sizeof(c));
+  std::string out;
+  format_record<int, std::uint64_t, const char *>(out, "a {} b {} c {}", packed.data());
+  assert(out == "a -7 b 42 c xyz");
+
+  const no_default nd{1234};
+  std::array<std::byte, sizeof(nd)> raw;
+  std::memcpy(raw.data(), &nd, sizeof(nd));
+  assert(load_arg<no_default>(raw.data()).value == 1234);
+  std::println("test_async_logger_format_record PASSED");
+}
+
+// Time every call individually and report the producer-side distribution. Both sides pay the
+// same two steady_clock reads per sample, so the comparison is fair; subtract ~20 ns for the
+// absolute cost.
+template <class Call> void run_per_call(benchmark::State &state, Call &&call) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  std::vector<std::int64_t> samples(n);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto t0 = std::chrono::steady_clock::now();
+      call(i);
+      const auto t1 = std::chrono::steady_clock::now();
+      samples[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) { return static_cast<double>(percentile::nearest_rank(samples, q)); };
+  state.counters["p50_ns"] = at(0.50);
+  state.counters["p99_ns"] = at(0.99);
+  state.counters["p99.9_ns"] = at(0.999);
+  state.counters["max_ns"] = static_cast<double>(samples.back());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// The hot thread's side of the logger. The ring is sized to hold the whole run, so the numbers
+// are the reserve/encode/commit path and not the drop path (reported as `dropped` anyway).
+inline void BM_AsyncLoggerCall(benchmark::State &state) {
+  const auto path = (std::filesystem::temp_directory_path() / "async_logger_bench.log").string();
+  logger<std::size_t{1} << 23> log{path};
+  auto w = log.make_writer();
+  const double px = 101.25;
+  run_per_call(state, [&](std::size_t i) {
+    w.log<"order {} px {} qty {} side {}">(static_cast<std::uint64_t>(i), px,
+                                           static_cast<std::int32_t>(i & 0xFF), 'B');
+  });
+  state.counters["dropped"] = static_cast<double>(w.dropped());
+}
+
+// The same message formatted and written on the calling thread.
+inline void BM_PrintlnCall(benchmark::State &state) {
+  const auto path = (std::filesystem::temp_directory_path() / "println_bench.log").string();
+  std::FILE *f = std::fopen(path.c_str(), "a");
+  if (f == nullptr) {
+    state.SkipWithError("could not open the log file");
+    return;
+  }
+  const double px = 101.25;
+  run_per_call(state, [&](std::size_t i) {
+    std::println(f, "order {} px {} qty {} side {}", static_cast<std::uint64_t>(i), px,
+                 static_cast<std::int32_t>(i & 0xFF), 'B');
+  });
+  std::fclose(f);
+}
+
+inline void test() {
+  test_round_trip();
+  test_format_record();
+  // Args = {calls per run}. 200k records of ~40 bytes fit in the 8 MiB benchmark ring.
+  BENCHMARK(BM_AsyncLoggerCall)->Iterations(1)->Arg(200'000)->UseRealTime();
+  BENCHMARK(BM_PrintlnCall)->Iterations(1)->Arg(200'000)->UseRealTime();
+}
+
+} // namespace async_logger
@@ -0,0 +1,26 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  cache_line.hpp — the one CACHE_LINE_SIZE every padded structure aligns to
+// =====================================================================================
+//
+// The queues' counters, the flight recorder's thread buffers, the pool's slots, the risk
+// table's rows and the seqlock all keep their hot fields a line apart. They must agree on how
+// long a line is, so it is defined once, here, at global scope where fast_queue_SPSC.hpp has
+// always had it.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <version>
+
+#if defined(__cpp_lib_hardware_interference_size)
+#include <new>
+inline constexpr std::size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+#elif defined(__aarch64__) && defined(__APPLE__)
+inline constexpr std::size_t CACHE_LINE_SIZE = 128; // Apple Silicon
+#else
+inline constexpr std::size_t CACHE_LINE_SIZE = 64; // safe default
+#endif
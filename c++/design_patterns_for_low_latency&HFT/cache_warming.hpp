@@ -6,10 +6,18 @@
 
 #include <algorithm>
 #include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "fast_queue_SPSC.hpp"
 #include "utils.hpp"
 
 namespace cache_warming {
@@ -60,6 +68,163 @@ inline void BM_CacheWarm(benchmark::State &state) {
   }
 }
 
+// --- Cache-hierarchy sweep -------------------------------------------------------------
+// BM_CacheCold/BM_CacheWarm only contrast "fits" with "much bigger than the LLC". The sweep
+// below walks the working set from 4 KiB to 1 GiB in powers of two, so the per-access cost
+// plotted against the size shows a step at every cache level: the x position of a step is
+// that level's capacity, the plateau height before it is its latency (or bandwidth).
+//
+// Three access patterns:
+//  - BM_MemSequential  : stream through every 8-byte word; prefetcher-friendly -> bandwidth.
+//  - BM_MemStrided     : one load per `stride` bytes. kLineSize = one per line (prefetchable
+//                        but every access is a new line), 4096 = one per page (defeats the
+//                        stream prefetcher and adds TLB pressure).
+//  - BM_MemPointerChase: a random cyclic permutation over line-sized nodes; every load
+//                        depends on the previous one, so neither prefetch nor memory-level
+//                        parallelism help -> the true load-to-use latency of each level.
+//
+// Each runs single-threaded and with all hardware threads. The threads share ONE read-only
+// buffer (built by thread 0 before the timing loop, whose start is a barrier), so every core
+// holds the same working set in its private L1/L2 while competing for the shared L3 and DRAM.
+// Use --benchmark_format=csv (or json) and plot ns_per_access / bytes_per_second against the
+// working-set size to get the curve.
+
+// The queues' line size (fast_queue_SPSC.hpp): 128 bytes on Apple Silicon, 64 on x86.
+constexpr std::size_t kLineSize = CACHE_LINE_SIZE;
+constexpr std::int64_t kSweepMin = std::int64_t{4} << 10; // 4 KiB
+constexpr std::int64_t kSweepMax = std::int64_t{1} << 30; // 1 GiB
+
+// One node per cache line so each hop of the chase is a distinct line.
+struct alignas(kLineSize) chase_node {
+  chase_node *next;
+};
+
+// Sattolo's algorithm: a uniformly random permutation with a SINGLE cycle, so the chase visits
+// every node of the working set before repeating (a plain shuffle can leave short cycles that
+// stay cache-resident and flatter the large sizes).
+inline std::unique_ptr<chase_node[]> make_chase(std::size_t nodes, std::uint64_t seed = 42) {
+  std::vector<std::size_t> order(nodes);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::mt19937_64 rng{seed};
+  for (std::size_t i = nodes - 1; i > 0; --i) {
+    std::uniform_int_distribution<std::size_t> pick(0, i - 1);
+    std::swap(order[i], order[pick(rng)]);
+  }
+  auto chain = std::make_unique<chase_node[]>(nodes);
+  for (std::size_t i = 0; i < nodes; ++i) {
+    chain[i].next = &chain[order[i]];
+  }
+  return chain;
+}
+
+// Per-access cost, averaged over threads: seconds per access, printed as e.g. "1.2ns".
+// Iterations are summed over the threads before the rate is taken, so each thread reports
+// its share of the accesses; kAvgThreads alone would divide a latency by the thread count.
+inline benchmark::Counter per_access(const benchmark::State &state, double accesses) {
+  return benchmark::Counter(accesses / static_cast<double>(state.threads()),
+                            benchmark::Counter::kIsIterationInvariantRate |
+                                benchmark::Counter::kAvgThreads |
+                                benchmark::Counter::kInvert);
+}
+
+// Args: range(0) = working set in bytes.
+inline void BM_MemSequential(benchmark::State &state) {
+  static std::vector<std::uint64_t> words;
+  const auto n = static_cast<std::size_t>(state.range(0)) / sizeof(std::uint64_t);
+  if (state.thread_index() == 0) {
+    words.assign(n, 1);
+  }
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      sum += words[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  state.counters["ns_per_access"] = per_access(state, static_cast<double>(n));
+  state.counters["working_set_KiB"] = static_cast<double>(state.range(0) >> 10);
+  if (state.thread_index() == 0) {
+    words = {};
+  }
+}
+
+// Args: range(0) = working set in bytes, range(1) = stride in bytes.
+inline void BM_MemStrided(benchmark::State &state) {
+  static std::vector<std::uint64_t> words;
+  const auto n = static_cast<std::size_t>(state.range(0)) / sizeof(std::uint64_t);
+  const auto step = static_cast<std::size_t>(state.range(1)) / sizeof(std::uint64_t);
+  if (state.thread_index() == 0) {
+    words.assign(n, 1);
+  }
+  const std::size_t accesses = n / step;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < n; i += step) {
+      sum += words[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  // Bytes actually pulled through the hierarchy: one whole line per access.
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(accesses * kLineSize));
+  state.counters["ns_per_access"] = per_access(state, static_cast<double>(accesses));
+  state.counters["working_set_KiB"] = static_cast<double>(state.range(0) >> 10);
+  if (state.thread_index() == 0) {
+    words = {};
+  }
+}
+
+// Args: range(0) = working set in bytes.
+inline void BM_MemPointerChase(benchmark::State &state) {
+  static std::unique_ptr<chase_node[]> chain;
+  constexpr std::size_t kHops = 1 << 16; // dependent loads per iteration
+  const auto nodes = static_cast<std::size_t>(state.range(0)) / sizeof(chase_node);
+  if (state.thread_index() == 0) {
+    chain = make_chase(nodes);
+  }
+  // Each thread starts at a different point of the single cycle. The start is picked inside
+  // the loop because thread 0's chain is only guaranteed visible after the loop-start barrier.
+  const chase_node *p = nullptr;
+  for (auto _ : state) {
+    if (p == nullptr) {
+      p = &chain[(static_cast<std::size_t>(state.thread_index()) * 7919) % nodes];
+    }
+    for (std::size_t i = 0; i < kHops; ++i) {
+      p = p->next;
+    }
+    benchmark::DoNotOptimize(p);
+  }
+  state.counters["ns_per_access"] = per_access(state, static_cast<double>(kHops));
+  state.counters["working_set_KiB"] = static_cast<double>(state.range(0) >> 10);
+  if (state.thread_index() == 0) {
+    chain.reset();
+  }
+}
+
+// Registers the sweep. Unlike test() this does not run the benchmarks itself: main's single
+// benchmark::Initialize/RunSpecifiedBenchmarks pass executes them (filter with
+// --benchmark_filter=BM_Mem).
+inline void sweep() {
+  const int hw = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+  for (auto *b : {benchmark::RegisterBenchmark("BM_MemSequential", BM_MemSequential),
+                  benchmark::RegisterBenchmark("BM_MemPointerChase", BM_MemPointerChase)}) {
+    b->RangeMultiplier(2)->Range(kSweepMin, kSweepMax)->ArgName("bytes")->UseRealTime();
+    b->Threads(1);
+    if (hw > 1) {
+      b->Threads(hw);
+    }
+  }
+  auto *strided = benchmark::RegisterBenchmark("BM_MemStrided", BM_MemStrided);
+  strided->ArgsProduct({benchmark::CreateRange(kSweepMin, kSweepMax, 2),
+                         {static_cast<std::int64_t>(kLineSize), 4096}})
+      ->ArgNames({"bytes", "stride"})
+      ->UseRealTime()
+      ->Threads(1);
+  if (hw > 1) {
+    strided->Threads(hw);
+  }
+}
+
 inline void test() {
   BENCHMARK(BM_CacheCold);
   BENCHMARK(BM_CacheWarm);
@@ -4,7 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include "utils.hpp"
 
@@ -49,6 +60,261 @@ template <typename T> static void BM_CompileTimeDispatch(benchmark::State &state
   }
 }
 
+// --- Megamorphic dispatch over heterogeneous containers -----------------------------------
+// The benchmarks above call one object through one Base*, so the indirect-branch predictor
+// sees a single target and the virtual call costs almost nothing. What actually hurts is a
+// MEGAMORPHIC call site: one loop over a container of mixed types, where the target changes
+// from element to element. Every technique below runs the same work - fold an accumulator
+// through 1k..1M "ops" of four kinds (add/sub/mul/xor with a per-object constant) - so only
+// the dispatch mechanism differs:
+//
+//  - BM_MixedVirtual       : std::vector<std::unique_ptr<op_base>>, virtual apply().
+//  - BM_MixedVariant       : std::vector<std::variant<...>> + std::visit.
+//  - BM_MixedFunctionTable : packed {kind, k} records + a table of function pointers.
+//  - BM_BatchedVirtual     : type-sorted batches (one pointer array per kind), still virtual -
+//                            but each batch's call site is monomorphic, so it predicts.
+//  - BM_BatchedFinal       : the same batches through pointers to `final` classes: the compiler
+//                            knows the exact target, so the call is direct and inlined.
+//  - BM_BatchedCrtp        : per-kind value arrays with CRTP static dispatch - no vtable at all.
+//
+// The mixed benchmarks take an order argument: shuffled (0) leaves the indirect branch to guess
+// the kind of every element, sorted (1) groups equal kinds so the same call site becomes
+// predictable. The gap between the two is the branch-predictor cost; the gap between sorted
+// and the batched variants is what remains of the dispatch itself.
+
+constexpr std::size_t kKinds = 4;
+
+// The work behind every dispatch mechanism, so they differ only in how they reach it.
+template <std::size_t Kind> constexpr std::uint32_t eval(std::uint32_t x, std::uint32_t k) {
+  if constexpr (Kind == 0) {
+    return x + k;
+  } else if constexpr (Kind == 1) {
+    return x - k;
+  } else if constexpr (Kind == 2) {
+    return x * k;
+  } else {
+    return x ^ k;
+  }
+}
+
+// Virtual hierarchy. `kind` is a plain data member so containers can be sorted by type.
+class op_base {
+public:
+  op_base(std::uint8_t kind, std::uint32_t k) : kind{kind}, k{k} {}
+  virtual ~op_base() = default;
+  virtual std::uint32_t apply(std::uint32_t x) const = 0;
+
+  std::uint8_t kind;
+  std::uint32_t k;
+};
+
+template <std::size_t Kind> class op_virtual : public op_base {
+public:
+  explicit op_virtual(std::uint32_t k) : op_base{Kind, k} {}
+  std::uint32_t apply(std::uint32_t x) const override { return eval<Kind>(x, k); }
+};
+
+template <std::size_t Kind> class op_virtual_final final : public op_base {
+public:
+  explicit op_virtual_final(std::uint32_t k) : op_base{Kind, k} {}
+  std::uint32_t apply(std::uint32_t x) const override { return eval<Kind>(x, k); }
+};
+
+// Plain value types for std::variant.
+template <std::size_t Kind> struct op_value {
+  std::uint32_t k;
+  std::uint32_t apply(std::uint32_t x) const { return eval<Kind>(x, k); }
+};
+using op_variant = std::variant<op_value<0>, op_value<1>, op_value<2>, op_value<3>>;
+
+// CRTP: the "interface" resolves to the derived implementation at compile time.
+template <class Derived> struct crtp_op {
+  std::uint32_t apply(std::uint32_t x) const {
+    return static_cast<const Derived &>(*this).apply_impl(x);
+  }
+};
+template <std::size_t Kind> struct op_crtp : crtp_op<op_crtp<Kind>> {
+  explicit op_crtp(std::uint32_t k) : k{k} {}
+  std::uint32_t apply_impl(std::uint32_t x) const { return eval<Kind>(x, k); }
+  std::uint32_t k;
+};
+
+// Function-pointer table over packed records.
+struct op_record {
+  std::uint8_t kind;
+  std::uint32_t k;
+};
+using op_fn = std::uint32_t (*)(std::uint32_t, std::uint32_t);
+inline constexpr std::array<op_fn, kKinds> op_table{&eval<0>, &eval<1>, &eval<2>, &eval<3>};
+
+// The element sequence shared by all benchmarks: n kinds in equal proportion, shuffled with a
+// fixed seed, then optionally sorted. k is odd so the multiply never collapses the accumulator.
+struct op_spec {
+  std::uint8_t kind;
+  std::uint32_t k;
+};
+inline std::vector<op_spec> make_specs(std::size_t n, bool sorted) {
+  std::vector<op_spec> specs(n);
+  std::mt19937 rng{1234};
+  for (std::size_t i = 0; i < n; ++i) {
+    specs[i] = {static_cast<std::uint8_t>(i % kKinds), static_cast<std::uint32_t>(rng()) | 1U};
+  }
+  std::shuffle(specs.begin(), specs.end(), rng);
+  if (sorted) {
+    std::stable_sort(specs.begin(), specs.end(),
+                     [](const op_spec &a, const op_spec &b) { return a.kind < b.kind; });
+  }
+  return specs;
+}
+
+// Build the object for kind `kind` by expanding the (runtime) kind into the matching Kind.
+template <template <std::size_t> class Op, class Make, std::size_t... Kinds>
+auto make_by_kind(std::uint8_t kind, Make &&make, std::index_sequence<Kinds...>) {
+  using result_t = decltype(make.template operator()<Op<0>>());
+  result_t out{};
+  ((kind == Kinds ? (out = make.template operator()<Op<Kinds>>(), true) : false) || ...);
+  return out;
+}
+
+// Args: range(0) = number of objects, range(1) = 0 shuffled / 1 sorted by kind.
+inline void BM_MixedVirtual(benchmark::State &state) {
+  // Allocated in the SHUFFLED order even when the pointers are later sorted, like objects that
+  // were created as they arrived: sorting the array does not make the heap layout sorted.
+  const auto specs = make_specs(static_cast<std::size_t>(state.range(0)), false);
+  std::vector<std::unique_ptr<op_base>> objects;
+  objects.reserve(specs.size());
+  for (const auto &s : specs) {
+    objects.push_back(make_by_kind<op_virtual>(
+        s.kind,
+        [&]<class T>() -> std::unique_ptr<op_base> { return std::make_unique<T>(s.k); },
+        std::make_index_sequence<kKinds>{}));
+  }
+  if (state.range(1) != 0) {
+    std::stable_sort(objects.begin(), objects.end(),
+                     [](const auto &a, const auto &b) { return a->kind < b->kind; });
+  }
+  for (auto _ : state) {
+    std::uint32_t acc = 1;
+    for (const auto &o : objects) {
+      acc = o->apply(acc);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+inline void BM_MixedVariant(benchmark::State &state) {
+  const auto specs = make_specs(static_cast<std::size_t>(state.range(0)), state.range(1) != 0);
+  std::vector<op_variant> objects;
+  objects.reserve(specs.size());
+  for (const auto &s : specs) {
+    objects.push_back(make_by_kind<op_value>(
+        s.kind, [&]<class T>() -> op_variant { return T{s.k}; },
+        std::make_index_sequence<kKinds>{}));
+  }
+  for (auto _ : state) {
+    std::uint32_t acc = 1;
+    for (const auto &o : objects) {
+      acc = std::visit([acc](const auto &op) { return op.apply(acc); }, o);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+inline void BM_MixedFunctionTable(benchmark::State &state) {
+  const auto specs = make_specs(static_cast<std::size_t>(state.range(0)), state.range(1) != 0);
+  std::vector<op_record> records;
+  records.reserve(specs.size());
+  for (const auto &s : specs) {
+    records.push_back({s.kind, s.k});
+  }
+  for (auto _ : state) {
+    std::uint32_t acc = 1;
+    for (const auto &r : records) {
+      acc = op_table[r.kind](acc, r.k);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Type-sorted batches of pointers into the virtual hierarchy. Op = op_virtual keeps the call
+// virtual (but monomorphic per batch); Op = op_virtual_final lets the compiler devirtualize.
+template <template <std::size_t> class Op> inline void BM_Batched(benchmark::State &state) {
+  const auto specs = make_specs(static_cast<std::size_t>(state.range(0)), false);
+  std::vector<std::unique_ptr<op_base>> storage;
+  storage.reserve(specs.size());
+  auto batches = []<std::size_t... Kinds>(std::index_sequence<Kinds...>) {
+    return std::tuple<std::vector<const Op<Kinds> *>...>{};
+  }(std::make_index_sequence<kKinds>{});
+  for (const auto &s : specs) {
+    [&]<std::size_t... Kinds>(std::index_sequence<Kinds...>) {
+      ((s.kind == Kinds ? (storage.push_back(std::make_unique<Op<Kinds>>(s.k)),
+                           std::get<Kinds>(batches).push_back(
+                               static_cast<const Op<Kinds> *>(storage.back().get())),
+                           true)
+                        : false) ||
+       ...);
+    }(std::make_index_sequence<kKinds>{});
+  }
+  for (auto _ : state) {
+    std::uint32_t acc = 1;
+    std::apply(
+        [&acc](const auto &...batch) {
+          // The pointer's static type is Op<Kind>: with `final` the call below is direct.
+          ((std::for_each(batch.begin(), batch.end(), [&acc](auto *o) { acc = o->apply(acc); })),
+           ...);
+        },
+        batches);
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+inline void BM_BatchedCrtp(benchmark::State &state) {
+  const auto specs = make_specs(static_cast<std::size_t>(state.range(0)), false);
+  std::tuple<std::vector<op_crtp<0>>, std::vector<op_crtp<1>>, std::vector<op_crtp<2>>,
+             std::vector<op_crtp<3>>>
+      batches;
+  for (const auto &s : specs) {
+    [&]<std::size_t... Kinds>(std::index_sequence<Kinds...>) {
+      ((s.kind == Kinds ? (std::get<Kinds>(batches).emplace_back(s.k), true) : false) || ...);
+    }(std::make_index_sequence<kKinds>{});
+  }
+  // Called through the CRTP base, as generic code written against the "interface" would.
+  auto run = [](const auto &batch, std::uint32_t acc) {
+    for (const auto &o : batch) {
+      using base_t = crtp_op<std::remove_cvref_t<decltype(o)>>;
+      acc = static_cast<const base_t &>(o).apply(acc);
+    }
+    return acc;
+  };
+  for (auto _ : state) {
+    std::uint32_t acc = 1;
+    std::apply([&](const auto &...batch) { ((acc = run(batch, acc)), ...); }, batches);
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Registers the megamorphic suite. Like cache_warming::sweep() this only registers: main's
+// single benchmark pass runs it (filter with --benchmark_filter='BM_Mixed|BM_Batched').
+inline void suite() {
+  const auto sizes = benchmark::CreateRange(1 << 10, 1 << 20, 8); // 1k..1M objects
+  for (auto *b : {benchmark::RegisterBenchmark("BM_MixedVirtual", BM_MixedVirtual),
+                  benchmark::RegisterBenchmark("BM_MixedVariant", BM_MixedVariant),
+                  benchmark::RegisterBenchmark("BM_MixedFunctionTable", BM_MixedFunctionTable)}) {
+    b->ArgsProduct({sizes, {0, 1}})->ArgNames({"objects", "sorted"});
+  }
+  for (auto *b :
+       {benchmark::RegisterBenchmark("BM_BatchedVirtual", BM_Batched<op_virtual>),
+        benchmark::RegisterBenchmark("BM_BatchedFinal", BM_Batched<op_virtual_final>),
+        benchmark::RegisterBenchmark("BM_BatchedCrtp", BM_BatchedCrtp)}) {
+    b->ArgsProduct({sizes})->ArgNames({"objects"});
+  }
+}
+
 inline void test() {
   BENCHMARK(BM_RuntimeDispatch)->Arg(1)->Arg(2);
   BENCHMARK_TEMPLATE(BM_CompileTimeDispatch, Derived1);
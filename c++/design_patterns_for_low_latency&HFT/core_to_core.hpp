@@ -0,0 +1,278 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  core_to_core.hpp — what a cache-line transfer between two CPUs costs
+// =====================================================================================
+//
+// Every cost the queues pay crosses cores as a cache-line transfer. The producer's store to
+// write_counter invalidates the consumer's copy, and the consumer's next load must fetch the
+// line from the producer's cache. A false-shared line bounces on every write of either side.
+// This header measures those transfers directly, for a chosen pair of logical CPUs:
+//
+//  - round trip : two threads bounce ONE line. A writes an odd value, B waits for it and
+//                 writes the next even one, A waits for that. Each round trip is two
+//                 transfers, and each is an invalidate plus a fetch. This is the queue's
+//                 "write, then wait for the other side's counter" pattern, with no payload.
+//  - one way    : A stores a steady_clock stamp into the line; B spins on the line and reads
+//                 the clock when the new value arrives. The difference is one transfer plus
+//                 B's clock read. It needs a clock that agrees across CPUs (Linux
+//                 CLOCK_MONOTONIC does, on an invariant TSC). B acknowledges on a SECOND line,
+//                 so the acknowledgement never disturbs the measured one.
+//  - matrix     : both, for every ordered pair of the given CPUs. The rows are the
+//                 initiators (the writer for one way); the diagonal is empty.
+//  - false sharing: two threads each bump their OWN counter, `offset` bytes apart. 8 puts them
+//                 on one line; CACHE_LINE_SIZE puts them on neighbouring lines; twice that
+//                 shows whether the adjacent-line prefetcher pairs 64-byte lines (the reason
+//                 std::hardware_destructive_interference_size can be 128 on x86).
+//
+// Results are medians over the samples, not means: a timer interrupt on either CPU makes one
+// sample 10x slower and would drag a mean with it. The threads are pinned with
+// thread_placement::pin_current_thread. When both run on ONE CPU they cannot spin (the waiter
+// would burn its time slice while the other holds the value), so `spin = false` makes every
+// wait yield instead; the numbers are then scheduler round trips, not cache transfers.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace core_to_core {
+
+struct probe_config {
+  std::uint64_t samples = 10'000; // round trips, or one-way transfers, per pair
+  bool spin = true;               // busy-wait with spin_pause; false: yield (one shared CPU)
+};
+
+// One ordered pair of logical CPUs. cpu < 0 leaves that thread unpinned.
+struct pair_latency {
+  int from;
+  int to;
+  double round_trip_ns; // median
+  double one_way_ns;    // median
+};
+
+namespace detail {
+
+inline std::int64_t now_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <class Pred> inline void wait_until(Pred &&done, bool spin) noexcept {
+  while (!done()) {
+    if (spin) {
+      fast_queue_spsc::spin_pause();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Runs a() pinned to cpu_a and b() pinned to cpu_b, released together once both are pinned.
+template <class A, class B> inline void run_pair(int cpu_a, int cpu_b, A &&a, B &&b) {
+  std::atomic<int> ready{0};
+  auto start = [&](int cpu) {
+    if (cpu >= 0) {
+      thread_placement::pin_current_thread(cpu);
+    }
+    ready.fetch_add(1, std::memory_order_acq_rel);
+    while (ready.load(std::memory_order_acquire) < 2) {
+      std::this_thread::yield();
+    }
+  };
+  std::thread tb([&] {
+    start(cpu_b);
+    b();
+  });
+  std::thread ta([&] {
+    start(cpu_a);
+    a();
+  });
+  ta.join();
+  tb.join();
+}
+
+inline double median(std::vector<std::int64_t> &v) {
+  if (v.empty()) {
+    return 0.0;
+  }
+  const auto mid = v.begin() + static_cast<std::ptrdiff_t>(v.size() / 2);
+  std::nth_element(v.begin(), mid, v.end());
+  return static_cast<double>(*mid);
+}
+
+} // namespace detail
+
+/**
+ * Round trips of one cache line between `from` (the initiator) and `to`. Returns every
+ * round trip in ns, in order.
+ */
+inline std::vector<std::int64_t> round_trips(int from, int to, const probe_config &cfg) {
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> ball{0};
+  std::vector<std::int64_t> samples;
+  samples.reserve(cfg.samples);
+  detail::run_pair(
+      from, to,
+      [&] {
+        for (std::uint64_t i = 0; i < cfg.samples; ++i) {
+          const std::int64_t t0 = detail::now_ns();
+          ball.store(2 * i + 1, std::memory_order_release);
+          detail::wait_until([&] { return ball.load(std::memory_order_acquire) == 2 * i + 2; },
+                             cfg.spin);
+          samples.push_back(detail::now_ns() - t0);
+        }
+      },
+      [&] {
+        for (std::uint64_t i = 0; i < cfg.samples; ++i) {
+          detail::wait_until([&] { return ball.load(std::memory_order_acquire) == 2 * i + 1; },
+                             cfg.spin);
+          ball.store(2 * i + 2, std::memory_order_release);
+        }
+      });
+  return samples;
+}
+
+/**
+ * One-way transfers of a stamped line from `from` to `to`: the reader's clock when the new
+ * stamp arrived minus the stamp. Returns every transfer in ns, in order.
+ */
+inline std::vector<std::int64_t> one_way(int from, int to, const probe_config &cfg) {
+  struct alignas(CACHE_LINE_SIZE) line {
+    std::atomic<std::int64_t> value{0};
+  };
+  line stamp;
+  line ack; // "ready for sample i", on its own line
+  std::vector<std::int64_t> samples;
+  samples.reserve(cfg.samples);
+  detail::run_pair(
+      from, to,
+      [&] {
+        for (std::uint64_t i = 0; i < cfg.samples; ++i) {
+          detail::wait_until(
+              [&] {
+                return ack.value.load(std::memory_order_acquire) == static_cast<std::int64_t>(i);
+              },
+              cfg.spin);
+          stamp.value.store(detail::now_ns(), std::memory_order_release);
+        }
+      },
+      [&] {
+        std::int64_t last = 0;
+        for (std::uint64_t i = 0; i < cfg.samples; ++i) {
+          ack.value.store(static_cast<std::int64_t>(i), std::memory_order_release);
+          std::int64_t s = 0;
+          detail::wait_until(
+              [&] {
+                s = stamp.value.load(std::memory_order_acquire);
+                return s != last;
+              },
+              cfg.spin);
+          samples.push_back(detail::now_ns() - s);
+          last = s;
+        }
+      });
+  return samples;
+}
+
+// Both medians for one ordered pair.
+inline pair_latency measure_pair(int from, int to, const probe_config &cfg) {
+  auto rt = round_trips(from, to, cfg);
+  auto ow = one_way(from, to, cfg);
+  return {from, to, detail::median(rt), detail::median(ow)};
+}
+
+// Round-trip and one-way medians for every ordered pair of `cpus`, row = initiator.
+struct latency_matrix {
+  std::vector<int> cpus;
+  std::vector<double> round_trip_ns; // cpus.size()^2, row-major; NaN on the diagonal
+  std::vector<double> one_way_ns;
+
+  double round_trip_at(std::size_t from, std::size_t to) const {
+    return round_trip_ns[from * cpus.size() + to];
+  }
+  double one_way_at(std::size_t from, std::size_t to) const {
+    return one_way_ns[from * cpus.size() + to];
+  }
+};
+
+inline latency_matrix measure_matrix(const std::vector<int> &cpus, const probe_config &cfg) {
+  const std::size_t n = cpus.size();
+  latency_matrix m{cpus, std::vector<double>(n * n, NAN), std::vector<double>(n * n, NAN)};
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      if (i != j) {
+        const auto p = measure_pair(cpus[i], cpus[j], cfg);
+        m.round_trip_ns[i * n + j] = p.round_trip_ns;
+        m.one_way_ns[i * n + j] = p.one_way_ns;
+      }
+    }
+  }
+  return m;
+}
+
+/**
+ * The matrix as a table, one of its two measurements (`one_way` false: round trips), in whole
+ * ns. Rows are initiators, columns the peers, "-" on the diagonal:
+ *
+ *        cpu     0     1     2
+ *          0     -    61   142
+ *          1    60     -   139
+ *          2   141   140     -
+ */
+inline std::string format_matrix(const latency_matrix &m, bool one_way) {
+  const auto &v = one_way ? m.one_way_ns : m.round_trip_ns;
+  const std::size_t n = m.cpus.size();
+  std::string s = std::format("{:>5} ", "cpu");
+  for (const int c : m.cpus) {
+    s += std::format("{:>6}", c);
+  }
+  s += '\n';
+  for (std::size_t i = 0; i < n; ++i) {
+    s += std::format("{:>5} ", m.cpus[i]);
+    for (std::size_t j = 0; j < n; ++j) {
+      const double x = v[i * n + j];
+      s += std::isnan(x) ? std::format("{:>6}", "-") : std::format("{:>6.0f}", x);
+    }
+    s += '\n';
+  }
+  return s;
+}
+
+/**
+ * Two threads, on `cpu_a` and `cpu_b`, each write their own 8-byte counter `increments` times;
+ * the counters are `offset` bytes apart (a multiple of 8 in [8, 512)). Each counter has one
+ * writer, like the queue's read_counter and write_counter, so an increment is a relaxed load and
+ * store, not a locked RMW. Returns the wall time in ns per increment, both threads counted.
+ */
+inline double contended_increments(std::size_t offset, std::uint64_t increments, int cpu_a,
+                                   int cpu_b) {
+  alignas(512) std::array<std::uint64_t, 128> words{};
+  std::atomic_ref<std::uint64_t> a{words[0]};
+  std::atomic_ref<std::uint64_t> b{words[offset / sizeof(std::uint64_t)]};
+  auto bump = [increments](std::atomic_ref<std::uint64_t> c) {
+    for (std::uint64_t i = 0; i < increments; ++i) {
+      c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  };
+  const std::int64_t t0 = detail::now_ns();
+  detail::run_pair(cpu_a, cpu_b, [&] { bump(a); }, [&] { bump(b); });
+  const std::int64_t t1 = detail::now_ns();
+  return static_cast<double>(t1 - t0) / static_cast<double>(2 * increments);
+}
+
+} // namespace core_to_core
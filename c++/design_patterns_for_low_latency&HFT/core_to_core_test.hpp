@@ -0,0 +1,160 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for core_to_core.hpp. The probes are checked for shape on any host,
+// then the host's core-to-core matrix is printed (round trip and one way, every ordered pair
+// of the CPUs this process may use). The benchmarks repeat the round trip and the false-sharing
+// sweep under each thread_placement topology, so a placement for the queues, and the
+// CACHE_LINE_SIZE used to pad their counters, can be checked against this machine.
+//
+
+#pragma once
+
+#include "core_to_core.hpp"
+#include "percentile.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace core_to_core {
+
+inline void test_format_matrix() {
+  std::println("--- test_format_matrix ---");
+  const latency_matrix m{{0, 2}, {NAN, 61.0, 59.6, NAN}, {NAN, 30.0, 31.0, NAN}};
+  assert(m.round_trip_at(0, 1) == 61.0 && m.one_way_at(1, 0) == 31.0);
+  [[maybe_unused]] const std::string rt = format_matrix(m, false);
+  assert(std::ranges::count(rt, '\n') == 3 && rt.find('-') != std::string::npos);
+  assert(rt.find("61") != std::string::npos && rt.find("60") != std::string::npos);
+  assert(format_matrix(m, true).find("31") != std::string::npos);
+  std::println("test_format_matrix PASSED");
+}
+
+// Every probe returns one sample per round, none negative, on whatever CPUs the OS picks.
+inline void test_probes() {
+  std::println("--- test_probes ---");
+  const probe_config cfg{.samples = 200, .spin = std::thread::hardware_concurrency() >= 2};
+  [[maybe_unused]] const auto rt = round_trips(-1, -1, cfg);
+  [[maybe_unused]] const auto ow = one_way(-1, -1, cfg);
+  assert(rt.size() == cfg.samples && ow.size() == cfg.samples);
+  assert(std::ranges::all_of(rt, [](std::int64_t ns) { return ns > 0; }));
+  assert(std::ranges::all_of(ow, [](std::int64_t ns) { return ns >= 0; }));
+  [[maybe_unused]] const double per_increment = contended_increments(8, 1'000, -1, -1);
+  assert(per_increment > 0.0);
+  std::println("test_probes PASSED");
+}
+
+// The matrix for the CPUs this process may run on. 2,000 samples per probe and pair keeps a
+// 32-CPU host under a minute.
+inline void print_host_matrix() {
+  std::println("--- core-to-core latency (median ns) ---");
+  std::vector<int> cpus;
+  for (const auto &c : thread_placement::read_cpu_topology()) {
+    cpus.push_back(c.cpu);
+  }
+  if (cpus.size() < 2) {
+    std::println("needs two CPUs, this process may use {}", cpus.size());
+    return;
+  }
+  const auto m = measure_matrix(cpus, probe_config{.samples = 2'000, .spin = true});
+  std::print("round trip, row = initiator:\n{}", format_matrix(m, false));
+  std::print("one way, row = writer:\n{}", format_matrix(m, true));
+}
+
+// --- Benchmarks ------------------------------------------------------------------------------
+// The two threads are placed by range(0) = thread_placement::topology (thread 0 = initiator).
+// Unavailable placements are skipped. When both threads share a CPU (same_core, or floating on
+// a one-CPU host) the probes yield instead of spinning.
+inline std::optional<thread_placement::placement_plan> pair_plan(benchmark::State &state) {
+  const auto t = static_cast<thread_placement::topology>(state.range(0));
+  auto plan = thread_placement::make_plan(t, 2);
+  if (!plan) {
+    const std::string msg = "thread placement '" + std::string{thread_placement::to_string(t)} +
+                            "' unavailable on this host";
+    state.SkipWithError(msg.c_str());
+    return std::nullopt;
+  }
+  state.SetLabel(plan->describe().c_str());
+  return plan;
+}
+
+inline bool shares_cpu(const thread_placement::placement_plan &plan) {
+  return std::thread::hardware_concurrency() < 2 ||
+         (plan.threads[0].cpu >= 0 && plan.threads[0].cpu == plan.threads[1].cpu);
+}
+
+// 10,000 round trips and 10,000 one-way transfers per iteration. Time per iteration covers
+// both; the counters are the percentiles over every sample of the run.
+inline void BM_CacheLineTransfer(benchmark::State &state) {
+  const auto plan = pair_plan(state);
+  if (!plan) {
+    return;
+  }
+  const int a = plan->threads[0].cpu;
+  const int b = plan->threads[1].cpu;
+  const probe_config cfg{.samples = 10'000, .spin = !shares_cpu(*plan)};
+  std::vector<std::int64_t> rt;
+  std::vector<std::int64_t> ow;
+  for (auto _ : state) {
+    const auto r = round_trips(a, b, cfg);
+    const auto o = one_way(a, b, cfg);
+    rt.insert(rt.end(), r.begin(), r.end());
+    ow.insert(ow.end(), o.begin(), o.end());
+  }
+  std::ranges::sort(rt);
+  std::ranges::sort(ow);
+  const auto at = [](const std::vector<std::int64_t> &v, double q) {
+    return static_cast<double>(percentile::nearest_rank(v, q));
+  };
+  state.counters["round_trip_p50_ns"] = at(rt, 0.50);
+  state.counters["round_trip_p99_ns"] = at(rt, 0.99);
+  state.counters["one_way_p50_ns"] = at(ow, 0.50);
+  state.counters["one_way_p99_ns"] = at(ow, 0.99);
+}
+
+// Two owners, two counters, range(1) bytes apart: 8 = one line (false sharing),
+// CACHE_LINE_SIZE = neighbouring lines, 2 * CACHE_LINE_SIZE = neighbouring line pairs.
+// Manual time is the pair's wall time; ns_per_increment counts both threads' increments.
+inline void BM_FalseSharing(benchmark::State &state) {
+  const auto plan = pair_plan(state);
+  if (!plan) {
+    return;
+  }
+  constexpr std::uint64_t INCREMENTS = 10'000'000;
+  const auto offset = static_cast<std::size_t>(state.range(1));
+  double ns = 0.0;
+  for (auto _ : state) {
+    ns = contended_increments(offset, INCREMENTS, plan->threads[0].cpu, plan->threads[1].cpu);
+    state.SetIterationTime(ns * 2 * INCREMENTS * 1e-9);
+  }
+  state.counters["ns_per_increment"] = ns;
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(2 * INCREMENTS));
+}
+
+inline void test() {
+  test_format_matrix();
+  test_probes();
+  print_host_matrix();
+  const auto placements = thread_placement::topology_args();
+  BENCHMARK(BM_CacheLineTransfer)
+      ->Iterations(3)
+      ->ArgsProduct({placements})
+      ->ArgNames({"placement"});
+  const auto line = static_cast<std::int64_t>(CACHE_LINE_SIZE);
+  BENCHMARK(BM_FalseSharing)
+      ->UseManualTime()
+      ->Iterations(3)
+      ->ArgsProduct({placements, {8, line, 2 * line}})
+      ->ArgNames({"placement", "offset"});
+}
+
+} // namespace core_to_core
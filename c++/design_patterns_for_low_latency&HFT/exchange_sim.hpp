@@ -0,0 +1,402 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  exchange_sim.hpp — a local exchange behind a pair of shared-memory rings
+// =====================================================================================
+//
+// Order-entry latency is the other half of tick-to-trade: the time from deciding to trade to
+// holding the exchange's answer. Without an exchange on the box, this header stands one in. An
+// exchange simulator runs in its OWN PROCESS and talks to the trading process through two
+// fast_queue_t rings placed in a POSIX shared-memory object:
+//
+//      client process                               exchange process
+//      session::send ──── requests  (SPSC ring) ───► serve: matcher ──► order_book::book
+//      session::poll ◄─── responses (SPSC ring) ────  acks, fills, rejects, cancels
+//
+// The rings are the same ones the threads of this module use. They hold nothing but two
+// lock-free atomic counters and a byte array, so they work unchanged across a process boundary:
+// lock-free std::atomic is address-free, and the mapping can sit at a different address in each
+// process. Each side keeps its own producer / consumer, as a thread would. The round trip a
+// client measures is therefore the queue hop both ways, plus the matching, plus the cost of
+// the other process's core noticing the work - what a co-located gateway on shared memory costs.
+//
+// The matcher uses the book engine for its resting orders (order_book.hpp mirrors a venue and
+// does not match, so the matching loop lives here). A new order is added to the book first,
+// which validates it: a bad id, price or quantity comes back as a reject carrying the book's
+// status. Otherwise it is acked and then crossed against the opposite side in price-time
+// priority: every trade executes both orders in the book and sends a fill for each. An IOC
+// remainder is taken off again and reported as cancelled. A day remainder rests.
+//
+// Every response echoes the send stamp of the request that caused it and carries the
+// simulator's own stamp. Both processes read steady_clock, which is CLOCK_MONOTONIC on Linux
+// and shared across the box, so the round trip splits into a request leg and a response leg.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "order_book.hpp"
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace exchange_sim {
+
+using order_book::order_id;
+using order_book::price_t;
+using order_book::qty_t;
+using order_book::side;
+
+enum class request_type : std::uint8_t { new_order, cancel };
+enum class time_in_force : std::uint8_t { day, ioc };
+enum class response_type : std::uint8_t { ack, reject, fill, cancelled };
+
+inline const char *to_string(response_type t) noexcept {
+  switch (t) {
+  case response_type::ack:
+    return "ack";
+  case response_type::reject:
+    return "reject";
+  case response_type::fill:
+    return "fill";
+  case response_type::cancelled:
+    return "cancelled";
+  }
+  return "?";
+}
+
+// steady_clock in ns. The same clock in both processes (see the header comment).
+inline std::int64_t now_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Client -> exchange. Trivially copyable, 40 bytes. `price` and `qty` are ignored by cancel.
+struct request {
+  order_id id;
+  price_t price;
+  qty_t qty;
+  std::int64_t send_ns; // client's stamp, echoed on every response it causes
+  request_type type;
+  side s;
+  time_in_force tif;
+};
+
+// Exchange -> client. One request produces one or more: ack then fills, or a single reject.
+struct response {
+  order_id id;
+  price_t price; // fill: the trade price; otherwise the order's limit (0 for cancels)
+  qty_t qty;     // fill: traded; ack: accepted; cancelled: taken off the book
+  qty_t leaves;  // still open on the order after this event
+  std::int64_t send_ns;     // send stamp of the request that caused this response
+  std::int64_t exchange_ns; // when the simulator produced it
+  response_type type;
+  order_book::status reason; // why, for a reject
+};
+
+static_assert(std::is_trivially_copyable_v<request> && std::is_trivially_copyable_v<response>);
+
+/**
+ * The exchange's matching engine: an order_book::book plus price-time crossing. `emit` is
+ * called with each response in the order the client should see them.
+ */
+class matcher {
+public:
+  explicit matcher(const order_book::book_config &cfg) : book_{cfg} {}
+
+  template <class Emit> void on_request(const request &r, Emit &&emit) {
+    ++requests_;
+    const std::int64_t t = now_ns();
+    if (r.type == request_type::cancel) {
+      const order_book::order *o = book_.find(r.id);
+      if (o == nullptr) {
+        emit(response{r.id, 0, 0, 0, r.send_ns, t, response_type::reject,
+                      order_book::status::unknown_order});
+        return;
+      }
+      const qty_t open = o->qty;
+      book_.cancel(r.id);
+      emit(response{r.id, 0, open, 0, r.send_ns, t, response_type::cancelled,
+                    order_book::status::ok});
+      return;
+    }
+
+    // The book validates the order; a crossing order sits at the tail of its level only until
+    // the loop below has traded it.
+    if (const auto st = book_.add(r.id, r.s, r.price, r.qty); st != order_book::status::ok) {
+      emit(response{r.id, r.price, r.qty, 0, r.send_ns, t, response_type::reject, st});
+      return;
+    }
+    emit(response{r.id, r.price, r.qty, r.qty, r.send_ns, t, response_type::ack,
+                  order_book::status::ok});
+
+    const side contra = r.s == side::bid ? side::ask : side::bid;
+    qty_t open = r.qty;
+    while (open > 0) {
+      const auto best = contra == side::ask ? book_.best_ask() : book_.best_bid();
+      if (!best || (r.s == side::bid ? *best > r.price : *best < r.price)) {
+        break;
+      }
+      const order_id resting = *book_.front(contra, *best);
+      const qty_t resting_open = book_.find(resting)->qty;
+      const qty_t traded = std::min(open, resting_open);
+      book_.execute(resting, traded);
+      book_.execute(r.id, traded);
+      open -= traded;
+      ++fills_;
+      emit(response{r.id, *best, traded, open, r.send_ns, t, response_type::fill,
+                    order_book::status::ok});
+      emit(response{resting, *best, traded, resting_open - traded, r.send_ns, t,
+                    response_type::fill, order_book::status::ok});
+    }
+    if (open > 0 && r.tif == time_in_force::ioc) {
+      book_.cancel(r.id);
+      emit(response{r.id, r.price, open, 0, r.send_ns, t, response_type::cancelled,
+                    order_book::status::ok});
+    }
+  }
+
+  const order_book::book &book() const noexcept { return book_; }
+  std::uint64_t requests() const noexcept { return requests_; }
+  // Trades: one per resting order hit, i.e. per pair of fills.
+  std::uint64_t fills() const noexcept { return fills_; }
+
+private:
+  order_book::book book_;
+  std::uint64_t requests_ = 0;
+  std::uint64_t fills_ = 0;
+};
+
+/**
+ * What lives in the shared-memory object: the two rings and a little control state. The
+ * exchange process raises `exchange_up` once it serves and leaves `requests` / `fills` behind
+ * when it stops.
+ */
+template <std::size_t Size> struct gateway_rings {
+  fast_queue_spsc::fast_queue_t<Size> requests;  // client -> exchange
+  fast_queue_spsc::fast_queue_t<Size> responses; // exchange -> client
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> exchange_up{0};
+  std::atomic<std::uint32_t> stop{0};
+  std::atomic<std::uint64_t> requests_served{0};
+  std::atomic<std::uint64_t> fills{0};
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+              std::atomic<std::uint32_t>::is_always_lock_free,
+              "the rings are shared across processes: their atomics must be lock-free");
+
+enum class open_mode : std::uint8_t { create, attach };
+
+/**
+ * A T in a named POSIX shared-memory object. `create` makes the object (failing if the name is
+ * taken), constructs a T in it and removes the name again on destruction. `attach` maps an
+ * existing one. T is never destroyed, only unmapped, so it must be trivially destructible.
+ */
+template <class T> class shared_memory {
+  static_assert(std::is_trivially_destructible_v<T>);
+
+public:
+  shared_memory(std::string name, open_mode mode) : name_{std::move(name)} {
+    const bool create = mode == open_mode::create;
+    const int fd = ::shm_open(name_.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+    if (fd < 0) {
+      return;
+    }
+    owner_ = create;
+    if (create && ::ftruncate(fd, sizeof(T)) != 0) {
+      ::close(fd);
+      return;
+    }
+    void *p = ::mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the object
+    if (p == MAP_FAILED) {
+      return;
+    }
+    value_ = create ? new (p) T{} : static_cast<T *>(p);
+  }
+
+  shared_memory(const shared_memory &) = delete;
+  shared_memory &operator=(const shared_memory &) = delete;
+
+  ~shared_memory() {
+    if (value_ != nullptr) {
+      ::munmap(value_, sizeof(T));
+    }
+    if (owner_) {
+      ::shm_unlink(name_.c_str());
+    }
+  }
+
+  bool ok() const noexcept { return value_ != nullptr; }
+  T &operator*() const noexcept { return *value_; }
+  T *operator->() const noexcept { return value_; }
+
+private:
+  std::string name_;
+  T *value_ = nullptr;
+  bool owner_ = false;
+};
+
+struct exchange_config {
+  // A small book: the simulator only needs the prices and ids its clients use.
+  order_book::book_config book{.min_price = 0,
+                               .num_levels = 1 << 12,
+                               .max_orders = 1 << 16,
+                               .max_order_id = 1 << 20};
+  int cpu = -1;     // pin the exchange process here (-1: leave it to the scheduler)
+  bool spin = true; // busy-poll the request ring; false: yield when it is empty
+};
+
+/**
+ * The exchange's event loop: match every request and write its responses, until `stop` is
+ * raised. A full response ring is waited out - the client is expected to keep draining it.
+ */
+template <std::size_t Size> void serve(gateway_rings<Size> &rings, const exchange_config &cfg) {
+  if (cfg.cpu >= 0) {
+    thread_placement::pin_current_thread(cfg.cpu);
+  }
+  matcher m{cfg.book};
+  fast_queue_spsc::consumer in;
+  fast_queue_spsc::producer out;
+  auto reply = [&](const response &rsp) {
+    const auto bytes = std::as_bytes(std::span{&rsp, 1});
+    while (!out.try_write(rings.responses, bytes)) {
+      fast_queue_spsc::spin_pause();
+    }
+  };
+  rings.exchange_up.store(1, std::memory_order_release);
+  std::array<std::byte, sizeof(request)> buf;
+  for (;;) {
+    if (in.try_read(rings.requests, buf)) {
+      request r;
+      std::memcpy(&r, buf.data(), sizeof(r));
+      m.on_request(r, reply);
+    } else if (rings.stop.load(std::memory_order_acquire) != 0) {
+      break;
+    } else if (cfg.spin) {
+      fast_queue_spsc::spin_pause();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  rings.requests_served.store(m.requests(), std::memory_order_relaxed);
+  rings.fills.store(m.fills(), std::memory_order_release);
+}
+
+/**
+ * Creates the shared-memory rings under `name` and forks the exchange process that serves
+ * them. The constructor returns once the exchange is up (or ok() is false). The destructor, or
+ * stop(), tells it to finish the requests already queued and reaps it.
+ *
+ * The child only runs serve() and leaves with _exit, so it never returns into the parent's code
+ * or runs its atexit handlers. Fork from a thread that owns no locks the child will need: before
+ * other threads exist, or with them idle.
+ */
+template <std::size_t Size> class exchange_process {
+public:
+  exchange_process(const std::string &name, const exchange_config &cfg)
+      : shm_{name, open_mode::create} {
+    if (!shm_.ok()) {
+      return;
+    }
+    pid_ = ::fork();
+    if (pid_ == 0) {
+      serve(*shm_, cfg);
+      ::_exit(0);
+    }
+    if (pid_ < 0) {
+      return;
+    }
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (shm_->exchange_up.load(std::memory_order_acquire) == 0 &&
+           std::chrono::steady_clock::now() < give_up) {
+      std::this_thread::yield();
+    }
+  }
+
+  exchange_process(const exchange_process &) = delete;
+  exchange_process &operator=(const exchange_process &) = delete;
+
+  ~exchange_process() { stop(); }
+
+  bool ok() const noexcept {
+    return pid_ > 0 && shm_->exchange_up.load(std::memory_order_acquire) != 0;
+  }
+  gateway_rings<Size> &rings() const noexcept { return *shm_; }
+
+  // Stops and reaps the exchange; true if it exited cleanly. Idempotent.
+  bool stop() {
+    if (pid_ <= 0) {
+      return false;
+    }
+    shm_->stop.store(1, std::memory_order_release);
+    int wstatus = 0;
+    const bool reaped = ::waitpid(pid_, &wstatus, 0) == pid_;
+    pid_ = -1;
+    return reaped && WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0;
+  }
+
+  // What the exchange served; valid after stop().
+  std::uint64_t requests_served() const noexcept {
+    return shm_->requests_served.load(std::memory_order_relaxed);
+  }
+  std::uint64_t fills() const noexcept { return shm_->fills.load(std::memory_order_acquire); }
+
+private:
+  shared_memory<gateway_rings<Size>> shm_;
+  pid_t pid_ = -1;
+};
+
+/**
+ * The client end of the rings: sends requests, drains responses. Owns the producer of the
+ * request ring and the consumer of the response ring, so exactly one session per rings.
+ */
+template <std::size_t Size> class session {
+public:
+  explicit session(gateway_rings<Size> &rings) : rings_{rings} {}
+
+  // False (nothing sent) when the request ring is full.
+  bool send(const request &r) {
+    return out_.try_write(rings_.requests, std::as_bytes(std::span{&r, 1}));
+  }
+
+  // Hands every response waiting in the ring to on_response; returns how many there were.
+  template <class OnResponse> std::size_t poll(OnResponse &&on_response) {
+    std::size_t n = 0;
+    std::array<std::byte, sizeof(response)> buf;
+    while (in_.try_read(rings_.responses, buf)) {
+      response rsp;
+      std::memcpy(&rsp, buf.data(), sizeof(rsp));
+      on_response(rsp);
+      ++n;
+    }
+    return n;
+  }
+
+private:
+  gateway_rings<Size> &rings_;
+  fast_queue_spsc::producer out_;
+  fast_queue_spsc::consumer in_;
+};
+
+} // namespace exchange_sim
@@ -0,0 +1,271 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for exchange_sim.hpp. The tests check the matcher's responses on a
+// hand-written scenario (acks, fills on both sides in price-time order, IOC remainders, rejects
+// and cancels), then the same kind of exchange running in its own process behind the
+// shared-memory rings. The benchmark is run_latency's paced loop turned into a round trip: at
+// each tick the client sends an order that trades and waits for its fill, and reports the
+// tick-to-trade distribution measured from when the tick was due.
+//
+
+#pragma once
+
+#include "exchange_sim.hpp"
+#include "percentile.hpp"
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+namespace exchange_sim {
+
+// A shared-memory name no other run on the box is using.
+inline std::string shm_name(const char *what) {
+  return "/fq_exchange_sim_" + std::to_string(::getpid()) + "_" + what;
+}
+
+inline void test_matching() {
+  std::println("--- test_exchange_sim_matching ---");
+  matcher m{{.min_price = 0, .num_levels = 256, .max_orders = 16, .max_order_id = 64}};
+  std::vector<response> out;
+  auto send = [&](const request &r) {
+    out.clear();
+    m.on_request(r, [&](const response &rsp) { out.push_back(rsp); });
+  };
+  using enum response_type;
+
+  // Two asks at 100 in time order, one at 101.
+  send({1, 100, 10, 0, request_type::new_order, side::ask, time_in_force::day});
+  assert(out.size() == 1 && out[0].type == ack && out[0].leaves == 10);
+  send({2, 100, 5, 0, request_type::new_order, side::ask, time_in_force::day});
+  send({3, 101, 5, 0, request_type::new_order, side::ask, time_in_force::day});
+  assert(m.book().best_ask() == 100 && m.book().depth(side::ask, 100) == 15);
+
+  // A buy for 12 up to 101 takes order 1 whole, then 2 of order 2, both at 100.
+  send({4, 101, 12, 7, request_type::new_order, side::bid, time_in_force::ioc});
+  assert(out.size() == 5 && out[0].type == ack);
+  assert(out[1].type == fill && out[1].id == 4 && out[1].qty == 10 && out[1].leaves == 2);
+  assert(out[2].type == fill && out[2].id == 1 && out[2].price == 100 && out[2].leaves == 0);
+  assert(out[3].type == fill && out[3].id == 4 && out[3].qty == 2 && out[3].leaves == 0);
+  assert(out[4].type == fill && out[4].id == 2 && out[4].qty == 2 && out[4].leaves == 3);
+  assert(std::ranges::all_of(out, [](const response &r) { return r.send_ns == 7; }));
+  assert(m.book().depth(side::ask, 100) == 3 && !m.book().best_bid() && m.fills() == 2);
+
+  // An IOC for more than is there up to its limit: the rest comes back cancelled.
+  send({5, 100, 10, 0, request_type::new_order, side::bid, time_in_force::ioc});
+  assert(out.size() == 4 && out[3].type == cancelled && out[3].qty == 7 && out[3].leaves == 0);
+  assert(m.book().best_ask() == 101 && !m.book().best_bid());
+
+  // A day order that does not cross rests; a cancel takes it off.
+  send({6, 99, 4, 0, request_type::new_order, side::bid, time_in_force::day});
+  assert(out.size() == 1 && m.book().best_bid() == 99);
+  send({6, 0, 0, 0, request_type::cancel, side::bid, time_in_force::day});
+  assert(out.size() == 1 && out[0].type == cancelled && out[0].qty == 4 && !m.book().best_bid());
+
+  // Rejects carry the book's reason and leave it untouched.
+  send({3, 101, 1, 0, request_type::new_order, side::ask, time_in_force::day});
+  assert(out.size() == 1 && out[0].type == reject &&
+         out[0].reason == order_book::status::duplicate_order);
+  send({7, 100, 0, 0, request_type::new_order, side::bid, time_in_force::day});
+  assert(out[0].type == reject && out[0].reason == order_book::status::bad_quantity);
+  send({8, 0, 0, 0, request_type::cancel, side::bid, time_in_force::day});
+  assert(out[0].type == reject && out[0].reason == order_book::status::unknown_order);
+  assert(m.book().size() == 1 && m.book().depth(side::ask, 101) == 5 && m.requests() == 10);
+  std::println("test_exchange_sim_matching PASSED");
+}
+
+inline void test_round_trip_process() {
+  std::println("--- test_exchange_sim_round_trip_process ---");
+  constexpr std::size_t SIZE = std::size_t{1} << 12; // small: the 400 posts below wrap it
+  exchange_process<SIZE> exchange{shm_name("test"), {.spin = false}};
+  assert(exchange.ok());
+  session<SIZE> client{exchange.rings()};
+
+  // Rest 200 asks, then take them all with one IOC buy, then send a cancel for one of them.
+  std::vector<response> got;
+  auto collect = [&](const response &r) { got.push_back(r); };
+  auto send = [&](const request &r) {
+    while (!client.send(r)) {
+      client.poll(collect); // request ring full: the exchange may be waiting on us
+      std::this_thread::yield();
+    }
+  };
+  constexpr std::uint64_t N = 200;
+  for (std::uint64_t id = 1; id <= N; ++id) {
+    send({id, 100 + static_cast<price_t>(id % 4), 1, now_ns(), request_type::new_order,
+          side::ask, time_in_force::day});
+  }
+  send({N + 1, 200, 2 * N, now_ns(), request_type::new_order, side::bid, time_in_force::ioc});
+  send({1, 0, 0, now_ns(), request_type::cancel, side::ask, time_in_force::day});
+  const std::size_t expected = N + 1 + 2 * N + 1 + 1; // acks, fill pairs, IOC rest, reject
+  const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while (got.size() < expected && std::chrono::steady_clock::now() < give_up) {
+    if (client.poll(collect) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  assert(got.size() == expected);
+  assert(std::ranges::all_of(got.begin(), got.begin() + N + 1,
+                             [](const response &r) { return r.type == response_type::ack; }));
+  // Price priority across the levels, time priority within one: 4, 8, ..., then 1, 5, ...
+  [[maybe_unused]] price_t last_price = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    [[maybe_unused]] const response &taker = got[N + 1 + 2 * i];
+    const response &maker = got[N + 2 + 2 * i];
+    assert(taker.id == N + 1 && taker.type == response_type::fill && maker.price == taker.price);
+    assert(maker.id % 4 == static_cast<order_id>(maker.price - 100) && maker.price >= last_price);
+    last_price = maker.price;
+  }
+  assert(got[expected - 2].type == response_type::cancelled && got[expected - 2].qty == N);
+  assert(got.back().type == response_type::reject);
+  for ([[maybe_unused]] const response &r : got) {
+    assert(r.exchange_ns >= r.send_ns);
+  }
+  [[maybe_unused]] const bool stopped = exchange.stop();
+  assert(stopped);
+  assert(exchange.requests_served() == N + 2 && exchange.fills() == N);
+  std::println("test_exchange_sim_round_trip_process PASSED");
+}
+
+// Tick-to-trade through the exchange process. Ticks are scheduled at range(0) per second, as
+// run_latency schedules its messages. At each tick the client sends an IOC buy that crosses
+// the ask it keeps resting at the exchange, and waits for the buy's fill; then, off the clock,
+// it rests the next ask and collects that ack before the next tick.
+//  - p*_ns: fill received minus the tick's INTENDED time. The client is closed-loop (one order
+//    in flight), so a slow round trip delays the next ticks; measuring from the intended time
+//    charges that to them, as run_latency's corrected mode does (coordinated omission).
+//  - uncorrected_p99_ns: the same from the order's send stamp.
+//  - request_p50_ns / response_p50_ns: the two legs, split at the exchange's stamp.
+// With two CPUs or more the exchange process is pinned to the last one and the client to CPU 0,
+// and both busy-poll; on one CPU both yield when idle, or neither would let the other run.
+// Args: range(0) = ticks per second, range(1) = ticks per iteration.
+inline void BM_ExchangeTickToTrade(benchmark::State &state) {
+  constexpr std::size_t SIZE = std::size_t{1} << 16;
+  const auto rate = static_cast<std::int64_t>(state.range(0));
+  const auto n = static_cast<std::uint64_t>(state.range(1));
+  const unsigned cpus = std::thread::hardware_concurrency();
+  const bool own_core = cpus >= 2;
+  const exchange_config cfg{.cpu = own_core ? static_cast<int>(cpus - 1) : -1, .spin = own_core};
+  exchange_process<SIZE> exchange{shm_name("bench"), cfg};
+  if (!exchange.ok()) {
+    state.SkipWithError("could not start the exchange process");
+    return;
+  }
+
+  const std::int64_t period = 1'000'000'000 / rate;
+  constexpr price_t PX = 1000;
+  std::vector<std::int64_t> t2t;
+  std::vector<std::int64_t> uncorrected;
+  std::vector<std::int64_t> request_leg;
+  std::vector<std::int64_t> response_leg;
+  order_id next_id = 1;
+  // One session for the run: its producer and consumer carry the rings' positions.
+  session<SIZE> s{exchange.rings()};
+  for (auto _ : state) {
+    std::thread client([&] {
+      if (own_core) {
+        thread_placement::pin_current_thread(0);
+      }
+      auto idle = [&] {
+        if (own_core) {
+          fast_queue_spsc::spin_pause();
+        } else {
+          std::this_thread::yield();
+        }
+      };
+      // Sends `r` and polls until the response `done` accepts has arrived.
+      auto round_trip = [&](const request &r, auto &&done) {
+        while (!s.send(r)) {
+          idle();
+        }
+        bool seen = false;
+        while (!seen) {
+          if (s.poll([&](const response &rsp) { seen = seen || done(rsp); }) == 0) {
+            idle();
+          }
+        }
+      };
+      auto is_ack = [](const response &rsp) { return rsp.type == response_type::ack; };
+      // Ids are reused once their orders are gone; both kinds leave the book every tick.
+      auto take_id = [&] {
+        next_id = next_id + 1 < cfg.book.max_order_id ? next_id + 1 : 1;
+        return next_id;
+      };
+      round_trip({take_id(), PX, 1, now_ns(), request_type::new_order, side::ask,
+                  time_in_force::day},
+                 is_ack);
+      const std::int64_t t0 = now_ns();
+      for (std::uint64_t k = 0; k < n; ++k) {
+        const std::int64_t tick = t0 + period * static_cast<std::int64_t>(k);
+        while (now_ns() < tick) {
+          idle();
+        }
+        const order_id id = take_id();
+        round_trip({id, PX, 1, now_ns(), request_type::new_order, side::bid, time_in_force::ioc},
+                   [&](const response &rsp) {
+                     if (rsp.id != id || rsp.type != response_type::fill) {
+                       return false;
+                     }
+                     const std::int64_t recv = now_ns();
+                     t2t.push_back(recv - tick);
+                     uncorrected.push_back(recv - rsp.send_ns);
+                     request_leg.push_back(rsp.exchange_ns - rsp.send_ns);
+                     response_leg.push_back(recv - rsp.exchange_ns);
+                     return true;
+                   });
+        round_trip({take_id(), PX, 1, now_ns(), request_type::new_order, side::ask,
+                    time_in_force::day},
+                   is_ack);
+      }
+    });
+    client.join();
+  }
+
+  std::ranges::sort(t2t);
+  std::ranges::sort(uncorrected);
+  std::ranges::sort(request_leg);
+  std::ranges::sort(response_leg);
+  const std::int64_t p50 = percentile::nearest_rank(t2t, 0.50);
+  const std::int64_t p99 = percentile::nearest_rank(t2t, 0.99);
+  const std::int64_t p999 = percentile::nearest_rank(t2t, 0.999);
+  const std::int64_t uncorrected_p99 = percentile::nearest_rank(uncorrected, 0.99);
+  state.counters["p50_ns"] = static_cast<double>(p50);
+  state.counters["p99_ns"] = static_cast<double>(p99);
+  state.counters["p99.9_ns"] = static_cast<double>(p999);
+  state.counters["max_ns"] = t2t.empty() ? 0.0 : static_cast<double>(t2t.back());
+  state.counters["uncorrected_p99_ns"] = static_cast<double>(uncorrected_p99);
+  state.counters["request_p50_ns"] =
+      static_cast<double>(percentile::nearest_rank(request_leg, 0.50));
+  state.counters["response_p50_ns"] =
+      static_cast<double>(percentile::nearest_rank(response_leg, 0.50));
+  state.SetItemsProcessed(static_cast<std::int64_t>(t2t.size()));
+  state.SetLabel(own_core ? "pinned" : "shared cpu");
+  std::println("tick-to-trade at {} ticks/s | p50 {} ns | p99 {} ns | p99.9 {} ns | "
+               "p99 from send stamp {} ns | samples {}",
+               rate, p50, p99, p999, uncorrected_p99, t2t.size());
+}
+
+inline void test() {
+  test_matching();
+  test_round_trip_process();
+  BENCHMARK(BM_ExchangeTickToTrade)
+      ->UseRealTime()
+      ->Iterations(3)
+      ->ArgsProduct({{10'000, 50'000}, {20'000}})
+      ->ArgNames({"rate", "N"});
+}
+
+} // namespace exchange_sim
@@ -83,6 +83,9 @@
 
 #pragma once
 
+#include "flight_recorder.hpp"
+#include "interleaving.hpp"
+
 #include <algorithm>
 #include <array>
 #include <atomic>
@@ -96,7 +99,7 @@
 #include <span>
 
 // Kept inside the namespace (below) so this header can coexist in one TU with
-// fast_queue_SPSC.hpp, which defines a CACHE_LINE_SIZE of its own at global scope.
+// cache_line.hpp, which defines a CACHE_LINE_SIZE of its own at global scope.
 namespace fast_queue_spmc {
 
 #if defined(__cpp_lib_hardware_interference_size)
@@ -134,12 +137,14 @@ inline void spin_pause() noexcept {
  * Every counter sits on its own cache line. The producer overwrites only up to
  * min(read_counter[*]); until then a slot is still owned by at least one consumer.
  */
-template <std::size_t Size, std::size_t NConsumers> struct spmc_queue_t {
+template <std::size_t Size, std::size_t NConsumers, class Sched = interleaving::none>
+struct spmc_queue_t {
   static_assert((Size & (Size - 1)) == 0, "queue size must be a power of two");
   static_assert(NConsumers >= 1, "need at least one consumer");
   static constexpr std::size_t SIZE = Size;
   static constexpr std::uint64_t MASK = Size - 1;
   static constexpr std::size_t N = NConsumers;
+  using schedule_policy = Sched; // points before shared accesses, as in fast_queue_t
 
   // One cache line per counter so no two writers (or the producer's N-way scan) share a
   // line. padded_counter wraps the atomic so the array elements are individually aligned.
@@ -173,6 +178,13 @@ inline void ring_read(const Q &fq, std::uint64_t counter, std::byte *dst, std::s
   }
 }
 
+template <class Q> inline void ring_prefetch(const Q &fq, std::uint64_t counter, std::size_t n) {
+  for (std::uint64_t line = counter & ~std::uint64_t{CACHE_LINE_SIZE - 1}; line < counter + n;
+       line += CACHE_LINE_SIZE) {
+    __builtin_prefetch(fq.buffer.data() + (line & Q::MASK), 0, 3);
+  }
+}
+
 struct producer {
   /**
    * Write one message, visible to ALL consumers. Returns false (nothing written) when the
@@ -192,18 +204,32 @@ struct producer {
       cached_min_read = load_min_read(fq);
       bytes_in_flight = write_counter - cached_min_read;
       if (bytes_in_flight + record_size > Q::SIZE) {
+        if constexpr (flight_recorder::enabled) {
+          if (!stall_recorded) { // once per stall, not once per retry
+            flight_recorder::record(flight_recorder::event::full_stall,
+                                    static_cast<std::uint32_t>(record_size));
+            stall_recorded = true;
+          }
+        }
         return false; // slowest consumer still behind -> genuinely full
       }
     }
 
     // Write once; every consumer will read these same bytes (read-shared, cheap fan-out).
+    Q::schedule_policy::point(interleaving::site::ring_access);
     ring_write(fq, write_counter, reinterpret_cast<const std::byte *>(&payload_size),
                sizeof(payload_size));
     ring_write(fq, write_counter + sizeof(payload_size), payload.data(), payload.size());
 
     write_counter += record_size;
     // Publish once: release pairs with each consumer's acquire load of write_counter.
+    Q::schedule_policy::point(interleaving::site::publish_head);
     fq.write_counter.store(write_counter, std::memory_order_release);
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::write,
+                              static_cast<std::uint32_t>(record_size));
+      stall_recorded = false;
+    }
     return true;
   }
 
@@ -213,6 +239,7 @@ struct producer {
   template <class Q> static std::uint64_t load_min_read(const Q &fq) {
     std::uint64_t m = std::numeric_limits<std::uint64_t>::max();
     for (const auto &rc : fq.read_counter) {
+      Q::schedule_policy::point(interleaving::site::load_tail);
       m = std::min(m, rc.value.load(std::memory_order_acquire));
     }
     return m;
@@ -220,6 +247,7 @@ struct producer {
 
   std::uint64_t write_counter{0};   // private copy of the head (producer is sole writer)
   std::uint64_t cached_min_read{0}; // last observed min() of the consumer tails
+  bool stall_recorded{false};       // flight recorder: the current full stall is already logged
 };
 
 /**
@@ -257,8 +285,15 @@ struct consumer {
     assert(pending_record == 0 && "an uncommitted zero-copy view is still outstanding");
     // Empty check for this consumer: cached head first, refresh only when it looks empty.
     if (read_counter == cached_write) {
+      Q::schedule_policy::point(interleaving::site::load_head);
       cached_write = fq.write_counter.load(std::memory_order_acquire);
       if (read_counter == cached_write) {
+        if constexpr (flight_recorder::enabled) {
+          if (!idle_recorded) { // once per idle spell, not once per poll
+            flight_recorder::record(flight_recorder::event::wait_park, 0, trace_source());
+            idle_recorded = true;
+          }
+        }
         return std::nullopt; // this consumer has read everything published so far
       }
     }
@@ -271,10 +306,15 @@ struct consumer {
     // slot mid-read. The lossless gate below makes all of that unnecessary.
 
     header_t payload_size{};
+    Q::schedule_policy::point(interleaving::site::ring_access);
     ring_read(fq, read_counter, reinterpret_cast<std::byte *>(&payload_size), sizeof(payload_size));
     assert(payload_size >= 0 && static_cast<std::size_t>(payload_size) <= out.size() &&
            "output buffer isn't large enough for the message");
+    if (prefetch_depth != 0) {
+      prefetch_after(fq, read_counter + sizeof(header_t) + static_cast<std::size_t>(payload_size));
+    }
 
+    Q::schedule_policy::point(interleaving::site::ring_access);
     ring_read(fq, read_counter + sizeof(payload_size), out.data(),
               static_cast<std::size_t>(payload_size));
 
@@ -282,7 +322,13 @@ struct consumer {
     read_counter += record_size;
     // Publish this consumer's progress. Once ALL consumers pass a byte, the producer's
     // min() gate lets it reuse that space.
+    Q::schedule_policy::point(interleaving::site::publish_tail);
     fq.read_counter[id].value.store(read_counter, std::memory_order_release);
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::read,
+                              static_cast<std::uint32_t>(payload_size), trace_source());
+      idle_recorded = false;
+    }
     return static_cast<std::size_t>(payload_size);
   }
 
@@ -301,15 +347,26 @@ struct consumer {
   template <class Q> std::optional<read_view> try_read_view(Q &fq) {
     assert(pending_record == 0 && "previous try_read_view was not committed");
     if (read_counter == cached_write) {
+      Q::schedule_policy::point(interleaving::site::load_head);
       cached_write = fq.write_counter.load(std::memory_order_acquire);
       if (read_counter == cached_write) {
+        if constexpr (flight_recorder::enabled) {
+          if (!idle_recorded) { // once per idle spell, not once per poll
+            flight_recorder::record(flight_recorder::event::wait_park, 0, trace_source());
+            idle_recorded = true;
+          }
+        }
         return std::nullopt; // this consumer has read everything published so far
       }
     }
 
     header_t payload_size{};
+    Q::schedule_policy::point(interleaving::site::ring_access);
     ring_read(fq, read_counter, reinterpret_cast<std::byte *>(&payload_size), sizeof(payload_size));
     assert(payload_size >= 0);
+    if (prefetch_depth != 0) {
+      prefetch_after(fq, read_counter + sizeof(header_t) + static_cast<std::size_t>(payload_size));
+    }
 
     // Expose the payload in place, splitting into (at most) two pieces if it wraps the end.
     const std::uint64_t payload_start = read_counter + sizeof(header_t);
@@ -326,6 +383,11 @@ struct consumer {
     // Remember the record size but DON'T advance/publish yet: the producer's min() gate keeps
     // this consumer's peeked bytes alive only while this tail has not moved past them.
     pending_record = sizeof(header_t) + plen;
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::read_view,
+                              static_cast<std::uint32_t>(plen), trace_source());
+      idle_recorded = false;
+    }
     return v;
   }
 
@@ -335,15 +397,51 @@ struct consumer {
    */
   template <class Q> void commit_read(Q &fq) {
     assert(pending_record != 0 && "commit_read without a matching try_read_view");
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::view_commit,
+                              static_cast<std::uint32_t>(pending_record), trace_source());
+    }
     read_counter += pending_record;
     pending_record = 0;
+    Q::schedule_policy::point(interleaving::site::publish_tail);
     fq.read_counter[id].value.store(read_counter, std::memory_order_release);
   }
 
-  std::size_t id;                // which read_counter slot this consumer owns (0..N-1)
-  std::uint64_t read_counter{0}; // this consumer's private tail
-  std::uint64_t cached_write{0}; // last observed head (producer progress)
-  std::size_t pending_record{0}; // size of a peeked-but-not-committed record (0 = none)
+  /**
+   * Software prefetch of the prefetch_depth records after the one being read, walked once from
+   * prefetch_cursor up to this consumer's cached head - as in the SPSC consumer. The lines are
+   * requested into THIS consumer's cache; the others prefetch (or miss) on their own.
+   */
+  template <class Q> void prefetch_after(const Q &fq, std::uint64_t record_end) {
+    if (prefetch_cursor > read_counter) {
+      --prefetch_queued; // the record being read was the oldest one prefetched
+    } else {
+      prefetch_cursor = record_end;
+      prefetch_queued = 0;
+    }
+    while (prefetch_queued < prefetch_depth && prefetch_cursor < cached_write) {
+      header_t payload_size{};
+      Q::schedule_policy::point(interleaving::site::ring_access);
+      ring_read(fq, prefetch_cursor, reinterpret_cast<std::byte *>(&payload_size),
+                sizeof(payload_size));
+      const std::size_t record_size = sizeof(header_t) + static_cast<std::size_t>(payload_size);
+      ring_prefetch(fq, prefetch_cursor, record_size + sizeof(header_t));
+      prefetch_cursor += record_size;
+      ++prefetch_queued;
+    }
+  }
+
+  // This consumer's tag in the flight recorder (see flight_recorder.hpp).
+  std::uint8_t trace_source() const noexcept { return static_cast<std::uint8_t>(id); }
+
+  std::size_t id;                   // which read_counter slot this consumer owns (0..N-1)
+  std::uint64_t read_counter{0};    // this consumer's private tail
+  std::uint64_t cached_write{0};    // last observed head (producer progress)
+  std::size_t pending_record{0};    // size of a peeked-but-not-committed record (0 = none)
+  std::size_t prefetch_depth{0};    // K: records to prefetch ahead of the read (0 = off)
+  std::uint64_t prefetch_cursor{0}; // start of the first record not yet prefetched
+  std::size_t prefetch_queued{0};   // records prefetched ahead, up to prefetch_depth
+  bool idle_recorded{false};        // flight recorder: the current empty spell is already logged
 };
 
 } // namespace fast_queue_spmc
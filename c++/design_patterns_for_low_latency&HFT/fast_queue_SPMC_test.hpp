@@ -11,6 +11,7 @@
 #pragma once
 
 #include "fast_queue_SPMC.hpp"
+#include "thread_placement.hpp"
 
 #include <array>
 #include <atomic>
@@ -22,6 +23,7 @@
 #include <memory>
 #include <print>
 #include <span>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -103,17 +105,77 @@ inline void test_broadcast_zero_copy() {
                NC, N);
 }
 
+// --- Correctness demo: consumer prefetch ---------------------------------------------------
+// Single-threaded: bursts fill the small ring, then consumer 0 (prefetching 3 records ahead,
+// copy reads) and consumer 1 (no prefetch, zero-copy reads) each drain part of it. Both must
+// see the same stream, and the prefetch cursor never passes the published head.
+inline void test_broadcast_prefetch() {
+  std::println("--- test_broadcast_prefetch ---");
+  auto fq_ptr = std::make_unique<spmc_queue_t<QUEUE_SIZE, 2>>();
+  auto &fq = *fq_ptr;
+  producer prod;
+  consumer fast{0};
+  consumer plain{1};
+  fast.prefetch_depth = 3;
+  const auto size_of = [](std::uint64_t seq) { return sizeof(seq) + seq * 11 % 120; };
+  std::array<std::byte, 128> in{};
+  std::array<std::byte, 128> out{};
+  std::uint64_t written = 0;
+  std::array<std::uint64_t, 2> read{};
+  for (int round = 0; round < 2'000; ++round) {
+    for (;;) {
+      std::memcpy(in.data(), &written, sizeof(written));
+      if (!prod.try_write(fq, std::span<const std::byte>{in.data(), size_of(written)})) {
+        break;
+      }
+      ++written;
+    }
+    const std::uint64_t want = round % 4 == 0 ? written : written - 3;
+    while (read[0] < want) {
+      [[maybe_unused]] const auto got = fast.try_read(fq, out);
+      std::uint64_t seq{};
+      std::memcpy(&seq, out.data(), sizeof(seq));
+      assert(got == size_of(read[0]) && seq == read[0]);
+      assert(fast.prefetch_cursor <= fq.write_counter.load(std::memory_order_relaxed));
+      ++read[0];
+    }
+    while (read[1] < want) {
+      const auto v = plain.try_read_view(fq);
+      assert(v && v->size() == size_of(read[1]));
+      std::array<std::byte, sizeof(std::uint64_t)> head{};
+      const std::size_t k = std::min(head.size(), v->first.size());
+      std::memcpy(head.data(), v->first.data(), k);
+      std::memcpy(head.data() + k, v->second.data(), head.size() - k);
+      [[maybe_unused]] std::uint64_t seq{};
+      std::memcpy(&seq, head.data(), sizeof(seq));
+      assert(seq == read[1]);
+      plain.commit_read(fq);
+      ++read[1];
+    }
+  }
+  std::println("test_broadcast_prefetch PASSED ({} messages to both consumers)", written);
+}
+
 // --- Broadcast throughput benchmark -------------------------------------------------------
 // One producer fans N messages out to NC consumers (each reads all N). We measure the queue's
 // raw read/write speed only - the consumer just reads (copy or zero-copy), no decode/process.
 // ZeroCopy selects try_read_view/commit_read vs try_read; BusySpin selects the wait strategy.
 // Manual timing brackets only the pump (spawn/join and payload build excluded).
+// Args: range(0) = N, range(1) = thread_placement::topology, range(2) = SCHED_FIFO priority.
+// The producer is placement thread 0 and consumer c is thread c + 1, so e.g. cross_socket puts
+// all NC consumers on the other socket and same_core time-slices all NC + 1 threads on one CPU.
 template <class Queue, bool BusySpin, bool ZeroCopy>
 inline void run_broadcast(benchmark::State &state) {
   const auto N = static_cast<std::uint64_t>(state.range(0));
   constexpr std::size_t NC = Queue::N;
   constexpr std::size_t MAX_MSG = 64;
 
+  const auto plan = thread_placement::plan_from_benchmark(state, NC + 1);
+  if (!plan) {
+    return;
+  }
+  std::atomic<std::uint64_t> placement_failures{0};
+
   auto pause = [] {
     if constexpr (BusySpin) {
       spin_pause();
@@ -149,6 +211,9 @@ inline void run_broadcast(benchmark::State &state) {
     consumers.reserve(NC);
     for (std::size_t c = 0; c < NC; ++c) {
       consumers.emplace_back([&, c] {
+        if (!thread_placement::apply(plan->threads[c + 1])) {
+          placement_failures.fetch_add(1, std::memory_order_relaxed);
+        }
         consumer cons{c};
         std::array<std::byte, MAX_MSG> out{}; // used by the copy path only
         std::uint64_t got = 0;
@@ -183,6 +248,9 @@ inline void run_broadcast(benchmark::State &state) {
     }
 
     std::thread producer_thread([&] {
+      if (!thread_placement::apply(plan->threads[0])) {
+        placement_failures.fetch_add(1, std::memory_order_relaxed);
+      }
       while (!go.load(std::memory_order_acquire)) {
         pause();
       }
@@ -213,6 +281,12 @@ inline void run_broadcast(benchmark::State &state) {
   std::println("broadcast {} msgs/iteration to {} consumers (read/write speed only); producer hit "
                "a full queue {} times on the last iteration",
                N, NC, last_fulls);
+  const auto failures = placement_failures.load(std::memory_order_relaxed);
+  std::println("placement: {}", plan->describe());
+  if (failures != 0) {
+    state.counters["placement_failures"] = static_cast<double>(failures);
+    std::println("WARNING: {} thread(s) failed to apply the placement", failures);
+  }
 }
 
 // Large ring, busy-spin, 3 consumers - copy read path.
@@ -254,16 +328,33 @@ inline void test_broadcast_back_pressure_zero_copy(benchmark::State &state) {
 // (called after this in main), so these benchmarks run in the same pass as the SPSC ones.
 inline void test() {
   test_broadcast_zero_copy();
-  // Arg(N) = messages broadcast per iteration. Add more ->Arg()s to sweep N.
+  test_broadcast_prefetch();
+  // Args = {N messages broadcast per iteration, placement topology, SCHED_FIFO priority}, swept
+  // over thread_placement::queue_topologies (see fast_queue_spsc::test()).
+  const std::vector<std::string> names{"N", "placement", "fifo"};
+  const auto placements = thread_placement::topology_args(thread_placement::queue_topologies);
   // Large decoupled ring (producer/fan-out-bound):
-  BENCHMARK(test_broadcast_optimized)->UseManualTime()->Iterations(1)->Arg(100'000'000);
-  BENCHMARK(test_broadcast_optimized_zero_copy)->UseManualTime()->Iterations(1)->Arg(100'000'000);
+  BENCHMARK(test_broadcast_optimized)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_broadcast_optimized_zero_copy)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000'000}, placements, {0}})
+      ->ArgNames(names);
   // Small contended ring (consumer-bound via the min() gate); smaller N since it's slower:
-  BENCHMARK(test_broadcast_back_pressure)->UseManualTime()->Iterations(1)->Arg(10'000'000);
+  BENCHMARK(test_broadcast_back_pressure)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{10'000'000}, placements, {0}})
+      ->ArgNames(names);
   BENCHMARK(test_broadcast_back_pressure_zero_copy)
       ->UseManualTime()
       ->Iterations(1)
-      ->Arg(10'000'000);
+      ->ArgsProduct({{10'000'000}, placements, {0}})
+      ->ArgNames(names);
 }
 
 } // namespace fast_queue_spmc
@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include "cache_line.hpp"
+#include "flight_recorder.hpp"
+#include "interleaving.hpp"
+#include "record_header.hpp"
+#include "small_copy.hpp"
+
 #include <algorithm>
 #include <array>
 #include <atomic>
@@ -15,15 +21,6 @@
 #include <span>
 #include <version>
 
-#if defined(__cpp_lib_hardware_interference_size)
-#include <new>
-inline constexpr std::size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
-#elif defined(__aarch64__) && defined(__APPLE__)
-inline constexpr std::size_t CACHE_LINE_SIZE = 128; // Apple Silicon
-#else
-inline constexpr std::size_t CACHE_LINE_SIZE = 64; // safe default
-#endif
-
 namespace fast_queue_spsc {
 
 // The ring capacity must be a power of two so a monotonically increasing byte
@@ -38,7 +35,8 @@ static_assert((QUEUE_SIZE & (QUEUE_SIZE - 1)) == 0, "QUEUE_SIZE must be a power
 // stalls vanish and throughput reflects the raw data-movement cost.
 constexpr std::size_t LARGE_QUEUE_SIZE = std::size_t{1} << 20;
 
-// Each message record is: [int32 length][payload bytes].
+// Each message record is, by default (record_header::int32_length): [int32 length][payload
+// bytes]. Code that reads that format directly (replay, the journal) uses header_t.
 using header_t = std::int32_t;
 
 /**
@@ -58,11 +56,30 @@ using header_t = std::int32_t;
  * Because fullness/emptiness are distinguished by the counter *difference* (not
  * by offset equality), the whole buffer can be used - there is no wasted slot.
  * The physical position of a counter in the buffer is (counter & MASK).
+ *
+ * `Copy` is how ring_write / ring_read move the bytes of a record that does not wrap:
+ * small_copy::libc (std::memcpy) or small_copy::simd (inline size-class kernels for short
+ * records, see small_copy.hpp). It changes nothing about the layout or the protocol.
+ *
+ * `Header` is how each record is framed: the int32 length by default, or a varint length, a
+ * 16-bit length plus a 16-bit type, no header for fixed-size records, and optionally a
+ * CRC32C trailer (see record_header.hpp). Producer and consumer must of course agree, which
+ * they do by construction: both take it from the queue type.
+ *
+ * `Sched` gets a call before every access to shared state (each counter load or store, each
+ * group of ring copies). The default, interleaving::none, does nothing; the interleaving tests
+ * use interleaving::controlled to choose the order of the producer's and consumer's steps
+ * (see interleaving.hpp).
  */
-template <std::size_t Size> struct fast_queue_t {
+template <std::size_t Size, class Copy = small_copy::libc,
+          class Header = record_header::int32_length, class Sched = interleaving::none>
+struct fast_queue_t {
   static_assert((Size & (Size - 1)) == 0, "queue size must be a power of two");
   static constexpr std::size_t SIZE = Size;
   static constexpr std::uint64_t MASK = Size - 1;
+  using copy_policy = Copy;
+  using header_policy = Header;
+  using schedule_policy = Sched;
 
   alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> read_counter{0};
   alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> write_counter{0};
@@ -92,9 +109,10 @@ inline void ring_write(Q &fq, std::uint64_t counter, const std::byte *src, std::
   // Common path: the whole record fits before the physical end, so the copy uses
   // the FULL (compile-time-constant, at each call site) size `n` — clang folds it
   // to direct loads/stores. The wrapping split is the rare branch. (Mirrors the
-  // ulang fast_queue restructure for an apples-to-apples comparison.)
+  // ulang fast_queue restructure for an apples-to-apples comparison.) The payload's
+  // `n` is only known at run time; Q::copy_policy decides how that copy is done.
   if (index + n <= Q::SIZE) {
-    std::memcpy(fq.buffer.data() + index, src, n);
+    Q::copy_policy::copy(fq.buffer.data() + index, src, n);
   } else { // the record straddles the end -> split at the physical boundary
     const std::size_t first = Q::SIZE - index;
     std::memcpy(fq.buffer.data() + index, src, first);
@@ -108,9 +126,10 @@ template <class Q>
 inline void ring_read(const Q &fq, std::uint64_t counter, std::byte *dst, std::size_t n) {
   const auto index = static_cast<std::size_t>(counter & Q::MASK);
   // Common path: constant-size copy (see ring_write) so clang folds it to direct
-  // loads/stores; the wrapping split is the rare branch.
+  // loads/stores; the wrapping split is the rare branch. Runtime lengths go through
+  // Q::copy_policy.
   if (index + n <= Q::SIZE) {
-    std::memcpy(dst, fq.buffer.data() + index, n);
+    Q::copy_policy::copy(dst, fq.buffer.data() + index, n);
   } else {
     const std::size_t first = Q::SIZE - index;
     std::memcpy(dst, fq.buffer.data() + index, first);
@@ -118,15 +137,56 @@ inline void ring_read(const Q &fq, std::uint64_t counter, std::byte *dst, std::s
   }
 }
 
+// CRC32C of the n ring bytes starting at `counter`, continuing across the physical end.
+template <class Q>
+inline std::uint32_t ring_crc32c(const Q &fq, std::uint64_t counter, std::size_t n) {
+  const auto index = static_cast<std::size_t>(counter & Q::MASK);
+  const std::size_t first = std::min(n, Q::SIZE - index);
+  const std::uint32_t crc = record_header::crc32c_update(0, fq.buffer.data() + index, first);
+  return n > first ? record_header::crc32c_update(crc, fq.buffer.data(), n - first) : crc;
+}
+
+// Prefetch (for reading) every cache line of the n ring bytes starting at `counter`, wrapping
+// around the end. A hint only: it never faults and never blocks.
+template <class Q> inline void ring_prefetch(const Q &fq, std::uint64_t counter, std::size_t n) {
+  for (std::uint64_t line = counter & ~std::uint64_t{CACHE_LINE_SIZE - 1}; line < counter + n;
+       line += CACHE_LINE_SIZE) {
+    __builtin_prefetch(fq.buffer.data() + (line & Q::MASK), 0, 3);
+  }
+}
+
+/**
+ * A writable, in-place window onto the ring for one record being built by the zero-copy
+ * write path (`producer::try_reserve`). The producer fills the payload directly in the ring
+ * instead of building it elsewhere and copying it in.
+ *
+ * Like `read_view`, the window may straddle the physical end of the buffer and then comes
+ * in two pieces: `first`, then `second` at the buffer's start. Nothing is visible to the
+ * consumer until `producer::commit_write` publishes it.
+ */
+struct write_view {
+  std::span<std::byte> first;
+  std::span<std::byte> second;
+
+  std::size_t size() const noexcept { return first.size() + second.size(); }
+  bool wrapped() const noexcept { return !second.empty(); }
+};
+
 struct producer {
   /**
    * Try to write one message. Returns false (nothing written) when the queue
    * does not have room for the whole record - this is the limit check that
    * gives us back-pressure and guarantees the consumer never loses data.
+   * `type` is recorded by headers that have a type field and ignored by the others.
    */
-  template <class Q> bool try_write(Q &fq, std::span<const std::byte> payload) {
-    const auto payload_size = static_cast<header_t>(payload.size());
-    const std::size_t record_size = sizeof(header_t) + payload_size;
+  template <class Q>
+  bool try_write(Q &fq, std::span<const std::byte> payload, std::uint16_t type = 0) {
+    using H = typename Q::header_policy;
+    assert(pending_payload == 0 && "an uncommitted reservation is still outstanding");
+    assert(record_header::fits<H>(payload.size()) && "payload does not fit the record header");
+    const std::size_t header_size = H::bytes(payload.size());
+    const std::size_t record_size =
+        header_size + payload.size() + record_header::trailer_bytes<H>;
     assert(record_size <= Q::SIZE && "message larger than the whole queue");
 
     // Check the free space against the limit. First use the cached tail to
@@ -134,29 +194,151 @@ struct producer {
     // the shared counter if that suggests we might be full.
     std::uint64_t bytes_available_to_read = write_counter - read_counter;
     if (bytes_available_to_read + record_size > Q::SIZE) {
+      Q::schedule_policy::point(interleaving::site::load_tail);
       read_counter = fq.read_counter.load(std::memory_order_acquire);
       bytes_available_to_read = write_counter - read_counter;
       if (bytes_available_to_read + record_size > Q::SIZE) {
+        if constexpr (flight_recorder::enabled) {
+          if (!stall_recorded) { // once per stall, not once per retry
+            flight_recorder::record(flight_recorder::event::full_stall,
+                                    static_cast<std::uint32_t>(record_size));
+            stall_recorded = true;
+          }
+        }
         return false; // genuinely full
       }
     }
 
-    // Write the message: payload size prefix followed by the payload. Both copies go
-    // through ring_write so a record that reaches the end of the buffer wraps around
-    // to the beginning.
-    ring_write(fq, write_counter, reinterpret_cast<const std::byte *>(&payload_size),
-               sizeof(payload_size));
-    ring_write(fq, write_counter + sizeof(payload_size), payload.data(), payload.size());
+    // Write the message: header, payload and (if the policy has one) checksum trailer. All
+    // copies go through ring_write so a record that reaches the end of the buffer wraps
+    // around to the beginning.
+    Q::schedule_policy::point(interleaving::site::ring_access);
+    if constexpr (H::max_bytes != 0) {
+      std::array<std::byte, H::max_bytes> header;
+      H::encode(header.data(), header_size, payload.size(), type);
+      ring_write(fq, write_counter, header.data(), header_size);
+    }
+    ring_write(fq, write_counter + header_size, payload.data(), payload.size());
+    if constexpr (H::checksum) {
+      const std::uint32_t crc = record_header::crc32c_update(0, payload.data(), payload.size());
+      ring_write(fq, write_counter + header_size + payload.size(),
+                 reinterpret_cast<const std::byte *>(&crc), sizeof(crc));
+    }
 
     write_counter += record_size;
     // Publish: everything up to write_counter is now safe for the consumer to
     // read. release pairs with the consumer's acquire load.
+    Q::schedule_policy::point(interleaving::site::publish_head);
     fq.write_counter.store(write_counter, std::memory_order_release);
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::write,
+                              static_cast<std::uint32_t>(record_size));
+      stall_recorded = false;
+    }
     return true;
   }
 
+  /**
+   * Zero-copy write. Reserves room for a record of up to `payload_size` bytes and returns a
+   * `write_view` of its payload IN the ring, or std::nullopt when the queue is full (same
+   * limit check as try_write). This is a two-phase API: fill the view, then call
+   * commit_write() to publish it. Exactly one commit_write() must follow each successful
+   * try_reserve(), and nothing else may be written in between.
+   *
+   * The reservation is an upper bound: commit_write(fq, used) may publish fewer bytes (e.g.
+   * a datagram shorter than the maximum), and the unused tail is simply not consumed.
+   */
+  template <class Q> std::optional<write_view> try_reserve(Q &fq, std::size_t payload_size) {
+    using H = typename Q::header_policy;
+    assert(pending_payload == 0 && "previous try_reserve was not committed");
+    assert(record_header::fits<H>(payload_size) && "payload does not fit the record header");
+    // The header is sized for the reserved length; a shorter commit still uses this size.
+    const std::size_t header_size = H::bytes(payload_size);
+    const std::size_t record_size = header_size + payload_size + record_header::trailer_bytes<H>;
+    assert(record_size <= Q::SIZE && "message larger than the whole queue");
+
+    // Same cached-first / refresh-on-demand limit check as try_write.
+    std::uint64_t bytes_available_to_read = write_counter - read_counter;
+    if (bytes_available_to_read + record_size > Q::SIZE) {
+      Q::schedule_policy::point(interleaving::site::load_tail);
+      read_counter = fq.read_counter.load(std::memory_order_acquire);
+      bytes_available_to_read = write_counter - read_counter;
+      if (bytes_available_to_read + record_size > Q::SIZE) {
+        if constexpr (flight_recorder::enabled) {
+          if (!stall_recorded) { // once per stall, not once per retry
+            flight_recorder::record(flight_recorder::event::full_stall,
+                                    static_cast<std::uint32_t>(record_size));
+            stall_recorded = true;
+          }
+        }
+        return std::nullopt; // genuinely full
+      }
+    }
+
+    // Expose the payload in place, splitting into (at most) two pieces if it wraps the end.
+    // The header is written at commit time, once the final length is known.
+    const std::uint64_t payload_start = write_counter + header_size;
+    const auto index = static_cast<std::size_t>(payload_start & Q::MASK);
+    const std::size_t first_len = std::min(payload_size, Q::SIZE - index);
+
+    write_view v{};
+    v.first = std::span<std::byte>{fq.buffer.data() + index, first_len};
+    if (payload_size > first_len) { // straddles the end -> second piece at the buffer start
+      v.second = std::span<std::byte>{fq.buffer.data(), payload_size - first_len};
+    }
+    pending_payload = payload_size;
+    pending_header = header_size;
+    return v;
+  }
+
+  /**
+   * Publish the record reserved by the last try_reserve with `used` payload bytes (at most
+   * the reserved size). Must be called exactly once after a successful try_reserve().
+   */
+  template <class Q> void commit_write(Q &fq, std::size_t used, std::uint16_t type = 0) {
+    using H = typename Q::header_policy;
+    assert(used <= pending_payload && "committing more than was reserved");
+    assert(record_header::fits<H>(used) && "payload does not fit the record header");
+    Q::schedule_policy::point(interleaving::site::ring_access);
+    if constexpr (H::max_bytes != 0) {
+      std::array<std::byte, H::max_bytes> header;
+      H::encode(header.data(), pending_header, used, type);
+      ring_write(fq, write_counter, header.data(), pending_header);
+    }
+    if constexpr (H::checksum) {
+      const std::uint64_t payload_start = write_counter + pending_header;
+      const std::uint32_t crc = ring_crc32c(fq, payload_start, used);
+      ring_write(fq, payload_start + used, reinterpret_cast<const std::byte *>(&crc), sizeof(crc));
+    }
+    const std::size_t record_size = pending_header + used + record_header::trailer_bytes<H>;
+    write_counter += record_size;
+    pending_payload = 0;
+    // Publish: header and payload are both in place. release pairs with the consumer's acquire.
+    Q::schedule_policy::point(interleaving::site::publish_head);
+    fq.write_counter.store(write_counter, std::memory_order_release);
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::write,
+                              static_cast<std::uint32_t>(record_size));
+      stall_recorded = false;
+    }
+  }
+
+  // Publish the whole reservation.
+  template <class Q> void commit_write(Q &fq) { commit_write(fq, pending_payload); }
+
+  /**
+   * Drop the reservation made by the last try_reserve without publishing anything. The bytes
+   * written into the view stay in free space the consumer never reads, so a reserve / fill /
+   * cancel round is a dry run of the write path: it touches the same slots and code as a real
+   * write and leaves the queue exactly as it was (see warmup.hpp).
+   */
+  void cancel_reserve() noexcept { pending_payload = 0; }
+
   std::uint64_t write_counter{0}; // private copy of the head
   std::uint64_t read_counter{0};  // last observed tail (consumer progress)
+  std::size_t pending_payload{0}; // size of a reserved-but-not-committed payload (0 = none)
+  std::size_t pending_header{0};  // header size fixed by that reservation
+  bool stall_recorded{false};     // flight recorder: the current full stall is already logged
 };
 
 /**
@@ -181,31 +363,64 @@ struct read_view {
 struct consumer {
   /**
    * Try to read one message into `out`. Returns the number of payload bytes
-   * read, or std::nullopt when the queue is empty.
+   * read, or std::nullopt when the queue is empty. With a checksumming header a record
+   * that fails its CRC is skipped (and counted in checksum_failures), never returned.
    */
   template <class Q> std::optional<std::size_t> try_read(Q &fq, std::span<std::byte> out) {
+    using H = typename Q::header_policy;
     assert(pending_record == 0 && "an uncommitted zero-copy view is still outstanding");
-    // Empty check. Use the cached head first, refresh only when it looks empty.
-    if (read_counter == write_counter) {
-      write_counter = fq.write_counter.load(std::memory_order_acquire);
+    for (;;) { // loops only past a record that fails its checksum
+      // Empty check. Use the cached head first, refresh only when it looks empty.
       if (read_counter == write_counter) {
-        return std::nullopt; // nothing to read
+        Q::schedule_policy::point(interleaving::site::load_head);
+        write_counter = fq.write_counter.load(std::memory_order_acquire);
+        if (read_counter == write_counter) {
+          if constexpr (flight_recorder::enabled) {
+            if (!idle_recorded) { // once per idle spell, not once per poll
+              flight_recorder::record(flight_recorder::event::wait_park, 0, 0);
+              idle_recorded = true;
+            }
+          }
+          return std::nullopt; // nothing to read
+        }
       }
-    }
 
-    header_t payload_size{};
-    ring_read(fq, read_counter, reinterpret_cast<std::byte *>(&payload_size), sizeof(payload_size));
-    assert(payload_size >= 0 && static_cast<std::size_t>(payload_size) <= out.size() &&
-           "output buffer isn't large enough for the message");
+      std::size_t payload_size = 0;
+      Q::schedule_policy::point(interleaving::site::ring_access);
+      const std::size_t header_size = read_header(fq, payload_size);
+      assert(payload_size <= out.size() && "output buffer isn't large enough for the message");
+      if (prefetch_depth != 0) {
+        prefetch_after(fq, read_counter + header_size + payload_size +
+                               record_header::trailer_bytes<H>);
+      }
 
-    ring_read(fq, read_counter + sizeof(payload_size), out.data(),
-              static_cast<std::size_t>(payload_size));
+      Q::schedule_policy::point(interleaving::site::ring_access);
+      ring_read(fq, read_counter + header_size, out.data(), payload_size);
+      bool intact = true;
+      if constexpr (H::checksum) {
+        std::uint32_t crc{};
+        ring_read(fq, read_counter + header_size + payload_size,
+                  reinterpret_cast<std::byte *>(&crc), sizeof(crc));
+        intact = crc == record_header::crc32c_update(0, out.data(), payload_size);
+      }
 
-    const std::size_t record_size = sizeof(payload_size) + static_cast<std::size_t>(payload_size);
-    read_counter += record_size;
-    // Publish: the producer may now reuse the space we just consumed.
-    fq.read_counter.store(read_counter, std::memory_order_release);
-    return static_cast<std::size_t>(payload_size);
+      const std::size_t record_size =
+          header_size + payload_size + record_header::trailer_bytes<H>;
+      read_counter += record_size;
+      // Publish: the producer may now reuse the space we just consumed.
+      Q::schedule_policy::point(interleaving::site::publish_tail);
+      fq.read_counter.store(read_counter, std::memory_order_release);
+      if (!intact) {
+        ++checksum_failures;
+        continue;
+      }
+      if constexpr (flight_recorder::enabled) {
+        flight_recorder::record(flight_recorder::event::read,
+                                static_cast<std::uint32_t>(payload_size), 0);
+        idle_recorded = false;
+      }
+      return payload_size;
+    }
   }
 
   /**
@@ -216,40 +431,69 @@ struct consumer {
    * one commit_read() must follow each successful try_read_view() (a consumer uses either
    * try_read or the view API, not both interleaved).
    *
-   * Only the 4-byte length header is copied (into a local, so a header that itself straddles
-   * the end is handled); the payload - the bulk - is exposed in place, saving the ring->out
-   * copy that try_read performs.
+   * Only the header is copied (into a local, so a header that itself straddles the end is
+   * handled); the payload - the bulk - is exposed in place, saving the ring->out copy that
+   * try_read performs. A checksummed record is verified in place before it is handed out.
    */
   template <class Q> std::optional<read_view> try_read_view(Q &fq) {
+    using H = typename Q::header_policy;
     assert(pending_record == 0 && "previous try_read_view was not committed");
-    // Empty check, same cached-first / refresh-on-demand trick as try_read.
-    if (read_counter == write_counter) {
-      write_counter = fq.write_counter.load(std::memory_order_acquire);
+    for (;;) { // loops only past a record that fails its checksum
+      // Empty check, same cached-first / refresh-on-demand trick as try_read.
       if (read_counter == write_counter) {
-        return std::nullopt; // nothing to read
+        Q::schedule_policy::point(interleaving::site::load_head);
+        write_counter = fq.write_counter.load(std::memory_order_acquire);
+        if (read_counter == write_counter) {
+          if constexpr (flight_recorder::enabled) {
+            if (!idle_recorded) { // once per idle spell, not once per poll
+              flight_recorder::record(flight_recorder::event::wait_park, 0, 0);
+              idle_recorded = true;
+            }
+          }
+          return std::nullopt; // nothing to read
+        }
+      }
+
+      std::size_t plen = 0;
+      Q::schedule_policy::point(interleaving::site::ring_access);
+      const std::size_t header_size = read_header(fq, plen);
+      const std::uint64_t payload_start = read_counter + header_size;
+      const std::size_t record_size = header_size + plen + record_header::trailer_bytes<H>;
+      if (prefetch_depth != 0) {
+        prefetch_after(fq, read_counter + record_size);
+      }
+      if constexpr (H::checksum) {
+        std::uint32_t crc{};
+        ring_read(fq, payload_start + plen, reinterpret_cast<std::byte *>(&crc), sizeof(crc));
+        if (crc != ring_crc32c(fq, payload_start, plen)) {
+          read_counter += record_size; // skip it: the length is trusted, so we stay in step
+          Q::schedule_policy::point(interleaving::site::publish_tail);
+          fq.read_counter.store(read_counter, std::memory_order_release);
+          ++checksum_failures;
+          continue;
+        }
       }
-    }
 
-    header_t payload_size{};
-    ring_read(fq, read_counter, reinterpret_cast<std::byte *>(&payload_size), sizeof(payload_size));
-    assert(payload_size >= 0);
+      // Expose the payload in place, splitting into (at most) two pieces if it wraps the end.
+      const auto index = static_cast<std::size_t>(payload_start & Q::MASK);
+      const std::size_t first_len = std::min(plen, Q::SIZE - index);
 
-    // Expose the payload in place, splitting into (at most) two pieces if it wraps the end.
-    const std::uint64_t payload_start = read_counter + sizeof(header_t);
-    const auto index = static_cast<std::size_t>(payload_start & Q::MASK);
-    const auto plen = static_cast<std::size_t>(payload_size);
-    const std::size_t first_len = std::min(plen, Q::SIZE - index);
+      read_view v{};
+      v.first = std::span<const std::byte>{fq.buffer.data() + index, first_len};
+      if (plen > first_len) { // straddles the end -> second piece at the buffer start
+        v.second = std::span<const std::byte>{fq.buffer.data(), plen - first_len};
+      }
 
-    read_view v{};
-    v.first = std::span<const std::byte>{fq.buffer.data() + index, first_len};
-    if (plen > first_len) { // straddles the end -> second piece at the buffer start
-      v.second = std::span<const std::byte>{fq.buffer.data(), plen - first_len};
+      // Remember the record size but DON'T advance/publish yet: the producer must not reuse
+      // this space until the consumer has finished reading it in place (commit_read).
+      pending_record = record_size;
+      if constexpr (flight_recorder::enabled) {
+        flight_recorder::record(flight_recorder::event::read_view,
+                                static_cast<std::uint32_t>(plen), 0);
+        idle_recorded = false;
+      }
+      return v;
     }
-
-    // Remember the record size but DON'T advance/publish yet: the producer must not reuse
-    // this space until the consumer has finished reading it in place (commit_read).
-    pending_record = sizeof(header_t) + plen;
-    return v;
   }
 
   /**
@@ -258,15 +502,82 @@ struct consumer {
    */
   template <class Q> void commit_read(Q &fq) {
     assert(pending_record != 0 && "commit_read without a matching try_read_view");
+    if constexpr (flight_recorder::enabled) {
+      flight_recorder::record(flight_recorder::event::view_commit,
+                              static_cast<std::uint32_t>(pending_record), 0);
+    }
     read_counter += pending_record;
     pending_record = 0;
     // Publish: the producer may now reuse the space we just finished reading in place.
+    Q::schedule_policy::point(interleaving::site::publish_tail);
     fq.read_counter.store(read_counter, std::memory_order_release);
   }
 
-  std::uint64_t read_counter{0};  // private copy of the tail
-  std::uint64_t write_counter{0}; // last observed head (producer progress)
-  std::size_t pending_record{0};  // size of a peeked-but-not-committed record (0 = none)
+  /**
+   * Decode the header of the record at read_counter: returns the header's size, stores the
+   * payload length in `payload_size` and the record's type in last_type. A varint header is
+   * read in two steps - its first byte says how long it is.
+   */
+  template <class Q> std::size_t read_header(const Q &fq, std::size_t &payload_size) {
+    return decode_header(fq, read_counter, payload_size, last_type);
+  }
+
+  // The same for the record at any published position `counter`.
+  template <class Q>
+  static std::size_t decode_header(const Q &fq, std::uint64_t counter, std::size_t &payload_size,
+                                   std::uint16_t &type) {
+    using H = typename Q::header_policy;
+    std::array<std::byte, H::max_bytes> header;
+    std::size_t header_size = H::max_bytes;
+    if constexpr (H::variable) {
+      ring_read(fq, counter, header.data(), 1);
+      header_size = H::bytes_from_first(header[0]);
+      ring_read(fq, counter + 1, header.data() + 1, header_size - 1);
+    } else if constexpr (H::max_bytes != 0) {
+      ring_read(fq, counter, header.data(), header_size);
+    }
+    payload_size = H::decode(header.data(), header_size, type);
+    return header_size;
+  }
+
+  /**
+   * Software prefetch for a consumer that is behind the producer. Called as the record at
+   * read_counter (ending at `record_end`) is read: keeps the prefetch_depth records AFTER it
+   * requested - every line of their header, payload and trailer - as far as the cached
+   * write_counter allows. Records are walked once, from prefetch_cursor (the first record not
+   * yet prefetched), so in the steady state each read prefetches one record: the one K ahead.
+   * Its header sits on a line the previous walk already requested (each record's range is
+   * extended by one maximal header for that), so the walk itself rarely waits on memory.
+   */
+  template <class Q> void prefetch_after(const Q &fq, std::uint64_t record_end) {
+    using H = typename Q::header_policy;
+    if (prefetch_cursor > read_counter) {
+      --prefetch_queued; // the record being read was the oldest one prefetched
+    } else {             // first use, or caught up with the producer: restart behind this record
+      prefetch_cursor = record_end;
+      prefetch_queued = 0;
+    }
+    while (prefetch_queued < prefetch_depth && prefetch_cursor < write_counter) {
+      std::size_t payload_size = 0;
+      std::uint16_t type{};
+      Q::schedule_policy::point(interleaving::site::ring_access);
+      const std::size_t record_size = decode_header(fq, prefetch_cursor, payload_size, type) +
+                                      payload_size + record_header::trailer_bytes<H>;
+      ring_prefetch(fq, prefetch_cursor, record_size + H::max_bytes);
+      prefetch_cursor += record_size;
+      ++prefetch_queued;
+    }
+  }
+
+  std::uint64_t read_counter{0};      // private copy of the tail
+  std::uint64_t write_counter{0};     // last observed head (producer progress)
+  std::size_t pending_record{0};      // size of a peeked-but-not-committed record (0 = none)
+  std::uint16_t last_type{0};         // type field of the last record read (0 without one)
+  std::uint64_t checksum_failures{0}; // records skipped because their CRC32C did not match
+  std::size_t prefetch_depth{0};      // K: records to prefetch ahead of the read (0 = off)
+  std::uint64_t prefetch_cursor{0};   // start of the first record not yet prefetched
+  std::size_t prefetch_queued{0};     // records prefetched ahead, up to prefetch_depth
+  bool idle_recorded{false};          // flight recorder: the current empty spell is already logged
 };
 
 } // namespace fast_queue_spsc
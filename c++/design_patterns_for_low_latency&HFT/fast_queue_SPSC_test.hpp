@@ -10,6 +10,8 @@
 #pragma once
 
 #include "fast_queue_SPSC.hpp"
+#include "percentile.hpp"
+#include "thread_placement.hpp"
 
 #include <algorithm>
 #include <array>
@@ -21,8 +23,10 @@
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <print>
 #include <span>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <vector>
@@ -186,6 +190,301 @@ inline void test_zero_copy() {
   std::println("test_zero_copy PASSED ({} messages read in place, byte-for-byte, no loss)", N);
 }
 
+// --- Demo: zero-copy producer write (reserve in place, commit) ----------------------------
+// The mirror image of test_zero_copy: the producer builds each message IN the ring through a
+// write_view (filling both pieces when the reservation wraps), over-reserves and commits
+// only what it used, and the consumer checks every byte with the plain copying try_read.
+inline void test_reserve_commit() {
+  std::println("--- test_reserve_commit ---");
+  constexpr std::uint64_t N = 1'000'000;
+  constexpr std::size_t MAX_PAYLOAD = sizeof(std::uint64_t) + 36;
+  auto fq_ptr = std::make_unique<fast_queue>();
+  fast_queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  std::atomic<bool> go{false};
+
+  std::thread producer_thread([&] {
+    while (!go.load(std::memory_order_acquire)) {
+      spin_pause();
+    }
+    for (std::uint64_t seq = 0; seq < N; ++seq) {
+      const std::size_t extra = static_cast<std::size_t>(seq % 37); // 0..36 -> 8..44 byte payload
+      std::optional<write_view> view;
+      while (!(view = prod.try_reserve(fq, MAX_PAYLOAD))) {
+        spin_pause();
+      }
+      // Build the message byte by byte so the split point can fall anywhere, even inside seq.
+      std::array<std::byte, MAX_PAYLOAD> bytes{};
+      std::memcpy(bytes.data(), &seq, sizeof(seq));
+      for (std::size_t i = 0; i < extra; ++i) {
+        bytes[sizeof(seq) + i] = static_cast<std::byte>((extra + i) & 0xFF);
+      }
+      for (std::size_t i = 0; i < sizeof(seq) + extra; ++i) {
+        const std::size_t f = view->first.size();
+        (i < f ? view->first[i] : view->second[i - f]) = bytes[i];
+      }
+      prod.commit_write(fq, sizeof(seq) + extra); // publish less than was reserved
+    }
+  });
+
+  std::thread consumer_thread([&] {
+    while (!go.load(std::memory_order_acquire)) {
+      spin_pause();
+    }
+    std::array<std::byte, MAX_PAYLOAD> out{};
+    std::uint64_t expected = 0;
+    while (expected < N) {
+      const auto n = cons.try_read(fq, out);
+      if (!n) {
+        spin_pause();
+        continue;
+      }
+      std::uint64_t seq{};
+      std::memcpy(&seq, out.data(), sizeof(seq));
+      assert(seq == expected && "reserve/commit: out of order or lost message");
+      const std::size_t extra = *n - sizeof(seq);
+      assert(extra == seq % 37 && "reserve/commit: wrong committed length");
+      for (std::size_t i = 0; i < extra; ++i) {
+        assert(out[sizeof(seq) + i] == static_cast<std::byte>((extra + i) & 0xFF) &&
+               "reserve/commit: payload corrupted");
+      }
+      ++expected;
+    }
+  });
+
+  go.store(true, std::memory_order_release);
+  producer_thread.join();
+  consumer_thread.join();
+  std::println("test_reserve_commit PASSED ({} messages built in place, no loss)", N);
+}
+
+// --- Demo: size-class copy kernels (small_copy.hpp) ---------------------------------------
+// Every length from 0 to 200 (across every size class and into the memcpy fallback) at every
+// source/destination misalignment within 8 bytes: the copy must match byte for byte and must
+// not touch a byte past either end. Then a small ring using the kernels carries records of
+// 1..64 bytes, which land at every offset and wrap thousands of times, checked byte for byte.
+inline void test_small_copy() {
+  std::println("--- test_small_copy ---");
+  constexpr std::size_t MAX_N = 200;
+  constexpr std::byte GUARD{0xA5};
+  std::array<std::byte, MAX_N + 16> src{};
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<std::byte>(i * 7 + 1);
+  }
+  for (std::size_t n = 0; n <= MAX_N; ++n) {
+    for (std::size_t so = 0; so < 8; ++so) {
+      for (std::size_t d = 0; d < 8; ++d) {
+        std::array<std::byte, MAX_N + 32> dst;
+        dst.fill(GUARD);
+        small_copy::copy(dst.data() + 8 + d, src.data() + so, n);
+        for (std::size_t i = 0; i < dst.size(); ++i) {
+          [[maybe_unused]] const bool inside = i >= 8 + d && i < 8 + d + n;
+          assert(dst[i] == (inside ? src[so + i - 8 - d] : GUARD) && "small_copy: wrong bytes");
+        }
+      }
+    }
+  }
+
+  using simd_queue = fast_queue_t<QUEUE_SIZE, small_copy::simd>;
+  auto fq_ptr = std::make_unique<simd_queue>();
+  simd_queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  std::array<std::byte, 64> in{};
+  std::array<std::byte, 64> out{};
+  for (std::uint64_t seq = 0; seq < 100'000; ++seq) {
+    const std::size_t n = 1 + seq % 64;
+    for (std::size_t i = 0; i < n; ++i) {
+      in[i] = static_cast<std::byte>(seq * 3 + i);
+    }
+    [[maybe_unused]] const bool written =
+        prod.try_write(fq, std::span<const std::byte>{in.data(), n});
+    assert(written);
+    [[maybe_unused]] const auto got = cons.try_read(fq, out);
+    assert(got && *got == n && std::memcmp(in.data(), out.data(), n) == 0);
+  }
+  std::println("test_small_copy PASSED (lengths 0..{} at every alignment, ring round trip)", MAX_N);
+}
+
+// --- Demo: record header policies (record_header.hpp) --------------------------------------
+// Payloads of every length a policy allows (up to 300 bytes, or exactly N for fixed<N>) through
+// a small ring with each policy, so headers and trailers straddle the end too: through the
+// copy read, the zero-copy read, and a reservation committed shorter than reserved (a varint
+// header then keeps the width of the reserved length). Types travel with length16_type16.
+template <class H> inline void check_round_trip() {
+  using Queue = fast_queue_t<QUEUE_SIZE, small_copy::libc, H>;
+  auto fq_ptr = std::make_unique<Queue>();
+  Queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  [[maybe_unused]] constexpr bool has_type = std::is_same_v<H, record_header::length16_type16>;
+  std::array<std::byte, 300> in{};
+  std::array<std::byte, 300> out{};
+  for (std::uint64_t i = 0; i < 3'000; ++i) {
+    const std::size_t n = H::max_bytes == 0 ? H::max_payload : i % 301;
+    const auto type = static_cast<std::uint16_t>(i * 7);
+    for (std::size_t k = 0; k < n; ++k) {
+      in[k] = static_cast<std::byte>(i + k);
+    }
+    [[maybe_unused]] const auto same = [&](std::span<const std::byte> a,
+                                            std::span<const std::byte> b) {
+      return std::equal(a.begin(), a.end(), in.begin()) &&
+             std::equal(b.begin(), b.end(), in.begin() + static_cast<std::ptrdiff_t>(a.size()));
+    };
+    switch (i % 3) {
+    case 0: { // copy write, copy read
+      [[maybe_unused]] const bool written =
+          prod.try_write(fq, std::span<const std::byte>{in.data(), n}, type);
+      assert(written);
+      [[maybe_unused]] const auto got = cons.try_read(fq, out);
+      assert(got && *got == n && same({out.data(), n}, {}));
+      break;
+    }
+    case 1: { // copy write, zero-copy read
+      [[maybe_unused]] const bool written =
+          prod.try_write(fq, std::span<const std::byte>{in.data(), n}, type);
+      assert(written);
+      [[maybe_unused]] const auto v = cons.try_read_view(fq);
+      assert(v && v->size() == n && same(v->first, v->second));
+      cons.commit_read(fq);
+      break;
+    }
+    default: { // reserve more than is committed (fixed<N>: exactly N)
+      const std::size_t reserve = H::max_bytes == 0 ? n : n + 150;
+      const auto w = prod.try_reserve(fq, reserve);
+      assert(w && w->size() == reserve);
+      for (std::size_t k = 0; k < n; ++k) {
+        const std::size_t f = w->first.size();
+        (k < f ? w->first[k] : w->second[k - f]) = in[k];
+      }
+      prod.commit_write(fq, n, type);
+      [[maybe_unused]] const auto got = cons.try_read(fq, out);
+      assert(got && *got == n && same({out.data(), n}, {}));
+      break;
+    }
+    }
+    assert(cons.last_type == (has_type ? type : 0));
+  }
+  assert(cons.try_read(fq, out) == std::nullopt && cons.checksum_failures == 0);
+}
+
+inline void test_record_headers() {
+  std::println("--- test_record_headers ---");
+  // CRC32C check value, and the chaining the ring relies on for a split payload.
+  const std::string check = "123456789";
+  [[maybe_unused]] const auto *digits = reinterpret_cast<const std::byte *>(check.data());
+  assert(record_header::crc32c_update(0, digits, 9) == 0xE3069283u);
+  assert(record_header::crc32c_update(record_header::crc32c_update(0, digits, 4), digits + 4, 5) ==
+         0xE3069283u);
+  // Varint sizes at the class boundaries.
+  using record_header::varint_length;
+  assert(varint_length::bytes(127) == 1 && varint_length::bytes(128) == 2);
+  assert(varint_length::bytes(16'383) == 2 && varint_length::bytes(16'384) == 4);
+
+  check_round_trip<record_header::int32_length>();
+  check_round_trip<record_header::varint_length>();
+  check_round_trip<record_header::length16_type16>();
+  check_round_trip<record_header::fixed<24>>();
+  check_round_trip<record_header::crc32c<record_header::int32_length>>();
+  check_round_trip<record_header::crc32c<record_header::varint_length>>();
+
+  // A record damaged in the ring is skipped and counted; the next one still reads.
+  using checked = fast_queue_t<QUEUE_SIZE, small_copy::libc,
+                               record_header::crc32c<record_header::varint_length>>;
+  auto fq_ptr = std::make_unique<checked>();
+  producer prod;
+  consumer cons;
+  const std::array<std::byte, 16> a{std::byte{1}};
+  const std::array<std::byte, 16> b{std::byte{2}};
+  [[maybe_unused]] bool written = prod.try_write(*fq_ptr, std::span<const std::byte>{a});
+  written = written && prod.try_write(*fq_ptr, std::span<const std::byte>{b});
+  assert(written);
+  fq_ptr->buffer[5] ^= std::byte{0x40}; // inside the first payload
+  std::array<std::byte, 16> out{};
+  [[maybe_unused]] const auto got = cons.try_read(*fq_ptr, out);
+  assert(got == 16 && out == b && cons.checksum_failures == 1);
+  std::println("test_record_headers PASSED");
+}
+
+// --- Demo: software prefetch in the consumer ------------------------------------------------
+// Bursts of records of every size up to 300 bytes through the small ring, drained partly in
+// between so the consumer runs behind the producer, the prefetch cursor crosses the end and
+// the consumer catches up and restarts it. Prefetching must not change what is read, and it
+// never walks past what the producer has published.
+template <class H> inline void check_prefetch() {
+  using Queue = fast_queue_t<QUEUE_SIZE, small_copy::libc, H>;
+  auto fq_ptr = std::make_unique<Queue>();
+  Queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  cons.prefetch_depth = 4;
+  std::array<std::byte, 300> in{};
+  std::array<std::byte, 300> out{};
+  std::uint64_t written = 0;
+  std::uint64_t read = 0;
+  const auto size_of = [](std::uint64_t seq) { return sizeof(seq) + seq * 13 % 293; };
+  const auto check = [&](std::span<const std::byte> a, std::span<const std::byte> b) {
+    [[maybe_unused]] const std::size_t n = size_of(read);
+    assert(a.size() + b.size() == n);
+    std::array<std::byte, 300> got{};
+    std::memcpy(got.data(), a.data(), a.size());
+    std::memcpy(got.data() + a.size(), b.data(), b.size());
+    for ([[maybe_unused]] std::size_t k = 0; k < n; ++k) {
+      assert(got[k] == static_cast<std::byte>(read + k));
+    }
+    assert(cons.prefetch_queued <= cons.prefetch_depth);
+    assert(cons.prefetch_cursor <= fq.write_counter.load(std::memory_order_relaxed));
+    ++read;
+  };
+  for (int round = 0; round < 2'000; ++round) {
+    // Write until full, read a part of it: the consumer stays behind by several records.
+    for (;;) {
+      const std::size_t n = size_of(written);
+      for (std::size_t k = 0; k < n; ++k) {
+        in[k] = static_cast<std::byte>(written + k);
+      }
+      if (!prod.try_write(fq, std::span<const std::byte>{in.data(), n})) {
+        break;
+      }
+      ++written;
+    }
+    for (std::uint64_t drain = round % 3 == 0 ? written - read : 2; drain != 0; --drain) {
+      if (round % 2 == 0) {
+        const auto got = cons.try_read(fq, out);
+        assert(got);
+        check({out.data(), *got}, {});
+      } else {
+        const auto v = cons.try_read_view(fq);
+        assert(v);
+        check(v->first, v->second);
+        cons.commit_read(fq);
+      }
+    }
+  }
+  assert(read > 1'000);
+}
+
+inline void test_prefetch() {
+  std::println("--- test_prefetch ---");
+  check_prefetch<record_header::int32_length>();
+  check_prefetch<record_header::varint_length>();
+  check_prefetch<record_header::crc32c<record_header::varint_length>>();
+  std::println("test_prefetch PASSED");
+}
+
+// Print the placement a benchmark ran under, and flag threads that could not apply it (no
+// CAP_SYS_NICE for SCHED_FIFO, a CPU outside the cgroup, ...): their numbers were measured
+// on a floating thread and must not be compared against pinned runs.
+inline void report_placement(benchmark::State &state, const thread_placement::placement_plan &plan,
+                             std::uint64_t failures) {
+  std::println("placement: {}", plan.describe());
+  if (failures != 0) {
+    state.counters["placement_failures"] = static_cast<double>(failures);
+    std::println("WARNING: {} thread(s) failed to apply the placement", failures);
+  }
+}
+
 // --- Demo 3: full-ring throughput benchmark ------------------------------
 // Two threads pump N variable-sized messages through a Queue ring and we measure the
 // queue's raw read/write speed. This is a PERFORMANCE test: the consumer only reads
@@ -198,12 +497,22 @@ inline void test_zero_copy() {
 // false = std::this_thread::yield() (cooperative, traps into the scheduler).
 // Manual timing brackets only the pump: thread spawn and join are excluded, and
 // so is payload construction (built once, up front).
+//
+// Args: range(0) = N messages, range(1) = thread_placement::topology, range(2) = SCHED_FIFO
+// priority (0 = default policy). Each thread pins itself before waiting at the start gate.
 template <class Queue, bool BusySpin, bool ZeroCopy = false>
 inline void run_full_ring(benchmark::State &state) {
   // Messages to pump per iteration, taken from the benchmark Arg so the count is set at
   // registration and can be swept with multiple ->Arg()s (same pattern as run_latency).
   const auto N = static_cast<std::uint64_t>(state.range(0));
 
+  // Producer = thread 0, consumer = thread 1. Unavailable placements skip the benchmark.
+  const auto plan = thread_placement::plan_from_benchmark(state, 2);
+  if (!plan) {
+    return;
+  }
+  std::atomic<std::uint64_t> placement_failures{0};
+
   // The consumer's scratch buffer is sized to the largest possible message, not
   // to the ring: a 1 MiB ring must never land on the consumer's stack.
   constexpr std::size_t MAX_MSG = 64;
@@ -268,6 +577,9 @@ inline void run_full_ring(benchmark::State &state) {
     std::chrono::steady_clock::time_point t_end;
 
     std::thread producer_thread([&] {
+      if (!thread_placement::apply(plan->threads[0])) {
+        placement_failures.fetch_add(1, std::memory_order_relaxed);
+      }
       while (!go.load(std::memory_order_acquire)) {
         pause(); // wait at the gate
       }
@@ -291,6 +603,9 @@ inline void run_full_ring(benchmark::State &state) {
     });
 
     std::thread consumer_thread([&] {
+      if (!thread_placement::apply(plan->threads[1])) {
+        placement_failures.fetch_add(1, std::memory_order_relaxed);
+      }
       std::array<std::byte, MAX_MSG> out{};
       std::uint64_t expected = 0;
       while (!go.load(std::memory_order_acquire)) {
@@ -344,6 +659,7 @@ inline void run_full_ring(benchmark::State &state) {
 
   std::println("pumped {} messages/iteration (read/write speed only, no payload processing)", N);
   std::println("producer hit a full queue {} times on the last iteration", last_fulls);
+  report_placement(state, *plan, placement_failures.load(std::memory_order_relaxed));
 }
 
 // Small ring: producer and consumer collide constantly, so the ring is full or
@@ -391,6 +707,140 @@ inline void test_full_ring_optimized_yield(benchmark::State &state) {
   std::println("test_full_ring_optimized_yield PASSED");
 }
 
+// Same large ring + busy-spin as test_full_ring_optimized, but the ring copies its records
+// with the small_copy::simd kernels instead of libc memcpy. The records are the same (12..48
+// bytes with their header), so the difference is the copy alone.
+inline void test_full_ring_optimized_simd(benchmark::State &state) {
+  std::println("--- test_full_ring_optimized_simd ---");
+  run_full_ring<fast_queue_t<LARGE_QUEUE_SIZE, small_copy::simd>, /*BusySpin=*/true>(state);
+  std::println("test_full_ring_optimized_simd PASSED");
+}
+
+// --- The ring's copy path on one thread ----------------------------------------------------
+// A copy of a short record is a few ns. In the two-thread pump that hides under cache-line
+// transfers and waiting, so this runs run_full_ring's records (8..44-byte payloads) through
+// try_write and try_read on ONE thread: a batch that half fills a 1 MiB ring, then drained.
+// What is left to measure is the framing, the counters and the copies. Copy selects the
+// kernel: small_copy::libc or small_copy::simd.
+template <class Copy> inline void run_ring_copy(benchmark::State &state) {
+  using Queue = fast_queue_t<LARGE_QUEUE_SIZE, Copy>;
+  constexpr std::uint64_t BATCH = 16'384; // about 480 KiB of records
+  auto fq_ptr = std::make_unique<Queue>();
+  Queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  std::array<std::byte, 64> in{};
+  std::array<std::byte, 64> out{};
+  std::uint64_t bytes = 0;
+  for (auto _ : state) {
+    for (std::uint64_t seq = 0; seq < BATCH; ++seq) {
+      const std::size_t n = sizeof(seq) + static_cast<std::size_t>(seq % 37);
+      std::memcpy(in.data(), &seq, sizeof(seq));
+      prod.try_write(fq, std::span<const std::byte>{in.data(), n});
+      bytes += sizeof(header_t) + n;
+    }
+    while (cons.try_read(fq, out)) {
+      benchmark::DoNotOptimize(out);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BATCH));
+  state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+
+inline void test_ring_copy_libc(benchmark::State &state) { run_ring_copy<small_copy::libc>(state); }
+inline void test_ring_copy_simd(benchmark::State &state) { run_ring_copy<small_copy::simd>(state); }
+
+// --- Bandwidth by record header ---------------------------------------------------------------
+// Messages of exactly Payload bytes framed by H, written and read on one thread as in
+// run_ring_copy: a batch that half fills a 1 MiB ring, then drained. bytes_per_second counts
+// PAYLOAD bytes, so the framing shows up as lost bandwidth; framing_pct is the share of the
+// ring each record spends on header and trailer (what a cross-core transfer pays for too),
+// and the time per message includes encoding, decoding and any CRC32C.
+template <class H, std::size_t Payload>
+inline void test_record_header_bandwidth(benchmark::State &state) {
+  using Queue = fast_queue_t<LARGE_QUEUE_SIZE, small_copy::libc, H>;
+  constexpr std::size_t RECORD = H::bytes(Payload) + Payload + record_header::trailer_bytes<H>;
+  constexpr std::uint64_t BATCH = LARGE_QUEUE_SIZE / 2 / RECORD;
+  auto fq_ptr = std::make_unique<Queue>();
+  Queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  std::array<std::byte, Payload> in{};
+  std::array<std::byte, Payload> out{};
+  for (auto _ : state) {
+    for (std::uint64_t seq = 0; seq < BATCH; ++seq) {
+      std::memcpy(in.data(), &seq, std::min(sizeof(seq), Payload));
+      prod.try_write(fq, std::span<const std::byte>{in});
+    }
+    while (cons.try_read(fq, out)) {
+      benchmark::DoNotOptimize(out);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BATCH));
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(BATCH * Payload));
+  state.counters["framing_pct"] = 100.0 * static_cast<double>(RECORD - Payload) / RECORD;
+}
+
+// --- Consumer prefetch, large records -------------------------------------------------------
+// A consumer far behind the producer: the ring (256 MiB, past the last-level cache of most
+// machines) is filled with range(0)-byte messages, then drained through try_read_view with
+// prefetch_depth = range(1) (0 = off). Reading a message touches one word per cache line, a
+// stand-in for a decoder; what the prefetch can hide is the miss on each line. Manual time
+// covers the drain only; bytes_per_second counts payload bytes.
+constexpr std::size_t PREFETCH_QUEUE_SIZE = std::size_t{1} << 28;
+
+inline void test_prefetch_read_view(benchmark::State &state) {
+  using Queue = fast_queue_t<PREFETCH_QUEUE_SIZE>;
+  const auto payload = static_cast<std::size_t>(state.range(0));
+  auto fq_ptr = std::make_unique<Queue>();
+  Queue &fq = *fq_ptr;
+  producer prod;
+  consumer cons;
+  cons.prefetch_depth = static_cast<std::size_t>(state.range(1));
+  std::vector<std::byte> in(payload, std::byte{1});
+  std::uint64_t messages = 0;
+  for (auto _ : state) {
+    std::uint64_t batch = 0;
+    while (prod.try_write(fq, std::span<const std::byte>{in})) {
+      ++batch;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t sum = 0;
+    while (const auto v = cons.try_read_view(fq)) {
+      for (const auto piece : {v->first, v->second}) {
+        for (std::size_t k = 0; k < piece.size(); k += CACHE_LINE_SIZE) {
+          sum += std::to_integer<std::uint64_t>(piece[k]);
+        }
+      }
+      cons.commit_read(fq);
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+                               .count());
+    messages += batch;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(messages));
+  state.SetBytesProcessed(static_cast<std::int64_t>(messages * payload));
+}
+
+template <std::size_t Payload> inline void register_record_header_bandwidth() {
+  namespace rh = record_header;
+  const std::string n = "/" + std::to_string(Payload);
+  benchmark::RegisterBenchmark(("test_record_header/int32" + n).c_str(),
+                               test_record_header_bandwidth<rh::int32_length, Payload>);
+  benchmark::RegisterBenchmark(("test_record_header/varint" + n).c_str(),
+                               test_record_header_bandwidth<rh::varint_length, Payload>);
+  benchmark::RegisterBenchmark(("test_record_header/len16_type16" + n).c_str(),
+                               test_record_header_bandwidth<rh::length16_type16, Payload>);
+  benchmark::RegisterBenchmark(("test_record_header/fixed" + n).c_str(),
+                               test_record_header_bandwidth<rh::fixed<Payload>, Payload>);
+  benchmark::RegisterBenchmark(("test_record_header/crc32c_int32" + n).c_str(),
+                               test_record_header_bandwidth<rh::crc32c<rh::int32_length>, Payload>);
+  benchmark::RegisterBenchmark(
+      ("test_record_header/crc32c_varint" + n).c_str(),
+      test_record_header_bandwidth<rh::crc32c<rh::varint_length>, Payload>);
+}
+
 // --- Demo 4: end-to-end latency under a realistic arrival rate -----------
 // Models an HFT feed: messages arrive at a target rate (msgs/sec) with real gaps
 // between them - nobody sleeps. The producer BUSY-WAITS on the clock until the
@@ -401,21 +851,58 @@ inline void test_full_ring_optimized_yield(benchmark::State &state) {
 // how much a descheduled consumer costs during the idle gaps between messages.
 struct latency_msg { // trivially copyable so to_bytes/from_bytes work
   std::uint64_t seq;
-  std::int64_t t_send_ns;
+  std::int64_t t_send_ns;     // when the producer actually got round to sending it
+  std::int64_t t_intended_ns; // when the schedule said it should be sent: t0 + period * seq
 };
 
-template <bool BusySpin> inline void run_latency(benchmark::State &state) {
+// Where a message's latency is measured FROM.
+//  - send_stamp: recv - t_send. Service time of the queue alone. Suffers from COORDINATED
+//    OMISSION: when try_write stalls on a full ring the producer falls behind schedule, and
+//    every message it sends late gets a fresh (late) send stamp - the time it spent waiting to
+//    be sent is silently dropped, exactly at the moments the system is struggling.
+//  - intended: recv - t_intended. What an upstream sender running at the target rate would
+//    observe: the backlog built up by a stall is charged to every message caught behind it.
+//    This is the number to hold an SLA against.
+enum class latency_origin { send_stamp, intended };
+
+// percentile::nearest_rank, which every latency benchmark in the tree reports through.
+inline void test_percentile() {
+  std::println("--- test_percentile ---");
+  std::vector<std::int64_t> v(1000);
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    v[i] = static_cast<std::int64_t>(i) + 1; // 1..1000: the value is its rank
+  }
+  assert(percentile::nearest_rank(v, 0.50) == 500 && percentile::nearest_rank(v, 0.99) == 990);
+  assert(percentile::nearest_rank(v, 0.999) == 999 && percentile::nearest_rank(v, 1.0) == 1000);
+  assert(percentile::nearest_rank(v, 0.0) == 1);
+  assert(percentile::nearest_rank(std::vector<std::int64_t>{7}, 0.99) == 7);
+  assert(percentile::nearest_rank(std::vector<std::int64_t>{}, 0.99) == 0);
+  std::println("test_percentile PASSED");
+}
+
+// Args: range(0) = rate, range(1)/range(2) = thread placement (as in run_full_ring).
+// Origin selects which latency the headline p50/p99/p99.9 report. Independently of it the
+// producer records, per message, how long try_write stalled on a full ring, so back-pressure
+// shows up as its own distribution instead of hiding inside (or outside) the latency one.
+template <bool BusySpin, latency_origin Origin = latency_origin::send_stamp>
+inline void run_latency(benchmark::State &state) {
   const auto rate = static_cast<std::uint64_t>(state.range(0)); // messages / second
   constexpr std::uint64_t N = 50'000;                           // samples per iteration
   constexpr std::size_t MAX_MSG = 64;
 
+  const auto plan = thread_placement::plan_from_benchmark(state, 2);
+  if (!plan) {
+    return;
+  }
+  std::atomic<std::uint64_t> placement_failures{0};
+
   using clock = std::chrono::steady_clock;
   const auto period =
       std::chrono::nanoseconds(rate == 0 ? 0 : static_cast<std::int64_t>(1'000'000'000ULL / rate));
-  auto now_ns = [] {
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch())
-        .count();
+  auto to_ns = [](clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
   };
+  auto now_ns = [&to_ns] { return to_ns(clock::now()); };
 
   std::int64_t sum_ns = 0;
   std::int64_t min_ns = std::numeric_limits<std::int64_t>::max();
@@ -425,8 +912,17 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
   // Every per-message latency, kept so we can sort for tail percentiles after the run.
   // The mean hides the tail and `max` is a single noisy sample; p99/p99.9 are what
   // actually characterize HFT latency (you get picked off on your worst cases).
+  const auto total = static_cast<std::size_t>(N) * static_cast<std::size_t>(state.max_iterations);
   std::vector<std::int64_t> all_lat;
-  all_lat.reserve(static_cast<std::size_t>(N) * static_cast<std::size_t>(state.max_iterations));
+  all_lat.reserve(total);
+  // In intended mode: the send-stamp latency of the same messages, to show what CO hid.
+  std::vector<std::int64_t> all_uncorrected;
+  if constexpr (Origin == latency_origin::intended) {
+    all_uncorrected.reserve(total);
+  }
+  // Per-message producer stall on a full ring (0 when the first try_write succeeded).
+  std::vector<std::int64_t> all_stall;
+  all_stall.reserve(total);
 
   // NOTE: deliberately NO payload pool here (unlike run_full_ring). This benchmark measures
   // end-to-end DELIVERY LATENCY, not throughput. It sends a modest, fixed N of messages at a
@@ -453,8 +949,18 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
     std::int64_t c_max = 0;
     std::vector<std::int64_t> c_lat;
     c_lat.reserve(N);
+    std::vector<std::int64_t> c_uncorrected;
+    if constexpr (Origin == latency_origin::intended) {
+      c_uncorrected.reserve(N);
+    }
+    // Producer-side stall samples, likewise published after the join.
+    std::vector<std::int64_t> p_stall;
+    p_stall.reserve(N);
 
     std::thread consumer_thread([&] {
+      if (!thread_placement::apply(plan->threads[1])) {
+        placement_failures.fetch_add(1, std::memory_order_relaxed);
+      }
       std::array<std::byte, MAX_MSG> out{};
       std::uint64_t got = 0;
       while (!go.load(std::memory_order_acquire)) {
@@ -472,7 +978,11 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
         }
         const std::int64_t recv = now_ns(); // stamp arrival as early as possible
         const auto m = from_bytes<latency_msg>(std::span<const std::byte>{out.data(), *n});
-        const std::int64_t lat = recv - m.t_send_ns;
+        std::int64_t lat = recv - m.t_send_ns;
+        if constexpr (Origin == latency_origin::intended) {
+          c_uncorrected.push_back(lat);
+          lat = recv - m.t_intended_ns;
+        }
         c_sum += lat;
         c_min = std::min(c_min, lat);
         c_max = std::max(c_max, lat);
@@ -482,21 +992,33 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
     });
 
     std::thread producer_thread([&] {
+      if (!thread_placement::apply(plan->threads[0])) {
+        placement_failures.fetch_add(1, std::memory_order_relaxed);
+      }
       while (!go.load(std::memory_order_acquire)) {
         spin_pause();
       }
       const auto t0 = clock::now();
       for (std::uint64_t seq = 0; seq < N; ++seq) {
-        // Busy-wait (never sleep) until this message's scheduled send time.
+        // Busy-wait (never sleep) until this message's scheduled send time. If an earlier
+        // stall made us late, target is already in the past and we send immediately - the
+        // lateness is what t_intended_ns preserves.
         const auto target = t0 + period * static_cast<std::int64_t>(seq);
         while (clock::now() < target) {
           spin_pause();
         }
-        const latency_msg m{seq, now_ns()}; // stamp send as late as possible
+        const latency_msg m{seq, now_ns(), to_ns(target)}; // stamp send as late as possible
         const auto bytes = to_bytes(m);
-        while (!prod.try_write(fq, std::span<const std::byte>{bytes})) {
-          spin_pause();
+        std::int64_t stall = 0;
+        if (!prod.try_write(fq, std::span<const std::byte>{bytes})) {
+          // Ring full: time the back-pressure wait. Only the slow path pays for the clock.
+          const std::int64_t stall_begin = now_ns();
+          while (!prod.try_write(fq, std::span<const std::byte>{bytes})) {
+            spin_pause();
+          }
+          stall = now_ns() - stall_begin;
         }
+        p_stall.push_back(stall);
       }
     });
 
@@ -508,26 +1030,17 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
     min_ns = std::min(min_ns, c_min);
     max_ns = std::max(max_ns, c_max);
     all_lat.insert(all_lat.end(), c_lat.begin(), c_lat.end());
+    all_uncorrected.insert(all_uncorrected.end(), c_uncorrected.begin(), c_uncorrected.end());
+    all_stall.insert(all_stall.end(), p_stall.begin(), p_stall.end());
     samples += N;
   }
 
   const double avg_ns = samples ? static_cast<double>(sum_ns) / static_cast<double>(samples) : 0.0;
 
-  // Nearest-rank percentiles over the sorted samples: p = value at index ceil(q*n)-1.
   std::sort(all_lat.begin(), all_lat.end());
-  auto pct = [&all_lat](double q) -> std::int64_t {
-    if (all_lat.empty()) {
-      return 0;
-    }
-    auto idx = static_cast<std::size_t>(q * static_cast<double>(all_lat.size()));
-    if (idx >= all_lat.size()) {
-      idx = all_lat.size() - 1;
-    }
-    return all_lat[idx];
-  };
-  const std::int64_t p50 = pct(0.50);
-  const std::int64_t p99 = pct(0.99);
-  const std::int64_t p999 = pct(0.999);
+  const std::int64_t p50 = percentile::nearest_rank(all_lat, 0.50);
+  const std::int64_t p99 = percentile::nearest_rank(all_lat, 0.99);
+  const std::int64_t p999 = percentile::nearest_rank(all_lat, 0.999);
 
   state.counters["avg_ns"] = avg_ns;
   state.counters["min_ns"] = static_cast<double>(min_ns);
@@ -536,9 +1049,33 @@ template <bool BusySpin> inline void run_latency(benchmark::State &state) {
   state.counters["p99.9_ns"] = static_cast<double>(p999);
   state.counters["max_ns"] = static_cast<double>(max_ns);
 
+  const auto stalled = static_cast<std::uint64_t>(
+      std::count_if(all_stall.begin(), all_stall.end(), [](std::int64_t v) { return v != 0; }));
+  std::sort(all_stall.begin(), all_stall.end());
+  const std::int64_t stall_p99 = percentile::nearest_rank(all_stall, 0.99);
+  const std::int64_t stall_max = all_stall.empty() ? 0 : all_stall.back();
+  state.counters["stalled_msgs"] = static_cast<double>(stalled);
+  state.counters["stall_p99_ns"] = static_cast<double>(stall_p99);
+  state.counters["stall_max_ns"] = static_cast<double>(stall_max);
+
   std::println("rate {} msg/s | avg {:.0f} ns | min {} ns | p50 {} ns | p99 {} ns | p99.9 {} ns | "
                "max {} ns | samples {}",
                rate, avg_ns, min_ns, p50, p99, p999, max_ns, samples);
+  std::println("producer stalled on a full ring for {} of {} messages | stall p99 {} ns | "
+               "stall max {} ns",
+               stalled, samples, stall_p99, stall_max);
+  if constexpr (Origin == latency_origin::intended) {
+    // Side by side: how much of the corrected tail the send-stamp measurement would have hidden.
+    std::sort(all_uncorrected.begin(), all_uncorrected.end());
+    const std::int64_t u_p99 = percentile::nearest_rank(all_uncorrected, 0.99);
+    const std::int64_t u_p999 = percentile::nearest_rank(all_uncorrected, 0.999);
+    state.counters["uncorrected_p99_ns"] = static_cast<double>(u_p99);
+    state.counters["uncorrected_p99.9_ns"] = static_cast<double>(u_p999);
+    std::println("coordinated omission: p99 {} ns (from intended) vs {} ns (from send stamp) | "
+                 "p99.9 {} ns vs {} ns",
+                 p99, u_p99, p999, u_p999);
+  }
+  report_placement(state, *plan, placement_failures.load(std::memory_order_relaxed));
 }
 
 // Consumer busy-spins on an empty queue - the HFT production strategy.
@@ -554,18 +1091,86 @@ inline void test_latency_yield(benchmark::State &state) {
   run_latency</*BusySpin=*/false>(state);
 }
 
+// Busy-spin consumer, latency measured from each message's INTENDED send time, so stalls on a
+// full ring are charged to the messages queued behind them (coordinated-omission corrected).
+// At rates the ring cannot sustain, compare p99 against uncorrected_p99_ns.
+inline void test_latency_corrected(benchmark::State &state) {
+  std::println("--- test_latency_corrected (busy-spin, from intended send time) ---");
+  run_latency</*BusySpin=*/true, latency_origin::intended>(state);
+}
+
 inline void test() {
   test_basic();
   test_limits();
   test_zero_copy();
-  // Arg(N) = number of messages to pump per iteration. Add more ->Arg()s to sweep N.
-  BENCHMARK(test_full_ring_back_pressure)->UseManualTime()->Iterations(1)->Arg(1'000'000'000);
-  BENCHMARK(test_full_ring_back_pressure_yield)->UseManualTime()->Iterations(1)->Arg(1'000'000'000);
-  BENCHMARK(test_full_ring_optimized)->UseManualTime()->Iterations(1)->Arg(1'000'000'000);
-  BENCHMARK(test_full_ring_optimized_zero_copy)->UseManualTime()->Iterations(1)->Arg(1'000'000'000);
-  BENCHMARK(test_full_ring_optimized_yield)->UseManualTime()->Iterations(1)->Arg(100'000'000);
-  // Sweep a couple of representative arrival rates (msgs/sec).
-  BENCHMARK(test_latency)->UseRealTime()->Iterations(1)->Arg(100'000)->Arg(1'000'000'000);
-  BENCHMARK(test_latency_yield)->UseRealTime()->Iterations(1)->Arg(100'000)->Arg(1'000'000'000);
+  test_reserve_commit();
+  test_small_copy();
+  test_record_headers();
+  test_prefetch();
+  test_percentile();
+  // Args = {N messages per iteration, placement topology, SCHED_FIFO priority}. Every benchmark
+  // is swept over thread_placement::queue_topologies (placements this host cannot provide are
+  // skipped); set the last list to e.g. {0, 80} to also measure under SCHED_FIFO.
+  const std::vector<std::string> names{"N", "placement", "fifo"};
+  const auto placements = thread_placement::topology_args(thread_placement::queue_topologies);
+  BENCHMARK(test_full_ring_back_pressure)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1'000'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_full_ring_back_pressure_yield)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1'000'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_full_ring_optimized)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1'000'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_full_ring_optimized_zero_copy)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1'000'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_full_ring_optimized_simd)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1'000'000'000}, placements, {0}})
+      ->ArgNames(names);
+  BENCHMARK(test_full_ring_optimized_yield)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000'000}, placements, {0}})
+      ->ArgNames(names);
+  // Copy kernels in the ring path, single-threaded: libc memcpy vs small_copy::simd.
+  BENCHMARK(test_ring_copy_libc);
+  BENCHMARK(test_ring_copy_simd);
+  // Payload bandwidth per record header policy, 8-byte and 64-byte messages.
+  register_record_header_bandwidth<8>();
+  register_record_header_bandwidth<64>();
+  // A consumer draining a full 256 MiB ring: message size x prefetch depth K (0 = off).
+  BENCHMARK(test_prefetch_read_view)
+      ->UseManualTime()
+      ->Iterations(3)
+      ->ArgsProduct({{256, 1024, 4096}, {0, 2, 4, 8, 16}})
+      ->ArgNames({"bytes", "depth"});
+  // Sweep a couple of representative arrival rates (msgs/sec) under every placement.
+  const std::vector<std::string> latency_names{"rate", "placement", "fifo"};
+  BENCHMARK(test_latency)
+      ->UseRealTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000, 1'000'000'000}, placements, {0}})
+      ->ArgNames(latency_names);
+  BENCHMARK(test_latency_yield)
+      ->UseRealTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000, 1'000'000'000}, placements, {0}})
+      ->ArgNames(latency_names);
+  BENCHMARK(test_latency_corrected)
+      ->UseRealTime()
+      ->Iterations(1)
+      ->ArgsProduct({{100'000, 1'000'000'000}, placements, {0}})
+      ->ArgNames(latency_names);
 }
 } // namespace fast_queue_spsc
@@ -0,0 +1,493 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  feed_handler.hpp — UDP multicast in, SPSC ring out
+// =====================================================================================
+//
+// The queue benchmarks feed fast_queue_t from a thread that makes its messages up. A real
+// feed arrives as UDP multicast, one datagram per exchange packet, and the feed handler is the
+// producer: it takes datagrams off the socket, checks their sequence numbers and publishes the
+// payloads for the strategy thread. This is that producer, on loopback, with a publisher to
+// drive it:
+//
+//  - BATCHED RECEIVE: one recvmmsg collects up to `batch` datagrams, so the syscall cost is
+//    paid once per batch instead of once per packet when the feed bursts.
+//  - RESERVE / COMMIT: each payload goes into the ring with try_reserve + commit_write - the
+//    length header is written once, after the copy, and nothing is staged a second time. The
+//    datagrams land in a per-batch receive area first: recvmmsg needs every destination before
+//    it returns, and the ring has room for one reservation at a time. That one copy is from
+//    memory the kernel just wrote, still in L1.
+//  - SEQUENCE GAPS: every datagram carries a packet_header { seq, send_ns }. A seq beyond the
+//    next expected one is a gap (counted, with the number of packets missing - where a real
+//    handler would request a retransmission or resynchronise from a snapshot); one below it
+//    is a duplicate or a packet arriving after it was given up on, and is dropped. The handler
+//    synchronises on the first packet it sees, so it can join a running feed.
+//  - BACK-PRESSURE: UDP cannot push back. When the ring is full the handler spins until the
+//    consumer makes room; meanwhile the socket's receive buffer absorbs the feed, and what it
+//    cannot absorb the kernel drops - the publisher's next seq then shows up as a gap.
+//
+// WAITING for data is where a socket-fed producer gets its latency tail: a thread asleep in the
+// kernel pays a wakeup and a context switch before it sees the packet. feed_config::mode picks
+// how poll() waits:
+//
+//  - busy_poll: never sleeps. recvmmsg(MSG_DONTWAIT) returns at once and the caller spins on
+//    poll() - on a core of its own (thread_placement::pin_current_thread), or the spinning
+//    starves whatever shares it. SO_BUSY_POLL is set as well, so on a NAPI NIC the receive
+//    call itself polls the device queue instead of waiting for its interrupt (loopback has no
+//    NAPI queue: there the option is accepted and does nothing).
+//  - epoll: sleeps in epoll_wait until the socket is readable, then drains it.
+//  - blocking: sleeps in recvmmsg(MSG_WAITFORONE) until the first datagram of a batch.
+//  The sleeping modes give up after `wait_timeout` and return 0, so the loop can check for
+//  shutdown.
+//
+// TIMESTAMPS: with SO_TIMESTAMPING each datagram carries the time the kernel received it, the
+// software stamp on CLOCK_REALTIME, converted to steady_clock. A NIC stamp would be on the
+// NIC's own clock, which no offset taken here translates, so hardware stamps are not asked
+// for. poll() gathers, per packet, an `envelope`: seq, the publisher's send_ns, that kernel
+// stamp and the time recvmmsg handed it over. user_rx_ns - kernel_rx_ns is the wakeup cost of
+// the mode; user_rx_ns - send_ns the whole way from the publisher. With feed_config::envelope
+// the envelope is written into the ring in front of the payload, so the strategy thread
+// downstream has the stamps too; on_commit always gets it.
+//
+// Wire format: [packet_header][payload], little-endian, one message per datagram.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <sys/epoll.h>
+#endif
+
+namespace feed_handler {
+
+inline void spin_pause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+struct packet_header {
+  std::uint64_t seq;     // from 1, one per datagram
+  std::uint64_t send_ns; // publisher's steady_clock when the datagram was sent
+};
+static_assert(sizeof(packet_header) == 16);
+
+// Largest datagram handled: an Ethernet frame's UDP payload. Longer ones are cut and dropped.
+inline constexpr std::size_t MAX_DATAGRAM = 1472;
+inline constexpr std::size_t MAX_PAYLOAD = MAX_DATAGRAM - sizeof(packet_header);
+
+// What the handler knows about a packet it published; see `feed_config::envelope`.
+struct envelope {
+  std::uint64_t seq;
+  std::uint64_t send_ns;      // publisher's stamp
+  std::uint64_t kernel_rx_ns; // SO_TIMESTAMPING receive stamp on steady_clock; 0 = none
+  std::uint64_t user_rx_ns;   // when recvmmsg returned it to the handler
+};
+static_assert(sizeof(envelope) == 32);
+
+enum class receive_mode : std::uint8_t { busy_poll, epoll, blocking };
+
+inline const char *to_string(receive_mode m) noexcept {
+  switch (m) {
+  case receive_mode::busy_poll:
+    return "busy_poll";
+  case receive_mode::epoll:
+    return "epoll";
+  case receive_mode::blocking:
+    return "blocking";
+  }
+  return "?";
+}
+
+inline std::uint64_t now_ns() noexcept {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+}
+
+struct feed_config {
+  std::string group = "239.1.1.1";     // multicast group (a unicast address also works)
+  std::uint16_t port = 31001;
+  std::string interface = "127.0.0.1"; // where to join / send the group
+  int rcvbuf = 8 << 20;                // SO_RCVBUF request; the kernel caps it at rmem_max
+  std::size_t batch = 32;              // datagrams per recvmmsg
+  int ttl = 0;                         // publisher's multicast TTL: 0 keeps it on this host
+  receive_mode mode = receive_mode::busy_poll;
+  int busy_poll_us = 50;               // SO_BUSY_POLL budget in busy_poll mode
+  std::chrono::milliseconds wait_timeout{100}; // epoll / blocking: poll() returns 0 after it
+  bool timestamps = true;              // ask for SO_TIMESTAMPING receive stamps
+  bool envelope = false;               // write the envelope in front of each payload
+};
+
+namespace detail {
+
+inline bool parse(const feed_config &cfg, sockaddr_in &group, in_addr &iface) {
+  group = {};
+  group.sin_family = AF_INET;
+  group.sin_port = htons(cfg.port);
+  return ::inet_pton(AF_INET, cfg.group.c_str(), &group.sin_addr) == 1 &&
+         ::inet_pton(AF_INET, cfg.interface.c_str(), &iface) == 1;
+}
+
+inline bool is_multicast(const sockaddr_in &a) noexcept {
+  return (ntohl(a.sin_addr.s_addr) >> 28) == 0xE; // 224.0.0.0/4
+}
+
+} // namespace detail
+
+/**
+ * Publishes numbered datagrams to the feed address: the local stand-in for the exchange.
+ * send() stamps the next seq and the send time in front of the payload; skip() burns
+ * sequence numbers without sending, which is how tests make gaps.
+ */
+class publisher {
+public:
+  explicit publisher(const feed_config &cfg) {
+    sockaddr_in group{};
+    in_addr iface{};
+    if (!detail::parse(cfg, group, iface)) {
+      return;
+    }
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+      return;
+    }
+    bool ok = true;
+    if (detail::is_multicast(group)) {
+      const unsigned char loop = 1;
+      const auto ttl = static_cast<unsigned char>(cfg.ttl);
+      ok = ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) == 0 &&
+           ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0 &&
+           ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == 0;
+    }
+    if (!ok || ::connect(fd_, reinterpret_cast<const sockaddr *>(&group), sizeof(group)) != 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  publisher(const publisher &) = delete;
+  publisher &operator=(const publisher &) = delete;
+  ~publisher() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  bool ok() const noexcept { return fd_ >= 0; }
+
+  // Sends one datagram; false if the kernel refused it (the seq is used either way).
+  bool send(std::span<const std::byte> payload) noexcept {
+    packet_header h{seq_++, now_ns()};
+    iovec iov[2] = {{&h, sizeof(h)},
+                    {const_cast<std::byte *>(payload.data()), payload.size()}};
+    msghdr m{};
+    m.msg_iov = iov;
+    m.msg_iovlen = 2;
+    return ::sendmsg(fd_, &m, 0) == static_cast<ssize_t>(sizeof(h) + payload.size());
+  }
+
+  void skip(std::uint64_t n) noexcept { seq_ += n; }
+  std::uint64_t next_seq() const noexcept { return seq_; }
+
+private:
+  int fd_ = -1;
+  std::uint64_t seq_ = 1;
+};
+
+/**
+ * The feed handler: receives the feed at `cfg` and publishes each payload into `q` as one
+ * record, as the ring's only producer. Single-threaded: poll() is called from the handler's
+ * own loop. A socket that could not be set up leaves ok() false and poll() returning 0.
+ */
+template <class Q> class receiver {
+public:
+  receiver(Q &q, const feed_config &cfg)
+      : q_{q}, batch_{std::max<std::size_t>(cfg.batch, 1)}, mode_{cfg.mode},
+        timeout_ms_{static_cast<int>(cfg.wait_timeout.count())}, envelope_{cfg.envelope},
+        area_(batch_ * MAX_DATAGRAM), iov_(batch_), control_(batch_), msgs_(batch_) {
+    for (std::size_t i = 0; i < batch_; ++i) {
+      iov_[i] = {area_.data() + i * MAX_DATAGRAM, MAX_DATAGRAM};
+      msgs_[i].msg_hdr.msg_iov = &iov_[i];
+      msgs_[i].msg_hdr.msg_iovlen = 1;
+      msgs_[i].msg_hdr.msg_control = control_[i].bytes;
+    }
+    // Kernel stamps are CLOCK_REALTIME; everything else here is steady_clock.
+    const std::uint64_t s0 = now_ns();
+    const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    realtime_offset_ns_ = static_cast<std::int64_t>(wall.count()) -
+                          static_cast<std::int64_t>((s0 + now_ns()) / 2);
+    sockaddr_in group{};
+    in_addr iface{};
+    if (!detail::parse(cfg, group, iface)) {
+      return;
+    }
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0); // blocking or not is chosen per receive call
+    if (fd_ < 0) {
+      return;
+    }
+    const int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)); // several handlers per host
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &cfg.rcvbuf, sizeof(cfg.rcvbuf));
+    const timeval tv{static_cast<time_t>(timeout_ms_ / 1000),
+                     static_cast<suseconds_t>(timeout_ms_ % 1000 * 1000)};
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)); // bounds blocking receives
+#if defined(__linux__)
+    if (mode_ == receive_mode::busy_poll) {
+      busy_polling_ = ::setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &cfg.busy_poll_us,
+                                   sizeof(cfg.busy_poll_us)) == 0;
+    }
+    if (cfg.timestamps) {
+      const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+      timestamping_ = ::setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+    }
+#endif
+    // Bound to the group address the socket gets only this group's traffic on the port.
+    bool ok = ::bind(fd_, reinterpret_cast<const sockaddr *>(&group), sizeof(group)) == 0;
+    if (ok && detail::is_multicast(group)) {
+      const ip_mreq mreq{group.sin_addr, iface};
+      ok = ::setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+    }
+#if defined(__linux__)
+    if (ok && mode_ == receive_mode::epoll) {
+      ep_ = ::epoll_create1(EPOLL_CLOEXEC);
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ok = ep_ >= 0 && ::epoll_ctl(ep_, EPOLL_CTL_ADD, fd_, &ev) == 0;
+    }
+#endif
+    if (!ok) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  receiver(const receiver &) = delete;
+  receiver &operator=(const receiver &) = delete;
+  ~receiver() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    if (ep_ >= 0) {
+      ::close(ep_);
+    }
+  }
+
+  bool ok() const noexcept { return fd_ >= 0; }
+  receive_mode mode() const noexcept { return mode_; }
+  // Whether the kernel took SO_BUSY_POLL / SO_TIMESTAMPING.
+  bool busy_polling() const noexcept { return busy_polling_; }
+  bool timestamping() const noexcept { return timestamping_; }
+
+  /**
+   * Takes what the socket has, up to one batch, and publishes it; in the epoll and blocking
+   * modes it first waits up to `wait_timeout` for something to arrive. Returns the number of
+   * datagrams received (0: nothing came). `on_commit(envelope, now_ns)` runs after each
+   * payload is published.
+   */
+  template <class OnCommit> std::size_t poll(OnCommit &&on_commit) {
+    const std::size_t n = receive();
+    const std::uint64_t user_rx_ns = now_ns();
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::byte *d = area_.data() + i * MAX_DATAGRAM;
+      const auto len = static_cast<std::size_t>(msgs_[i].msg_len);
+      if (len < sizeof(packet_header) || (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+        ++malformed_;
+        continue;
+      }
+      packet_header h;
+      std::memcpy(&h, d, sizeof(h));
+      if (h.seq < next_seq_) {
+        ++duplicates_;
+        continue;
+      }
+      if (h.seq > next_seq_ && next_seq_ != 0) {
+        ++gaps_;
+        missing_ += h.seq - next_seq_;
+      }
+      next_seq_ = h.seq + 1;
+      const envelope e{h.seq, h.send_ns, kernel_rx_ns(msgs_[i].msg_hdr), user_rx_ns};
+      publish(e, {d + sizeof(h), len - sizeof(h)});
+      on_commit(e, now_ns());
+    }
+    return n;
+  }
+
+  std::size_t poll() {
+    return poll([](const envelope &, std::uint64_t) {});
+  }
+
+  // 0 until the first packet has been seen.
+  std::uint64_t next_seq() const noexcept { return next_seq_; }
+  std::uint64_t packets() const noexcept { return packets_; }
+  std::uint64_t bytes() const noexcept { return bytes_; }        // payload bytes published
+  std::uint64_t gaps() const noexcept { return gaps_; }          // runs of missing packets
+  std::uint64_t missing() const noexcept { return missing_; }    // packets in those runs
+  std::uint64_t duplicates() const noexcept { return duplicates_; }
+  std::uint64_t malformed() const noexcept { return malformed_; } // short or truncated
+  std::uint64_t full_spins() const noexcept { return full_spins_; }
+  std::uint64_t batches() const noexcept { return batches_; }    // recvmmsg calls that got data
+  std::uint64_t errors() const noexcept { return errors_; }
+
+private:
+  std::size_t receive() {
+    if (fd_ < 0) {
+      return 0;
+    }
+    for (std::size_t i = 0; i < batch_; ++i) {
+      msgs_[i].msg_hdr.msg_flags = 0;
+      msgs_[i].msg_hdr.msg_controllen = sizeof(control_[i].bytes);
+    }
+#if defined(__linux__)
+    if (mode_ == receive_mode::epoll) {
+      epoll_event ev;
+      if (::epoll_wait(ep_, &ev, 1, timeout_ms_) <= 0) {
+        return 0; // timed out (or interrupted)
+      }
+    }
+    const int flags = mode_ == receive_mode::blocking ? MSG_WAITFORONE : MSG_DONTWAIT;
+    const int r = ::recvmmsg(fd_, msgs_.data(), static_cast<unsigned>(batch_), flags, nullptr);
+    if (r < 0) {
+      errors_ += errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+      return 0;
+    }
+    batches_ += r > 0;
+    return static_cast<std::size_t>(r);
+#else
+    if (mode_ != receive_mode::busy_poll) { // no epoll: poll(2) waits for both modes
+      pollfd p{fd_, POLLIN, 0};
+      if (::poll(&p, 1, timeout_ms_) <= 0) {
+        return 0;
+      }
+    }
+    std::size_t n = 0; // no recvmmsg: one recvmsg per datagram
+    for (; n < batch_; ++n) {
+      const ssize_t r = ::recvmsg(fd_, &msgs_[n].msg_hdr, MSG_DONTWAIT);
+      if (r < 0) {
+        errors_ += errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+        break;
+      }
+      msgs_[n].msg_len = static_cast<unsigned>(r);
+    }
+    batches_ += n > 0;
+    return n;
+#endif
+  }
+
+  // The SO_TIMESTAMPING stamp of a received datagram on steady_clock, 0 if it has none.
+  std::uint64_t kernel_rx_ns([[maybe_unused]] const msghdr &m) const noexcept {
+#if defined(__linux__)
+    for (const cmsghdr *c = CMSG_FIRSTHDR(&m); c != nullptr;
+         c = CMSG_NXTHDR(const_cast<msghdr *>(&m), const_cast<cmsghdr *>(c))) {
+      if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPING) {
+        continue;
+      }
+      scm_timestamping ts;
+      std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+      const timespec &t = ts.ts[0]; // software stamp; ts[2] is the NIC clock, never requested
+      if (t.tv_sec == 0 && t.tv_nsec == 0) {
+        return 0;
+      }
+      const std::int64_t wall = static_cast<std::int64_t>(t.tv_sec) * 1'000'000'000 + t.tv_nsec;
+      return static_cast<std::uint64_t>(wall - realtime_offset_ns_);
+    }
+#endif
+    return 0;
+  }
+
+  // Copies `src` into the reservation at byte `offset`, across the wrap if needed.
+  static void write_at(const fast_queue_spsc::write_view &v, std::size_t offset,
+                       std::span<const std::byte> src) noexcept {
+    const std::size_t first = v.first.size();
+    std::size_t done = 0;
+    if (offset < first) {
+      done = std::min(src.size(), first - offset);
+      std::memcpy(v.first.data() + offset, src.data(), done);
+    }
+    if (done < src.size()) {
+      std::memcpy(v.second.data() + (offset + done - first), src.data() + done,
+                  src.size() - done);
+    }
+  }
+
+  void publish(const envelope &e, std::span<const std::byte> payload) {
+    const std::size_t head = envelope_ ? sizeof(e) : 0;
+    auto v = prod_.try_reserve(q_, head + payload.size());
+    while (!v) { // the consumer is behind: wait for room, the socket buffer holds the feed
+      ++full_spins_;
+      spin_pause();
+      v = prod_.try_reserve(q_, head + payload.size());
+    }
+    write_at(*v, 0, std::span{reinterpret_cast<const std::byte *>(&e), head});
+    write_at(*v, head, payload);
+    prod_.commit_write(q_);
+    ++packets_;
+    bytes_ += payload.size();
+  }
+
+#if !defined(__linux__)
+  struct mmsghdr {
+    msghdr msg_hdr;
+    unsigned msg_len;
+  };
+#endif
+
+  // Per-datagram ancillary data: room for one scm_timestamping message.
+  struct control_buffer {
+    alignas(cmsghdr) unsigned char bytes[128];
+  };
+
+  Q &q_;
+  fast_queue_spsc::producer prod_{};
+  std::size_t batch_;
+  receive_mode mode_;
+  int timeout_ms_;
+  bool envelope_;
+  bool busy_polling_ = false;
+  bool timestamping_ = false;
+  std::int64_t realtime_offset_ns_ = 0; // CLOCK_REALTIME - steady_clock
+  std::vector<std::byte> area_; // batch_ receive slots of MAX_DATAGRAM bytes
+  std::vector<iovec> iov_;
+  std::vector<control_buffer> control_;
+  std::vector<mmsghdr> msgs_;
+  int fd_ = -1;
+  int ep_ = -1; // epoll instance, epoll mode only
+  std::uint64_t next_seq_ = 0;
+  std::uint64_t packets_ = 0;
+  std::uint64_t bytes_ = 0;
+  std::uint64_t gaps_ = 0;
+  std::uint64_t missing_ = 0;
+  std::uint64_t duplicates_ = 0;
+  std::uint64_t malformed_ = 0;
+  std::uint64_t full_spins_ = 0;
+  std::uint64_t batches_ = 0;
+  std::uint64_t errors_ = 0;
+};
+
+} // namespace feed_handler
@@ -0,0 +1,400 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for feed_handler.hpp, over real UDP multicast on loopback. The tests
+// check gap and duplicate accounting, that variable-size payloads come out of a small,
+// wrapping ring byte for byte, and that every receive mode delivers the same packets with
+// ordered envelope stamps. The benchmarks run publisher, feed handler and strategy consumer
+// on their own threads: packets per second through the handler by recvmmsg batch size with
+// the publisher flat out, the wire-to-queue latency of a paced feed, and the receive latency
+// tail of the blocking, epoll and busy-poll modes.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "feed_handler.hpp"
+#include "percentile.hpp"
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <print>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace feed_handler {
+
+// Payload of packet `seq`: 8 + seq % 200 bytes, each a function of seq and position.
+inline std::size_t fill_payload(std::uint64_t seq, std::span<std::byte> out) {
+  const std::size_t n = 8 + seq % 200;
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<std::byte>(seq * 31 + i);
+  }
+  return n;
+}
+
+// Polls until `done()` or a second has passed without it.
+template <class Receiver, class Done> void poll_until(Receiver &r, Done &&done) {
+  const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+  while (!done() && std::chrono::steady_clock::now() < give_up) {
+    if (r.poll() == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+inline void test_sequence_gaps() {
+  std::println("--- test_feed_handler_sequence_gaps ---");
+  using queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 16>;
+  const feed_config cfg{.port = 31011, .batch = 4};
+  auto q = std::make_unique<queue>();
+  receiver<queue> r{*q, cfg};
+  publisher p{cfg};
+  publisher late{cfg}; // a second source re-sending seq 1.. : duplicates
+  assert(r.ok() && p.ok() && late.ok());
+
+  std::array<std::byte, MAX_PAYLOAD> buf;
+  for (std::uint64_t seq = 1; seq <= 10; ++seq) {
+    if (seq >= 6 && seq <= 8) {
+      p.skip(1); // lost on the wire
+      continue;
+    }
+    [[maybe_unused]] const bool sent = p.send(std::span{buf.data(), fill_payload(seq, buf)});
+    assert(sent);
+  }
+  poll_until(r, [&] { return r.packets() == 7; });
+  [[maybe_unused]] const bool resent = late.send(std::span{buf.data(), fill_payload(1, buf)});
+  assert(resent);
+  poll_until(r, [&] { return r.duplicates() == 1; });
+  assert(r.packets() == 7 && r.gaps() == 1 && r.missing() == 3 && r.next_seq() == 11);
+  assert(r.duplicates() == 1 && r.malformed() == 0 && r.errors() == 0);
+
+  fast_queue_spsc::consumer c;
+  std::array<std::byte, MAX_PAYLOAD> want;
+  for (const std::uint64_t seq : {1, 2, 3, 4, 5, 9, 10}) {
+    [[maybe_unused]] const auto n = c.try_read(*q, buf);
+    [[maybe_unused]] const std::size_t len = fill_payload(seq, want);
+    assert(n && *n == len && std::memcmp(buf.data(), want.data(), len) == 0);
+  }
+  assert(!c.try_read(*q, buf));
+  std::println("test_feed_handler_sequence_gaps PASSED");
+}
+
+inline void test_payload_round_trip() {
+  std::println("--- test_feed_handler_round_trip ---");
+  using queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 14>; // wraps every ~100 packets
+  constexpr std::uint64_t N = 20'000;
+  constexpr std::uint64_t BURST = 32;
+  const feed_config cfg{.port = 31012};
+  auto q = std::make_unique<queue>();
+  receiver<queue> r{*q, cfg};
+  publisher p{cfg};
+  fast_queue_spsc::consumer c;
+  std::array<std::byte, MAX_PAYLOAD> buf, want;
+  std::uint64_t got = 0;
+  for (std::uint64_t seq = 1; seq <= N; seq += BURST) {
+    for (std::uint64_t s = seq; s < seq + BURST && s <= N; ++s) {
+      [[maybe_unused]] const bool sent = p.send(std::span{buf.data(), fill_payload(s, buf)});
+      assert(sent);
+    }
+    const std::uint64_t expect = std::min(seq + BURST - 1, N);
+    poll_until(r, [&] { return r.packets() == expect; });
+    while (const auto v = c.try_read_view(*q)) {
+      ++got;
+      [[maybe_unused]] const std::size_t len = fill_payload(got, want);
+      assert(v->size() == len);
+      assert(std::memcmp(v->first.data(), want.data(), v->first.size()) == 0);
+      assert(std::memcmp(v->second.data(), want.data() + v->first.size(), v->second.size()) ==
+             0);
+      c.commit_read(*q);
+    }
+  }
+  assert(got == N && r.packets() == N && r.gaps() == 0 && r.duplicates() == 0);
+  assert(r.batches() < N); // some polls found more than one datagram waiting
+  std::println("test_feed_handler_round_trip PASSED ({} packets in {} batches)", N,
+               r.batches());
+}
+
+// Every mode delivers the same packets, with the envelope in front of each payload and the
+// stamps in order; the sleeping modes give up after wait_timeout on a silent socket.
+inline void test_receive_modes() {
+  std::println("--- test_feed_handler_receive_modes ---");
+  using queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 16>;
+  constexpr std::uint64_t N = 50;
+  // The kernel stamp is converted from CLOCK_REALTIME: allow for the offset's error.
+  [[maybe_unused]] constexpr std::uint64_t SLACK_NS = 100'000;
+  std::uint16_t port = 31013;
+  for (const receive_mode mode :
+       {receive_mode::busy_poll, receive_mode::epoll, receive_mode::blocking}) {
+    const feed_config cfg{.port = port++,
+                          .batch = 4,
+                          .mode = mode,
+                          .wait_timeout = std::chrono::milliseconds{10},
+                          .envelope = true};
+    auto q = std::make_unique<queue>();
+    receiver<queue> r{*q, cfg};
+    publisher p{cfg};
+    assert(r.ok() && p.ok() && r.mode() == mode);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    assert(r.poll() == 0); // nothing sent yet
+    const auto waited = std::chrono::steady_clock::now() - t0;
+    assert(mode == receive_mode::busy_poll ? waited < std::chrono::milliseconds{5}
+                                           : waited >= std::chrono::milliseconds{5});
+
+    std::array<std::byte, MAX_PAYLOAD> buf, want;
+    for (std::uint64_t seq = 1; seq <= N; ++seq) {
+      [[maybe_unused]] const bool sent = p.send(std::span{buf.data(), fill_payload(seq, buf)});
+      assert(sent);
+    }
+    poll_until(r, [&] { return r.packets() == N; });
+    assert(r.packets() == N && r.gaps() == 0);
+
+    fast_queue_spsc::consumer c;
+    for (std::uint64_t seq = 1; seq <= N; ++seq) {
+      [[maybe_unused]] const auto n = c.try_read(*q, buf);
+      envelope e;
+      std::memcpy(&e, buf.data(), sizeof(e));
+      [[maybe_unused]] const std::size_t len = fill_payload(seq, want);
+      assert(n && *n == sizeof(e) + len && e.seq == seq);
+      assert(std::memcmp(buf.data() + sizeof(e), want.data(), len) == 0);
+      assert(e.send_ns <= e.user_rx_ns);
+      if (r.timestamping()) {
+        assert(e.kernel_rx_ns + SLACK_NS >= e.send_ns && e.kernel_rx_ns <= e.user_rx_ns + SLACK_NS);
+      }
+    }
+    std::println("{}: {} packets, kernel stamps {}, SO_BUSY_POLL {}", to_string(mode), N,
+                 r.timestamping() ? "on" : "off", r.busy_polling() ? "on" : "off");
+  }
+  std::println("test_feed_handler_receive_modes PASSED");
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// Three threads: the publisher, the feed handler (the benchmark thread) and a consumer that
+// drains the 1 MiB ring. Payloads are 64 bytes, about an ITCH add-order with its framing.
+
+constexpr std::size_t BENCH_PAYLOAD = 64;
+using bench_queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 20>;
+
+// Drains `q` until `stop`; returns the number of records read.
+inline std::uint64_t drain(bench_queue &q, const std::atomic<bool> &stop) {
+  fast_queue_spsc::consumer c;
+  std::uint64_t n = 0;
+  for (;;) {
+    if (const auto v = c.try_read_view(q)) {
+      benchmark::DoNotOptimize(v->first.data());
+      c.commit_read(q);
+      ++n;
+    } else if (stop.load(std::memory_order_acquire)) {
+      return n;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Publisher flat out, range(1) packets; the handler polls until the last seq arrived or the
+// feed has been quiet for 20 ms after the publisher finished (the tail was dropped). Reports
+// received packets per second and what the kernel dropped on the way (missing). When the
+// publisher is the bottleneck (one sendmsg per packet) the pps are equal across batch sizes
+// and the saving shows in the CPU column - the handler thread's own time.
+// Args: range(0) = recvmmsg batch.
+inline void BM_FeedHandlerPps(benchmark::State &state) {
+  const feed_config cfg{.port = 31021, .batch = static_cast<std::size_t>(state.range(0))};
+  const auto n = static_cast<std::uint64_t>(state.range(1));
+  std::uint64_t received = 0;
+  std::uint64_t missing = 0;
+  double per_batch = 0;
+  for (auto _ : state) {
+    auto q = std::make_unique<bench_queue>();
+    receiver<bench_queue> r{*q, cfg};
+    publisher p{cfg};
+    std::atomic<bool> done{false};
+    std::atomic<bool> stop{false};
+    std::uint64_t consumed = 0;
+    std::thread consumer([&] { consumed = drain(*q, stop); });
+    const auto t0 = std::chrono::steady_clock::now();
+    std::thread pub([&] {
+      std::array<std::byte, BENCH_PAYLOAD> msg{};
+      for (std::uint64_t i = 0; i < n; ++i) {
+        p.send(msg);
+      }
+      done.store(true, std::memory_order_release);
+    });
+    auto last = t0;
+    while (r.next_seq() <= n) {
+      const auto now = std::chrono::steady_clock::now();
+      if (r.poll() != 0) {
+        last = now;
+      } else if (done.load(std::memory_order_acquire) &&
+                 now - last > std::chrono::milliseconds{20}) {
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    state.SetIterationTime(std::chrono::duration<double>(last - t0).count());
+    pub.join();
+    stop.store(true, std::memory_order_release);
+    consumer.join();
+    assert(consumed == r.packets());
+    received += r.packets();
+    missing += n - r.packets();
+    per_batch = static_cast<double>(r.packets()) / static_cast<double>(r.batches());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(received));
+  state.counters["missing"] =
+      static_cast<double>(missing) / static_cast<double>(state.iterations());
+  state.counters["pkts_per_batch"] = per_batch;
+}
+
+// A paced feed of `n` packets, one every PACE_NS, into a receiver on its own thread; on_commit
+// sees each packet the handler publishes. With two CPUs or more the handler is pinned to the
+// last one and the publisher to CPU 0, so a busy-polling handler has a core to itself; on one
+// CPU the busy-poll loop yields when idle instead, or the publisher would never run.
+constexpr std::uint64_t PACE_NS = 20'000;
+
+template <class OnCommit>
+void run_paced(const feed_config &cfg, std::uint64_t n, OnCommit &&on_commit) {
+  const unsigned cpus = std::thread::hardware_concurrency();
+  const bool own_core = cpus >= 2;
+  auto q = std::make_unique<bench_queue>();
+  std::atomic<bool> joined{false};
+  std::atomic<bool> done{false};
+  std::atomic<bool> stop{false};
+  std::thread consumer([&] { drain(*q, stop); });
+  std::thread handler([&] {
+    if (own_core) {
+      thread_placement::pin_current_thread(static_cast<int>(cpus - 1));
+    }
+    receiver<bench_queue> r{*q, cfg};
+    joined.store(true, std::memory_order_release);
+    std::uint64_t idle_since = 0;
+    while (r.next_seq() <= n) {
+      if (r.poll(on_commit) != 0) {
+        idle_since = 0;
+      } else if (done.load(std::memory_order_acquire)) {
+        idle_since = idle_since == 0 ? now_ns() : idle_since;
+        if (now_ns() - idle_since > 20'000'000) {
+          break; // the tail was dropped
+        }
+      } else if (cfg.mode == receive_mode::busy_poll) {
+        if (own_core) {
+          spin_pause();
+        } else {
+          std::this_thread::yield();
+        }
+      } // the sleeping modes waited inside poll()
+    }
+  });
+  std::thread pub([&] {
+    if (own_core) {
+      thread_placement::pin_current_thread(0);
+    }
+    publisher p{cfg};
+    while (!joined.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    std::array<std::byte, BENCH_PAYLOAD> msg{};
+    std::uint64_t next = now_ns();
+    for (std::uint64_t i = 0; i < n; ++i) {
+      while (now_ns() < next) {
+        std::this_thread::yield();
+      }
+      p.send(msg);
+      next += PACE_NS;
+    }
+    done.store(true, std::memory_order_release);
+  });
+  pub.join();
+  handler.join();
+  stop.store(true, std::memory_order_release);
+  consumer.join();
+}
+
+// Each packet's wire-to-queue latency: its commit time minus its send stamp.
+// Args: range(0) = recvmmsg batch, range(1) = packets.
+inline void BM_FeedHandlerWireToQueue(benchmark::State &state) {
+  const feed_config cfg{.port = 31022, .batch = static_cast<std::size_t>(state.range(0))};
+  std::vector<std::uint64_t> lat;
+  for (auto _ : state) {
+    run_paced(cfg, static_cast<std::uint64_t>(state.range(1)),
+              [&](const envelope &e, std::uint64_t committed_ns) {
+                lat.push_back(committed_ns - e.send_ns);
+              });
+  }
+  std::ranges::sort(lat);
+  state.counters["p50_ns"] = static_cast<double>(percentile::nearest_rank(lat, 0.50));
+  state.counters["p99_ns"] = static_cast<double>(percentile::nearest_rank(lat, 0.99));
+  state.counters["p99.9_ns"] = static_cast<double>(percentile::nearest_rank(lat, 0.999));
+  state.counters["max_ns"] = lat.empty() ? 0.0 : static_cast<double>(lat.back());
+  state.SetItemsProcessed(static_cast<std::int64_t>(lat.size()));
+}
+
+// Receive latency by wait mode, from the envelope: p* is the whole way from the publisher's
+// send to the handler holding the packet (user_rx_ns - send_ns); wake_p* the part after the
+// kernel had it (user_rx_ns - kernel_rx_ns) - the wakeup the mode pays, or does not.
+// Args: range(0) = receive_mode, range(1) = packets.
+inline void BM_FeedHandlerReceiveLatency(benchmark::State &state) {
+  const auto mode = static_cast<receive_mode>(state.range(0));
+  const feed_config cfg{.port = 31023, .batch = 8, .mode = mode};
+  std::vector<std::uint64_t> wire;
+  std::vector<std::uint64_t> wake;
+  for (auto _ : state) {
+    run_paced(cfg, static_cast<std::uint64_t>(state.range(1)),
+              [&](const envelope &e, std::uint64_t) {
+                wire.push_back(e.user_rx_ns - e.send_ns);
+                if (e.kernel_rx_ns != 0 && e.user_rx_ns >= e.kernel_rx_ns) {
+                  wake.push_back(e.user_rx_ns - e.kernel_rx_ns);
+                }
+              });
+  }
+  std::ranges::sort(wire);
+  std::ranges::sort(wake);
+  state.counters["p50_ns"] = static_cast<double>(percentile::nearest_rank(wire, 0.50));
+  state.counters["p99_ns"] = static_cast<double>(percentile::nearest_rank(wire, 0.99));
+  state.counters["p99.9_ns"] = static_cast<double>(percentile::nearest_rank(wire, 0.999));
+  state.counters["wake_p50_ns"] = static_cast<double>(percentile::nearest_rank(wake, 0.50));
+  state.counters["wake_p99_ns"] = static_cast<double>(percentile::nearest_rank(wake, 0.99));
+  state.SetItemsProcessed(static_cast<std::int64_t>(wire.size()));
+  state.SetLabel(std::string{to_string(mode)} +
+                 (std::thread::hardware_concurrency() >= 2 ? " pinned" : " shared cpu"));
+}
+
+inline void test() {
+  test_sequence_gaps();
+  test_payload_round_trip();
+  test_receive_modes();
+  BENCHMARK(BM_FeedHandlerPps)
+      ->UseManualTime()
+      ->Iterations(3)
+      ->ArgsProduct({{1, 8, 32}, {500'000}})
+      ->ArgNames({"batch", "N"});
+  BENCHMARK(BM_FeedHandlerWireToQueue)
+      ->UseRealTime()
+      ->Iterations(1)
+      ->ArgsProduct({{1, 32}, {100'000}})
+      ->ArgNames({"batch", "N"});
+  BENCHMARK(BM_FeedHandlerReceiveLatency)
+      ->UseRealTime()
+      ->Iterations(1)
+      ->ArgsProduct({{static_cast<std::int64_t>(receive_mode::blocking),
+                      static_cast<std::int64_t>(receive_mode::epoll),
+                      static_cast<std::int64_t>(receive_mode::busy_poll)},
+                     {50'000}})
+      ->ArgNames({"mode", "N"});
+}
+
+} // namespace feed_handler
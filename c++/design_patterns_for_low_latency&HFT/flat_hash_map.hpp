@@ -0,0 +1,230 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  flat_hash_map.hpp — open-addressing Robin Hood hash map for integral keys
+// =====================================================================================
+//
+// std::unordered_map keeps every element in its own heap node behind a bucket array: a lookup
+// is a bucket load, then a pointer chase per node in the chain - a cache miss each, plus a
+// malloc per insert and a free per erase. Order-id tables are hit on every message, so they
+// want one flat array instead:
+//
+//  - OPEN ADDRESSING with linear probing: key, value and probe distance sit together in one
+//    slot array, so a lookup reads consecutive slots, usually within a single cache line.
+//  - ROBIN HOOD insertion: an incoming key takes the slot of any resident that is closer to
+//    its own home slot ("rich") and carries on inserting the displaced one. Probe lengths
+//    stay short and even at high load, and a lookup can stop as soon as it meets a resident
+//    closer to home than the probe is - a miss costs about as much as a hit.
+//  - BACKWARD-SHIFT DELETION: erase moves the following run of displaced keys back by one
+//    slot instead of leaving a tombstone, so there is nothing to clean up and lookups never
+//    slow down after heavy insert/erase churn (the order-id pattern).
+//  - keys are mixed with a Fibonacci multiply and the HIGH bits select the slot, so the
+//    sequential ids an exchange hands out spread evenly over the table.
+//  - capacity is a power of two with a 7/8 maximum load. reserve(n) sizes the table so n
+//    keys fit without rehashing; after that, insert and erase never allocate.
+//
+// Pointers returned by find()/insert() stay valid only until the next insert or erase, since
+// both may move slots. Not thread-safe: one owner thread, like the book and the pools.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flat_hash_map {
+
+// Fibonacci hashing: multiply by 2^64 / phi; the table keeps the top log2(capacity) bits.
+struct fibonacci_hash {
+  template <std::integral K> constexpr std::uint64_t operator()(K key) const noexcept {
+    return static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+  }
+};
+
+template <std::integral K, class V, class Hash = fibonacci_hash> class flat_hash_map {
+  static_assert(std::is_default_constructible_v<V> && std::is_move_assignable_v<V>);
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+
+  static constexpr std::size_t MIN_CAPACITY = 16;
+
+  flat_hash_map() { rehash(MIN_CAPACITY); }
+  explicit flat_hash_map(std::size_t expected) { rehash(capacity_for(expected)); }
+
+  /**
+   * Inserts key -> value unless the key is present. Returns the value slot and whether it was
+   * inserted (false: the existing value is left untouched, like std::unordered_map::insert).
+   */
+  std::pair<V *, bool> insert(K key, V value) {
+    if (V *v = find(key)) {
+      return {v, false};
+    }
+    if (size_ + 1 > max_load_) [[unlikely]] {
+      rehash(slots_.size() * 2);
+    }
+    return {place(key, std::move(value)), true};
+  }
+
+  // Inserts a default-constructed value when the key is missing.
+  V &operator[](K key) { return *insert(key, V{}).first; }
+
+  V *find(K key) noexcept {
+    const std::size_t i = index_of(key);
+    return i == NPOS ? nullptr : &slots_[i].value;
+  }
+
+  const V *find(K key) const noexcept {
+    const std::size_t i = index_of(key);
+    return i == NPOS ? nullptr : &slots_[i].value;
+  }
+
+  bool contains(K key) const noexcept { return find(key) != nullptr; }
+
+  // Returns false when the key was not present.
+  bool erase(K key) noexcept {
+    std::size_t i = index_of(key);
+    if (i == NPOS) {
+      return false;
+    }
+    // Backward shift: pull every displaced successor one slot closer to its home.
+    for (std::size_t next = (i + 1) & mask_; slots_[next].dist > 1;
+         i = next, next = (next + 1) & mask_) {
+      slots_[i].key = slots_[next].key;
+      slots_[i].value = std::move(slots_[next].value);
+      slots_[i].dist = static_cast<std::uint8_t>(slots_[next].dist - 1);
+    }
+    slots_[i].dist = 0;
+    slots_[i].value = V{};
+    --size_;
+    return true;
+  }
+
+  // Make room for `n` keys in total; inserting up to n never rehashes afterwards.
+  void reserve(std::size_t n) {
+    const std::size_t cap = capacity_for(n);
+    if (cap > slots_.size()) {
+      rehash(cap);
+    }
+  }
+
+  void clear() noexcept {
+    for (slot &s : slots_) {
+      if (s.dist != 0) {
+        s = slot{};
+      }
+    }
+    size_ = 0;
+  }
+
+  // Calls fn(key, value) for every element, in table order.
+  template <class F> void for_each(F &&fn) const {
+    for (const slot &s : slots_) {
+      if (s.dist != 0) {
+        fn(s.key, s.value);
+      }
+    }
+  }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  std::size_t capacity() const noexcept { return slots_.size(); }
+  std::size_t max_load() const noexcept { return max_load_; }
+
+private:
+  struct slot {
+    K key{};
+    V value{};
+    std::uint8_t dist{0}; // 1 + distance from the home slot; 0 = empty
+  };
+
+  // Probe distances are kept in a byte. With Fibonacci hashing at 7/8 load they stay in the
+  // single digits; a pathological hash that reaches the limit forces a grow instead.
+  static constexpr std::uint8_t MAX_DIST = 255;
+
+  static constexpr std::size_t NPOS = ~std::size_t{0};
+
+  static std::size_t capacity_for(std::size_t n) noexcept {
+    return std::max(MIN_CAPACITY, std::bit_ceil(n + n / 7 + 1));
+  }
+
+  std::size_t home(K key) const noexcept {
+    return static_cast<std::size_t>(Hash{}(key) >> shift_);
+  }
+
+  std::size_t index_of(K key) const noexcept {
+    std::size_t i = home(key);
+    for (std::uint8_t d = 1;; ++d, i = (i + 1) & mask_) {
+      const slot &s = slots_[i];
+      if (s.dist < d) {
+        return NPOS; // empty, or a resident closer to home than we are: key is absent
+      }
+      if (s.dist == d && s.key == key) {
+        return i;
+      }
+    }
+  }
+
+  // Robin Hood insert of a key known to be absent; capacity is already sufficient. Returns
+  // where `key` itself ended up.
+  V *place(K key, V value) {
+    const K original = key;
+    V *placed = nullptr;
+    std::size_t i = home(key);
+    for (std::uint8_t d = 1;; ++d, i = (i + 1) & mask_) {
+      if (d == MAX_DIST) [[unlikely]] {
+        // Pathological clustering: grow, re-insert the element in hand, then look the
+        // original key up again since the rehash moved it.
+        rehash(slots_.size() * 2);
+        place(key, std::move(value));
+        return find(original);
+      }
+      slot &s = slots_[i];
+      if (s.dist == 0) {
+        s.key = key;
+        s.value = std::move(value);
+        s.dist = d;
+        ++size_;
+        return placed != nullptr ? placed : &s.value;
+      }
+      if (s.dist < d) {
+        // The resident is richer: take its slot and carry it on.
+        std::swap(s.key, key);
+        std::swap(s.value, value);
+        std::swap(s.dist, d);
+        placed = placed != nullptr ? placed : &s.value;
+      }
+    }
+  }
+
+  void rehash(std::size_t capacity) {
+    assert(std::has_single_bit(capacity));
+    std::vector<slot> old = std::exchange(slots_, std::vector<slot>(capacity));
+    mask_ = capacity - 1;
+    shift_ = 64 - static_cast<unsigned>(std::countr_zero(capacity));
+    max_load_ = capacity - capacity / 8;
+    size_ = 0;
+    for (slot &s : old) {
+      if (s.dist != 0) {
+        place(s.key, std::move(s.value));
+      }
+    }
+  }
+
+  std::vector<slot> slots_;
+  std::size_t mask_{0};
+  unsigned shift_{64};
+  std::size_t size_{0};
+  std::size_t max_load_{0};
+};
+
+} // namespace flat_hash_map
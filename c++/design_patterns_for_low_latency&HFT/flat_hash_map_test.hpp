@@ -0,0 +1,235 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for flat_hash_map.hpp: basic semantics, a randomized insert / find /
+// erase run against std::unordered_map (with a key range small enough to build long displaced
+// runs), reserve-without-rehash, and churn that must not grow the table. The benchmarks time
+// bulk insert, find (hits and misses) and an order-tracking mix - insert a new id, look up a
+// live one, erase the oldest - against std::unordered_map from 10k to 10M keys.
+//
+
+#pragma once
+
+#include "flat_hash_map.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <print>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace flat_hash_map {
+
+inline void test_basic() {
+  std::println("--- test_flat_hash_map_basic ---");
+  flat_hash_map<std::uint64_t, int> m;
+  [[maybe_unused]] const bool erased_missing = m.erase(42);
+  assert(m.empty() && m.find(42) == nullptr && !erased_missing);
+
+  [[maybe_unused]] auto [v, inserted] = m.insert(42, 1);
+  assert(inserted && *v == 1);
+  [[maybe_unused]] auto [again, inserted_again] = m.insert(42, 2);
+  assert(!inserted_again && *again == 1 && "insert must not overwrite");
+  m[7] = 70;
+  ++m[8];
+  assert(m.size() == 3 && *m.find(7) == 70 && *m.find(8) == 1);
+
+  // Sequential ids, the common order-id shape, well past several growths.
+  for (std::uint64_t id = 1000; id < 101'000; ++id) {
+    m.insert(id, static_cast<int>(id));
+  }
+  assert(m.size() == 100'003);
+  for (std::uint64_t id = 1000; id < 101'000; id += 2) {
+    [[maybe_unused]] const bool erased = m.erase(id);
+    assert(erased);
+  }
+  for (std::uint64_t id = 1000; id < 101'000; ++id) {
+    [[maybe_unused]] const int *p = m.find(id);
+    assert((id % 2 == 0) == (p == nullptr));
+    assert(p == nullptr || *p == static_cast<int>(id));
+  }
+  std::size_t visited = 0;
+  m.for_each([&](std::uint64_t, int) { ++visited; });
+  assert(visited == m.size());
+  std::println("test_flat_hash_map_basic PASSED");
+}
+
+// Random operations on a narrow key range, so erase regularly shifts long runs back, checked
+// step by step against std::unordered_map.
+inline void test_against_reference() {
+  std::println("--- test_flat_hash_map_reference ---");
+  flat_hash_map<std::uint32_t, std::uint64_t> m;
+  std::unordered_map<std::uint32_t, std::uint64_t> ref;
+  std::mt19937_64 rng{21};
+  for (int step = 0; step < 500'000; ++step) {
+    const auto key = static_cast<std::uint32_t>(rng() % 4096);
+    switch (rng() % 3) {
+    case 0: {
+      [[maybe_unused]] const bool inserted = m.insert(key, step).second;
+      [[maybe_unused]] const bool ref_inserted = ref.emplace(key, step).second;
+      assert(inserted == ref_inserted);
+      break;
+    }
+    case 1: {
+      [[maybe_unused]] const bool erased = m.erase(key);
+      [[maybe_unused]] const bool ref_erased = ref.erase(key) == 1;
+      assert(erased == ref_erased);
+      break;
+    }
+    default: {
+      [[maybe_unused]] const auto *p = m.find(key);
+      [[maybe_unused]] const auto it = ref.find(key);
+      assert((p == nullptr) == (it == ref.end()));
+      assert(p == nullptr || *p == it->second);
+    }
+    }
+    assert(m.size() == ref.size());
+  }
+  for ([[maybe_unused]] const auto &[k, v] : ref) {
+    assert(m.find(k) != nullptr && *m.find(k) == v);
+  }
+  std::println("test_flat_hash_map_reference PASSED");
+}
+
+inline void test_reserve_and_churn() {
+  std::println("--- test_flat_hash_map_reserve ---");
+  constexpr std::size_t N = 100'000;
+  flat_hash_map<std::uint64_t, std::uint64_t> m;
+  m.reserve(N);
+  [[maybe_unused]] const std::size_t cap = m.capacity();
+  assert(m.max_load() >= N);
+  std::mt19937_64 rng{5};
+  std::vector<std::uint64_t> live;
+  for (std::size_t i = 0; i < N; ++i) {
+    live.push_back(rng());
+    m.insert(live.back(), i);
+  }
+  assert(m.capacity() == cap && "reserve(n) must hold n keys without rehashing");
+
+  // Steady-state churn (erase one, insert one) far longer than the table: with backward-shift
+  // deletion nothing accumulates, so the table never grows.
+  for (std::size_t i = 0; i < 10 * N; ++i) {
+    std::uint64_t &slot = live[i % N];
+    [[maybe_unused]] const bool erased = m.erase(slot);
+    assert(erased);
+    slot = rng();
+    m.insert(slot, i);
+  }
+  assert(m.capacity() == cap && m.size() == N);
+  for ([[maybe_unused]] const auto k : live) {
+    assert(m.contains(k));
+  }
+  std::println("test_flat_hash_map_reserve PASSED");
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// Keys are splitmix64(i): random-looking 64-bit ids, recomputable from i so the 10M-key runs
+// need no key array. Both maps are reserved up front. Args: range(0) = N keys.
+
+using flat_map = flat_hash_map<std::uint64_t, std::uint64_t>;
+using std_map = std::unordered_map<std::uint64_t, std::uint64_t>;
+
+constexpr std::uint64_t bench_key(std::uint64_t i) noexcept {
+  std::uint64_t z = i + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+inline void put(flat_map &m, std::uint64_t k, std::uint64_t v) { m.insert(k, v); }
+inline void put(std_map &m, std::uint64_t k, std::uint64_t v) { m.emplace(k, v); }
+inline const std::uint64_t *lookup(const flat_map &m, std::uint64_t k) { return m.find(k); }
+inline const std::uint64_t *lookup(const std_map &m, std::uint64_t k) {
+  const auto it = m.find(k);
+  return it == m.end() ? nullptr : &it->second;
+}
+
+// Bulk insert of N keys into a freshly reserved map (destruction not timed).
+template <class Map> void run_insert(benchmark::State &state) {
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  for (auto _ : state) {
+    auto m = std::make_unique<Map>();
+    m->reserve(n);
+    for (std::uint64_t i = 0; i < n; ++i) {
+      put(*m, bench_key(i), i);
+    }
+    benchmark::DoNotOptimize(m->size());
+    state.PauseTiming();
+    m.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Lookups in random order over a map of N keys. range(1) = hit percentage (100 or 0).
+template <class Map> void run_find(benchmark::State &state) {
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  const bool hits = state.range(1) == 100;
+  Map m;
+  m.reserve(n);
+  for (std::uint64_t i = 0; i < n; ++i) {
+    put(m, bench_key(i), i);
+  }
+  constexpr std::uint64_t BATCH = 1 << 16;
+  std::uint64_t at = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::uint64_t j = 0; j < BATCH; ++j, ++at) {
+      // Misses use keys beyond the inserted range.
+      const std::uint64_t i = bench_key(at ^ 0xABCDEF) % n + (hits ? 0 : n);
+      const std::uint64_t *v = lookup(m, bench_key(i));
+      sum += v != nullptr ? *v : 1;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BATCH));
+}
+
+// Order tracking: N live ids; each op inserts the next id, looks up a random live one and
+// erases the oldest (ids live about N ops, like orders resting on a book).
+template <class Map> void run_mix(benchmark::State &state) {
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  Map m;
+  m.reserve(n + 1);
+  std::uint64_t next = 0;
+  for (; next < n; ++next) {
+    put(m, bench_key(next), next);
+  }
+  std::uint64_t sum = 0;
+  for (auto _ : state) {
+    put(m, bench_key(next), next);
+    const std::uint64_t *v = lookup(m, bench_key(next - bench_key(next ^ 0x5555) % n));
+    sum += v != nullptr ? *v : 0;
+    m.erase(bench_key(next - n));
+    ++next;
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+
+inline void BM_FlatMapInsert(benchmark::State &state) { run_insert<flat_map>(state); }
+inline void BM_UnorderedMapInsert(benchmark::State &state) { run_insert<std_map>(state); }
+inline void BM_FlatMapFind(benchmark::State &state) { run_find<flat_map>(state); }
+inline void BM_UnorderedMapFind(benchmark::State &state) { run_find<std_map>(state); }
+inline void BM_FlatMapMix(benchmark::State &state) { run_mix<flat_map>(state); }
+inline void BM_UnorderedMapMix(benchmark::State &state) { run_mix<std_map>(state); }
+
+inline void test() {
+  test_basic();
+  test_against_reference();
+  test_reserve_and_churn();
+  const std::vector<std::int64_t> sizes{10'000, 100'000, 1'000'000, 10'000'000};
+  BENCHMARK(BM_FlatMapInsert)->ArgsProduct({sizes});
+  BENCHMARK(BM_UnorderedMapInsert)->ArgsProduct({sizes});
+  BENCHMARK(BM_FlatMapFind)->ArgsProduct({sizes, {100, 0}})->ArgNames({"keys", "hit%"});
+  BENCHMARK(BM_UnorderedMapFind)->ArgsProduct({sizes, {100, 0}})->ArgNames({"keys", "hit%"});
+  BENCHMARK(BM_FlatMapMix)->ArgsProduct({sizes});
+  BENCHMARK(BM_UnorderedMapMix)->ArgsProduct({sizes});
+}
+
+} // namespace flat_hash_map
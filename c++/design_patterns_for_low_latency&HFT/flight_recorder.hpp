@@ -0,0 +1,470 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  flight_recorder.hpp — always-on, per-thread binary event trace for the fast queues
+// =====================================================================================
+//
+// When a latency spike shows up we need to know what the producer and consumers were doing
+// around it: was the ring full, was a consumer parked on an empty queue, how long did a
+// zero-copy view stay uncommitted? Sampling profilers are too coarse and logging too slow, so
+// this is a FLIGHT RECORDER: every thread appends compact 16-byte events to its OWN ring and
+// keeps overwriting the oldest ones, forever. Nothing is formatted or flushed on the hot path;
+// the rings are only read when someone asks for a dump (a signal, or an explicit call).
+//
+// -------------------------------------------------------------------------------------
+//  Hot path: a few nanoseconds per event
+// -------------------------------------------------------------------------------------
+//  record_event() = one thread_local load + one TSC read + one 16-byte store + one release
+//  store of the thread's head counter. No atomics RMW, no sharing: each ring has exactly one
+//  writer (its thread) so there is nothing to contend on. The ring is a power of two, so the
+//  slot is `head & MASK`, exactly like the queues.
+//
+// -------------------------------------------------------------------------------------
+//  Compile-time switch
+// -------------------------------------------------------------------------------------
+//  The queue hot paths call record() unconditionally; it is an `if constexpr (enabled)` that
+//  compiles to nothing unless FAST_QUEUE_FLIGHT_RECORDER is defined (CMake option
+//  ENABLE_FLIGHT_RECORDER). record_event() always records, for code that wants the recorder
+//  regardless of the build flag (and for the overhead benchmark).
+//
+// -------------------------------------------------------------------------------------
+//  Dump and conversion
+// -------------------------------------------------------------------------------------
+//  dump_to_fd() only uses write(2), so it is async-signal-safe: install_dump_on_signal()
+//  hooks it to e.g. SIGUSR2 and `kill -USR2 <pid>` snapshots every ring to a binary file
+//  while the process keeps running. load() + write_chrome_json() turn that file into
+//  Chrome-trace / Perfetto JSON (chrome://tracing or ui.perfetto.dev), one track per thread;
+//  full_stall and wait_park become duration slices ending at the next write / read.
+//
+//  A dump taken while threads are recording can race with the writer overwriting the oldest
+//  slots of its ring. load() therefore keeps only the longest suffix with non-decreasing
+//  timestamps per thread, which drops exactly those overwritten-during-dump entries.
+//
+
+#pragma once
+
+#include "cache_line.hpp"
+#include "posix_io.hpp"
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace flight_recorder {
+
+#if defined(FAST_QUEUE_FLIGHT_RECORDER)
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+// Events per thread ring (16 bytes each -> 256 KiB per thread). Power of two.
+constexpr std::size_t EVENTS_PER_THREAD = std::size_t{1} << 14;
+static_assert((EVENTS_PER_THREAD & (EVENTS_PER_THREAD - 1)) == 0,
+              "EVENTS_PER_THREAD must be a power of two");
+constexpr std::uint64_t EVENT_MASK = EVENTS_PER_THREAD - 1;
+
+// Threads that can hold a ring at the same time. A thread that finds no free slot records
+// nothing (counted in dropped_threads()).
+constexpr std::size_t MAX_THREADS = 128;
+
+enum class event : std::uint8_t {
+  write = 1,       // producer committed a record; arg = record bytes
+  full_stall = 2,  // producer found the ring full (logged once per stall); arg = record bytes
+  read = 3,        // consumer copied a record out; arg = payload bytes
+  read_view = 4,   // consumer obtained a zero-copy view; arg = payload bytes
+  view_commit = 5, // consumer released the view; arg = record bytes
+  wait_park = 6,   // consumer found the ring empty (logged once per idle spell)
+};
+
+inline const char *to_string(event e) noexcept {
+  switch (e) {
+  case event::write:
+    return "write";
+  case event::full_stall:
+    return "full_stall";
+  case event::read:
+    return "read";
+  case event::read_view:
+    return "read_view";
+  case event::view_commit:
+    return "view_commit";
+  case event::wait_park:
+    return "wait_park";
+  }
+  return "unknown";
+}
+
+// One trace entry. `source` tells apart the actors sharing one thread or one queue type, e.g.
+// the SPMC consumer id (PRODUCER_SOURCE for producers).
+struct record_t {
+  std::uint64_t tsc;
+  std::uint32_t arg;
+  event type;
+  std::uint8_t source;
+  std::uint16_t reserved;
+};
+static_assert(sizeof(record_t) == 16, "keep trace entries at 16 bytes");
+
+constexpr std::uint8_t PRODUCER_SOURCE = 0xFF;
+
+// The trace's clock (tsc.hpp), under the names the recorder has always exported.
+using tsc::calibrate_ticks_per_ns;
+using tsc::read_tsc;
+
+/**
+ * One thread's ring. `head` counts events ever recorded by the owning thread (the only
+ * writer); the newest event is at (head - 1) & EVENT_MASK. Buffers are never freed: when a
+ * thread exits its slot is released and a later thread may reuse it, so a dump never touches
+ * freed memory even from a signal handler.
+ */
+struct alignas(CACHE_LINE_SIZE) thread_buffer {
+  std::atomic<std::uint64_t> head{0};
+  std::atomic<bool> in_use{false};
+  std::uint64_t os_tid{0};
+  std::array<record_t, EVENTS_PER_THREAD> events{};
+};
+
+struct registry {
+  std::array<std::atomic<thread_buffer *>, MAX_THREADS> slots{};
+  std::atomic<std::uint64_t> dropped_threads{0};
+  std::atomic<double> ticks_per_ns{0.0};
+  std::array<char, 256> dump_path{}; // written once by install_dump_on_signal
+};
+
+inline registry &global_registry() noexcept {
+  static registry r;
+  return r;
+}
+
+inline std::uint64_t current_os_tid() noexcept {
+#if defined(__linux__)
+  return static_cast<std::uint64_t>(::gettid());
+#elif defined(__APPLE__)
+  std::uint64_t tid = 0;
+  pthread_threadid_np(nullptr, &tid);
+  return tid;
+#else
+  return 0;
+#endif
+}
+
+// Claim a ring for the calling thread: a never-used slot first (so the history of exited
+// threads survives as long as possible), then a released one. nullptr when all are taken.
+inline thread_buffer *acquire_buffer() {
+  auto &reg = global_registry();
+  for (auto &slot : reg.slots) {
+    if (slot.load(std::memory_order_acquire) != nullptr) {
+      continue;
+    }
+    auto *fresh = new thread_buffer;
+    fresh->in_use.store(true, std::memory_order_relaxed);
+    fresh->os_tid = current_os_tid();
+    thread_buffer *expected = nullptr;
+    if (slot.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+      return fresh;
+    }
+    delete fresh; // another thread won this slot; keep scanning
+  }
+  for (auto &slot : reg.slots) {
+    auto *b = slot.load(std::memory_order_acquire);
+    bool expected = false;
+    if (b != nullptr && b->in_use.compare_exchange_strong(expected, true)) {
+      b->os_tid = current_os_tid();
+      b->head.store(0, std::memory_order_release);
+      return b;
+    }
+  }
+  reg.dropped_threads.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+// Per-thread handle: claims a ring on first use, releases the slot when the thread exits.
+struct thread_handle {
+  thread_buffer *buffer{nullptr};
+  bool unavailable{false};
+
+  ~thread_handle() {
+    if (buffer != nullptr) {
+      buffer->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+inline thread_local thread_handle this_thread_handle;
+
+/**
+ * Append one event to the calling thread's ring, regardless of the build flag. The first call
+ * on a thread claims its ring (allocation, off the steady-state path).
+ */
+inline void record_event(event type, std::uint32_t arg = 0,
+                         std::uint8_t source = PRODUCER_SOURCE) noexcept {
+  auto &h = this_thread_handle;
+  thread_buffer *b = h.buffer;
+  if (b == nullptr) [[unlikely]] {
+    if (h.unavailable) {
+      return;
+    }
+    b = h.buffer = acquire_buffer();
+    if (b == nullptr) {
+      h.unavailable = true;
+      return;
+    }
+  }
+  const std::uint64_t head = b->head.load(std::memory_order_relaxed);
+  b->events[head & EVENT_MASK] = record_t{read_tsc(), arg, type, source, 0};
+  // Release: a dumper that reads head also sees the entry behind it.
+  b->head.store(head + 1, std::memory_order_release);
+}
+
+// The call the queue hot paths use: compiled out unless FAST_QUEUE_FLIGHT_RECORDER is set.
+inline void record(event type, std::uint32_t arg = 0,
+                   std::uint8_t source = PRODUCER_SOURCE) noexcept {
+  if constexpr (enabled) {
+    record_event(type, arg, source);
+  }
+}
+
+inline std::uint64_t dropped_threads() noexcept {
+  return global_registry().dropped_threads.load(std::memory_order_relaxed);
+}
+
+// --- binary dump -----------------------------------------------------------------------
+//  [file_header][thread_header][record_t x count][thread_header][record_t x count]...
+struct file_header {
+  std::array<char, 8> magic; // "FQFLREC\0"
+  std::uint32_t version;
+  std::uint32_t threads;
+  double ticks_per_ns;
+};
+
+struct thread_header {
+  std::uint32_t slot;
+  std::uint32_t reserved;
+  std::uint64_t os_tid;
+  std::uint64_t count; // records that follow, oldest first
+};
+
+inline constexpr std::array<char, 8> FILE_MAGIC{'F', 'Q', 'F', 'L', 'R', 'E', 'C', '\0'};
+inline constexpr std::uint32_t FILE_VERSION = 1;
+
+/**
+ * Write every ring to `fd`. Async-signal-safe: no allocation, no locks, only write(2). Call
+ * calibrate (install_dump_on_signal or dump) beforehand so the file carries a tick rate.
+ */
+inline bool dump_to_fd(int fd) noexcept {
+  auto &reg = global_registry();
+  file_header fh{FILE_MAGIC, FILE_VERSION, 0, reg.ticks_per_ns.load(std::memory_order_relaxed)};
+  for (const auto &slot : reg.slots) {
+    const auto *b = slot.load(std::memory_order_acquire);
+    if (b != nullptr && b->head.load(std::memory_order_acquire) != 0) {
+      ++fh.threads;
+    }
+  }
+  if (!posix_io::write_all(fd, &fh, sizeof(fh))) {
+    return false;
+  }
+  std::uint32_t written = 0;
+  for (std::uint32_t i = 0; i < MAX_THREADS && written < fh.threads; ++i) {
+    const auto *b = reg.slots[i].load(std::memory_order_acquire);
+    if (b == nullptr) {
+      continue;
+    }
+    const std::uint64_t head = b->head.load(std::memory_order_acquire);
+    if (head == 0) {
+      continue;
+    }
+    const std::uint64_t count = std::min<std::uint64_t>(head, EVENTS_PER_THREAD);
+    const thread_header th{i, 0, b->os_tid, count};
+    // The oldest live entry is at (head - count); the ring may hand it back in two pieces.
+    const auto start = static_cast<std::size_t>((head - count) & EVENT_MASK);
+    const std::size_t first = std::min<std::size_t>(count, EVENTS_PER_THREAD - start);
+    if (!posix_io::write_all(fd, &th, sizeof(th)) ||
+        !posix_io::write_all(fd, b->events.data() + start, first * sizeof(record_t)) ||
+        !posix_io::write_all(fd, b->events.data(), (count - first) * sizeof(record_t))) {
+      return false;
+    }
+    ++written;
+  }
+  return true;
+}
+
+inline void ensure_calibrated() {
+  auto &reg = global_registry();
+  if (reg.ticks_per_ns.load(std::memory_order_relaxed) == 0.0) {
+    reg.ticks_per_ns.store(calibrate_ticks_per_ns(), std::memory_order_relaxed);
+  }
+}
+
+// Dump every ring to `path` (not async-signal-safe: calibrates on first use).
+inline bool dump(const std::string &path) {
+  ensure_calibrated();
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  const bool ok = dump_to_fd(fd);
+  return ::close(fd) == 0 && ok;
+}
+
+namespace detail {
+inline void on_dump_signal(int) {
+  const int saved_errno = errno;
+  const int fd =
+      ::open(global_registry().dump_path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0) {
+    dump_to_fd(fd);
+    ::close(fd);
+  }
+  errno = saved_errno;
+}
+} // namespace detail
+
+/**
+ * Dump all rings to `path` whenever `signo` (e.g. SIGUSR2) is delivered. Calibrates the tick
+ * rate now, so the handler itself does nothing but open/write/close.
+ */
+inline bool install_dump_on_signal(int signo, const std::string &path) {
+  auto &reg = global_registry();
+  if (path.size() >= reg.dump_path.size()) {
+    return false;
+  }
+  ensure_calibrated();
+  std::memcpy(reg.dump_path.data(), path.c_str(), path.size() + 1);
+  struct sigaction sa {};
+  sa.sa_handler = detail::on_dump_signal;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  return ::sigaction(signo, &sa, nullptr) == 0;
+}
+
+// --- loading and Chrome-trace conversion -----------------------------------------------
+struct thread_trace {
+  std::uint32_t slot;
+  std::uint64_t os_tid;
+  std::vector<record_t> events; // oldest first
+};
+
+struct trace {
+  double ticks_per_ns{1.0};
+  std::vector<thread_trace> threads;
+};
+
+// Read a dump produced by dump()/dump_to_fd(). std::nullopt on a malformed file.
+inline std::optional<trace> load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  file_header fh{};
+  if (!in.read(reinterpret_cast<char *>(&fh), sizeof(fh)) || fh.magic != FILE_MAGIC ||
+      fh.version != FILE_VERSION) {
+    return std::nullopt;
+  }
+  trace t;
+  t.ticks_per_ns = fh.ticks_per_ns > 0.0 ? fh.ticks_per_ns : 1.0;
+  for (std::uint32_t i = 0; i < fh.threads; ++i) {
+    thread_header th{};
+    if (!in.read(reinterpret_cast<char *>(&th), sizeof(th)) || th.count > EVENTS_PER_THREAD) {
+      return std::nullopt;
+    }
+    thread_trace tt{th.slot, th.os_tid, std::vector<record_t>(th.count)};
+    if (!in.read(reinterpret_cast<char *>(tt.events.data()),
+                 static_cast<std::streamsize>(th.count * sizeof(record_t)))) {
+      return std::nullopt;
+    }
+    // Drop entries the writer overwrote while the dump was in progress: they carry NEWER
+    // timestamps than the entries after them, so keep the longest non-decreasing suffix.
+    std::size_t start = tt.events.size();
+    while (start > 0 &&
+           (start == tt.events.size() || tt.events[start - 1].tsc <= tt.events[start].tsc)) {
+      --start;
+    }
+    tt.events.erase(tt.events.begin(), tt.events.begin() + static_cast<std::ptrdiff_t>(start));
+    t.threads.push_back(std::move(tt));
+  }
+  return t;
+}
+
+/**
+ * Chrome trace-event JSON (also opened by Perfetto). One track per ring; timestamps in
+ * microseconds from the earliest event. full_stall and wait_park are duration ("X") slices
+ * that end at the thread's next write / read-side event; everything else is an instant.
+ */
+inline void write_chrome_json(const trace &t, std::ostream &out) {
+  std::uint64_t base = std::numeric_limits<std::uint64_t>::max();
+  for (const auto &tt : t.threads) {
+    if (!tt.events.empty()) {
+      base = std::min(base, tt.events.front().tsc);
+    }
+  }
+  const auto to_us = [&](std::uint64_t tsc) {
+    return static_cast<double>(tsc - base) / t.ticks_per_ns / 1000.0;
+  };
+  const auto ends_wait = [](event waiting, event e) {
+    return waiting == event::full_stall ? e == event::write
+                                        : e == event::read || e == event::read_view;
+  };
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto sep = [&] {
+    out << (first ? "\n" : ",\n");
+    first = false;
+  };
+  out.setf(std::ios::fixed);
+  out.precision(3);
+  for (const auto &tt : t.threads) {
+    sep();
+    out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << tt.slot
+        << R"(,"args":{"name":"ring )" << tt.slot << " (tid " << tt.os_tid << ")\"}}";
+    for (std::size_t i = 0; i < tt.events.size(); ++i) {
+      const auto &e = tt.events[i];
+      sep();
+      out << R"({"name":")" << to_string(e.type) << R"(","pid":1,"tid":)" << tt.slot
+          << R"(,"ts":)" << to_us(e.tsc);
+      if (e.type == event::full_stall || e.type == event::wait_park) {
+        std::size_t j = i + 1;
+        while (j < tt.events.size() && !ends_wait(e.type, tt.events[j].type)) {
+          ++j;
+        }
+        const std::uint64_t end = j < tt.events.size() ? tt.events[j].tsc : e.tsc;
+        out << R"(,"ph":"X","dur":)" << to_us(end) - to_us(e.tsc);
+      } else {
+        out << R"(,"ph":"i","s":"t")";
+      }
+      out << R"(,"args":{"bytes":)" << e.arg << R"(,"source":)" << unsigned{e.source} << "}}";
+    }
+  }
+  out << "\n]}\n";
+}
+
+// Convenience: binary dump file -> Chrome-trace JSON file.
+inline bool convert_to_chrome_json(const std::string &dump_path, const std::string &json_path) {
+  const auto t = load(dump_path);
+  if (!t) {
+    return false;
+  }
+  std::ofstream out(json_path);
+  write_chrome_json(*t, out);
+  return static_cast<bool>(out);
+}
+
+} // namespace flight_recorder
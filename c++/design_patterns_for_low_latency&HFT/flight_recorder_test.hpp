@@ -0,0 +1,118 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for flight_recorder.hpp: a record -> dump -> load -> Chrome-JSON round
+// trip (including a ring that has wrapped), and the per-event cost of record_event() that
+// decides whether the recorder can stay on in the queue hot paths.
+//
+
+#pragma once
+
+#include "flight_recorder.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <print>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+namespace flight_recorder {
+
+// Two threads record a recognisable event pattern - one of them more than a ring's worth, so
+// its ring wraps - then the rings are dumped, loaded back and converted.
+inline void test_record_dump_load() {
+  std::println("--- test_record_dump_load ---");
+  constexpr std::uint32_t TAG = 0x0F1E0000; // arg prefix so we find our own threads' events
+  constexpr std::uint64_t SHORT_RUN = 100;
+  constexpr std::uint64_t LONG_RUN = EVENTS_PER_THREAD + 1000; // wraps the ring
+
+  auto record_run = [](std::uint64_t n, std::uint8_t source) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      const auto arg = TAG | static_cast<std::uint32_t>(i & 0xFFFF);
+      if (i % 10 == 0) {
+        record_event(event::full_stall, arg, source);
+      }
+      record_event(event::write, arg, source);
+    }
+  };
+  // Keep both threads alive until the dump so their slots are not recycled in between.
+  std::atomic<int> recorded{0};
+  std::atomic<bool> dumped{false};
+  auto worker = [&](std::uint64_t n, std::uint8_t source) {
+    record_run(n, source);
+    recorded.fetch_add(1, std::memory_order_release);
+    while (!dumped.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  };
+  std::thread a(worker, SHORT_RUN, std::uint8_t{1});
+  std::thread b(worker, LONG_RUN, std::uint8_t{2});
+  while (recorded.load(std::memory_order_acquire) != 2) {
+    std::this_thread::yield();
+  }
+
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::string bin = (dir / "flight_recorder_test.bin").string();
+  const std::string json = (dir / "flight_recorder_test.json").string();
+  [[maybe_unused]] const bool ok = dump(bin);
+  dumped.store(true, std::memory_order_release);
+  a.join();
+  b.join();
+  assert(ok && "dump failed");
+
+  const auto t = load(bin);
+  assert(t && "dump could not be loaded back");
+  std::size_t short_events = 0;
+  std::size_t long_events = 0;
+  for (const auto &tt : t->threads) {
+    if (tt.events.empty() || (tt.events.back().arg & 0xFFFF0000) != TAG) {
+      continue; // another thread's ring (e.g. a benchmark thread)
+    }
+    for (std::size_t i = 1; i < tt.events.size(); ++i) {
+      assert(tt.events[i - 1].tsc <= tt.events[i].tsc && "events out of order");
+    }
+    (tt.events.back().source == 1 ? short_events : long_events) = tt.events.size();
+  }
+  assert(short_events == SHORT_RUN + SHORT_RUN / 10 && "short ring lost events");
+  assert(long_events == EVENTS_PER_THREAD && "wrapped ring must hold exactly its capacity");
+
+  std::ostringstream out;
+  write_chrome_json(*t, out);
+  assert(out.str().find("\"full_stall\"") != std::string::npos);
+  assert(out.str().find("\"ph\":\"X\"") != std::string::npos && "stall must become a slice");
+  [[maybe_unused]] const bool converted = convert_to_chrome_json(bin, json);
+  assert(converted);
+  std::println("test_record_dump_load PASSED ({} + {} events, json at {})", short_events,
+               long_events, json);
+}
+
+// Per-event cost on the recording thread: the number that must stay at a few ns.
+inline void BM_FlightRecorderRecord(benchmark::State &state) {
+  std::uint32_t i = 0;
+  for (auto _ : state) {
+    record_event(event::write, ++i);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The timestamp alone, to separate the counter read from the store.
+inline void BM_FlightRecorderReadTsc(benchmark::State &state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(read_tsc());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+inline void test() {
+  test_record_dump_load();
+  BENCHMARK(BM_FlightRecorderRecord);
+  BENCHMARK(BM_FlightRecorderReadTsc);
+}
+
+} // namespace flight_recorder
@@ -0,0 +1,392 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  interleaving.hpp — deterministic schedules for the queue's producer/consumer steps
+// =====================================================================================
+//
+// test_basic, test_zero_copy and test_broadcast_zero_copy run real threads and see whatever
+// interleavings the OS produces: on an idle machine mostly the same few, and never the one
+// where the consumer is descheduled between reading a header and reading the payload. This
+// header takes the schedule out of the OS's hands.
+//
+//  - Schedule points. The queues take a fourth template parameter, a schedule policy, and call
+//    Sched::point(site) before every access to shared state: each load or store of a counter
+//    and each group of ring copies. The default policy, `none`, has an empty point() and
+//    compiles to nothing; `controlled` hands control to the scheduler running the thread.
+//  - controller runs N bodies on N real threads, exactly ONE of them at a time. At every
+//    point the running thread stops and a chooser picks who runs next, so a run is fully
+//    determined by its list of choices - the trace - and can be replayed from it.
+//  - Waiting. A scenario's retry loop calls wait() instead of spinning. If no counter was
+//    published since the failed attempt began, the thread is not runnable until one is: the
+//    retry would see the same state. That keeps every schedule finite and turns a lost message
+//    into a clean "stuck" outcome instead of an endless spin.
+//  - Exploration. random_walk() runs seeded random schedules. explore() enumerates EVERY
+//    schedule with at most `preemption_bound` preemptions (switches away from a thread that
+//    could have continued), depth first. Most concurrency bugs need only one or two
+//    preemptions, which is what makes that bound useful.
+//
+// What this does and does not check: the runs are sequentially consistent (one thread at a
+// time, with the controller's mutex between steps), so the harness proves the ORDER of the
+// steps - what is copied before a counter is published, what is read after it is loaded, the
+// full/empty arithmetic and the wrap. It cannot show a hardware reordering. A weakened memory
+// order that keeps the step order still needs the ENABLE_TSAN build and the two-thread stress
+// tests; one that reorders steps (a tail published before the payload is read) fails here.
+//
+// Errors follow the repo's test style: a scenario records what went wrong as a message, and
+// the run's outcome and trace are returned, never thrown.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace interleaving {
+
+// Where a schedule point sits in the queue code.
+enum class site : std::uint8_t {
+  load_head,    // before the consumer loads write_counter
+  load_tail,    // before the producer loads a read_counter
+  publish_head, // before the producer stores write_counter
+  publish_tail, // before a consumer stores its read_counter
+  ring_access,  // before a group of ring copies (header, payload)
+  wait,         // a scenario's retry loop: cannot proceed until someone publishes
+};
+
+// The default schedule policy: no points.
+struct none {
+  static void point(site) noexcept {}
+};
+
+class controller;
+
+namespace detail {
+inline thread_local controller *current = nullptr;
+inline thread_local std::uint32_t current_id = 0;
+} // namespace detail
+
+// The schedule policy of a queue under test: every point is a scheduling decision.
+struct controlled {
+  static void point(site s);
+};
+
+// How a run ended.
+enum class outcome : std::uint8_t {
+  completed,  // every body returned
+  stuck,      // every unfinished thread is waiting: a deadlock or a lost message
+  step_limit, // more than max_steps points: a livelock, or a limit set too low
+};
+
+struct run_result {
+  outcome end{outcome::completed};
+  std::vector<std::uint32_t> trace; // the thread that ran after each decision
+};
+
+/**
+ * Picks the next thread at a decision: `runnable` lists the threads that may run (ascending),
+ * `running` is the thread that reached the point (or -1 when it finished or waits, i.e. is not
+ * in the list). Returns an element of `runnable`.
+ */
+using chooser = std::function<std::uint32_t(const std::vector<std::uint32_t> &runnable,
+                                            std::int64_t running)>;
+
+class controller {
+public:
+  /**
+   * Runs body(0) .. body(threads - 1), each on its own thread, one at a time, switching only at
+   * schedule points as `choose` decides. When the run is cut short (stuck or step_limit) the
+   * threads are released to run freely; scenario loops see wait() return false and exit.
+   */
+  run_result run(std::size_t threads, const std::function<void(std::uint32_t)> &body,
+                 chooser choose, std::size_t max_steps = 100'000) {
+    choose_ = std::move(choose);
+    max_steps_ = max_steps;
+    steps_ = 0;
+    aborted_ = false;
+    result_ = {};
+    epoch_ = 0;
+    finished_.assign(threads, false);
+    waiting_.assign(threads, false);
+    published_.assign(threads, false);
+    attempt_.assign(threads, std::nullopt);
+    {
+      std::lock_guard lk{m_};
+      decide(-1);
+    }
+    std::vector<std::thread> pool;
+    for (std::uint32_t id = 0; id < threads; ++id) {
+      pool.emplace_back([this, id, &body] {
+        {
+          std::unique_lock lk{m_};
+          cv_.wait(lk, [&] { return running_ == id || aborted_; });
+        }
+        detail::current = this;
+        detail::current_id = id;
+        body(id);
+        detail::current = nullptr;
+        finish(id);
+      });
+    }
+    for (auto &t : pool) {
+      t.join();
+    }
+    return result_;
+  }
+
+  // A schedule point reached by thread `id`. Returns false once the run has been aborted.
+  bool step(std::uint32_t id, site s) {
+    std::unique_lock lk{m_};
+    if (aborted_) {
+      return false;
+    }
+    progress(id);
+    if (s == site::publish_head || s == site::publish_tail) {
+      published_[id] = true; // takes effect at this thread's next point, after the store
+    }
+    if (s == site::wait) {
+      // Block only if nothing was published since the attempt's first point: the failed
+      // attempt read state no newer than that.
+      waiting_[id] = attempt_[id] == epoch_;
+      attempt_[id].reset();
+    } else if (!attempt_[id]) {
+      attempt_[id] = epoch_;
+    }
+    if (++steps_ > max_steps_) {
+      abort(outcome::step_limit);
+      return false;
+    }
+    decide(id);
+    cv_.wait(lk, [&] { return running_ == id || aborted_; });
+    return !aborted_;
+  }
+
+private:
+  // A thread that published a counter at its previous point has now stored it: a new epoch,
+  // and every waiting thread may try again.
+  void progress(std::uint32_t id) {
+    if (published_[id]) {
+      published_[id] = false;
+      ++epoch_;
+      waiting_.assign(waiting_.size(), false);
+    }
+  }
+
+  void finish(std::uint32_t id) {
+    std::lock_guard lk{m_};
+    finished_[id] = true;
+    if (aborted_) {
+      return;
+    }
+    progress(id);
+    decide(-1);
+  }
+
+  // Under m_: pick the next thread, or end the run when nothing can run.
+  void decide(std::int64_t running) {
+    std::vector<std::uint32_t> runnable;
+    bool unfinished = false;
+    for (std::uint32_t t = 0; t < finished_.size(); ++t) {
+      unfinished = unfinished || !finished_[t];
+      if (!finished_[t] && !waiting_[t]) {
+        runnable.push_back(t);
+      }
+    }
+    if (runnable.empty()) {
+      if (unfinished) {
+        abort(outcome::stuck);
+      }
+      return;
+    }
+    if (running >= 0 && waiting_[static_cast<std::size_t>(running)]) {
+      running = -1;
+    }
+    running_ = choose_(runnable, running);
+    result_.trace.push_back(running_);
+    cv_.notify_all();
+  }
+
+  void abort(outcome why) {
+    result_.end = why;
+    aborted_ = true;
+    cv_.notify_all();
+  }
+
+  std::mutex m_;
+  std::condition_variable cv_;
+  chooser choose_;
+  std::size_t max_steps_{0};
+  std::size_t steps_{0};
+  bool aborted_{false};
+  std::uint32_t running_{0};
+  std::uint64_t epoch_{0}; // counter stores so far
+  std::vector<bool> finished_;
+  std::vector<bool> waiting_;
+  std::vector<bool> published_;
+  std::vector<std::optional<std::uint64_t>> attempt_; // epoch at the current attempt's start
+  run_result result_;
+};
+
+inline void controlled::point(site s) {
+  if (detail::current != nullptr) {
+    detail::current->step(detail::current_id, s);
+  }
+}
+
+/**
+ * For a scenario's retry loop (queue full, queue empty): yields to the other threads until one
+ * of them publishes. Returns false when the run has been aborted and the body should return.
+ * Outside a controlled run it just yields the CPU.
+ */
+inline bool wait() {
+  if (detail::current == nullptr) {
+    std::this_thread::yield();
+    return true;
+  }
+  return detail::current->step(detail::current_id, site::wait);
+}
+
+// --- Drivers ----------------------------------------------------------------------------------
+// A Scenario is default-constructible (fresh queue state for every run) and has:
+//   static constexpr std::size_t threads;
+//   void body(std::uint32_t thread);
+//   std::optional<std::string> check() const; // after the run: what went wrong, if anything
+
+struct failure {
+  outcome end;
+  std::string what;
+  std::vector<std::uint32_t> trace; // replay() reproduces the run
+};
+
+struct explore_result {
+  std::size_t schedules{0};
+  bool exhausted{false}; // every schedule within the bound was run
+  std::optional<failure> failed;
+};
+
+namespace detail {
+template <class Scenario>
+std::optional<failure> run_scenario(const chooser &choose, std::size_t max_steps,
+                                    std::vector<std::uint32_t> *trace = nullptr) {
+  Scenario scenario;
+  controller c;
+  auto r = c.run(
+      Scenario::threads, [&](std::uint32_t t) { scenario.body(t); }, choose, max_steps);
+  if (trace != nullptr) {
+    *trace = r.trace;
+  }
+  if (r.end != outcome::completed) {
+    return failure{r.end, r.end == outcome::stuck ? "stuck" : "step limit", std::move(r.trace)};
+  }
+  if (auto what = scenario.check()) {
+    return failure{r.end, std::move(*what), std::move(r.trace)};
+  }
+  return std::nullopt;
+}
+} // namespace detail
+
+// Runs the schedule recorded in `trace` again. The same trace gives the same run.
+template <class Scenario>
+std::optional<failure> replay(const std::vector<std::uint32_t> &trace,
+                              std::size_t max_steps = 100'000) {
+  std::size_t k = 0;
+  return detail::run_scenario<Scenario>(
+      [&](const std::vector<std::uint32_t> &runnable, std::int64_t running) {
+        const std::uint32_t want = k < trace.size() ? trace[k] : runnable.front();
+        ++k;
+        for (const auto t : runnable) {
+          if (t == want) {
+            return t;
+          }
+        }
+        return running >= 0 ? static_cast<std::uint32_t>(running) : runnable.front();
+      },
+      max_steps);
+}
+
+// `runs` schedules that pick uniformly among the runnable threads at every point, seeded.
+template <class Scenario>
+explore_result random_walk(std::uint64_t seed, std::size_t runs,
+                           std::size_t max_steps = 100'000) {
+  explore_result out;
+  std::mt19937_64 rng{seed};
+  const chooser pick = [&](const std::vector<std::uint32_t> &runnable, std::int64_t) {
+    return runnable[static_cast<std::size_t>(rng() % runnable.size())];
+  };
+  for (; out.schedules < runs; ++out.schedules) {
+    if (auto f = detail::run_scenario<Scenario>(pick, max_steps)) {
+      out.failed = std::move(f);
+      ++out.schedules;
+      break;
+    }
+  }
+  return out;
+}
+
+/**
+ * Every schedule with at most `preemption_bound` preemptions, depth first: a run follows the
+ * choices of a prefix and then never preempts; the next prefix bumps the last decision that
+ * still has an untried alternative. Stops at the first failure or after max_schedules runs.
+ */
+template <class Scenario>
+explore_result explore(std::size_t preemption_bound, std::size_t max_schedules = 100'000,
+                       std::size_t max_steps = 100'000) {
+  explore_result out;
+  std::vector<std::size_t> prefix; // index chosen at each decision of the next run
+  for (; out.schedules < max_schedules; ++out.schedules) {
+    std::vector<std::size_t> chosen;
+    std::vector<std::size_t> options;
+    std::size_t preemptions = 0;
+    const chooser pick = [&](const std::vector<std::uint32_t> &runnable, std::int64_t running) {
+      // Candidates: the running thread first (no preemption), then the others - unless the
+      // bound is used up and the running thread can go on.
+      std::vector<std::uint32_t> cand;
+      if (running >= 0) {
+        cand.push_back(static_cast<std::uint32_t>(running));
+      }
+      if (running < 0 || preemptions < preemption_bound) {
+        for (const auto t : runnable) {
+          if (static_cast<std::int64_t>(t) != running) {
+            cand.push_back(t);
+          }
+        }
+      }
+      const std::size_t k = chosen.size();
+      const std::size_t i = k < prefix.size() ? prefix[k] : 0;
+      chosen.push_back(i);
+      options.push_back(cand.size());
+      if (running >= 0 && i != 0) {
+        ++preemptions;
+      }
+      return cand[i];
+    };
+    if (auto f = detail::run_scenario<Scenario>(pick, max_steps)) {
+      out.failed = std::move(f);
+      ++out.schedules;
+      return out;
+    }
+    // Backtrack to the last decision with an untried alternative.
+    std::size_t k = chosen.size();
+    while (k != 0 && chosen[k - 1] + 1 >= options[k - 1]) {
+      --k;
+    }
+    if (k == 0) {
+      out.exhausted = true;
+      ++out.schedules;
+      return out;
+    }
+    prefix.assign(chosen.begin(), chosen.begin() + static_cast<std::ptrdiff_t>(k));
+    ++prefix.back();
+  }
+  return out;
+}
+
+} // namespace interleaving
@@ -0,0 +1,319 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests for interleaving.hpp, and through it for the queues' step order. Each scenario runs a
+// producer and its consumers over a 32-byte ring, so a handful of messages already fill it and
+// wrap. Every schedule with up to two or three preemptions is run (one for the three-thread
+// broadcast), then a few thousand seeded random ones. A scenario checks that each consumer
+// sees every message, in order and intact.
+//
+// The harness is itself tested with a deliberately broken consumer that publishes its tail
+// before it has copied the payload out, the step order a careless "relax this store" would
+// produce. It must be caught, and its trace must replay to the same failure.
+//
+
+#pragma once
+
+#include "fast_queue_SPMC.hpp"
+#include "fast_queue_SPSC.hpp"
+#include "interleaving.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace interleaving {
+
+// The messages every scenario sends: payload sizes that make 4-byte-header records of 9..16
+// bytes, so the 32-byte ring is full after two or three and every record position wraps
+// sooner or later. Byte k of message i is i * 16 + k.
+inline constexpr std::array<std::size_t, 5> MESSAGE_SIZES{5, 12, 3, 9, 7};
+inline constexpr std::size_t RING = 32;
+
+inline std::byte message_byte(std::size_t i, std::size_t k) {
+  return static_cast<std::byte>(i * 16 + k);
+}
+
+// The first mismatch between message i and the `got` bytes, if any.
+inline std::optional<std::string> check_message(std::size_t i, std::span<const std::byte> a,
+                                                std::span<const std::byte> b = {}) {
+  if (a.size() + b.size() != MESSAGE_SIZES[i]) {
+    return "message " + std::to_string(i) + ": wrong length " + std::to_string(a.size());
+  }
+  for (std::size_t k = 0; k < a.size() + b.size(); ++k) {
+    const std::byte got = k < a.size() ? a[k] : b[k - a.size()];
+    if (got != message_byte(i, k)) {
+      return "message " + std::to_string(i) + ": byte " + std::to_string(k) + " overwritten";
+    }
+  }
+  return std::nullopt;
+}
+
+// One producer, one consumer. H frames the records; ZeroCopy uses try_reserve/commit_write and
+// try_read_view/commit_read instead of try_write/try_read; Prefetch is the consumer's
+// prefetch_depth, so the prefetch walk's header reads are interleaved too.
+template <class H, bool ZeroCopy, std::size_t Prefetch> struct spsc_scenario {
+  static constexpr std::size_t threads = 2;
+  using queue = fast_queue_spsc::fast_queue_t<RING, small_copy::libc, H, controlled>;
+
+  void body(std::uint32_t t) {
+    if (t == 0) {
+      fast_queue_spsc::producer prod;
+      for (std::size_t i = 0; i < MESSAGE_SIZES.size(); ++i) {
+        std::array<std::byte, 16> in{};
+        for (std::size_t k = 0; k < MESSAGE_SIZES[i]; ++k) {
+          in[k] = message_byte(i, k);
+        }
+        if constexpr (ZeroCopy) {
+          std::optional<fast_queue_spsc::write_view> w;
+          while (!(w = prod.try_reserve(fq, MESSAGE_SIZES[i]))) {
+            if (!wait()) {
+              return;
+            }
+          }
+          std::memcpy(w->first.data(), in.data(), w->first.size());
+          std::memcpy(w->second.data(), in.data() + w->first.size(), w->second.size());
+          prod.commit_write(fq);
+        } else {
+          while (!prod.try_write(fq, std::span<const std::byte>{in.data(), MESSAGE_SIZES[i]})) {
+            if (!wait()) {
+              return;
+            }
+          }
+        }
+      }
+      return;
+    }
+    fast_queue_spsc::consumer cons;
+    cons.prefetch_depth = Prefetch;
+    for (; received < MESSAGE_SIZES.size(); ++received) {
+      if constexpr (ZeroCopy) {
+        std::optional<fast_queue_spsc::read_view> v;
+        while (!(v = cons.try_read_view(fq))) {
+          if (!wait()) {
+            return;
+          }
+        }
+        // Read the bytes only after a point: the producer gets its chance to overwrite them.
+        controlled::point(site::ring_access);
+        if (auto what = check_message(received, v->first, v->second); what && !error) {
+          error = std::move(what);
+        }
+        cons.commit_read(fq);
+      } else {
+        std::array<std::byte, 16> out{};
+        std::optional<std::size_t> got;
+        while (!(got = cons.try_read(fq, out))) {
+          if (!wait()) {
+            return;
+          }
+        }
+        if (auto what = check_message(received, {out.data(), *got}); what && !error) {
+          error = std::move(what);
+        }
+      }
+    }
+  }
+
+  std::optional<std::string> check() const {
+    if (error) {
+      return error;
+    }
+    if (received != MESSAGE_SIZES.size()) {
+      return "consumer saw " + std::to_string(received) + " messages";
+    }
+    return std::nullopt;
+  }
+
+  queue fq;
+  std::size_t received{0};
+  std::optional<std::string> error;
+};
+
+// One producer, two consumers on the broadcast ring: consumer 1 copies, consumer 2 reads views.
+struct spmc_scenario {
+  static constexpr std::size_t threads = 3;
+  using queue = fast_queue_spmc::spmc_queue_t<RING, 2, controlled>;
+
+  void body(std::uint32_t t) {
+    if (t == 0) {
+      fast_queue_spmc::producer prod;
+      for (std::size_t i = 0; i < MESSAGE_SIZES.size(); ++i) {
+        std::array<std::byte, 16> in{};
+        for (std::size_t k = 0; k < MESSAGE_SIZES[i]; ++k) {
+          in[k] = message_byte(i, k);
+        }
+        while (!prod.try_write(fq, std::span<const std::byte>{in.data(), MESSAGE_SIZES[i]})) {
+          if (!wait()) {
+            return;
+          }
+        }
+      }
+      return;
+    }
+    const std::size_t c = t - 1;
+    fast_queue_spmc::consumer cons{c};
+    for (; received[c] < MESSAGE_SIZES.size(); ++received[c]) {
+      std::optional<std::string> what;
+      if (c == 0) {
+        std::array<std::byte, 16> out{};
+        std::optional<std::size_t> got;
+        while (!(got = cons.try_read(fq, out))) {
+          if (!wait()) {
+            return;
+          }
+        }
+        what = check_message(received[c], {out.data(), *got});
+      } else {
+        std::optional<fast_queue_spmc::read_view> v;
+        while (!(v = cons.try_read_view(fq))) {
+          if (!wait()) {
+            return;
+          }
+        }
+        controlled::point(site::ring_access);
+        what = check_message(received[c], v->first, v->second);
+        cons.commit_read(fq);
+      }
+      if (what && !error) {
+        error = "consumer " + std::to_string(c) + ", " + *what;
+      }
+    }
+  }
+
+  std::optional<std::string> check() const {
+    if (error) {
+      return error;
+    }
+    for (std::size_t c = 0; c < received.size(); ++c) {
+      if (received[c] != MESSAGE_SIZES.size()) {
+        return "consumer " + std::to_string(c) + " saw " + std::to_string(received[c]);
+      }
+    }
+    return std::nullopt;
+  }
+
+  queue fq;
+  std::array<std::size_t, 2> received{};
+  std::optional<std::string> error;
+};
+
+// The broken consumer: the SPSC read with its two last steps swapped - the tail is published
+// (freeing the record) before the payload is copied out.
+struct early_release_scenario {
+  static constexpr std::size_t threads = 2;
+  using queue = fast_queue_spsc::fast_queue_t<RING, small_copy::libc,
+                                              record_header::int32_length, controlled>;
+
+  void body(std::uint32_t t) {
+    if (t == 0) {
+      spsc.body(0);
+      return;
+    }
+    std::uint64_t read_counter = 0;
+    for (; received < MESSAGE_SIZES.size(); ++received) {
+      for (;;) {
+        controlled::point(site::load_head);
+        if (spsc.fq.write_counter.load(std::memory_order_acquire) != read_counter) {
+          break;
+        }
+        if (!wait()) {
+          return;
+        }
+      }
+      controlled::point(site::ring_access);
+      fast_queue_spsc::header_t len{};
+      fast_queue_spsc::ring_read(spsc.fq, read_counter, reinterpret_cast<std::byte *>(&len),
+                                 sizeof(len));
+      const auto n = static_cast<std::size_t>(len);
+      const std::uint64_t payload = read_counter + sizeof(len);
+      read_counter = payload + n;
+      controlled::point(site::publish_tail);
+      spsc.fq.read_counter.store(read_counter, std::memory_order_release); // too early
+      controlled::point(site::ring_access);
+      std::array<std::byte, 16> out{};
+      fast_queue_spsc::ring_read(spsc.fq, payload, out.data(), n);
+      if (auto what = check_message(received, {out.data(), n}); what && !error) {
+        error = std::move(what);
+      }
+    }
+  }
+
+  std::optional<std::string> check() const {
+    return error ? error
+                 : received == MESSAGE_SIZES.size() ? std::nullopt
+                                                    : std::optional<std::string>{"lost messages"};
+  }
+
+  spsc_scenario<record_header::int32_length, false, 0> spsc; // its producer and ring
+  std::size_t received{0};
+  std::optional<std::string> error;
+};
+
+inline std::string format_trace(const std::vector<std::uint32_t> &trace) {
+  std::string s;
+  for (const auto t : trace) {
+    s += static_cast<char>('0' + t);
+  }
+  return s;
+}
+
+// Every schedule up to `bound` preemptions, then `random_runs` seeded random schedules.
+template <class Scenario>
+void check_scenario(const char *name, std::size_t bound, std::size_t random_runs) {
+  const auto dfs = explore<Scenario>(bound);
+  const auto walk = random_walk<Scenario>(0x5eed, random_runs);
+  for (const auto *r : {&dfs, &walk}) {
+    if (r->failed) {
+      std::println("{}: {} after {} schedules, trace {}", name, r->failed->what, r->schedules,
+                   format_trace(r->failed->trace));
+    }
+  }
+  assert(!dfs.failed && !walk.failed && "a schedule broke the queue");
+  assert(dfs.exhausted && "raise max_schedules: the bounded search did not finish");
+  std::println("{}: {} schedules (all with <= {} preemptions) + {} random, all correct", name,
+               dfs.schedules, bound, walk.schedules);
+}
+
+inline void test_interleaving_spsc() {
+  std::println("--- test_interleaving_spsc ---");
+  check_scenario<spsc_scenario<record_header::int32_length, false, 0>>("try_write/try_read", 3,
+                                                                       2'000);
+  check_scenario<spsc_scenario<record_header::varint_length, true, 0>>(
+      "try_reserve/try_read_view, varint", 2, 2'000);
+  check_scenario<spsc_scenario<record_header::crc32c<record_header::int32_length>, false, 2>>(
+      "crc32c, prefetch 2", 2, 2'000);
+  std::println("test_interleaving_spsc PASSED");
+}
+
+inline void test_interleaving_spmc() {
+  std::println("--- test_interleaving_spmc ---");
+  check_scenario<spmc_scenario>("broadcast, copy + view", 1, 2'000);
+  std::println("test_interleaving_spmc PASSED");
+}
+
+// The harness finds the broken consumer, and its trace replays to the same failure.
+inline void test_interleaving_finds_early_release() {
+  std::println("--- test_interleaving_finds_early_release ---");
+  const auto r = explore<early_release_scenario>(2);
+  assert(r.failed && "the early tail release was not caught");
+  [[maybe_unused]] const auto again = replay<early_release_scenario>(r.failed->trace);
+  assert(again && again->what == r.failed->what && again->trace == r.failed->trace);
+  std::println("test_interleaving_finds_early_release PASSED (schedule {}: {}, trace {})",
+               r.schedules, r.failed->what, format_trace(r.failed->trace));
+}
+
+inline void test() {
+  test_interleaving_spsc();
+  test_interleaving_spmc();
+  test_interleaving_finds_early_release();
+}
+
+} // namespace interleaving
@@ -0,0 +1,611 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  journal.hpp — persisting every message of an SPMC feed without slowing its consumers
+// =====================================================================================
+//
+// The feed queue (fast_queue_SPMC.hpp) broadcasts every message to every consumer. Journaling
+// is one more consumer: journal::writer<Q> attaches to spmc_queue_t as an extra reader slot and
+// copies what it reads to disk on its own thread. The strategy consumers never see it; the
+// only way it can hurt them is by falling behind far enough that the min() reuse gate stops
+// the PRODUCER (counted as `fulls` by the benchmarks). So the write path is built to keep up:
+//
+//  - BATCHING: records are copied, exactly as they sit in the ring ([int32 length][payload]),
+//    into large CHUNKS (1 MiB by default). The disk sees few, big, sequential writes; the
+//    ring slot is released (commit_read) as soon as its record is copied.
+//  - ASYNC I/O: a sealed chunk is handed to io_uring and the thread carries on filling the next
+//    buffer while the kernel writes it. Several buffers rotate; the thread only waits when
+//    all of them are still in flight, which is exactly when the disk is the bottleneck.
+//    Where io_uring is unavailable (non-Linux, old kernels, seccomp) each chunk is written with
+//    a blocking pwritev instead.
+//  - O_DIRECT: chunks are BLOCK-aligned in memory, in size and in file offset, so the file is
+//    opened with O_DIRECT (F_NOCACHE on macOS) and a multi-GB journal does not evict the page
+//    cache the rest of the process lives in. Filesystems that refuse O_DIRECT (tmpfs) fall
+//    back to buffered writes.
+//  - DURABILITY: every `fsync_interval` the file is fdatasync'ed (an IORING_OP_FSYNC drained
+//    behind the chunk writes, or a blocking fdatasync on the fallback). A quiet feed does not
+//    strand a half-filled chunk in memory: after `idle_flush` without messages it is written
+//    as it is.
+//  - ROLLING: a new file is started before a chunk would take the current one past
+//    `file_size`: <directory>/<prefix>.<index>.fqj, index counting from 0.
+//
+// -------------------------------------------------------------------------------------
+//  File format
+// -------------------------------------------------------------------------------------
+//  A journal file is a sequence of chunks. Each starts on a BLOCK boundary with a
+//  chunk_header { magic, bytes, first_seq }, followed by `bytes` bytes of ring records and
+//  zero padding up to the next BLOCK boundary. first_seq numbers the chunk's first message
+//  from 0 across the whole journal, so a reader can tell a missing chunk or file. Records never
+//  straddle chunks; one too large for `buffer_size` is written as a chunk of its own.
+//
+//  Errors are counted, never thrown: a journal that cannot write keeps draining its slot
+//  (dropping what it cannot persist), so a full disk never stops the feed.
+//
+
+#pragma once
+
+#include "fast_queue_SPMC.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace journal {
+
+// Alignment of chunk buffers, sizes and offsets (the O_DIRECT unit on every common device).
+inline constexpr std::size_t BLOCK = 4096;
+inline constexpr std::uint32_t CHUNK_MAGIC = 0x314A5146; // "FQJ1"
+
+struct chunk_header {
+  std::uint32_t magic;
+  std::uint32_t bytes;     // ring records following this header
+  std::uint64_t first_seq; // journal-wide index of the chunk's first message
+};
+static_assert(sizeof(chunk_header) == 16);
+
+constexpr std::size_t align_up(std::size_t n) noexcept { return (n + BLOCK - 1) & ~(BLOCK - 1); }
+
+// <directory>/<prefix>.<index>.fqj
+inline std::filesystem::path file_path(const std::filesystem::path &directory,
+                                       const std::string &prefix, std::uint32_t index) {
+  char name[32];
+  std::snprintf(name, sizeof(name), ".%06u.fqj", index);
+  return directory / (prefix + name);
+}
+
+enum class backend : std::uint8_t { io_uring, pwritev };
+
+inline const char *to_string(backend b) noexcept {
+  switch (b) {
+  case backend::io_uring:
+    return "io_uring";
+  case backend::pwritev:
+    return "pwritev";
+  }
+  return "?";
+}
+
+struct journal_config {
+  std::filesystem::path directory;                      // must exist
+  std::string prefix = "journal";
+  std::size_t buffer_size = std::size_t{1} << 20;       // chunk size, a multiple of BLOCK
+  std::size_t buffers = 4;                              // chunks being filled or in flight
+  std::uint64_t file_size = std::uint64_t{1} << 30;     // roll before exceeding this
+  std::chrono::milliseconds fsync_interval{100};
+  std::chrono::microseconds idle_flush{500};            // write a partial chunk after this
+  backend io = backend::io_uring;                       // preferred; falls back to pwritev
+};
+
+#if defined(__linux__)
+/**
+ * The minimum of io_uring this needs, on the raw syscalls (no liburing dependency): one
+ * submission per call, completions reaped in order of arrival. Single-threaded.
+ */
+class uring {
+public:
+  explicit uring(unsigned entries) {
+    io_uring_params p{};
+    fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd_ < 0) {
+      return;
+    }
+    sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sq_len_ = cq_len_ = std::max(sq_len_, cq_len_);
+    }
+    sq_ptr_ = map(sq_len_, IORING_OFF_SQ_RING);
+    cq_ptr_ = single ? sq_ptr_ : map(cq_len_, IORING_OFF_CQ_RING);
+    sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe *>(map(sqes_len_, IORING_OFF_SQES));
+    if (sq_ptr_ == nullptr || cq_ptr_ == nullptr || sqes_ == nullptr) {
+      release();
+      return;
+    }
+    auto *sq = static_cast<char *>(sq_ptr_);
+    auto *cq = static_cast<char *>(cq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+  }
+
+  uring(const uring &) = delete;
+  uring &operator=(const uring &) = delete;
+  ~uring() { release(); }
+
+  bool ok() const noexcept { return fd_ >= 0; }
+
+  // Queues `sqe` and submits it. The caller keeps the in-flight count below `entries`. On
+  // failure the kernel has not consumed the entry and it is taken back off the queue, so a
+  // later submission cannot carry it in with a buffer the caller has since reused.
+  bool submit(const io_uring_sqe &sqe) noexcept {
+    const unsigned tail = *sq_tail_; // this thread is the only producer of submissions
+    sqes_[tail & sq_mask_] = sqe;
+    sq_array_[tail & sq_mask_] = tail & sq_mask_;
+    std::atomic_ref<unsigned>{*sq_tail_}.store(tail + 1, std::memory_order_release);
+    for (;;) {
+      const long r = ::syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0);
+      if (r == 1) {
+        return true;
+      }
+      if (r < 0 && errno == EINTR) {
+        continue;
+      }
+      std::atomic_ref<unsigned>{*sq_tail_}.store(tail, std::memory_order_release);
+      return false;
+    }
+  }
+
+  // Pops the next completion into `out`; if there is none, waits for one when `wait`.
+  bool reap(io_uring_cqe &out, bool wait) noexcept {
+    for (;;) {
+      const unsigned head = *cq_head_;
+      if (head != std::atomic_ref<unsigned>{*cq_tail_}.load(std::memory_order_acquire)) {
+        out = cqes_[head & cq_mask_];
+        std::atomic_ref<unsigned>{*cq_head_}.store(head + 1, std::memory_order_release);
+        return true;
+      }
+      if (!wait) {
+        return false;
+      }
+      const long r = ::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (r < 0 && errno != EINTR) {
+        return false;
+      }
+    }
+  }
+
+private:
+  void *map(std::size_t len, off_t what) const noexcept {
+    void *p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, what);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  void release() noexcept {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqes_len_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      ::munmap(cq_ptr_, cq_len_);
+    }
+    if (sq_ptr_ != nullptr) {
+      ::munmap(sq_ptr_, sq_len_);
+    }
+    sqes_ = nullptr;
+    sq_ptr_ = cq_ptr_ = nullptr;
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  int fd_ = -1;
+  void *sq_ptr_ = nullptr;
+  void *cq_ptr_ = nullptr;
+  std::size_t sq_len_ = 0;
+  std::size_t cq_len_ = 0;
+  std::size_t sqes_len_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+};
+#endif
+
+/**
+ * Journals everything published on `q` through consumer slot `consumer_id`, which no other
+ * reader may use. Starts its thread in the constructor; stop() (or the destructor) drains
+ * what has been published, writes the last chunk, syncs and closes the file.
+ */
+template <class Q> class writer {
+public:
+  writer(Q &q, std::size_t consumer_id, journal_config cfg)
+      : q_{q}, cons_{consumer_id}, cfg_{std::move(cfg)}, pending_(cfg_.buffers, 0) {
+    assert(cfg_.buffer_size % BLOCK == 0 && cfg_.buffers >= 2);
+    assert(cfg_.file_size >= cfg_.buffer_size);
+    memory_ = static_cast<std::byte *>(std::aligned_alloc(BLOCK, cfg_.buffer_size * cfg_.buffers));
+    errors_.fetch_add(memory_ == nullptr, std::memory_order_relaxed); // drain() then drops
+#if defined(__linux__)
+    if (cfg_.io == backend::io_uring) {
+      ring_ = std::make_unique<uring>(static_cast<unsigned>(2 * cfg_.buffers + 2));
+      if (!ring_->ok()) {
+        ring_.reset();
+      }
+    }
+#endif
+    io_ = ring_ ? backend::io_uring : backend::pwritev;
+    open_next();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  writer(const writer &) = delete;
+  writer &operator=(const writer &) = delete;
+
+  ~writer() {
+    stop();
+    std::free(memory_);
+  }
+
+  // Journals everything published so far, then returns once it is synced and closed.
+  void stop() {
+    if (thread_.joinable()) {
+      stop_.store(true, std::memory_order_release);
+      thread_.join();
+    }
+  }
+
+  bool ok() const noexcept { return errors() == 0; }
+  backend io() const noexcept { return io_; }
+  bool direct() const noexcept { return direct_.load(std::memory_order_acquire); }
+  std::uint64_t messages() const noexcept { return messages_.load(std::memory_order_acquire); }
+  // Bytes handed to the disk, chunk headers and padding included.
+  std::uint64_t bytes() const noexcept { return bytes_.load(std::memory_order_acquire); }
+  std::uint32_t files() const noexcept { return files_.load(std::memory_order_acquire); }
+  std::uint64_t syncs() const noexcept { return syncs_.load(std::memory_order_acquire); }
+  std::uint64_t errors() const noexcept { return errors_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr std::size_t DRAIN_BATCH = 256;
+  static constexpr std::uint64_t SYNC_TAG = ~std::uint64_t{0};
+
+  using clock = std::chrono::steady_clock;
+
+  void run() {
+    auto last_sync = clock::now();
+    auto last_message = last_sync;
+    for (;;) {
+      // Read `stop_` BEFORE draining: everything published before it was set gets drained.
+      const bool stopping = stop_.load(std::memory_order_acquire);
+      const std::size_t n = drain();
+      reap(false);
+      const auto now = clock::now();
+      if (n != 0) {
+        last_message = now;
+      } else if (stopping) {
+        break;
+      } else if (fill_ != 0 && now - last_message >= cfg_.idle_flush) {
+        seal();
+      }
+      if (now - last_sync >= cfg_.fsync_interval) {
+        sync();
+        last_sync = now;
+      }
+      if (n == 0) {
+        std::this_thread::yield(); // off the hot path: give the core back while idle
+      }
+    }
+    seal();
+    close_file();
+  }
+
+  // Copies up to DRAIN_BATCH records into the current chunk; returns how many.
+  std::size_t drain() {
+    std::size_t n = 0;
+    for (; n < DRAIN_BATCH; ++n) {
+      const auto view = cons_.try_read_view(q_);
+      if (!view) {
+        break;
+      }
+      const std::size_t record = sizeof(fast_queue_spmc::header_t) + view->size();
+      if (memory_ == nullptr) {
+        errors_.fetch_add(1, std::memory_order_relaxed); // dropped: no buffers to copy into
+      } else if (sizeof(chunk_header) + record > cfg_.buffer_size) {
+        seal();
+        write_oversize(*view);
+      } else {
+        if (sizeof(chunk_header) + fill_ + record > cfg_.buffer_size) {
+          seal();
+        }
+        copy_record(buffer(cur_) + sizeof(chunk_header) + fill_, *view);
+        fill_ += record;
+        ++chunk_messages_;
+      }
+      cons_.commit_read(q_); // the ring slot is free as soon as the record is copied
+    }
+    return n;
+  }
+
+  // [length][payload] of `view` at `dst`.
+  static void copy_record(std::byte *dst, const fast_queue_spmc::read_view &view) noexcept {
+    const auto len = static_cast<fast_queue_spmc::header_t>(view.size());
+    std::memcpy(dst, &len, sizeof(len));
+    std::memcpy(dst + sizeof(len), view.first.data(), view.first.size());
+    if (view.wrapped()) {
+      std::memcpy(dst + sizeof(len) + view.first.size(), view.second.data(), view.second.size());
+    }
+  }
+
+  // A record larger than a chunk buffer: a chunk of its own, from a one-off buffer, written
+  // with a blocking pwritev. Rare by construction (size buffer_size for the largest record).
+  void write_oversize(const fast_queue_spmc::read_view &view) {
+    const std::size_t record = sizeof(fast_queue_spmc::header_t) + view.size();
+    const std::size_t len = align_up(sizeof(chunk_header) + record);
+    const std::unique_ptr<std::byte, decltype(&std::free)> buf{
+        static_cast<std::byte *>(std::aligned_alloc(BLOCK, len)), &std::free};
+    if (buf == nullptr) {
+      errors_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      const chunk_header h{CHUNK_MAGIC, static_cast<std::uint32_t>(record), next_seq_};
+      std::memcpy(buf.get(), &h, sizeof(h));
+      copy_record(buf.get() + sizeof(h), view);
+      std::memset(buf.get() + sizeof(h) + record, 0, len - sizeof(h) - record);
+      if (file_offset_ != 0 && file_offset_ + len > cfg_.file_size) {
+        close_file();
+        open_next();
+      }
+      write_blocking(buf.get(), len);
+      file_offset_ += len;
+    }
+    messages_.store(++next_seq_, std::memory_order_release);
+  }
+
+  // Writes the current chunk (if any) and moves on to the next free buffer.
+  void seal() {
+    if (fill_ == 0) {
+      return;
+    }
+    std::byte *buf = buffer(cur_);
+    const chunk_header h{CHUNK_MAGIC, static_cast<std::uint32_t>(fill_), next_seq_};
+    std::memcpy(buf, &h, sizeof(h));
+    const std::size_t len = align_up(sizeof(h) + fill_);
+    std::memset(buf + sizeof(h) + fill_, 0, len - sizeof(h) - fill_);
+    if (file_offset_ + len > cfg_.file_size) {
+      close_file();
+      open_next();
+    }
+    write_chunk(cur_, len);
+    file_offset_ += len;
+    next_seq_ += chunk_messages_;
+    messages_.store(next_seq_, std::memory_order_release);
+    chunk_messages_ = 0;
+    fill_ = 0;
+    cur_ = (cur_ + 1) % cfg_.buffers;
+    while (pending_[cur_] != 0) { // every buffer in flight: the disk is the bottleneck
+      reap(true);
+    }
+  }
+
+  void write_chunk(std::size_t b, std::size_t len) {
+    if (fd_ < 0) {
+      errors_.fetch_add(1, std::memory_order_relaxed); // dropped: no file to write to
+      return;
+    }
+    unsynced_ = true;
+#if defined(__linux__)
+    if (ring_) {
+      io_uring_sqe sqe{};
+      sqe.opcode = IORING_OP_WRITE;
+      sqe.fd = fd_;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer(b));
+      sqe.len = static_cast<std::uint32_t>(len);
+      sqe.off = file_offset_;
+      sqe.user_data = b;
+      if (ring_->submit(sqe)) {
+        pending_[b] = len;
+        ++in_flight_;
+        return;
+      }
+    }
+#endif
+    write_blocking(buffer(b), len); // also when the ring refused the write
+  }
+
+  // pwritev of [p, p + len) at file_offset_, retried until done or failed.
+  void write_blocking(std::byte *p, std::size_t len) {
+    if (fd_ < 0) {
+      errors_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    unsynced_ = true;
+    iovec iov{p, len};
+    std::size_t done = 0;
+    while (done < len) {
+      const ssize_t w = ::pwritev(fd_, &iov, 1, static_cast<off_t>(file_offset_ + done));
+      if (w < 0 && errno == EINTR) {
+        continue;
+      }
+      if (w <= 0) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      done += static_cast<std::size_t>(w);
+      iov.iov_base = p + done;
+      iov.iov_len = len - done;
+    }
+    bytes_.fetch_add(len, std::memory_order_relaxed);
+  }
+
+  // Collects io_uring completions; with `wait`, blocks for at least one if any is in flight.
+  void reap([[maybe_unused]] bool wait) {
+#if defined(__linux__)
+    io_uring_cqe cqe;
+    while (in_flight_ != 0) {
+      if (!ring_->reap(cqe, wait)) {
+        if (wait) {
+          abandon_ring(); // waiting failed: no completion will ever free the buffers
+        }
+        return;
+      }
+      wait = false;
+      --in_flight_;
+      if (cqe.user_data == SYNC_TAG) {
+        errors_.fetch_add(cqe.res < 0, std::memory_order_relaxed);
+        continue;
+      }
+      std::size_t &len = pending_[cqe.user_data];
+      if (cqe.res < 0 || static_cast<std::size_t>(cqe.res) != len) {
+        errors_.fetch_add(1, std::memory_order_relaxed); // failed or short write
+      } else {
+        bytes_.fetch_add(static_cast<std::uint64_t>(cqe.res), std::memory_order_relaxed);
+      }
+      len = 0;
+    }
+#endif
+  }
+
+#if defined(__linux__)
+  // Gives up on io_uring after io_uring_enter failed: what was in flight counts as failed,
+  // its buffers are freed and the rest of the run writes with pwritev.
+  void abandon_ring() noexcept {
+    errors_.fetch_add(in_flight_, std::memory_order_relaxed);
+    std::ranges::fill(pending_, std::size_t{0});
+    in_flight_ = 0;
+    ring_.reset();
+    unsynced_ = fd_ >= 0; // the queued fdatasync, if any, is gone with the ring
+  }
+#endif
+
+  // fdatasync of everything written so far; asynchronous on io_uring.
+  void sync() {
+    if (fd_ < 0 || !unsynced_) {
+      return;
+    }
+    unsynced_ = false;
+    syncs_.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__)
+    if (ring_) {
+      io_uring_sqe sqe{};
+      sqe.opcode = IORING_OP_FSYNC;
+      sqe.flags = IOSQE_IO_DRAIN; // after every write submitted before it
+      sqe.fd = fd_;
+      sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+      sqe.user_data = SYNC_TAG;
+      if (ring_->submit(sqe)) {
+        ++in_flight_;
+        return;
+      }
+    }
+#endif
+    datasync();
+  }
+
+  void datasync() {
+#if defined(__APPLE__)
+    errors_.fetch_add(::fsync(fd_) != 0, std::memory_order_relaxed);
+#else
+    errors_.fetch_add(::fdatasync(fd_) != 0, std::memory_order_relaxed);
+#endif
+  }
+
+  void close_file() {
+    while (in_flight_ != 0) {
+      reap(true);
+    }
+    if (fd_ >= 0) {
+      if (unsynced_) {
+        syncs_.fetch_add(1, std::memory_order_relaxed);
+        datasync();
+      }
+      ::close(fd_);
+      fd_ = -1;
+    }
+    unsynced_ = false;
+  }
+
+  void open_next() {
+    const auto path = file_path(cfg_.directory, cfg_.prefix, files_.load());
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#if defined(O_DIRECT)
+    fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    direct_.store(fd_ >= 0, std::memory_order_release);
+    if (fd_ < 0 && errno == EINVAL) { // e.g. tmpfs: buffered writes instead
+      fd_ = ::open(path.c_str(), flags, 0644);
+    }
+#else
+    fd_ = ::open(path.c_str(), flags, 0644);
+#if defined(F_NOCACHE)
+    direct_.store(fd_ >= 0 && ::fcntl(fd_, F_NOCACHE, 1) == 0, std::memory_order_release);
+#endif
+#endif
+    if (fd_ < 0) {
+      errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    file_offset_ = 0;
+    files_.fetch_add(1, std::memory_order_release);
+  }
+
+  std::byte *buffer(std::size_t b) const noexcept { return memory_ + b * cfg_.buffer_size; }
+
+  Q &q_;
+  fast_queue_spmc::consumer cons_;
+  journal_config cfg_;
+  std::byte *memory_ = nullptr; // cfg_.buffers chunk buffers, BLOCK-aligned
+  std::vector<std::size_t> pending_; // per buffer: bytes the kernel is writing (0 = free)
+#if defined(__linux__)
+  std::unique_ptr<uring> ring_;
+#else
+  std::unique_ptr<int> ring_; // never set: keeps `ring_ ? ... : ...` portable
+#endif
+  backend io_ = backend::pwritev;
+  std::atomic<bool> direct_{false};
+  // Journal thread only.
+  int fd_ = -1;
+  std::uint64_t file_offset_ = 0;
+  std::size_t cur_ = 0;            // buffer being filled
+  std::size_t fill_ = 0;           // record bytes in it
+  std::uint64_t chunk_messages_ = 0;
+  std::uint64_t next_seq_ = 0;     // first_seq of the chunk being filled
+  std::size_t in_flight_ = 0;      // io_uring operations submitted, not yet reaped
+  bool unsynced_ = false;          // written since the last sync
+  std::atomic<bool> stop_{false};
+  std::atomic<std::uint64_t> messages_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  std::atomic<std::uint32_t> files_{0};
+  std::atomic<std::uint64_t> syncs_{0};
+  std::atomic<std::uint64_t> errors_{0};
+  std::thread thread_; // started in the constructor body, once everything is initialised
+};
+
+} // namespace journal
@@ -0,0 +1,279 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for journal.hpp. The round trip journals a stream of variable-size
+// messages through a small ring into small rolling files (many chunks, many files) on both
+// backends, then parses the files back and checks every record, every chunk header and the
+// sequence numbering. The benchmark pushes a few hundred MB through spmc_queue_t with one
+// strategy reader and the journal attached, and reports the sustained write rate and how
+// often the journal's lag made the producer find the ring full - against the same run
+// without a journal.
+//
+
+#pragma once
+
+#include "fast_queue_SPMC.hpp"
+#include "journal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace journal {
+
+// Payload of message `seq`: the sequence number, then seq % 61 filler bytes.
+inline std::size_t fill_message(std::uint64_t seq, std::span<std::byte> out) {
+  const std::size_t n = sizeof(seq) + seq % 61;
+  std::memcpy(out.data(), &seq, sizeof(seq));
+  std::memset(out.data() + sizeof(seq), static_cast<int>(seq & 0xFF), n - sizeof(seq));
+  return n;
+}
+
+// Reads back every file of a journal in order and checks its structure and content against
+// fill_message. Returns the number of messages found.
+inline std::uint64_t verify_journal(const std::filesystem::path &dir, const std::string &prefix,
+                                    std::uint32_t files) {
+  std::uint64_t seq = 0;
+  std::vector<std::byte> chunk;
+  std::array<std::byte, 128> want;
+  for (std::uint32_t f = 0; f < files; ++f) {
+    std::ifstream in{file_path(dir, prefix, f), std::ios::binary};
+    assert(in && "journal file missing");
+    chunk_header h;
+    while (in.read(reinterpret_cast<char *>(&h), sizeof(h))) {
+      assert(h.magic == CHUNK_MAGIC && h.first_seq == seq && "chunks must be contiguous");
+      chunk.resize(align_up(sizeof(h) + h.bytes) - sizeof(h));
+      in.read(reinterpret_cast<char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+      assert(in && "chunk cut short");
+      for (std::size_t at = 0; at < h.bytes; ++seq) {
+        fast_queue_spmc::header_t len;
+        std::memcpy(&len, chunk.data() + at, sizeof(len));
+        const std::size_t n = fill_message(seq, want);
+        assert(static_cast<std::size_t>(len) == n &&
+               std::memcmp(chunk.data() + at + sizeof(len), want.data(), n) == 0);
+        at += sizeof(len) + n;
+      }
+    }
+  }
+  return seq;
+}
+
+inline void test_round_trip(backend io) {
+  std::println("--- test_journal_round_trip ({}) ---", to_string(io));
+  using queue = fast_queue_spmc::spmc_queue_t<std::size_t{1} << 12, 2>;
+  constexpr std::uint64_t N = 100'000;
+  const auto dir = std::filesystem::temp_directory_path() /
+                   (std::string{"journal_test_"} + to_string(io));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  auto q = std::make_unique<queue>();
+  journal_config cfg{.directory = dir,
+                     .buffer_size = 2 * BLOCK,
+                     .buffers = 3,
+                     .file_size = 16 * BLOCK, // rolls every few chunks
+                     .fsync_interval = std::chrono::milliseconds{5},
+                     .io = io};
+  std::uint32_t files = 0;
+  {
+    writer<queue> j{*q, 1, cfg};
+    std::thread strategy([&] {
+      fast_queue_spmc::consumer c{0};
+      std::array<std::byte, 128> out;
+      for (std::uint64_t got = 0; got < N;) {
+        if (c.try_read(*q, out)) {
+          ++got;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    fast_queue_spmc::producer prod;
+    std::array<std::byte, 128> msg;
+    for (std::uint64_t seq = 0; seq < N; ++seq) {
+      const std::size_t n = fill_message(seq, msg);
+      while (!prod.try_write(*q, std::span{msg.data(), n})) {
+        std::this_thread::yield();
+      }
+    }
+    strategy.join();
+    j.stop();
+    assert(j.ok() && j.messages() == N && j.files() > 1 && j.syncs() >= j.files());
+    files = j.files();
+    std::println("journaled {} messages into {} files via {} ({}), {} syncs", N, files,
+                 to_string(j.io()), j.direct() ? "O_DIRECT" : "buffered", j.syncs());
+  }
+  assert(verify_journal(dir, cfg.prefix, files) == N);
+  std::filesystem::remove_all(dir);
+  std::println("test_journal_round_trip ({}) PASSED", to_string(io));
+}
+
+// Every fourth message is 3 BLOCKs, larger than the 2-BLOCK chunk buffers: each must land in
+// a chunk of its own, between the ordinary chunks, with the numbering unbroken.
+inline void test_oversize_records() {
+  std::println("--- test_journal_oversize_records ---");
+  using queue = fast_queue_spmc::spmc_queue_t<std::size_t{1} << 15, 1>;
+  constexpr std::uint64_t N = 200;
+  const auto size_of = [](std::uint64_t seq) { return seq % 4 == 0 ? 3 * BLOCK : 16; };
+  const auto dir = std::filesystem::temp_directory_path() / "journal_test_oversize";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  auto q = std::make_unique<queue>();
+  const journal_config cfg{.directory = dir,
+                           .buffer_size = 2 * BLOCK,
+                           .buffers = 2,
+                           .file_size = 16 * BLOCK,
+                           .io = backend::pwritev};
+  std::uint32_t files = 0;
+  {
+    writer<queue> j{*q, 0, cfg};
+    fast_queue_spmc::producer prod;
+    std::vector<std::byte> msg(3 * BLOCK);
+    for (std::uint64_t seq = 0; seq < N; ++seq) {
+      std::memset(msg.data(), static_cast<int>(seq & 0xFF), size_of(seq));
+      while (!prod.try_write(*q, std::span{msg.data(), size_of(seq)})) {
+        std::this_thread::yield();
+      }
+    }
+    j.stop();
+    assert(j.ok() && j.messages() == N);
+    files = j.files();
+  }
+  std::uint64_t seq = 0;
+  std::vector<std::byte> chunk;
+  for (std::uint32_t f = 0; f < files; ++f) {
+    std::ifstream in{file_path(dir, cfg.prefix, f), std::ios::binary};
+    chunk_header h;
+    while (in.read(reinterpret_cast<char *>(&h), sizeof(h))) {
+      assert(h.magic == CHUNK_MAGIC && h.first_seq == seq);
+      chunk.resize(align_up(sizeof(h) + h.bytes) - sizeof(h));
+      in.read(reinterpret_cast<char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+      for (std::size_t at = 0; at < h.bytes; ++seq) {
+        fast_queue_spmc::header_t len;
+        std::memcpy(&len, chunk.data() + at, sizeof(len));
+        assert(static_cast<std::size_t>(len) == size_of(seq));
+        assert(std::ranges::all_of(std::span{chunk.data() + at + sizeof(len), size_of(seq)},
+                                   [&](std::byte b) { return b == std::byte(seq & 0xFF); }));
+        at += sizeof(len) + size_of(seq);
+      }
+    }
+  }
+  assert(seq == N);
+  std::filesystem::remove_all(dir);
+  std::println("test_journal_oversize_records PASSED");
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// The producer publishes range(0) messages of 120 bytes on a 1 MiB broadcast ring as fast as
+// it can; reader 0 is a strategy that just consumes, reader 1 is the journal (or, for the
+// baseline, a second plain consumer). Manual time runs from the start until the journal is
+// stopped - everything written and fdatasync'ed. `fulls` counts the producer's failed
+// try_writes: the back-pressure the readers put on the feed.
+
+constexpr std::size_t BENCH_PAYLOAD = 120;
+using bench_queue = fast_queue_spmc::spmc_queue_t<std::size_t{1} << 20, 2>;
+
+template <class Reader1> void run_feed(benchmark::State &state, Reader1 &&make_reader1) {
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  std::uint64_t fulls = 0;
+  for (auto _ : state) {
+    auto q = std::make_unique<bench_queue>();
+    std::atomic<bool> go{false};
+    auto reader = [&](std::size_t id) {
+      fast_queue_spmc::consumer c{id};
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (std::uint64_t got = 0; got < n;) {
+        if (const auto v = c.try_read_view(*q)) {
+          benchmark::DoNotOptimize(v->first.data());
+          c.commit_read(*q);
+          ++got;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    };
+    std::thread strategy(reader, 0);
+    auto finish1 = make_reader1(*q, reader); // starts reader 1; returns a callable that ends it
+    std::array<std::byte, BENCH_PAYLOAD> msg{};
+    fast_queue_spmc::producer prod;
+    fulls = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::uint64_t seq = 0; seq < n; ++seq) {
+      std::memcpy(msg.data(), &seq, sizeof(seq));
+      while (!prod.try_write(*q, msg)) {
+        ++fulls;
+        std::this_thread::yield();
+      }
+    }
+    strategy.join();
+    finish1();
+    state.SetIterationTime(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          static_cast<std::int64_t>(BENCH_PAYLOAD + sizeof(std::int32_t)));
+  state.counters["fulls"] = static_cast<double>(fulls);
+}
+
+// Args: range(0) = messages, range(1) = backend (0 io_uring, 1 pwritev).
+inline void BM_JournalSustained(benchmark::State &state) {
+  const auto dir = std::filesystem::temp_directory_path() / "journal_bench";
+  std::filesystem::create_directories(dir);
+  const journal_config cfg{.directory = dir,
+                           .file_size = std::uint64_t{256} << 20,
+                           .io = static_cast<backend>(state.range(1))};
+  std::unique_ptr<writer<bench_queue>> j;
+  run_feed(state, [&](bench_queue &q, auto &) {
+    j = std::make_unique<writer<bench_queue>>(q, 1, cfg);
+    return [&] { j->stop(); };
+  });
+  state.SetLabel(std::string{to_string(j->io())} + (j->direct() ? " O_DIRECT" : " buffered"));
+  state.counters["files"] = j->files();
+  state.counters["syncs"] = static_cast<double>(j->syncs());
+  state.counters["errors"] = static_cast<double>(j->errors());
+  j.reset();
+  std::filesystem::remove_all(dir);
+}
+
+// The same feed with a second plain consumer in place of the journal.
+inline void BM_JournalBaseline(benchmark::State &state) {
+  std::unique_ptr<std::thread> t;
+  run_feed(state, [&](bench_queue &, auto &reader) {
+    t = std::make_unique<std::thread>(reader, 1);
+    return [&] { t->join(); };
+  });
+}
+
+inline void test() {
+  test_round_trip(backend::io_uring);
+  test_round_trip(backend::pwritev);
+  test_oversize_records();
+  BENCHMARK(BM_JournalSustained)
+      ->UseManualTime()
+      ->Iterations(1)
+      ->ArgsProduct({{2'000'000}, {0, 1}})
+      ->ArgNames({"N", "pwritev"});
+  BENCHMARK(BM_JournalBaseline)->UseManualTime()->Iterations(1)->Arg(2'000'000)->ArgName("N");
+}
+
+} // namespace journal
@@ -1,13 +1,77 @@
+#include "async_logger_test.hpp"
 #include "cache_warming.hpp"
 #include "compile_time_dispatch.hpp"
+#include "core_to_core_test.hpp"
+#include "exchange_sim_test.hpp"
 #include "fast_queue_SPMC_test.hpp"
 #include "fast_queue_SPSC_test.hpp"
+#include "feed_handler_test.hpp"
+#include "flat_hash_map_test.hpp"
+#include "flight_recorder_test.hpp"
+#include "interleaving_test.hpp"
+#include "journal_test.hpp"
+#include "market_data_test.hpp"
+#include "object_pool_test.hpp"
+#include "order_book_test.hpp"
+#include "replay_test.hpp"
+#include "risk_check_test.hpp"
+#include "seqlock_test.hpp"
+#include "strategy_pipeline_test.hpp"
+#include "thread_placement_test.hpp"
+#include "timer_wheel_test.hpp"
+#include "warmup_test.hpp"
 
 #include <benchmark/benchmark.h>
 
+#include <csignal>
+
 int main(int argc, char **argv) {
   // cache_warming::test();
+  // Working-set sweep (4 KiB..1 GiB): registers only, runs in the shared pass below.
+  cache_warming::sweep();
   // compile_time_dispatch::test();
+  // Megamorphic dispatch suite (virtual / variant / function table / CRTP / final): registers only.
+  compile_time_dispatch::suite();
+  // With -DENABLE_FLIGHT_RECORDER=ON the queues trace their events; `kill -USR2 <pid>` then
+  // snapshots every thread's ring (convert with flight_recorder::convert_to_chrome_json).
+  if constexpr (flight_recorder::enabled) {
+    flight_recorder::install_dump_on_signal(SIGUSR2, "fast_queue_flight_recorder.bin");
+  }
+  flight_recorder::test();
+  // Hot-thread cost of the async logger vs std::println.
+  async_logger::test();
+  // Order entry against a local exchange process over shared-memory rings: tick-to-trade.
+  exchange_sim::test();
+  // UDP multicast feed handler on loopback: gaps, pps by recvmmsg batch, wire-to-queue latency.
+  feed_handler::test();
+  // Robin Hood flat hash map vs std::unordered_map for order-id lookups.
+  flat_hash_map::test();
+  // Journal as an extra SPMC reader: sustained MB/s and the back-pressure it puts on the feed.
+  journal::test();
+  // ITCH-style decoder: compile-time schemas, jump-table dispatch, in-place from read_views.
+  market_data::test();
+  // Pool / slab allocator vs malloc and std::pmr.
+  object_pool::test();
+  // L3 book: correctness, then replay cost per message (direct and through the SPSC ring).
+  order_book::test();
+  // Journal replay through mmap: the live consumer loop over recorded files, GB/s vs pread.
+  replay::test();
+  // Pre-trade risk checks: branch-free limits table vs the branchy equivalent, rate and p99.
+  risk_check::test();
+  // Seqlock snapshot vs SPMC broadcast when readers only need the latest top of book.
+  seqlock::test();
+  // Decoder -> filter -> book -> signal composed at compile time vs a virtual handler chain.
+  strategy_pipeline::test();
+  // Timer wheel: exact expiry ticks, then schedule/cancel/expire vs a heap and a multimap.
+  timer_wheel::test();
+  // Cache warming on the order path: first-order latency after an idle gap, by cadence.
+  warmup::test();
+  // Host topology first: it tells which thread placements the queue benchmarks can run under.
+  thread_placement::test();
+  // Cache-line transfer cost for every CPU pair, and false sharing by counter distance.
+  core_to_core::test();
+  // Every producer/consumer schedule of a few messages, up to a preemption bound.
+  interleaving::test();
   // Register the SPMC broadcast benchmarks (and run their correctness demo) first; the SPSC
   // driver below owns the single benchmark::Initialize/RunSpecifiedBenchmarks pass, which then
   // executes both the SPSC and the SPMC benchmarks (and honours --benchmark_filter across both).
@@ -0,0 +1,273 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  market_data.hpp — schema-driven binary decoder with a compile-time jump table
+// =====================================================================================
+//
+// The queue tests move opaque byte spans and decode them with a memcpy into a struct. Real
+// feeds (NASDAQ ITCH, CME SBE, ...) are fixed binary layouts: every message type has its
+// fields at known offsets with a known byte order, and decoding is just loading those bytes.
+// This header describes such layouts ENTIRELY AT COMPILE TIME and reads fields straight out
+// of the buffer - no intermediate struct, no copy of the message:
+//
+//  - field<T, Offset, Endian> is a zero-size descriptor: get(p) loads sizeof(T) bytes at
+//    p + Offset and byte-swaps them if the wire order differs from the host's (one bswap
+//    instruction). uint48 and alpha cover ITCH's 6-byte timestamps and space-padded text.
+//  - a schema is a struct naming its type byte, wire size and fields; valid_schema() checks
+//    at compile time that every field lies inside the message.
+//  - message<Schema> wraps a pointer to the bytes: m.get<add_order::price>().
+//  - dispatcher<Handler, Schemas...> builds a constexpr 256-entry table indexed by the type
+//    byte, each entry a direct call to handler.on(message<Schema>). One indexed load and an
+//    indirect call whose target is fixed per type - no virtual objects, no switch ladder,
+//    and the table is shared by every decode (static constexpr, in .rodata).
+//
+// The schemas below are the order-book subset of NASDAQ TotalView-ITCH 5.0 (big-endian,
+// offsets as in the spec). An SBE-style little-endian layout is the same thing with
+// std::endian::little in its fields.
+//
+// decode(handler, read_view) decodes a message still sitting in the SPSC ring: in place when
+// it is contiguous, through a small stack copy only in the rare case that it wraps the end.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace market_data {
+
+// Byte order conversion of an integral value read from / written to the wire.
+template <std::endian E, class T> constexpr T wire_to_host(T v) noexcept {
+  if constexpr (E != std::endian::native && sizeof(T) > 1) {
+    return std::byteswap(v);
+  } else {
+    return v;
+  }
+}
+
+/**
+ * A fixed-offset integral (or char) field. Zero size: it only carries Offset, T and the wire
+ * byte order, so reading it compiles to a load (plus a bswap for the other byte order).
+ */
+template <class T, std::size_t Offset, std::endian E = std::endian::big> struct field {
+  static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+  using type = T;
+  static constexpr std::size_t offset = Offset;
+  static constexpr std::size_t size = sizeof(T);
+
+  static T get(const std::byte *msg) noexcept {
+    T v;
+    std::memcpy(&v, msg + Offset, sizeof(T)); // unaligned-safe; one mov after optimisation
+    return wire_to_host<E>(v);
+  }
+  static void put(std::byte *msg, T v) noexcept {
+    v = wire_to_host<E>(v); // the swap is its own inverse
+    std::memcpy(msg + Offset, &v, sizeof(T));
+  }
+};
+
+// ITCH's 6-byte integer (nanoseconds since midnight), always big-endian.
+template <std::size_t Offset> struct uint48 {
+  using type = std::uint64_t;
+  static constexpr std::size_t offset = Offset;
+  static constexpr std::size_t size = 6;
+
+  static std::uint64_t get(const std::byte *msg) noexcept {
+    std::uint64_t v = 0;
+    std::memcpy(reinterpret_cast<std::byte *>(&v) + 2, msg + Offset, 6); // big-endian, low 6
+    return wire_to_host<std::endian::big>(v);
+  }
+  static void put(std::byte *msg, std::uint64_t v) noexcept {
+    v = wire_to_host<std::endian::big>(v);
+    std::memcpy(msg + Offset, reinterpret_cast<const std::byte *>(&v) + 2, 6);
+  }
+};
+
+// Fixed-width, right space-padded text (e.g. the 8-byte stock symbol). get() returns a view
+// INTO the message with the padding trimmed - valid as long as the message bytes are.
+template <std::size_t Offset, std::size_t N> struct alpha {
+  using type = std::string_view;
+  static constexpr std::size_t offset = Offset;
+  static constexpr std::size_t size = N;
+
+  static std::string_view get(const std::byte *msg) noexcept {
+    std::string_view s{reinterpret_cast<const char *>(msg + Offset), N};
+    const auto end = s.find_last_not_of(' ');
+    return s.substr(0, end == std::string_view::npos ? 0 : end + 1);
+  }
+  static void put(std::byte *msg, std::string_view v) noexcept {
+    std::memset(msg + Offset, ' ', N);
+    std::memcpy(msg + Offset, v.data(), std::min(v.size(), N));
+  }
+};
+
+// Every field of a schema must lie inside its wire size.
+template <class Schema> consteval bool valid_schema() {
+  return std::apply(
+      [](auto... f) { return ((decltype(f)::offset + decltype(f)::size <= Schema::size) && ...); },
+      typename Schema::fields{});
+}
+
+// --- ITCH 5.0 order-book messages --------------------------------------------------
+// Common header: type(1) stock_locate(2) tracking_number(2) timestamp(6).
+
+namespace itch {
+using stock_locate = field<std::uint16_t, 1>;
+using tracking_number = field<std::uint16_t, 3>;
+using timestamp = uint48<5>;
+using order_ref = field<std::uint64_t, 11>;
+
+struct add_order {
+  static constexpr char type = 'A';
+  static constexpr std::size_t size = 36;
+  using side = field<char, 19>; // 'B' or 'S'
+  using shares = field<std::uint32_t, 20>;
+  using stock = alpha<24, 8>;
+  using price = field<std::uint32_t, 32>; // 4 implied decimals
+  using fields = std::tuple<stock_locate, tracking_number, timestamp, order_ref, side, shares,
+                            stock, price>;
+};
+
+struct order_executed {
+  static constexpr char type = 'E';
+  static constexpr std::size_t size = 31;
+  using executed_shares = field<std::uint32_t, 19>;
+  using match_number = field<std::uint64_t, 23>;
+  using fields = std::tuple<stock_locate, tracking_number, timestamp, order_ref,
+                            executed_shares, match_number>;
+};
+
+struct order_cancel {
+  static constexpr char type = 'X';
+  static constexpr std::size_t size = 23;
+  using cancelled_shares = field<std::uint32_t, 19>;
+  using fields =
+      std::tuple<stock_locate, tracking_number, timestamp, order_ref, cancelled_shares>;
+};
+
+struct order_delete {
+  static constexpr char type = 'D';
+  static constexpr std::size_t size = 19;
+  using fields = std::tuple<stock_locate, tracking_number, timestamp, order_ref>;
+};
+
+struct order_replace {
+  static constexpr char type = 'U';
+  static constexpr std::size_t size = 35;
+  using original_ref = order_ref;
+  using new_ref = field<std::uint64_t, 19>;
+  using shares = field<std::uint32_t, 27>;
+  using price = field<std::uint32_t, 31>;
+  using fields =
+      std::tuple<stock_locate, tracking_number, timestamp, original_ref, new_ref, shares, price>;
+};
+
+static_assert(valid_schema<add_order>() && valid_schema<order_executed>() &&
+              valid_schema<order_cancel>() && valid_schema<order_delete>() &&
+              valid_schema<order_replace>());
+
+// The largest message above; sizes the stack copy for a wrapped read_view.
+constexpr std::size_t MAX_MESSAGE_SIZE = 36;
+} // namespace itch
+
+// A typed, non-owning view of one message's bytes.
+template <class Schema> struct message {
+  using schema = Schema;
+  const std::byte *bytes;
+
+  template <class Field> typename Field::type get() const noexcept { return Field::get(bytes); }
+};
+
+// Start encoding a message: write its type byte. The caller then put()s the fields (tests,
+// replay generators and simulators use this to produce wire data).
+template <class Schema> void put_type(std::byte *msg) noexcept {
+  msg[0] = static_cast<std::byte>(Schema::type);
+}
+
+/**
+ * Type-byte -> handler table, built at compile time.
+ *
+ * Handler needs on(message<S>) for every S in Schemas, on_unknown(char type) and
+ * on_truncated(char type, std::size_t len). decode() returns false for unknown or truncated
+ * messages (after calling the corresponding hook).
+ */
+template <class Handler, class... Schemas> class dispatcher {
+  using entry = bool (*)(Handler &, const std::byte *, std::size_t);
+
+  template <class S> static bool invoke(Handler &h, const std::byte *p, std::size_t len) {
+    if (len < S::size) [[unlikely]] {
+      h.on_truncated(S::type, len);
+      return false;
+    }
+    h.on(message<S>{p});
+    return true;
+  }
+
+  static bool unknown(Handler &h, const std::byte *p, std::size_t) {
+    h.on_unknown(static_cast<char>(p[0]));
+    return false;
+  }
+
+  static constexpr std::array<entry, 256> make_table() {
+    std::array<entry, 256> t{};
+    t.fill(&unknown);
+    ((t[static_cast<unsigned char>(Schemas::type)] = &invoke<Schemas>), ...);
+    return t;
+  }
+
+  static constexpr std::array<entry, 256> table = make_table();
+
+public:
+  static bool decode(Handler &h, const std::byte *p, std::size_t len) {
+    if (len == 0) [[unlikely]] {
+      h.on_truncated('\0', 0);
+      return false;
+    }
+    return table[static_cast<unsigned char>(p[0])](h, p, len);
+  }
+
+  static bool decode(Handler &h, std::span<const std::byte> msg) {
+    return decode(h, msg.data(), msg.size());
+  }
+
+  // Decode a message in place in the ring. Only a message split by the ring's end is copied
+  // (into a stack buffer), so the usual case touches nothing but the ring bytes.
+  template <std::size_t MaxSize>
+  static bool decode(Handler &h, const fast_queue_spsc::read_view &v) {
+    if (!v.wrapped()) [[likely]] {
+      return decode(h, v.first.data(), v.first.size());
+    }
+    std::array<std::byte, MaxSize> joined;
+    const std::size_t len = std::min(v.size(), MaxSize);
+    const std::size_t head = std::min(v.first.size(), len);
+    std::memcpy(joined.data(), v.first.data(), head);
+    std::memcpy(joined.data() + head, v.second.data(), len - head);
+    return decode(h, joined.data(), len);
+  }
+};
+
+// The ITCH order-book dispatcher for a handler.
+template <class Handler>
+using itch_dispatcher = dispatcher<Handler, itch::add_order, itch::order_executed,
+                                   itch::order_cancel, itch::order_delete, itch::order_replace>;
+
+template <class Handler> bool decode(Handler &h, const fast_queue_spsc::read_view &v) {
+  return itch_dispatcher<Handler>::template decode<itch::MAX_MESSAGE_SIZE>(h, v);
+}
+
+template <class Handler> bool decode(Handler &h, std::span<const std::byte> msg) {
+  return itch_dispatcher<Handler>::decode(h, msg);
+}
+
+} // namespace market_data
@@ -0,0 +1,319 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for market_data.hpp: field byte order and round trips, dispatch of
+// known / unknown / truncated messages, decoding in place from the SPSC ring (including
+// messages that wrap its end), and decode throughput - compile-time jump table against a
+// hand-written switch - over read_views that point straight at the wire bytes.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "market_data.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <print>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace market_data {
+
+// --- Wire encoders (test / replay side) -------------------------------------------------
+
+inline std::size_t encode_add(std::byte *p, std::uint64_t ref, char side, std::uint32_t shares,
+                              std::string_view stock, std::uint32_t price, std::uint64_t ts) {
+  using m = itch::add_order;
+  put_type<m>(p);
+  itch::stock_locate::put(p, 1);
+  itch::tracking_number::put(p, 0);
+  itch::timestamp::put(p, ts);
+  itch::order_ref::put(p, ref);
+  m::side::put(p, side);
+  m::shares::put(p, shares);
+  m::stock::put(p, stock);
+  m::price::put(p, price);
+  return m::size;
+}
+
+inline std::size_t encode_executed(std::byte *p, std::uint64_t ref, std::uint32_t shares,
+                                   std::uint64_t match) {
+  using m = itch::order_executed;
+  put_type<m>(p);
+  itch::stock_locate::put(p, 1);
+  itch::tracking_number::put(p, 0);
+  itch::timestamp::put(p, 0);
+  itch::order_ref::put(p, ref);
+  m::executed_shares::put(p, shares);
+  m::match_number::put(p, match);
+  return m::size;
+}
+
+inline std::size_t encode_cancel(std::byte *p, std::uint64_t ref, std::uint32_t shares) {
+  using m = itch::order_cancel;
+  put_type<m>(p);
+  itch::stock_locate::put(p, 1);
+  itch::tracking_number::put(p, 0);
+  itch::timestamp::put(p, 0);
+  itch::order_ref::put(p, ref);
+  m::cancelled_shares::put(p, shares);
+  return m::size;
+}
+
+inline std::size_t encode_delete(std::byte *p, std::uint64_t ref) {
+  using m = itch::order_delete;
+  put_type<m>(p);
+  itch::stock_locate::put(p, 1);
+  itch::tracking_number::put(p, 0);
+  itch::timestamp::put(p, 0);
+  itch::order_ref::put(p, ref);
+  return m::size;
+}
+
+inline std::size_t encode_replace(std::byte *p, std::uint64_t ref, std::uint64_t new_ref,
+                                  std::uint32_t shares, std::uint32_t price) {
+  using m = itch::order_replace;
+  put_type<m>(p);
+  itch::stock_locate::put(p, 1);
+  itch::tracking_number::put(p, 0);
+  itch::timestamp::put(p, 0);
+  m::original_ref::put(p, ref);
+  m::new_ref::put(p, new_ref);
+  m::shares::put(p, shares);
+  m::price::put(p, price);
+  return m::size;
+}
+
+// Folds every field it sees into a checksum, so a benchmark cannot skip any load, and counts
+// messages per type for the tests.
+struct checksum_handler {
+  std::uint64_t sum = 0;
+  std::array<std::uint64_t, 256> count{};
+  std::uint64_t unknown = 0;
+  std::uint64_t truncated = 0;
+
+  void on(message<itch::add_order> m) {
+    using s = itch::add_order;
+    sum += m.get<itch::order_ref>() + m.get<s::shares>() + m.get<s::price>() +
+           static_cast<std::uint64_t>(m.get<s::side>()) + m.get<s::stock>().size();
+    ++count['A'];
+  }
+  void on(message<itch::order_executed> m) {
+    using s = itch::order_executed;
+    sum += m.get<itch::order_ref>() + m.get<s::executed_shares>() + m.get<s::match_number>();
+    ++count['E'];
+  }
+  void on(message<itch::order_cancel> m) {
+    sum += m.get<itch::order_ref>() + m.get<itch::order_cancel::cancelled_shares>();
+    ++count['X'];
+  }
+  void on(message<itch::order_delete> m) {
+    sum += m.get<itch::order_ref>();
+    ++count['D'];
+  }
+  void on(message<itch::order_replace> m) {
+    using s = itch::order_replace;
+    sum += m.get<s::original_ref>() + m.get<s::new_ref>() + m.get<s::shares>() +
+           m.get<s::price>();
+    ++count['U'];
+  }
+  void on_unknown(char) { ++unknown; }
+  void on_truncated(char, std::size_t) { ++truncated; }
+};
+
+inline void test_fields() {
+  std::println("--- test_market_data_fields ---");
+  std::array<std::byte, itch::add_order::size> buf{};
+  encode_add(buf.data(), 0x0102030405060708, 'B', 100, "AAPL", 0x11223344, 0x0000AABBCCDDEEFF);
+
+  // ITCH is big-endian on the wire whatever the host is.
+  assert(buf[32] == std::byte{0x11} && buf[35] == std::byte{0x44});
+  assert(buf[11] == std::byte{0x01} && buf[18] == std::byte{0x08});
+  assert(buf[5] == std::byte{0xAA} && buf[10] == std::byte{0xFF});
+  assert(buf[28] == std::byte{' '} && "alpha must be space padded");
+
+  [[maybe_unused]] const message<itch::add_order> m{buf.data()};
+  assert(m.get<itch::order_ref>() == 0x0102030405060708);
+  assert(m.get<itch::timestamp>() == 0x0000AABBCCDDEEFF);
+  assert(m.get<itch::add_order::side>() == 'B');
+  assert(m.get<itch::add_order::shares>() == 100);
+  assert(m.get<itch::add_order::stock>() == "AAPL");
+  assert(m.get<itch::add_order::price>() == 0x11223344);
+
+  // A little-endian (SBE-style) field over the same bytes reads them the other way round.
+  assert((field<std::uint32_t, 32, std::endian::little>::get(buf.data()) == 0x44332211));
+  std::println("test_market_data_fields PASSED");
+}
+
+inline void test_dispatch() {
+  std::println("--- test_market_data_dispatch ---");
+  checksum_handler h;
+  std::array<std::byte, 64> buf{};
+
+  [[maybe_unused]] bool ok =
+      decode(h, std::span<const std::byte>{buf.data(), encode_delete(buf.data(), 7)});
+  assert(ok && h.count['D'] == 1 && h.sum == 7);
+  // Truncated: one byte short of an order_executed.
+  const std::size_t n = encode_executed(buf.data(), 1, 2, 3);
+  ok = decode(h, std::span<const std::byte>{buf.data(), n - 1});
+  assert(!ok && h.truncated == 1 && h.count['E'] == 0);
+  // Unknown type byte, and an empty span.
+  buf[0] = std::byte{'Z'};
+  ok = decode(h, std::span<const std::byte>{buf.data(), 40});
+  assert(!ok && h.unknown == 1);
+  ok = decode(h, std::span<const std::byte>{});
+  assert(!ok && h.unknown == 1 && h.truncated == 2);
+  std::println("test_market_data_dispatch PASSED");
+}
+
+// Push encoded messages through the 1 KB ring (so many of them straddle its end) and decode
+// every one from the consumer's read_view.
+inline void test_decode_from_ring() {
+  std::println("--- test_market_data_decode_from_ring ---");
+  constexpr std::uint64_t N = 10'000;
+  auto fq = std::make_unique<fast_queue_spsc::fast_queue>();
+  fast_queue_spsc::producer prod;
+  fast_queue_spsc::consumer cons;
+  checksum_handler h;
+  std::uint64_t expected_sum = 0;
+  std::uint64_t wrapped = 0;
+
+  std::uint64_t written = 0;
+  std::uint64_t decoded = 0;
+  while (decoded < N) {
+    std::array<std::byte, itch::MAX_MESSAGE_SIZE> buf{};
+    while (written < N) {
+      const std::uint64_t ref = written + 1;
+      const std::size_t len = written % 2 == 0 ? encode_add(buf.data(), ref, 'S', 10, "MSFT", 5, 0)
+                                               : encode_cancel(buf.data(), ref, 3);
+      if (!prod.try_write(*fq, std::span<const std::byte>{buf.data(), len})) {
+        break;
+      }
+      expected_sum += written % 2 == 0 ? ref + 10 + 5 + 'S' + 4 : ref + 3;
+      ++written;
+    }
+    while (auto view = cons.try_read_view(*fq)) {
+      wrapped += view->wrapped() ? 1 : 0;
+      [[maybe_unused]] const bool ok = decode(h, *view);
+      assert(ok);
+      cons.commit_read(*fq);
+      ++decoded;
+    }
+  }
+  assert(h.sum == expected_sum && h.count['A'] == N / 2 && h.count['X'] == N / 2);
+  assert(wrapped > 0 && "the test should have exercised wrapped messages");
+  std::println("test_market_data_decode_from_ring PASSED ({} messages, {} wrapped)", N,
+               wrapped);
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// A pre-encoded stream with a feed-like mix (adds, deletes, executions, cancels, replaces)
+// laid out back to back, plus one read_view per message pointing into it: the same spans a
+// consumer gets from try_read_view, so decoding touches only the wire bytes.
+
+struct encoded_stream {
+  std::vector<std::byte> bytes;
+  std::vector<fast_queue_spsc::read_view> views;
+};
+
+inline const encoded_stream &bench_stream() {
+  static const encoded_stream s = [] {
+    constexpr std::size_t N = 1'000'000;
+    encoded_stream out;
+    out.bytes.resize(N * itch::MAX_MESSAGE_SIZE);
+    std::vector<std::size_t> lengths;
+    std::mt19937_64 rng{1};
+    std::size_t at = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+      std::byte *p = out.bytes.data() + at;
+      const auto roll = rng() % 100;
+      const std::uint64_t ref = i + 1;
+      std::size_t len;
+      if (roll < 45) {
+        len = encode_add(p, ref, (roll & 1) ? 'B' : 'S', 100, "SPY", 4'500'000, i);
+      } else if (roll < 75) {
+        len = encode_delete(p, ref);
+      } else if (roll < 85) {
+        len = encode_executed(p, ref, 50, i);
+      } else if (roll < 90) {
+        len = encode_cancel(p, ref, 25);
+      } else {
+        len = encode_replace(p, ref, ref + N, 200, 4'500'100);
+      }
+      lengths.push_back(len);
+      at += len;
+    }
+    at = 0;
+    for (const std::size_t len : lengths) {
+      out.views.push_back({std::span<const std::byte>{out.bytes.data() + at, len}, {}});
+      at += len;
+    }
+    return out;
+  }();
+  return s;
+}
+
+inline void BM_DecodeJumpTable(benchmark::State &state) {
+  const auto &s = bench_stream();
+  checksum_handler h;
+  for (auto _ : state) {
+    for (const auto &v : s.views) {
+      decode(h, v);
+    }
+    benchmark::DoNotOptimize(h.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(s.views.size()));
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(s.bytes.size()));
+}
+
+// Baseline: the same handler behind a switch on the type byte (without the length checks the
+// table entries do, so if anything the switch is flattered).
+inline void BM_DecodeSwitch(benchmark::State &state) {
+  const auto &s = bench_stream();
+  checksum_handler h;
+  for (auto _ : state) {
+    for (const auto &v : s.views) {
+      const std::byte *p = v.first.data();
+      switch (static_cast<char>(p[0])) {
+      case 'A':
+        h.on(message<itch::add_order>{p});
+        break;
+      case 'E':
+        h.on(message<itch::order_executed>{p});
+        break;
+      case 'X':
+        h.on(message<itch::order_cancel>{p});
+        break;
+      case 'D':
+        h.on(message<itch::order_delete>{p});
+        break;
+      case 'U':
+        h.on(message<itch::order_replace>{p});
+        break;
+      default:
+        h.on_unknown(static_cast<char>(p[0]));
+      }
+    }
+    benchmark::DoNotOptimize(h.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(s.views.size()));
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(s.bytes.size()));
+}
+
+inline void test() {
+  test_fields();
+  test_dispatch();
+  test_decode_from_ring();
+  BENCHMARK(BM_DecodeJumpTable);
+  BENCHMARK(BM_DecodeSwitch);
+}
+
+} // namespace market_data
@@ -0,0 +1,323 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  object_pool.hpp — fixed-size object pool / slab allocator for hot-path objects
+// =====================================================================================
+//
+// malloc on the hot path is a lottery: usually a fast thread-cache hit, sometimes a lock, a
+// trim, or an mmap/brk syscall. Hot-path objects (orders, timers, messages) have one size
+// each and a bounded live count, so they can come from a pool that only ever touches the OS
+// while warming up:
+//
+//  - fixed_pool: slots of one size carved out of SLABS (big aligned blocks). Free slots form
+//    an intrusive singly linked list threaded through the slots themselves, so allocate and
+//    deallocate are one pointer pop / push - O(1), no search, no header per object. Slots are
+//    rounded up to whole cache lines and slabs are cache-line aligned, so two objects never
+//    share a line (no false sharing between threads that own neighbouring objects).
+//    reserve(n) pre-allocates up front; after that the pool never calls into the system.
+//  - object_pool<T>: the typed front end, constructing / destroying T in place.
+//  - shared_pool + thread_cache: for objects allocated on one thread and freed on others. The
+//    shared pool is a fixed_pool behind a mutex; each thread fronts it with a small private
+//    stack and moves slots in and out in batches, so the lock is taken once per batch instead
+//    of once per object (the tcmalloc / jemalloc tcache idea).
+//  - pool_resource: a std::pmr::memory_resource over a fixed_pool, so pmr containers whose
+//    node size fits a slot (list, map, unordered_map nodes) allocate from it; anything bigger
+//    or more aligned goes to the upstream resource.
+//
+// None of the single-threaded pieces are thread-safe: like std::pmr::unsynchronized_pool_
+// resource they are meant to be owned by one thread.
+//
+
+#pragma once
+
+#include "cache_line.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include <version>
+
+namespace object_pool {
+
+constexpr std::size_t round_up(std::size_t n, std::size_t align) noexcept {
+  return (n + align - 1) / align * align;
+}
+
+constexpr std::size_t UNLIMITED = std::numeric_limits<std::size_t>::max();
+
+/**
+ * Untyped pool of equally sized, cache-line-aligned slots.
+ *
+ * allocate() returns nullptr when the pool is exhausted and may not grow (max_slabs reached,
+ * or the system is out of memory); the caller decides what that means on its path.
+ */
+class fixed_pool {
+public:
+  explicit fixed_pool(std::size_t object_size, std::size_t slots_per_slab = 1024,
+                      std::size_t max_slabs = UNLIMITED)
+      : slot_size_{round_up(std::max(object_size, sizeof(free_node)), CACHE_LINE_SIZE)},
+        slots_per_slab_{slots_per_slab}, max_slabs_{max_slabs} {
+    assert(slots_per_slab > 0);
+  }
+
+  fixed_pool(const fixed_pool &) = delete;
+  fixed_pool &operator=(const fixed_pool &) = delete;
+
+  // Releases every slab. Objects still allocated must already have been destroyed.
+  ~fixed_pool() {
+    for (void *slab : slabs_) {
+      ::operator delete(slab, std::align_val_t{CACHE_LINE_SIZE});
+    }
+  }
+
+  void *allocate() noexcept {
+    if (free_ == nullptr && !grow()) [[unlikely]] {
+      return nullptr;
+    }
+    free_node *node = free_;
+    free_ = node->next;
+    ++in_use_;
+    return node;
+  }
+
+  void deallocate(void *p) noexcept {
+    assert(p != nullptr && in_use_ > 0);
+    auto *node = static_cast<free_node *>(p);
+    node->next = free_;
+    free_ = node;
+    --in_use_;
+  }
+
+  // Grow until at least `slots` slots exist, so the hot path never has to.
+  bool reserve(std::size_t slots) noexcept {
+    while (capacity() < slots) {
+      if (!grow()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::size_t slot_size() const noexcept { return slot_size_; }
+  std::size_t capacity() const noexcept { return slabs_.size() * slots_per_slab_; }
+  std::size_t in_use() const noexcept { return in_use_; }
+  std::size_t slabs() const noexcept { return slabs_.size(); }
+
+private:
+  struct free_node {
+    free_node *next;
+  };
+
+  bool grow() noexcept {
+    if (slabs_.size() >= max_slabs_) {
+      return false;
+    }
+    void *slab = ::operator new(slot_size_ * slots_per_slab_, std::align_val_t{CACHE_LINE_SIZE},
+                                std::nothrow);
+    if (slab == nullptr) {
+      return false;
+    }
+    try {
+      slabs_.push_back(slab);
+    } catch (...) {
+      ::operator delete(slab, std::align_val_t{CACHE_LINE_SIZE});
+      return false;
+    }
+    // Push the slots in reverse so a fresh slab hands them out in address order.
+    auto *base = static_cast<std::byte *>(slab);
+    for (std::size_t i = slots_per_slab_; i-- > 0;) {
+      auto *node = reinterpret_cast<free_node *>(base + i * slot_size_);
+      node->next = free_;
+      free_ = node;
+    }
+    return true;
+  }
+
+  std::size_t slot_size_;
+  std::size_t slots_per_slab_;
+  std::size_t max_slabs_;
+  free_node *free_{nullptr};
+  std::size_t in_use_{0};
+  std::vector<void *> slabs_;
+};
+
+// Typed front end: create() constructs a T in a pool slot, destroy() runs ~T and frees it.
+template <class T> class object_pool {
+  static_assert(alignof(T) <= CACHE_LINE_SIZE, "slots are only cache-line aligned");
+
+public:
+  explicit object_pool(std::size_t slots_per_slab = 1024, std::size_t max_slabs = UNLIMITED)
+      : pool_{sizeof(T), slots_per_slab, max_slabs} {}
+
+  // nullptr when the pool is exhausted. If T's constructor throws, the slot is returned.
+  template <class... Args> T *create(Args &&...args) {
+    void *p = pool_.allocate();
+    if (p == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+    try {
+      return ::new (p) T(std::forward<Args>(args)...);
+    } catch (...) {
+      pool_.deallocate(p);
+      throw;
+    }
+  }
+
+  void destroy(T *obj) noexcept {
+    obj->~T();
+    pool_.deallocate(obj);
+  }
+
+  bool reserve(std::size_t n) noexcept { return pool_.reserve(n); }
+  std::size_t in_use() const noexcept { return pool_.in_use(); }
+  std::size_t capacity() const noexcept { return pool_.capacity(); }
+
+private:
+  fixed_pool pool_;
+};
+
+/**
+ * A fixed_pool shared between threads. Only moves slots in batches; threads allocate through
+ * their own thread_cache.
+ */
+class shared_pool {
+public:
+  explicit shared_pool(std::size_t object_size, std::size_t slots_per_slab = 1024,
+                       std::size_t max_slabs = UNLIMITED)
+      : pool_{object_size, slots_per_slab, max_slabs} {}
+
+  // Take up to n slots into out[]; returns how many were taken.
+  std::size_t allocate_batch(void **out, std::size_t n) noexcept {
+    std::lock_guard lock{mutex_};
+    std::size_t i = 0;
+    for (; i < n; ++i) {
+      out[i] = pool_.allocate();
+      if (out[i] == nullptr) {
+        break;
+      }
+    }
+    return i;
+  }
+
+  void deallocate_batch(void *const *in, std::size_t n) noexcept {
+    std::lock_guard lock{mutex_};
+    for (std::size_t i = 0; i < n; ++i) {
+      pool_.deallocate(in[i]);
+    }
+  }
+
+  bool reserve(std::size_t slots) noexcept {
+    std::lock_guard lock{mutex_};
+    return pool_.reserve(slots);
+  }
+
+  std::size_t slot_size() const noexcept { return pool_.slot_size(); }
+
+  std::size_t in_use() noexcept {
+    std::lock_guard lock{mutex_};
+    return pool_.in_use();
+  }
+
+private:
+  std::mutex mutex_;
+  fixed_pool pool_;
+};
+
+/**
+ * One thread's private front for a shared_pool. Holds at most 2 * batch free slots: an empty
+ * cache refills `batch` slots under one lock, a full one hands `batch` back. The destructor
+ * returns everything. Not thread-safe itself - one per thread.
+ */
+class thread_cache {
+public:
+  explicit thread_cache(shared_pool &shared, std::size_t batch = 64)
+      : shared_{shared}, batch_{batch} {
+    assert(batch > 0);
+    slots_.resize(2 * batch);
+  }
+
+  thread_cache(const thread_cache &) = delete;
+  thread_cache &operator=(const thread_cache &) = delete;
+
+  ~thread_cache() { shared_.deallocate_batch(slots_.data(), count_); }
+
+  void *allocate() noexcept {
+    if (count_ == 0) [[unlikely]] {
+      count_ = shared_.allocate_batch(slots_.data(), batch_);
+      if (count_ == 0) {
+        return nullptr;
+      }
+    }
+    return slots_[--count_];
+  }
+
+  void deallocate(void *p) noexcept {
+    if (count_ == slots_.size()) [[unlikely]] {
+      // Hand back the oldest half; the most recently freed (cache-hot) slots stay local.
+      shared_.deallocate_batch(slots_.data(), batch_);
+      std::copy(slots_.begin() + static_cast<std::ptrdiff_t>(batch_), slots_.end(),
+                slots_.begin());
+      count_ -= batch_;
+    }
+    slots_[count_++] = p;
+  }
+
+private:
+  shared_pool &shared_;
+  std::size_t batch_;
+  std::vector<void *> slots_; // free slots, a stack: [0, count_)
+  std::size_t count_{0};
+};
+
+/**
+ * std::pmr adapter: requests that fit a slot (size and alignment) come from the pool, the rest
+ * from `upstream`. Single-threaded, like std::pmr::unsynchronized_pool_resource.
+ */
+class pool_resource : public std::pmr::memory_resource {
+public:
+  explicit pool_resource(std::size_t slot_size, std::size_t slots_per_slab = 1024,
+                         std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : pool_{slot_size, slots_per_slab}, upstream_{upstream} {}
+
+  fixed_pool &pool() noexcept { return pool_; }
+
+private:
+  bool fits(std::size_t bytes, std::size_t alignment) const noexcept {
+    return bytes <= pool_.slot_size() && alignment <= CACHE_LINE_SIZE;
+  }
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (fits(bytes, alignment)) {
+      if (void *p = pool_.allocate()) {
+        return p;
+      }
+      throw std::bad_alloc{};
+    }
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+    if (fits(bytes, alignment)) {
+      pool_.deallocate(p);
+    } else {
+      upstream_->deallocate(p, bytes, alignment);
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  fixed_pool pool_;
+  std::pmr::memory_resource *upstream_;
+};
+
+} // namespace object_pool
@@ -0,0 +1,234 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for object_pool.hpp: slot alignment, reuse, exhaustion and reserve,
+// typed construction, the thread cache under concurrent churn, and the pmr adapter. The
+// benchmarks time the same allocate/free churn through malloc, std::pmr's
+// unsynchronized_pool_resource, the pool directly and the pool behind the pmr interface.
+//
+
+#pragma once
+
+#include "object_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <memory_resource>
+#include <numeric>
+#include <print>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace object_pool {
+
+inline void test_fixed_pool() {
+  std::println("--- test_fixed_pool ---");
+  fixed_pool pool{24, /*slots_per_slab=*/8, /*max_slabs=*/2};
+  assert(pool.slot_size() == CACHE_LINE_SIZE);
+
+  std::set<void *> seen;
+  std::vector<void *> live;
+  for (int i = 0; i < 16; ++i) {
+    void *p = pool.allocate();
+    assert(p != nullptr);
+    assert(reinterpret_cast<std::uintptr_t>(p) % CACHE_LINE_SIZE == 0 && "slot not aligned");
+    assert(seen.insert(p).second && "slot handed out twice");
+    live.push_back(p);
+  }
+  [[maybe_unused]] void *over = pool.allocate();
+  assert(over == nullptr && "max_slabs must cap the pool");
+  assert(pool.in_use() == 16 && pool.capacity() == 16);
+
+  pool.deallocate(live.back()); // LIFO: the slot just freed comes back first
+  [[maybe_unused]] void *again = pool.allocate();
+  assert(again == live.back());
+  for (void *p : live) {
+    pool.deallocate(p);
+  }
+  assert(pool.in_use() == 0);
+
+  fixed_pool warm{64, 8};
+  [[maybe_unused]] const bool reserved = warm.reserve(100);
+  assert(reserved && warm.slabs() == 13);
+  for (int i = 0; i < 100; ++i) {
+    live[static_cast<std::size_t>(i % 16)] = warm.allocate();
+  }
+  assert(warm.slabs() == 13 && "a reserved pool must not grow");
+  std::println("test_fixed_pool PASSED");
+}
+
+inline void test_object_pool() {
+  std::println("--- test_object_pool ---");
+  static int alive = 0;
+  struct tracked {
+    explicit tracked(int v) : value{v} { ++alive; }
+    ~tracked() { --alive; }
+    int value;
+  };
+  object_pool<tracked> pool{4};
+  std::vector<tracked *> objs;
+  for (int i = 0; i < 10; ++i) {
+    objs.push_back(pool.create(i));
+  }
+  assert(alive == 10 && objs[7]->value == 7 && pool.capacity() == 12);
+  for (auto *o : objs) {
+    pool.destroy(o);
+  }
+  assert(alive == 0 && pool.in_use() == 0);
+  std::println("test_object_pool PASSED");
+}
+
+// Threads allocate on their own cache and free slots allocated by the others, which is the
+// cross-thread pattern the shared pool exists for. Every slot must come back.
+inline void test_thread_cache() {
+  std::println("--- test_thread_cache ---");
+  constexpr int THREADS = 4;
+  constexpr int ROUNDS = 20'000;
+  shared_pool shared{64};
+  std::vector<std::vector<void *>> handoff(THREADS);
+  std::atomic<int> phase_done{0};
+
+  auto worker = [&](int id) {
+    thread_cache cache{shared, 16};
+    std::vector<void *> mine;
+    for (int i = 0; i < ROUNDS; ++i) {
+      void *p = cache.allocate();
+      assert(p != nullptr);
+      *static_cast<int *>(p) = id; // the slot is really ours to write
+      mine.push_back(p);
+      if (mine.size() > 100) {
+        cache.deallocate(mine.front());
+        mine.erase(mine.begin());
+      }
+    }
+    handoff[static_cast<std::size_t>(id)] = std::move(mine);
+    phase_done.fetch_add(1);
+    while (phase_done.load() != THREADS) {
+      std::this_thread::yield();
+    }
+    // Free the neighbour's slots through our own cache.
+    for (void *p : handoff[static_cast<std::size_t>((id + 1) % THREADS)]) {
+      cache.deallocate(p);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(shared.in_use() == 0 && "slots leaked through the thread caches");
+  std::println("test_thread_cache PASSED");
+}
+
+inline void test_pool_resource() {
+  std::println("--- test_pool_resource ---");
+  pool_resource res{64, 64};
+  {
+    std::pmr::list<std::uint64_t> l{&res}; // 24-byte nodes -> pool
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      l.push_back(i);
+    }
+    assert(res.pool().in_use() == 1000);
+    std::pmr::vector<std::uint64_t> v{&res}; // growing buffer -> upstream once > 64 bytes
+    v.resize(1000);
+    assert(res.pool().in_use() == 1000);
+  }
+  assert(res.pool().in_use() == 0);
+  std::println("test_pool_resource PASSED");
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// Each iteration allocates `batch` 64-byte objects and frees them in a shuffled order (not
+// LIFO, which flatters every free list), touching one word of each so the slot is really
+// used. Args: range(0) = batch.
+
+constexpr std::size_t BENCH_OBJECT = 64;
+
+inline std::vector<std::size_t> free_order(std::size_t n) {
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::shuffle(order.begin(), order.end(), std::mt19937_64{7});
+  return order;
+}
+
+template <class Alloc, class Free>
+void run_churn(benchmark::State &state, Alloc &&alloc, Free &&release) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  const auto order = free_order(n);
+  std::vector<void *> ptrs(n);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < n; ++i) {
+      ptrs[i] = alloc();
+      *static_cast<std::size_t *>(ptrs[i]) = i;
+    }
+    benchmark::ClobberMemory();
+    for (const std::size_t i : order) {
+      release(ptrs[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+inline void BM_PoolMalloc(benchmark::State &state) {
+  run_churn(state, [] { return std::malloc(BENCH_OBJECT); }, [](void *p) { std::free(p); });
+}
+
+inline void BM_PoolPmrUnsynchronized(benchmark::State &state) {
+  std::pmr::unsynchronized_pool_resource res;
+  run_churn(
+      state, [&] { return res.allocate(BENCH_OBJECT, alignof(std::max_align_t)); },
+      [&](void *p) { res.deallocate(p, BENCH_OBJECT, alignof(std::max_align_t)); });
+}
+
+inline void BM_PoolFixed(benchmark::State &state) {
+  fixed_pool pool{BENCH_OBJECT};
+  pool.reserve(static_cast<std::size_t>(state.range(0))); // warm-up: no growth while timed
+  run_churn(state, [&] { return pool.allocate(); }, [&](void *p) { pool.deallocate(p); });
+}
+
+// The same pool behind the virtual std::pmr interface.
+inline void BM_PoolResource(benchmark::State &state) {
+  pool_resource res{BENCH_OBJECT};
+  res.pool().reserve(static_cast<std::size_t>(state.range(0)));
+  std::pmr::memory_resource &mr = res;
+  run_churn(
+      state, [&] { return mr.allocate(BENCH_OBJECT, alignof(std::max_align_t)); },
+      [&](void *p) { mr.deallocate(p, BENCH_OBJECT, alignof(std::max_align_t)); });
+}
+
+// Multi-threaded: every thread churns through its own thread_cache over one shared pool,
+// against malloc's own per-thread caching on the same pattern.
+inline void BM_PoolThreadCache(benchmark::State &state) {
+  static shared_pool shared{BENCH_OBJECT}; // every thread cache returns its slots on exit
+  thread_cache cache{shared};
+  run_churn(state, [&] { return cache.allocate(); }, [&](void *p) { cache.deallocate(p); });
+}
+
+inline void BM_PoolMallocThreads(benchmark::State &state) { BM_PoolMalloc(state); }
+
+inline void test() {
+  test_fixed_pool();
+  test_object_pool();
+  test_thread_cache();
+  test_pool_resource();
+  BENCHMARK(BM_PoolMalloc)->Arg(1'000)->Arg(100'000);
+  BENCHMARK(BM_PoolPmrUnsynchronized)->Arg(1'000)->Arg(100'000);
+  BENCHMARK(BM_PoolFixed)->Arg(1'000)->Arg(100'000);
+  BENCHMARK(BM_PoolResource)->Arg(1'000)->Arg(100'000);
+  const int hw = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+  BENCHMARK(BM_PoolThreadCache)->Arg(1'000)->Threads(1)->Threads(hw);
+  BENCHMARK(BM_PoolMallocThreads)->Arg(1'000)->Threads(1)->Threads(hw);
+}
+
+} // namespace object_pool
@@ -0,0 +1,358 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  order_book.hpp — L3 (order-by-order) limit order book with a flat price-level layout
+// =====================================================================================
+//
+// The book is what the queues in this module actually feed: a market-data handler decodes
+// add / modify / cancel / execute messages and the book keeps every resting order, in time
+// priority, per price level. Everything on the update path is O(1) and touches as few cache
+// lines as possible:
+//
+//  - PRICE LEVELS are two flat arrays (bids, asks) indexed by tick offset from `min_price`.
+//    Finding the level of a price is a subtraction, not a tree or hash walk, and neighbouring
+//    prices sit in neighbouring cache lines (a `level` is 16 bytes, four per line).
+//  - ORDERS live in a preallocated pool and are chained into their level's FIFO by 32-bit
+//    pool indices (an intrusive doubly linked list), so an add or a cancel is a few index
+//    writes and never allocates. Free slots are chained through the same `next` field.
+//  - ORDER-ID LOOKUP is a direct-mapped table id -> pool index. Exchange order references
+//    are dense and increasing, so a flat table sized to the id range beats any hash map.
+//
+// Best bid / best ask are cached level indices. Adding can only improve them; when the best
+// level empties, the book scans the flat array to the next non-empty level, which is short
+// and sequential in a live book.
+//
+// Prices are integer ticks; the book does not match (it mirrors the exchange's book from its
+// L3 feed, where executions arrive as explicit messages). Errors are reported as a `status`,
+// never thrown: a bad message on a feed must not unwind the handler.
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace order_book {
+
+using price_t = std::int64_t; // in ticks
+using qty_t = std::int64_t;
+using order_id = std::uint64_t;
+
+enum class side : std::uint8_t { bid, ask };
+
+enum class status : std::uint8_t {
+  ok,
+  unknown_order,      // modify/cancel/execute of an id that is not resting
+  duplicate_order,    // add of an id that is already resting
+  id_out_of_range,    // id >= max_order_id
+  price_out_of_range, // price outside [min_price, min_price + num_levels)
+  bad_quantity,       // qty <= 0, or an execution larger than the order
+  book_full,          // the order pool is exhausted
+};
+
+inline const char *to_string(status s) noexcept {
+  switch (s) {
+  case status::ok:
+    return "ok";
+  case status::unknown_order:
+    return "unknown_order";
+  case status::duplicate_order:
+    return "duplicate_order";
+  case status::id_out_of_range:
+    return "id_out_of_range";
+  case status::price_out_of_range:
+    return "price_out_of_range";
+  case status::bad_quantity:
+    return "bad_quantity";
+  case status::book_full:
+    return "book_full";
+  }
+  return "?";
+}
+
+// "no order" / end of list, for 32-bit pool indices.
+constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+
+struct order {
+  order_id id;
+  price_t price;
+  qty_t qty;
+  std::uint32_t prev; // FIFO neighbours in the level (pool indices)
+  std::uint32_t next; // also chains the free list
+  side s;
+};
+
+// 16 bytes: four levels per cache line.
+struct level {
+  qty_t qty{0};            // total resting quantity
+  std::uint32_t head{NIL}; // oldest order (first to trade)
+  std::uint32_t tail{NIL}; // newest order
+};
+static_assert(sizeof(level) == 16);
+
+struct book_config {
+  price_t min_price = 0;              // lowest representable price, in ticks
+  std::size_t num_levels = 1 << 16;   // price range per side
+  std::size_t max_orders = 1 << 20;   // resting orders at once (pool size)
+  std::size_t max_order_id = 1 << 24; // order ids must be < this
+};
+
+class book {
+public:
+  explicit book(const book_config &cfg)
+      : min_price_{cfg.min_price}, bids_(cfg.num_levels), asks_(cfg.num_levels),
+        pool_(cfg.max_orders), slot_of_(cfg.max_order_id, NIL), best_ask_{cfg.num_levels} {
+    assert(cfg.max_orders < NIL && "pool indices are 32-bit");
+    // Chain every pool slot into the free list.
+    for (std::size_t i = 0; i < pool_.size(); ++i) {
+      pool_[i].next = i + 1 < pool_.size() ? static_cast<std::uint32_t>(i + 1) : NIL;
+    }
+    free_ = pool_.empty() ? NIL : 0;
+  }
+
+  status add(order_id id, side s, price_t price, qty_t qty) {
+    if (id >= slot_of_.size()) {
+      return status::id_out_of_range;
+    }
+    if (slot_of_[id] != NIL) {
+      return status::duplicate_order;
+    }
+    const auto li = level_index(price);
+    if (!li) {
+      return status::price_out_of_range;
+    }
+    if (qty <= 0) {
+      return status::bad_quantity;
+    }
+    if (free_ == NIL) {
+      return status::book_full;
+    }
+    const std::uint32_t slot = free_;
+    free_ = pool_[slot].next;
+    pool_[slot] = order{id, price, qty, NIL, NIL, s};
+    slot_of_[id] = slot;
+    link_tail(s, *li, slot);
+    ++size_;
+    return status::ok;
+  }
+
+  /**
+   * Change an order's price and/or quantity. A pure size reduction keeps time priority (as
+   * on most venues); a price change or a size increase loses it - the order moves to the
+   * tail of its (new) level.
+   */
+  status modify(order_id id, price_t new_price, qty_t new_qty) {
+    const std::uint32_t slot = lookup(id);
+    if (slot == NIL) {
+      return status::unknown_order;
+    }
+    if (new_qty <= 0) {
+      return status::bad_quantity;
+    }
+    order &o = pool_[slot];
+    if (new_price == o.price && new_qty <= o.qty) {
+      levels(o.s)[*level_index(o.price)].qty -= o.qty - new_qty;
+      o.qty = new_qty;
+      return status::ok;
+    }
+    const auto li = level_index(new_price);
+    if (!li) {
+      return status::price_out_of_range;
+    }
+    unlink(slot);
+    o.price = new_price;
+    o.qty = new_qty;
+    link_tail(o.s, *li, slot);
+    return status::ok;
+  }
+
+  status cancel(order_id id) {
+    const std::uint32_t slot = lookup(id);
+    if (slot == NIL) {
+      return status::unknown_order;
+    }
+    remove(slot);
+    return status::ok;
+  }
+
+  // Trade `qty` against a resting order; the order leaves the book when fully filled.
+  status execute(order_id id, qty_t qty) {
+    const std::uint32_t slot = lookup(id);
+    if (slot == NIL) {
+      return status::unknown_order;
+    }
+    order &o = pool_[slot];
+    if (qty <= 0 || qty > o.qty) {
+      return status::bad_quantity;
+    }
+    if (qty == o.qty) {
+      remove(slot);
+    } else {
+      o.qty -= qty;
+      levels(o.s)[*level_index(o.price)].qty -= qty;
+    }
+    return status::ok;
+  }
+
+  std::optional<price_t> best_bid() const noexcept {
+    return best_bid_ == NONE ? std::nullopt : std::optional<price_t>{price_of(best_bid_)};
+  }
+  std::optional<price_t> best_ask() const noexcept {
+    return best_ask_ == asks_.size() ? std::nullopt : std::optional<price_t>{price_of(best_ask_)};
+  }
+
+  // Total resting quantity at a price (0 when empty or out of range).
+  qty_t depth(side s, price_t price) const noexcept {
+    const auto li = level_index(price);
+    return li ? levels(s)[*li].qty : 0;
+  }
+
+  // Number of orders queued at a price (walks the level's FIFO; for tests and tools).
+  std::size_t orders_at(side s, price_t price) const noexcept {
+    const auto li = level_index(price);
+    std::size_t n = 0;
+    for (std::uint32_t i = li ? levels(s)[*li].head : NIL; i != NIL; i = pool_[i].next) {
+      ++n;
+    }
+    return n;
+  }
+
+  // The resting order with this id, or nullptr.
+  const order *find(order_id id) const noexcept {
+    const std::uint32_t slot = lookup(id);
+    return slot == NIL ? nullptr : &pool_[slot];
+  }
+
+  // Id of the order first in line at a price, if any.
+  std::optional<order_id> front(side s, price_t price) const noexcept {
+    const auto li = level_index(price);
+    const std::uint32_t head = li ? levels(s)[*li].head : NIL;
+    return head == NIL ? std::nullopt : std::optional<order_id>{pool_[head].id};
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+private:
+  static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+  std::optional<std::size_t> level_index(price_t price) const noexcept {
+    const price_t off = price - min_price_;
+    if (off < 0 || static_cast<std::size_t>(off) >= bids_.size()) {
+      return std::nullopt;
+    }
+    return static_cast<std::size_t>(off);
+  }
+  price_t price_of(std::size_t li) const noexcept { return min_price_ + static_cast<price_t>(li); }
+
+  std::vector<level> &levels(side s) noexcept { return s == side::bid ? bids_ : asks_; }
+  const std::vector<level> &levels(side s) const noexcept {
+    return s == side::bid ? bids_ : asks_;
+  }
+
+  std::uint32_t lookup(order_id id) const noexcept {
+    return id < slot_of_.size() ? slot_of_[id] : NIL;
+  }
+
+  void link_tail(side s, std::size_t li, std::uint32_t slot) {
+    level &l = levels(s)[li];
+    order &o = pool_[slot];
+    o.prev = l.tail;
+    o.next = NIL;
+    if (l.tail != NIL) {
+      pool_[l.tail].next = slot;
+    } else {
+      l.head = slot;
+    }
+    l.tail = slot;
+    l.qty += o.qty;
+    // A new order can only improve the best price.
+    if (s == side::bid) {
+      if (best_bid_ == NONE || li > best_bid_) {
+        best_bid_ = li;
+      }
+    } else if (li < best_ask_) {
+      best_ask_ = li;
+    }
+  }
+
+  void unlink(std::uint32_t slot) {
+    order &o = pool_[slot];
+    const std::size_t li = *level_index(o.price);
+    level &l = levels(o.s)[li];
+    (o.prev != NIL ? pool_[o.prev].next : l.head) = o.next;
+    (o.next != NIL ? pool_[o.next].prev : l.tail) = o.prev;
+    l.qty -= o.qty;
+    if (l.head == NIL) {
+      level_emptied(o.s, li);
+    }
+  }
+
+  void remove(std::uint32_t slot) {
+    unlink(slot);
+    slot_of_[pool_[slot].id] = NIL;
+    pool_[slot].next = free_;
+    free_ = slot;
+    --size_;
+  }
+
+  // Move the cached best past a level that just became empty.
+  void level_emptied(side s, std::size_t li) noexcept {
+    if (s == side::bid) {
+      if (li == best_bid_) {
+        while (best_bid_ != NONE && bids_[best_bid_].head == NIL) {
+          best_bid_ = best_bid_ == 0 ? NONE : best_bid_ - 1;
+        }
+      }
+    } else if (li == best_ask_) {
+      while (best_ask_ < asks_.size() && asks_[best_ask_].head == NIL) {
+        ++best_ask_;
+      }
+    }
+  }
+
+  price_t min_price_;
+  std::vector<level> bids_;
+  std::vector<level> asks_;
+  std::vector<order> pool_;
+  std::vector<std::uint32_t> slot_of_; // order id -> pool index, NIL when not resting
+  std::uint32_t free_{NIL};            // head of the free-slot list
+  std::size_t size_{0};
+  std::size_t best_bid_{NONE}; // level index, NONE = no bids
+  std::size_t best_ask_;       // level index, asks_.size() = no asks
+};
+
+/**
+ * One L3 feed message as it travels through the queue in the replay benchmark. Trivially
+ * copyable, 32 bytes. `price` is ignored by cancel/execute; `qty` is the new size for modify
+ * and the traded size for execute.
+ */
+enum class msg_type : std::uint8_t { add, modify, cancel, execute };
+
+struct book_msg {
+  order_id id;
+  price_t price;
+  qty_t qty;
+  msg_type type;
+  side s;
+};
+
+inline status apply(book &b, const book_msg &m) {
+  switch (m.type) {
+  case msg_type::add:
+    return b.add(m.id, m.s, m.price, m.qty);
+  case msg_type::modify:
+    return b.modify(m.id, m.price, m.qty);
+  case msg_type::cancel:
+    return b.cancel(m.id);
+  case msg_type::execute:
+    return b.execute(m.id, m.qty);
+  }
+  return status::unknown_order;
+}
+
+} // namespace order_book
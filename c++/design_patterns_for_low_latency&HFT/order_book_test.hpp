@@ -0,0 +1,296 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for order_book.hpp: time priority and best-price bookkeeping on a hand
+// written scenario, a randomized replay checked against the generator's own view of the book,
+// and the replay cost per message - applied directly, and fed through an SPSC queue the way a
+// market-data thread would feed a strategy thread.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "order_book.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <print>
+#include <random>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace order_book {
+
+inline void test_priority_and_best() {
+  std::println("--- test_order_book_priority ---");
+  book b{{.min_price = 1000, .num_levels = 256, .max_orders = 16, .max_order_id = 64}};
+  assert(!b.best_bid() && !b.best_ask());
+
+  [[maybe_unused]] status st = b.add(1, side::bid, 1100, 10);
+  assert(st == status::ok);
+  st = b.add(2, side::bid, 1100, 20);
+  assert(st == status::ok);
+  st = b.add(3, side::bid, 1099, 5);
+  assert(st == status::ok);
+  st = b.add(4, side::ask, 1102, 7);
+  assert(st == status::ok);
+  st = b.add(5, side::ask, 1101, 3);
+  assert(st == status::ok);
+  assert(*b.best_bid() == 1100 && *b.best_ask() == 1101);
+  assert(b.depth(side::bid, 1100) == 30 && b.orders_at(side::bid, 1100) == 2);
+  assert(*b.front(side::bid, 1100) == 1);
+
+  // Size reduction keeps priority, size increase loses it.
+  st = b.modify(1, 1100, 8);
+  assert(st == status::ok);
+  assert(*b.front(side::bid, 1100) == 1 && b.depth(side::bid, 1100) == 28);
+  st = b.modify(1, 1100, 9);
+  assert(st == status::ok);
+  assert(*b.front(side::bid, 1100) == 2 && b.depth(side::bid, 1100) == 29);
+
+  // Partial then full execution of the front order.
+  st = b.execute(2, 5);
+  assert(st == status::ok && b.find(2)->qty == 15);
+  st = b.execute(2, 15);
+  assert(st == status::ok && !b.find(2));
+  assert(*b.front(side::bid, 1100) == 1);
+
+  // Emptying the best level moves the best to the next non-empty one.
+  st = b.cancel(1);
+  assert(st == status::ok);
+  assert(*b.best_bid() == 1099 && b.depth(side::bid, 1100) == 0);
+  st = b.modify(5, 1105, 3); // re-price the best ask away
+  assert(st == status::ok);
+  assert(*b.best_ask() == 1102);
+  st = b.cancel(3);
+  assert(st == status::ok && !b.best_bid());
+
+  // Errors leave the book untouched.
+  st = b.add(4, side::bid, 1050, 1);
+  assert(st == status::duplicate_order);
+  st = b.add(64, side::bid, 1050, 1);
+  assert(st == status::id_out_of_range);
+  st = b.add(6, side::bid, 999, 1);
+  assert(st == status::price_out_of_range);
+  st = b.add(6, side::bid, 1050, 0);
+  assert(st == status::bad_quantity);
+  st = b.cancel(42);
+  assert(st == status::unknown_order);
+  st = b.execute(4, 8);
+  assert(st == status::bad_quantity);
+  assert(b.size() == 2);
+
+  // The pool is reused after cancels and reports exhaustion.
+  for (order_id id = 10; id < 24; ++id) {
+    st = b.add(id, side::bid, 1000, 1);
+    assert(st == status::ok);
+  }
+  st = b.add(24, side::bid, 1000, 1);
+  assert(st == status::book_full);
+  std::println("test_order_book_priority PASSED");
+}
+
+// A synthetic L3 feed: orders rest a few ticks around a fixed mid (bids below, asks above, so
+// the book never crosses) and are modified, cancelled or executed at roughly the mix of a
+// real equity feed. `live` is the generator's own record of what must still rest at the end.
+struct feed {
+  struct resting {
+    order_id id;
+    side s;
+    price_t price;
+    qty_t qty;
+  };
+  std::vector<book_msg> msgs;
+  std::vector<resting> live;
+  order_id next_id = 1;
+};
+
+inline constexpr price_t FEED_MID = 1 << 15;
+
+inline feed make_feed(std::size_t n, std::uint64_t seed = 42) {
+  feed f;
+  f.msgs.reserve(n);
+  std::mt19937_64 rng{seed};
+  std::geometric_distribution<int> ticks_away{0.15};
+  std::uniform_int_distribution<int> percent{0, 99};
+  std::uniform_int_distribution<qty_t> size{1, 500};
+  auto price_for = [&](side s) {
+    const price_t away = 1 + std::min(ticks_away(rng), 2000);
+    return s == side::bid ? FEED_MID - away : FEED_MID + away;
+  };
+
+  while (f.msgs.size() < n) {
+    const int roll = f.live.size() < 1000 ? 0 : percent(rng);
+    if (roll < 45) {
+      const side s = (rng() & 1) ? side::bid : side::ask;
+      const feed::resting r{f.next_id++, s, price_for(s), size(rng)};
+      f.live.push_back(r);
+      f.msgs.push_back({r.id, r.price, r.qty, msg_type::add, r.s});
+      continue;
+    }
+    const std::size_t pick = rng() % f.live.size();
+    auto &r = f.live[pick];
+    if (roll < 80) {
+      f.msgs.push_back({r.id, 0, 0, msg_type::cancel, r.s});
+    } else if (roll < 90) {
+      if (rng() & 1) {
+        r.qty = std::max<qty_t>(1, r.qty / 2); // shrink in place
+      } else {
+        r.price = price_for(r.s); // re-price to the back of another level
+      }
+      f.msgs.push_back({r.id, r.price, r.qty, msg_type::modify, r.s});
+      continue;
+    } else {
+      const qty_t traded = (rng() & 1) ? r.qty : std::max<qty_t>(1, r.qty / 3);
+      f.msgs.push_back({r.id, 0, traded, msg_type::execute, r.s});
+      if (traded < r.qty) {
+        r.qty -= traded;
+        continue;
+      }
+    }
+    r = f.live.back(); // cancelled or fully executed: drop from the live set
+    f.live.pop_back();
+  }
+  return f;
+}
+
+inline book_config feed_config(const feed &f) {
+  return {.min_price = 0,
+          .num_levels = std::size_t{1} << 16,
+          .max_orders = std::size_t{1} << 16,
+          .max_order_id = static_cast<std::size_t>(f.next_id)};
+}
+
+inline void test_replay_matches_feed() {
+  std::println("--- test_order_book_replay ---");
+  const feed f = make_feed(500'000);
+  auto b = std::make_unique<book>(feed_config(f));
+  for (const auto &m : f.msgs) {
+    [[maybe_unused]] const status st = apply(*b, m);
+    assert(st == status::ok && "the generator only emits valid messages");
+  }
+
+  assert(b->size() == f.live.size());
+  std::map<std::pair<side, price_t>, qty_t> expected_depth;
+  std::optional<price_t> expected_bid;
+  std::optional<price_t> expected_ask;
+  for (const auto &r : f.live) {
+    [[maybe_unused]] const order *o = b->find(r.id);
+    assert(o && o->qty == r.qty && o->price == r.price && o->s == r.s);
+    expected_depth[{r.s, r.price}] += r.qty;
+    if (r.s == side::bid) {
+      expected_bid = std::max(expected_bid.value_or(r.price), r.price);
+    } else {
+      expected_ask = std::min(expected_ask.value_or(r.price), r.price);
+    }
+  }
+  for ([[maybe_unused]] const auto &[key, qty] : expected_depth) {
+    assert(b->depth(key.first, key.second) == qty);
+  }
+  assert(b->best_bid() == expected_bid && b->best_ask() == expected_ask);
+  std::println("test_order_book_replay PASSED ({} messages, {} orders resting, {} levels)",
+               f.msgs.size(), f.live.size(), expected_depth.size());
+}
+
+// Shared feeds, built once per message count: generating them is not what we measure.
+inline const feed &cached_feed(std::size_t n) {
+  static std::map<std::size_t, feed> feeds;
+  auto it = feeds.find(n);
+  if (it == feeds.end()) {
+    it = feeds.emplace(n, make_feed(n)).first;
+  }
+  return it->second;
+}
+
+// Book cost alone: apply a pre-built feed straight from memory.
+// Args: range(0) = messages per iteration.
+inline void BM_BookApply(benchmark::State &state) {
+  const feed &f = cached_feed(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto b = std::make_unique<book>(feed_config(f)); // fresh book, outside the timed region
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const auto &m : f.msgs) {
+      benchmark::DoNotOptimize(apply(*b, m));
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    state.SetIterationTime(std::chrono::duration<double>(t1 - t0).count());
+  }
+  state.counters["ns_per_msg"] = benchmark::Counter(
+      static_cast<double>(f.msgs.size()),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// The replay as deployed: a feed thread pushes every message through the 1 MiB SPSC ring and
+// this thread pops it with the zero-copy view and applies it to the book. The time is the
+// consumer's, from the first message to the last, so it includes the queue hop.
+// Args: range(0) = messages per iteration.
+inline void BM_BookReplaySpsc(benchmark::State &state) {
+  using large_queue = fast_queue_spsc::fast_queue_t<fast_queue_spsc::LARGE_QUEUE_SIZE>;
+  const feed &f = cached_feed(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto b = std::make_unique<book>(feed_config(f));
+    auto fq = std::make_unique<large_queue>();
+    fast_queue_spsc::producer prod;
+    fast_queue_spsc::consumer cons;
+    std::atomic<bool> go{false};
+
+    std::thread feed_thread([&] {
+      while (!go.load(std::memory_order_acquire)) {
+        fast_queue_spsc::spin_pause();
+      }
+      for (const auto &m : f.msgs) {
+        const std::span<const std::byte> bytes{reinterpret_cast<const std::byte *>(&m),
+                                               sizeof(m)};
+        while (!prod.try_write(*fq, bytes)) {
+          fast_queue_spsc::spin_pause();
+        }
+      }
+    });
+
+    go.store(true, std::memory_order_release);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t applied = 0; applied < f.msgs.size();) {
+      auto view = cons.try_read_view(*fq);
+      if (!view) {
+        fast_queue_spsc::spin_pause();
+        continue;
+      }
+      book_msg m; // 32 bytes: copying out also handles a record that wraps the ring
+      std::memcpy(&m, view->first.data(), view->first.size());
+      if (view->wrapped()) {
+        std::memcpy(reinterpret_cast<std::byte *>(&m) + view->first.size(), view->second.data(),
+                    view->second.size());
+      }
+      cons.commit_read(*fq);
+      benchmark::DoNotOptimize(apply(*b, m));
+      ++applied;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    feed_thread.join();
+    state.SetIterationTime(std::chrono::duration<double>(t1 - t0).count());
+  }
+  state.counters["ns_per_msg"] = benchmark::Counter(
+      static_cast<double>(f.msgs.size()),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+inline void test() {
+  test_priority_and_best();
+  test_replay_matches_feed();
+  BENCHMARK(BM_BookApply)->UseManualTime()->Arg(1'000'000);
+  BENCHMARK(BM_BookReplaySpsc)->UseManualTime()->Arg(1'000'000);
+}
+
+} // namespace order_book
@@ -0,0 +1,39 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  percentile.hpp — one definition of p50 / p99 / p99.9 for every benchmark
+// =====================================================================================
+//
+// Each latency benchmark sorts its samples and reports tail percentiles. They must all mean
+// the same thing, or a p99 in one report cannot be held against a p99 in another. This is
+// the NEAREST-RANK percentile: the smallest sample such that at least q of the samples are
+// less than or equal to it. That is the sample at 1-based rank ceil(q * n), so for n = 1000
+// p99 is the 990th smallest and p100 is the maximum. Every value it returns is a real
+// sample, never an interpolation between two.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace percentile {
+
+/**
+ * Nearest-rank percentile `q` in [0, 1] of an already sorted sample set; T{} for an empty
+ * one. q * n is taken a hair low before the ceil, so a q like 0.99 that is not exact in binary
+ * does not round a whole rank up.
+ */
+template <class T> T nearest_rank(const std::vector<T> &sorted, double q) {
+  if (sorted.empty()) {
+    return T{};
+  }
+  const double rank = std::ceil(q * static_cast<double>(sorted.size()) - 1e-9);
+  const auto idx = static_cast<std::size_t>(std::max(rank, 1.0)) - 1;
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+} // namespace percentile
@@ -0,0 +1,41 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  posix_io.hpp — write(2) until done
+// =====================================================================================
+//
+// write(2) may write less than asked, or be interrupted by a signal before writing anything.
+// The flight recorder's dump and the async logger's flush both need the whole buffer out, and
+// the dump runs inside a signal handler, so this is only write(2) and errno: no allocation,
+// no locks, async-signal-safe.
+//
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+
+#include <unistd.h>
+
+namespace posix_io {
+
+// Writes all `n` bytes at `data` to `fd`, retrying short writes and EINTR. False on any
+// other error, with errno set by write(2).
+inline bool write_all(int fd, const void *data, std::size_t n) noexcept {
+  const auto *p = static_cast<const char *>(data);
+  while (n > 0) {
+    const ssize_t w = ::write(fd, p, n);
+    if (w < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += w;
+    n -= static_cast<std::size_t>(w);
+  }
+  return true;
+}
+
+} // namespace posix_io
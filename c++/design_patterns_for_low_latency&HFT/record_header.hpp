@@ -0,0 +1,199 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  record_header.hpp — how a fast_queue_t record is framed
+// =====================================================================================
+//
+// A record in the SPSC ring has always been [int32 length][payload]. For an 8-byte message
+// that is 4 bytes of framing on 8 of data - a third of the ring's bandwidth spent on
+// headers - and it has no room for a message type or a checksum. The framing is therefore
+// a policy, the third template parameter of fast_queue_t:
+//
+//  - int32_length     [int32 length][payload]. The default, and the historical format.
+//  - varint_length    [1, 2 or 4 byte length][payload]. A PREFIX varint: the low bits of the
+//                     first byte give the header's size (x0 = 1 byte, 01 = 2, 11 = 4), so
+//                     the reader knows it after one byte, with no loop over continuation
+//                     bits. Payloads up to 127 bytes cost one byte of framing.
+//  - length16_type16  [uint16 length][uint16 type][payload]. The same 4 bytes as int32_length
+//                     but they carry a message type, for a consumer that dispatches on it
+//                     without looking into the payload. Payloads up to 65535 bytes.
+//  - fixed<N>         [payload]: no header at all. Every record is exactly N bytes, so
+//                     there is nothing to encode. The queue of one message type.
+//  - crc32c<H>        H, followed by a 4-byte CRC32C trailer of the payload. For a ring in
+//                     shared memory, where a misbehaving process can scribble over the bytes.
+//                     The consumer checks it, then skips and counts a record that fails. The
+//                     length is still trusted, so the stream stays in step.
+//
+// A policy encodes into a small local buffer and decodes from one; the queue copies those
+// bytes in and out of the ring like the payload (so a header can straddle the ring's end).
+// encode() takes the header size to write: the zero-copy producer fixes it at try_reserve,
+// for the reserved length, and a varint of a shorter committed length is then written in the
+// longer form, which decodes the same.
+//
+// crc32c_update() uses the SSE4.2 crc32 instruction, 8 bytes at a time, when the target has it
+// (-msse4.2, or -mavx2 / the ENABLE_AVX2 CMake option) and a byte-wise table otherwise.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace record_header {
+
+// [int32 length][payload]
+struct int32_length {
+  static constexpr std::size_t max_bytes = 4;
+  static constexpr bool variable = false;
+  static constexpr bool checksum = false;
+  static constexpr std::size_t max_payload = std::numeric_limits<std::int32_t>::max();
+
+  static constexpr std::size_t bytes(std::size_t) noexcept { return 4; }
+  static void encode(std::byte *out, std::size_t, std::size_t payload, std::uint16_t) noexcept {
+    const auto len = static_cast<std::int32_t>(payload);
+    std::memcpy(out, &len, sizeof(len));
+  }
+  static std::size_t decode(const std::byte *in, std::size_t, std::uint16_t &type) noexcept {
+    std::int32_t len{};
+    std::memcpy(&len, in, sizeof(len));
+    type = 0;
+    return static_cast<std::size_t>(len);
+  }
+};
+
+// [1, 2 or 4 byte little-endian length << tag bits][payload]
+struct varint_length {
+  static constexpr std::size_t max_bytes = 4;
+  static constexpr bool variable = true;
+  static constexpr bool checksum = false;
+  static constexpr std::size_t max_payload = (std::size_t{1} << 30) - 1;
+
+  static constexpr std::size_t bytes(std::size_t payload) noexcept {
+    return payload < (1u << 7) ? 1 : payload < (1u << 14) ? 2 : 4;
+  }
+  // Size of the header that starts with `first`.
+  static constexpr std::size_t bytes_from_first(std::byte first) noexcept {
+    const auto b = std::to_integer<unsigned>(first);
+    return (b & 1u) == 0 ? 1 : (b & 2u) == 0 ? 2 : 4;
+  }
+  static void encode(std::byte *out, std::size_t n, std::size_t payload, std::uint16_t) noexcept {
+    const auto len = static_cast<std::uint32_t>(payload);
+    const std::uint32_t v = n == 1 ? len << 1 : n == 2 ? (len << 2) | 1u : (len << 2) | 3u;
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = static_cast<std::byte>(v >> (8 * i));
+    }
+  }
+  static std::size_t decode(const std::byte *in, std::size_t n, std::uint16_t &type) noexcept {
+    std::uint32_t v = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      v |= std::to_integer<std::uint32_t>(in[i]) << (8 * i);
+    }
+    type = 0;
+    return n == 1 ? v >> 1 : v >> 2;
+  }
+};
+
+// [uint16 length][uint16 type][payload]
+struct length16_type16 {
+  static constexpr std::size_t max_bytes = 4;
+  static constexpr bool variable = false;
+  static constexpr bool checksum = false;
+  static constexpr std::size_t max_payload = std::numeric_limits<std::uint16_t>::max();
+
+  static constexpr std::size_t bytes(std::size_t) noexcept { return 4; }
+  static void encode(std::byte *out, std::size_t, std::size_t payload,
+                     std::uint16_t type) noexcept {
+    const std::array<std::uint16_t, 2> h{static_cast<std::uint16_t>(payload), type};
+    std::memcpy(out, h.data(), sizeof(h));
+  }
+  static std::size_t decode(const std::byte *in, std::size_t, std::uint16_t &type) noexcept {
+    std::array<std::uint16_t, 2> h{};
+    std::memcpy(h.data(), in, sizeof(h));
+    type = h[1];
+    return h[0];
+  }
+};
+
+// [payload], every payload exactly N bytes
+template <std::size_t N> struct fixed {
+  static_assert(N > 0, "a fixed-size record needs a payload");
+  static constexpr std::size_t max_bytes = 0;
+  static constexpr bool variable = false;
+  static constexpr bool checksum = false;
+  static constexpr std::size_t max_payload = N;
+
+  static constexpr std::size_t bytes(std::size_t) noexcept { return 0; }
+  static void encode(std::byte *, std::size_t, std::size_t, std::uint16_t) noexcept {}
+  static std::size_t decode(const std::byte *, std::size_t, std::uint16_t &type) noexcept {
+    type = 0;
+    return N;
+  }
+};
+
+// H's framing plus a CRC32C of the payload after it.
+template <class H> struct crc32c : H {
+  static_assert(!H::checksum, "one checksum is enough");
+  static constexpr bool checksum = true;
+};
+
+// Bytes after the payload: the CRC32C, when H has one.
+template <class H>
+inline constexpr std::size_t trailer_bytes = H::checksum ? sizeof(std::uint32_t) : 0;
+
+// True when a payload of `n` bytes can be framed by H (fixed<N> takes exactly N).
+template <class H> constexpr bool fits(std::size_t n) noexcept {
+  if constexpr (H::max_bytes == 0) {
+    return n == H::max_payload;
+  } else {
+    return n <= H::max_payload;
+  }
+}
+
+namespace detail {
+// Byte-wise table for the Castagnoli polynomial (reflected 0x82F63B78).
+constexpr std::array<std::uint32_t, 256> crc32c_table() {
+  std::array<std::uint32_t, 256> t{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t c = i;
+    for (int k = 0; k < 8; ++k) {
+      c = (c & 1u) != 0 ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+    }
+    t[i] = c;
+  }
+  return t;
+}
+inline constexpr auto CRC32C_TABLE = crc32c_table();
+} // namespace detail
+
+/**
+ * CRC32C of [p, p + n), continuing from `crc` (0 to start): update(update(0, a), b) is the CRC
+ * of a followed by b, which is how a payload split by the ring's end is checked.
+ */
+inline std::uint32_t crc32c_update(std::uint32_t crc, const std::byte *p, std::size_t n) noexcept {
+  crc = ~crc;
+#if defined(__SSE4_2__)
+  for (; n >= 8; n -= 8, p += 8) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc = static_cast<std::uint32_t>(_mm_crc32_u64(crc, v));
+  }
+  for (; n != 0; --n, ++p) {
+    crc = _mm_crc32_u8(crc, std::to_integer<std::uint8_t>(*p));
+  }
+#else
+  for (; n != 0; --n, ++p) {
+    crc = detail::CRC32C_TABLE[(crc ^ std::to_integer<std::uint32_t>(*p)) & 0xFFu] ^ (crc >> 8);
+  }
+#endif
+  return ~crc;
+}
+
+} // namespace record_header
@@ -0,0 +1,238 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  replay.hpp — feeding a recorded journal back through the live consumers
+// =====================================================================================
+//
+// journal.hpp writes every message of a feed to disk exactly as it sat in the ring. A
+// backtest wants those messages back through the SAME consumer code, as fast as memory allows
+// and in exactly the recorded order. replay gives the journal the shape of a queue:
+//
+//  - `source` is the "queue": it maps every file of a journal read-only and is never written.
+//  - `consumer` has the try_read_view / commit_read pair of fast_queue_spsc::consumer and
+//    returns the same fast_queue_spsc::read_view, pointing straight into the mapping. Code
+//    written against (consumer, queue) - a template over both, or stages taking a read_view
+//    such as strategy_pipeline::itch_decoder - runs against (replay::consumer, replay::source)
+//    unchanged. Records never straddle a chunk, so `second` is always empty.
+//
+// The files are read through the page cache, not copied. Each mapping is madvise'd
+// MADV_SEQUENTIAL: page faults then trigger the kernel's readahead in growing steps ahead of
+// the cursor, and pages behind it are reclaimed first, so a journal larger than memory streams
+// through without pushing the rest of the process out. A journal already in the page cache
+// replays at memory speed. Explicit MADV_WILLNEED - for a window ahead of the cursor as it
+// moves, or just for the head of each file - was measured SLOWER, cached and from disk alike:
+// it costs a page-cache walk per call and restarts the readahead state the faults have built.
+//
+// The consumer checks the format as it goes: a chunk with the wrong magic or running past its
+// file stops the replay with status::bad_chunk; a chunk whose first_seq is not the next
+// message number (a lost chunk or file) stops it with status::sequence_gap, which the caller
+// can accept_gap() to continue past. try_read_view returning nullopt means "nothing more" -
+// state() says whether that is the end of the journal or one of those.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "journal.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace replay {
+
+enum class status : std::uint8_t { ok, end, bad_chunk, sequence_gap };
+
+inline const char *to_string(status s) noexcept {
+  switch (s) {
+  case status::ok:
+    return "ok";
+  case status::end:
+    return "end";
+  case status::bad_chunk:
+    return "bad_chunk";
+  case status::sequence_gap:
+    return "sequence_gap";
+  }
+  return "?";
+}
+
+/**
+ * Every file of the journal <directory>/<prefix>.<index>.fqj, mapped read-only from index 0 up
+ * to the first index that does not exist. Immutable once built: any number of consumers can
+ * replay it, each from its own position.
+ */
+class source {
+public:
+  source(const std::filesystem::path &directory, const std::string &prefix = "journal") {
+    for (std::uint32_t index = 0;; ++index) {
+      const auto path = journal::file_path(directory, prefix, index);
+      const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        break;
+      }
+      struct stat st{};
+      mapped_file f{};
+      if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        f.size = static_cast<std::size_t>(st.st_size);
+        void *p = ::mmap(nullptr, f.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+          ok_ = false;
+          f.size = 0;
+        } else {
+          f.data = static_cast<const std::byte *>(p);
+          ::madvise(p, f.size, MADV_SEQUENTIAL);
+          bytes_ += f.size;
+        }
+      }
+      ::close(fd); // the mapping keeps the file
+      files_.push_back(f);
+    }
+  }
+
+  source(const source &) = delete;
+  source &operator=(const source &) = delete;
+
+  ~source() {
+    for (const mapped_file &f : files_) {
+      if (f.data != nullptr) {
+        ::munmap(const_cast<std::byte *>(f.data), f.size);
+      }
+    }
+  }
+
+  // False when a file exists but could not be mapped (it replays as empty).
+  bool ok() const noexcept { return ok_; }
+  std::size_t files() const noexcept { return files_.size(); }
+  // Total mapped bytes, chunk headers and padding included.
+  std::uint64_t bytes() const noexcept { return bytes_; }
+
+  std::span<const std::byte> file(std::size_t index) const noexcept {
+    return {files_[index].data, files_[index].size};
+  }
+
+private:
+  struct mapped_file {
+    const std::byte *data = nullptr;
+    std::size_t size = 0;
+  };
+
+  std::vector<mapped_file> files_;
+  std::uint64_t bytes_ = 0;
+  bool ok_ = true;
+};
+
+/**
+ * Reads a `source` from its first message, with the zero-copy read API of
+ * fast_queue_spsc::consumer. The views point into the mapping and stay valid as long as the
+ * source does (longer than the queue's guarantee, so consumer code written for the queue is
+ * safe here). Exactly one commit_read() must follow each successful try_read_view().
+ */
+class consumer {
+public:
+  template <class S> std::optional<fast_queue_spsc::read_view> try_read_view(S &src) {
+    assert(pending_record_ == 0 && "previous try_read_view was not committed");
+    while (at_ == chunk_end_) {
+      if (!next_chunk(src)) {
+        return std::nullopt;
+      }
+    }
+    fast_queue_spsc::header_t len{};
+    std::memcpy(&len, data_ + at_, sizeof(len));
+    const auto plen = static_cast<std::size_t>(len);
+    if (len < 0 || at_ + sizeof(len) + plen > chunk_end_) {
+      status_ = status::bad_chunk; // a record running past its chunk
+      chunk_end_ = at_;
+      return std::nullopt;
+    }
+    pending_record_ = sizeof(len) + plen;
+    return fast_queue_spsc::read_view{{data_ + at_ + sizeof(len), plen}, {}};
+  }
+
+  template <class S> void commit_read(S &) {
+    assert(pending_record_ != 0 && "commit_read without a matching try_read_view");
+    at_ += pending_record_;
+    pending_record_ = 0;
+    ++next_seq_;
+  }
+
+  // After status::sequence_gap: continue from the chunk that follows the gap.
+  void accept_gap() noexcept {
+    assert(status_ == status::sequence_gap);
+    status_ = status::ok;
+    chunk_end_ = at_ + gap_bytes_;
+    next_seq_ = gap_first_seq_;
+  }
+
+  status state() const noexcept { return status_; }
+  // Journal sequence number of the next message: the count replayed so far, plus any
+  // accepted gaps.
+  std::uint64_t next_seq() const noexcept { return next_seq_; }
+
+private:
+  // Moves to the next chunk, rolling to the next file at the end of one. False at the end of
+  // the journal or on a format error (status_ says which).
+  template <class S> bool next_chunk(S &src) {
+    if (status_ != status::ok) {
+      return false;
+    }
+    std::size_t pos = journal::align_up(chunk_end_);
+    for (;;) {
+      if (file_ < src.files()) {
+        const auto f = src.file(file_);
+        if (pos + sizeof(journal::chunk_header) <= f.size()) {
+          data_ = f.data();
+          journal::chunk_header h;
+          std::memcpy(&h, data_ + pos, sizeof(h));
+          if (h.magic != journal::CHUNK_MAGIC ||
+              pos + sizeof(h) + std::size_t{h.bytes} > f.size()) {
+            status_ = status::bad_chunk;
+            at_ = chunk_end_ = pos;
+            return false;
+          }
+          at_ = pos + sizeof(h);
+          if (h.first_seq != next_seq_) {
+            status_ = status::sequence_gap;
+            gap_first_seq_ = h.first_seq;
+            gap_bytes_ = h.bytes;
+            chunk_end_ = at_;
+            return false;
+          }
+          chunk_end_ = at_ + h.bytes;
+          return true;
+        }
+      }
+      if (file_ + 1 >= src.files()) {
+        status_ = status::end;
+        return false;
+      }
+      ++file_;
+      pos = 0;
+    }
+  }
+
+  const std::byte *data_ = nullptr; // current file's mapping
+  std::size_t file_ = 0;
+  std::size_t at_ = 0;              // next record in the current chunk
+  std::size_t chunk_end_ = 0;       // end of the current chunk's records
+  std::size_t pending_record_ = 0;  // size of a peeked-but-not-committed record (0 = none)
+  std::uint64_t next_seq_ = 0;
+  std::uint64_t gap_first_seq_ = 0; // the chunk after a sequence gap
+  std::size_t gap_bytes_ = 0;
+  status status_ = status::ok;
+};
+
+} // namespace replay
@@ -0,0 +1,344 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for replay.hpp. The tests replay a rolling journal record by record,
+// check that a lost file and a damaged chunk stop the replay with the right status, and run
+// one consumer loop - written once against (consumer, queue) - over a live SPSC ring and over
+// a replayed journal of the same ITCH stream, ending in the same book and the same signals.
+// The benchmark replays a 2 GiB journal from the page cache and from disk, against reading the
+// same files with pread into a buffer.
+//
+
+#pragma once
+
+#include "fast_queue_SPMC.hpp"
+#include "fast_queue_SPSC.hpp"
+#include "journal_test.hpp"
+#include "replay.hpp"
+#include "strategy_pipeline_test.hpp"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <print>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+namespace replay {
+
+// Journals messages 0..n-1, made by `make(seq, out)` -> size, through a one-reader SPMC ring
+// whose only reader is the journal. Returns the number of files written.
+template <class Make>
+std::uint32_t record(const journal::journal_config &cfg, std::uint64_t n, Make &&make) {
+  using queue = fast_queue_spmc::spmc_queue_t<std::size_t{1} << 20, 1>;
+  auto q = std::make_unique<queue>();
+  journal::writer<queue> j{*q, 0, cfg};
+  fast_queue_spmc::producer prod;
+  std::array<std::byte, 256> msg;
+  for (std::uint64_t seq = 0; seq < n; ++seq) {
+    const std::size_t len = make(seq, std::span{msg});
+    while (!prod.try_write(*q, std::span{msg.data(), len})) {
+      std::this_thread::yield();
+    }
+  }
+  j.stop();
+  assert(j.ok() && j.messages() == n);
+  return j.files();
+}
+
+// A strategy's read loop as it is written against the live ring: drain what is there into
+// the chain. Nothing in it knows whether (cons, q) is a queue or a replayed journal.
+template <class Consumer, class Queue, class Chain>
+std::uint64_t pump(Consumer &cons, Queue &q, Chain &chain) {
+  std::uint64_t n = 0;
+  while (const auto v = cons.try_read_view(q)) {
+    chain(*v);
+    cons.commit_read(q);
+    ++n;
+  }
+  return n;
+}
+
+inline std::filesystem::path fresh_dir(const char *name) {
+  const auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+// Small chunks and small files: many chunk and file boundaries.
+inline journal::journal_config small_journal(const std::filesystem::path &dir) {
+  return {.directory = dir,
+          .buffer_size = 2 * journal::BLOCK,
+          .buffers = 3,
+          .file_size = 16 * journal::BLOCK};
+}
+
+inline void test_round_trip() {
+  std::println("--- test_replay_round_trip ---");
+  constexpr std::uint64_t N = 50'000;
+  const auto dir = fresh_dir("replay_test_round_trip");
+  const std::uint32_t files = record(small_journal(dir), N, journal::fill_message);
+  source src{dir};
+  assert(src.ok() && src.files() == files && files > 1);
+  consumer cons;
+  std::array<std::byte, 128> want;
+  for (std::uint64_t seq = 0; seq < N; ++seq) {
+    [[maybe_unused]] const auto v = cons.try_read_view(src);
+    assert(v && !v->wrapped());
+    [[maybe_unused]] const std::size_t n = journal::fill_message(seq, want);
+    assert(v->size() == n && std::memcmp(v->first.data(), want.data(), n) == 0);
+    cons.commit_read(src);
+  }
+  [[maybe_unused]] const auto past_end = cons.try_read_view(src);
+  assert(!past_end && cons.state() == status::end && cons.next_seq() == N);
+  std::filesystem::remove_all(dir);
+  std::println("test_replay_round_trip PASSED ({} messages, {} files)", N, files);
+}
+
+inline void test_detects_damage() {
+  std::println("--- test_replay_detects_damage ---");
+  constexpr std::uint64_t N = 20'000;
+  const auto dir = fresh_dir("replay_test_damage");
+  const auto cfg = small_journal(dir);
+  [[maybe_unused]] const std::uint32_t files = record(cfg, N, journal::fill_message);
+  assert(files > 3);
+  {
+    // A lost file: the replay stops at the chunk after it, and can be told to go on.
+    const auto lost = journal::file_path(dir, cfg.prefix, 1);
+    const auto kept = dir / "kept";
+    std::filesystem::rename(lost, kept);
+    std::filesystem::copy_file(journal::file_path(dir, cfg.prefix, 2), lost);
+    source src{dir};
+    consumer cons;
+    std::uint64_t got = 0;
+    while (cons.try_read_view(src)) {
+      cons.commit_read(src);
+      ++got;
+    }
+    assert(cons.state() == status::sequence_gap && got == cons.next_seq());
+    [[maybe_unused]] const std::uint64_t before = got;
+    cons.accept_gap();
+    [[maybe_unused]] const auto resumed = cons.try_read_view(src);
+    assert(resumed && cons.next_seq() > before);
+    std::filesystem::remove(lost);
+    std::filesystem::rename(kept, lost);
+  }
+  {
+    // A damaged chunk header (the first of file 1) stops the replay where it is.
+    const auto path = journal::file_path(dir, cfg.prefix, 1);
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    const std::uint32_t junk = 0xDEADBEEF;
+    [[maybe_unused]] const ssize_t w = ::pwrite(fd, &junk, sizeof(junk), 0);
+    assert(w == sizeof(junk));
+    ::close(fd);
+    source src{dir};
+    consumer cons;
+    std::uint64_t got = 0;
+    while (cons.try_read_view(src)) {
+      cons.commit_read(src);
+      ++got;
+    }
+    assert(cons.state() == status::bad_chunk && got > 0 && got < N);
+  }
+  std::filesystem::remove_all(dir);
+  std::println("test_replay_detects_damage PASSED");
+}
+
+// The same ITCH stream through the same pump: live over an SPSC ring, then journaled and
+// replayed. Both chains must end in the same state.
+inline void test_drives_pipeline() {
+  std::println("--- test_replay_drives_pipeline ---");
+  using namespace strategy_pipeline;
+  const itch_stream &s = cached_stream(50'000);
+
+  using ring = fast_queue_spsc::fast_queue_t<std::size_t{1} << 16>;
+  auto q = std::make_unique<ring>();
+  fast_queue_spsc::producer prod;
+  fast_queue_spsc::consumer live_cons;
+  auto live = make_compiled(s.config);
+  std::uint64_t live_n = 0;
+  for (const auto &m : s.msgs) {
+    while (!prod.try_write(*q, m)) {
+      live_n += pump(live_cons, *q, *live);
+    }
+  }
+  live_n += pump(live_cons, *q, *live);
+
+  const auto dir = fresh_dir("replay_test_pipeline");
+  record(small_journal(dir), s.msgs.size(), [&](std::uint64_t seq, std::span<std::byte> out) {
+    std::memcpy(out.data(), s.msgs[seq].data(), s.msgs[seq].size());
+    return s.msgs[seq].size();
+  });
+  source src{dir};
+  consumer replay_cons;
+  auto replayed = make_compiled(s.config);
+  const std::uint64_t replay_n = pump(replay_cons, src, *replayed);
+  assert(replay_cons.state() == status::end);
+
+  [[maybe_unused]] const order_book::book &a = live->stage<2>().book;
+  [[maybe_unused]] const order_book::book &b = replayed->stage<2>().book;
+  assert(live_n == s.msgs.size() && replay_n == live_n);
+  assert(replayed->stage<0>().rejected == 0 && replayed->stage<2>().errors == 0);
+  assert(a.size() == b.size() && a.best_bid() == b.best_bid() && a.best_ask() == b.best_ask());
+  assert(live->stage<3>().signals == replayed->stage<3>().signals);
+  std::filesystem::remove_all(dir);
+  std::println("test_replay_drives_pipeline PASSED ({} messages, {} signals)", replay_n,
+               replayed->stage<3>().signals);
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// A 2 GiB journal of 120-byte messages (1 MiB chunks, 1 GiB files), recorded once and removed
+// at exit. Every benchmark walks all of it, touching each message's first 8 bytes, and reports
+// the journal bytes per second. Args: range(0) = cold: the files are dropped from the page
+// cache (POSIX_FADV_DONTNEED) before each pass, so the pass reads from the device.
+
+constexpr std::uint64_t BENCH_BYTES = std::uint64_t{2} << 30;
+
+struct bench_journal {
+  std::filesystem::path dir = fresh_dir("replay_bench");
+  std::uint32_t files = 0;
+  std::uint64_t messages = 0;
+
+  bench_journal() {
+    messages = BENCH_BYTES / (journal::BENCH_PAYLOAD + sizeof(fast_queue_spmc::header_t));
+    files = record({.directory = dir}, messages, [](std::uint64_t seq, std::span<std::byte> out) {
+      std::memcpy(out.data(), &seq, sizeof(seq));
+      return journal::BENCH_PAYLOAD;
+    });
+  }
+  ~bench_journal() { std::filesystem::remove_all(dir); }
+
+  // Evicts the files' pages. macOS has no per-file eviction, so there this is a no-op and the
+  // cold pread pass reads around the cache with F_NOCACHE instead (the cold mmap pass skips).
+  void drop_cache() const {
+#if defined(__linux__)
+    for (std::uint32_t f = 0; f < files; ++f) {
+      const int fd = ::open(journal::file_path(dir, "journal", f).c_str(), O_RDONLY);
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      ::close(fd);
+    }
+#endif
+  }
+};
+
+inline const bench_journal &cached_bench_journal() {
+  static const bench_journal j;
+  return j;
+}
+
+template <class Pass> void run_replay(benchmark::State &state, Pass &&pass) {
+  const bench_journal &j = cached_bench_journal();
+  const bool cold = state.range(0) != 0;
+  std::uint64_t bytes = 0;
+  if (!cold) { // the journal was written O_DIRECT: read it into the page cache first
+    std::uint64_t sum = 0;
+    std::uint64_t n = 0;
+    pass(j, sum, n);
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (cold) {
+      j.drop_cache();
+    }
+    state.ResumeTiming();
+    std::uint64_t sum = 0;
+    std::uint64_t n = 0;
+    bytes = pass(j, sum, n);
+    benchmark::DoNotOptimize(sum);
+    assert(n == j.messages);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(bytes));
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(j.messages));
+  state.SetLabel(cold ? "cold" : "cached");
+}
+
+// The files mapped and walked in place through replay::consumer.
+inline void BM_ReplayMmap(benchmark::State &state) {
+#if !defined(__linux__)
+  if (state.range(0) != 0) {
+    state.SkipWithError("cold mmap replay needs posix_fadvise to drop the page cache (Linux)");
+    return;
+  }
+#endif
+  run_replay(state, [](const bench_journal &j, std::uint64_t &sum, std::uint64_t &n) {
+    source src{j.dir};
+    consumer cons;
+    while (const auto v = cons.try_read_view(src)) {
+      std::uint64_t seq;
+      std::memcpy(&seq, v->first.data(), sizeof(seq));
+      sum += seq;
+      cons.commit_read(src);
+      ++n;
+    }
+    return src.bytes();
+  });
+}
+
+// Baseline: each chunk pread into a 1 MiB buffer, then walked.
+inline void BM_ReplayPread(benchmark::State &state) {
+  std::vector<std::byte> buf(journal::journal_config{}.buffer_size);
+  [[maybe_unused]] const bool cold = state.range(0) != 0;
+  run_replay(state, [&](const bench_journal &j, std::uint64_t &sum, std::uint64_t &n) {
+    std::uint64_t bytes = 0;
+    for (std::uint32_t f = 0; f < j.files; ++f) {
+      const int fd = ::open(journal::file_path(j.dir, "journal", f).c_str(), O_RDONLY);
+#if defined(__linux__)
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+#if defined(F_RDAHEAD)
+      ::fcntl(fd, F_RDAHEAD, 1);
+#endif
+#if defined(F_NOCACHE)
+      if (cold) { // see bench_journal::drop_cache
+        ::fcntl(fd, F_NOCACHE, 1);
+      }
+#endif
+#endif
+      for (off_t pos = 0;;) {
+        const ssize_t r = ::pread(fd, buf.data(), buf.size(), pos);
+        if (r < static_cast<ssize_t>(sizeof(journal::chunk_header))) {
+          break;
+        }
+        journal::chunk_header h;
+        std::memcpy(&h, buf.data(), sizeof(h));
+        for (std::size_t at = sizeof(h); at < sizeof(h) + h.bytes; ++n) {
+          fast_queue_spmc::header_t len;
+          std::memcpy(&len, buf.data() + at, sizeof(len));
+          std::uint64_t seq;
+          std::memcpy(&seq, buf.data() + at + sizeof(len), sizeof(seq));
+          sum += seq;
+          at += sizeof(len) + static_cast<std::size_t>(len);
+        }
+        const std::size_t chunk = journal::align_up(sizeof(h) + h.bytes);
+        pos += static_cast<off_t>(chunk);
+        bytes += chunk;
+      }
+      ::close(fd);
+    }
+    return bytes;
+  });
+}
+
+inline void test() {
+  test_round_trip();
+  test_detects_damage();
+  test_drives_pipeline();
+  BENCHMARK(BM_ReplayMmap)->Iterations(3)->Arg(0)->Arg(1)->ArgName("cold")->UseRealTime();
+  BENCHMARK(BM_ReplayPread)->Iterations(3)->Arg(0)->Arg(1)->ArgName("cold")->UseRealTime();
+}
+
+} // namespace replay
@@ -0,0 +1,213 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  risk_check.hpp — pre-trade risk checks with a branch-free hot path
+// =====================================================================================
+//
+// Every order a strategy sends passes max-quantity, price-collar, position-limit and
+// message-rate checks first. Written the obvious way - one function per check, each an
+// `if (...) return reject;` - the path costs a chain of data-dependent branches, and the
+// rejects are exactly the orders the predictor has not seen. Here the check is one straight
+// run of arithmetic over one cache line:
+//
+//  - LIMITS live in a packed table, one cache-line row per symbol (symbol_limits), indexed by
+//    a dense symbol id. An order touches exactly its own row; there is no hashing and no
+//    pointer to chase. Ids outside the table are clamped to a sentinel row, so an unknown
+//    symbol is checked like any other and simply fails.
+//  - EVERY CHECK RUNS on every order, as comparisons that compile to setcc / csel, and each
+//    result lands in its own bit of a reject_reason mask. A reject therefore reports all its
+//    reasons at once, and the time per order does not depend on which check fails.
+//  - STATE UPDATES are masked, not branched on: the accepted-order mask (all ones or zero)
+//    selects whether the token and the position delta are applied.
+//  - THE RATE LIMIT is a token bucket in Q32.32 fixed point: tokens refill at refill_per_ns
+//    per nanosecond up to `burst`, and an accepted order spends one. A saturating integer
+//    multiply and add - no floating point and no division on the hot path.
+//
+// Position is the worst-case exposure: an accepted buy adds its quantity at once (as if it
+// filled), an accepted sell subtracts it. Fills change nothing; release() gives the quantity
+// back when an order is cancelled or rejected downstream. The engine is single-threaded, like
+// the order-entry thread that owns it. Errors are values (a mask, a bool), never exceptions.
+//
+
+#pragma once
+
+#include "cache_line.hpp"
+#include "order_book.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace risk_check {
+
+using order_book::price_t;
+using order_book::side;
+
+// One bit per failed check; 0 means the order may go out.
+enum reject_reason : std::uint32_t {
+  accepted = 0,
+  max_qty = 1u << 0,        // qty == 0 or above the symbol's max order size
+  price_collar = 1u << 1,   // price further than `collar` ticks from the reference price
+  position_limit = 1u << 2, // the order would take |position| above max_position
+  rate_limit = 1u << 3,     // token bucket empty
+  unknown_symbol = 1u << 4, // symbol id outside the table
+};
+
+inline const char *to_string(reject_reason r) noexcept {
+  switch (r) {
+  case accepted:
+    return "accepted";
+  case max_qty:
+    return "max_qty";
+  case price_collar:
+    return "price_collar";
+  case position_limit:
+    return "position_limit";
+  case rate_limit:
+    return "rate_limit";
+  case unknown_symbol:
+    return "unknown_symbol";
+  }
+  return "?"; // several bits: test them one by one
+}
+
+struct order {
+  std::uint32_t symbol;
+  side s;
+  price_t price;
+  std::uint32_t qty;
+};
+
+// Human-scale limits for one symbol, converted by set_limits() into a symbol_limits row.
+struct limits_config {
+  std::uint32_t max_qty;
+  price_t ref_price;        // collar centre, usually last trade or mid
+  price_t collar;           // max |price - ref_price| in ticks
+  std::int64_t max_position;
+  double msgs_per_sec;      // sustained order rate (< 1e9)
+  std::uint32_t burst;      // bucket depth in orders
+};
+
+// Q32.32: one token.
+inline constexpr std::uint64_t TOKEN = std::uint64_t{1} << 32;
+
+// Everything one check reads or writes, in one cache line. Default: reject every order.
+struct alignas(CACHE_LINE_SIZE) symbol_limits {
+  price_t ref_price = 0;
+  price_t collar = -1; // |delta| > -1 always: a row never configured fails the collar
+  std::int64_t position = 0;
+  std::int64_t max_position = -1; // likewise the position limit, even for qty == 0
+  std::uint64_t tokens = 0;        // Q32.32
+  std::uint64_t last_ns = 0;       // time of the last refill
+  std::uint32_t refill_per_ns = 0; // Q0.32 tokens per ns
+  std::uint32_t burst = 0;         // bucket capacity in whole tokens
+  std::uint32_t max_qty = 0;
+};
+static_assert(sizeof(symbol_limits) == CACHE_LINE_SIZE);
+
+class engine {
+public:
+  // Room for symbol ids [0, symbols); every row starts out rejecting everything.
+  explicit engine(std::size_t symbols) : rows_(symbols + 1), sentinel_{symbols} {}
+
+  // Installs limits for one symbol, with a full token bucket. False if `symbol` is outside
+  // the table or the rate does not fit the fixed-point format.
+  bool set_limits(std::uint32_t symbol, const limits_config &cfg, std::uint64_t now_ns) {
+    if (symbol >= sentinel_ || !(cfg.msgs_per_sec >= 0.0 && cfg.msgs_per_sec < 1e9)) {
+      return false;
+    }
+    symbol_limits &l = rows_[symbol];
+    l.ref_price = cfg.ref_price;
+    l.collar = cfg.collar;
+    l.max_position = cfg.max_position;
+    l.max_qty = cfg.max_qty;
+    l.burst = cfg.burst;
+    l.refill_per_ns =
+        static_cast<std::uint32_t>(std::llround(cfg.msgs_per_sec * double(TOKEN) / 1e9));
+    l.tokens = std::uint64_t{cfg.burst} << 32;
+    l.last_ns = now_ns;
+    return true;
+  }
+
+  // Moves the collar centre (e.g. on each trade print).
+  bool set_reference_price(std::uint32_t symbol, price_t px) noexcept {
+    if (symbol >= sentinel_) {
+      return false;
+    }
+    rows_[symbol].ref_price = px;
+    return true;
+  }
+
+  /**
+   * Runs every check against `o` at time `now_ns` (monotonic, ns) and returns the reasons it
+   * fails, or 0. An accepted order spends one token and is added to the position; a rejected
+   * one changes nothing but the bucket's refill clock.
+   *
+   * With `dry_run` the order is checked but never spent, whatever the result: the same code
+   * and the same row writes as a real check (which is what keeps them cached, see
+   * warmup.hpp), and the only state change is the refill, which is additive and capped and so
+   * gives the same tokens later whether it is applied once or in steps.
+   */
+  std::uint32_t check(const order &o, std::uint64_t now_ns, bool dry_run = false) noexcept {
+    // Clamp unknown ids to the sentinel row with masks rather than a branch.
+    const std::uint64_t known = o.symbol < sentinel_;
+    const std::uint64_t row = (o.symbol & -known) | (sentinel_ & (known - 1));
+    symbol_limits &l = rows_[row];
+
+    // qty - 1 wraps for qty == 0, so one unsigned compare covers both bounds.
+    const std::uint32_t bad_qty = o.qty - 1u >= l.max_qty;
+
+    const price_t d = o.price - l.ref_price;
+    const price_t sgn = d >> 63;
+    const std::uint32_t bad_px = ((d ^ sgn) - sgn) > l.collar;
+
+    // side::bid is a buy (+qty), side::ask a sell (-qty).
+    const std::int64_t delta =
+        (1 - 2 * static_cast<std::int64_t>(o.s)) * static_cast<std::int64_t>(o.qty);
+    const std::int64_t pos = l.position + delta;
+    const std::int64_t psgn = pos >> 63;
+    const std::uint32_t bad_pos = ((pos ^ psgn) - psgn) > l.max_position;
+
+    // The refill saturates instead of wrapping, so however long the row sat idle (a slow
+    // bucket can take seconds to fill) it comes back full.
+    const std::uint64_t elapsed = now_ns - l.last_ns;
+    const std::uint64_t cap = std::uint64_t{l.burst} << 32;
+    std::uint64_t gained;
+    std::uint64_t tokens;
+    gained = -std::uint64_t{__builtin_mul_overflow(elapsed, l.refill_per_ns, &gained)} | gained;
+    tokens = -std::uint64_t{__builtin_add_overflow(l.tokens, gained, &tokens)} | tokens;
+    tokens ^= (tokens ^ cap) & -std::uint64_t{tokens > cap};
+    const std::uint32_t bad_rate = tokens < TOKEN;
+
+    const std::uint32_t mask = bad_qty * max_qty | bad_px * price_collar |
+                               bad_pos * position_limit | bad_rate * rate_limit |
+                               static_cast<std::uint32_t>(1 - known) * unknown_symbol;
+
+    const std::uint64_t take = -(std::uint64_t{mask == 0} & std::uint64_t{!dry_run});
+    l.tokens = tokens - (TOKEN & take);
+    l.last_ns = now_ns;
+    l.position += delta & static_cast<std::int64_t>(take);
+    return mask;
+  }
+
+  // Returns an accepted order's quantity to the position (cancelled or rejected downstream).
+  void release(std::uint32_t symbol, side s, std::uint32_t qty) noexcept {
+    if (symbol < sentinel_) {
+      rows_[symbol].position -=
+          (1 - 2 * static_cast<std::int64_t>(s)) * static_cast<std::int64_t>(qty);
+    }
+  }
+
+  const symbol_limits &limits(std::uint32_t symbol) const noexcept {
+    return rows_[symbol < sentinel_ ? symbol : sentinel_];
+  }
+  std::size_t symbols() const noexcept { return sentinel_; }
+
+private:
+  std::vector<symbol_limits> rows_; // [0, sentinel_) configured ids, then the sentinel
+  std::size_t sentinel_;
+};
+
+} // namespace risk_check
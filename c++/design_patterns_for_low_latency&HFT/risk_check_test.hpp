@@ -0,0 +1,388 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for risk_check.hpp: each reject reason on its own and combined, the
+// fixed-point token bucket (burst, refill, cap), and a randomized run checked order by order
+// against a branchy implementation of the same rules. The benchmarks time both over a
+// pre-generated stream across 1024 symbols with a few percent of rejects spread over all the
+// reasons: throughput (checks per second) and per-order latency percentiles.
+//
+
+#pragma once
+
+#include "percentile.hpp"
+#include "risk_check.hpp"
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace risk_check {
+
+/**
+ * The same rules written the usual way: one function per check, each with its own branches,
+ * and state updated only behind an `if`. Kept only as the benchmark baseline and as the
+ * reference the branch-free engine is tested against.
+ */
+class branchy_engine {
+public:
+  explicit branchy_engine(std::size_t symbols) : rows_(symbols) {}
+
+  bool set_limits(std::uint32_t symbol, const limits_config &cfg, std::uint64_t now_ns) {
+    engine one{1};
+    if (symbol >= rows_.size() || !one.set_limits(0, cfg, now_ns)) {
+      return false;
+    }
+    rows_[symbol] = one.limits(0); // same fixed-point conversion
+    return true;
+  }
+
+  std::uint32_t check(const order &o, std::uint64_t now_ns) noexcept {
+    if (o.symbol >= rows_.size()) {
+      return unknown_symbol | max_qty | price_collar | position_limit | rate_limit;
+    }
+    symbol_limits &l = rows_[o.symbol];
+    const std::int64_t delta = o.s == side::bid ? std::int64_t{o.qty} : -std::int64_t{o.qty};
+    std::uint32_t mask = 0;
+    if (!qty_ok(l, o)) {
+      mask |= max_qty;
+    }
+    if (!collar_ok(l, o)) {
+      mask |= price_collar;
+    }
+    if (!position_ok(l, delta)) {
+      mask |= position_limit;
+    }
+    refill(l, now_ns);
+    if (l.tokens < TOKEN) {
+      mask |= rate_limit;
+    }
+    if (mask == 0) {
+      l.tokens -= TOKEN;
+      l.position += delta;
+    }
+    return mask;
+  }
+
+  const symbol_limits &limits(std::uint32_t symbol) const noexcept { return rows_[symbol]; }
+
+private:
+  static bool qty_ok(const symbol_limits &l, const order &o) {
+    if (o.qty == 0) {
+      return false;
+    }
+    return o.qty <= l.max_qty;
+  }
+  static bool collar_ok(const symbol_limits &l, const order &o) {
+    if (o.price > l.ref_price) {
+      return o.price - l.ref_price <= l.collar;
+    }
+    return l.ref_price - o.price <= l.collar;
+  }
+  static bool position_ok(const symbol_limits &l, std::int64_t delta) {
+    const std::int64_t pos = l.position + delta;
+    if (pos < 0) {
+      return -pos <= l.max_position;
+    }
+    return pos <= l.max_position;
+  }
+  static void refill(symbol_limits &l, std::uint64_t now_ns) {
+    // In 128 bits, so no pause is long enough to overflow.
+    const unsigned __int128 tokens =
+        l.tokens + static_cast<unsigned __int128>(now_ns - l.last_ns) * l.refill_per_ns;
+    const std::uint64_t cap = std::uint64_t{l.burst} << 32;
+    l.tokens = tokens > cap ? cap : static_cast<std::uint64_t>(tokens);
+    l.last_ns = now_ns;
+  }
+
+  std::vector<symbol_limits> rows_;
+};
+
+constexpr limits_config TEST_LIMITS{.max_qty = 1000,
+                                    .ref_price = 10'000,
+                                    .collar = 50,
+                                    .max_position = 2000,
+                                    .msgs_per_sec = 1000.0,
+                                    .burst = 5};
+
+inline void test_reject_reasons() {
+  std::println("--- test_risk_check_reasons ---");
+  engine e{4};
+  [[maybe_unused]] std::uint32_t r = e.check({0, side::bid, 10'000, 10}, 0);
+  assert(r != accepted && "unconfigured rows reject");
+  [[maybe_unused]] const bool set = e.set_limits(0, TEST_LIMITS, 0);
+  [[maybe_unused]] const bool set_out_of_range = e.set_limits(4, TEST_LIMITS, 0);
+  assert(set && !set_out_of_range);
+
+  r = e.check({0, side::bid, 10'000, 1000}, 1);
+  assert(r == accepted);
+  r = e.check({0, side::bid, 10'000, 0}, 2);
+  assert(r == max_qty);
+  r = e.check({0, side::ask, 10'000, 1001}, 3);
+  assert(r == max_qty);
+  r = e.check({0, side::bid, 10'050, 10}, 4);
+  assert(r == accepted);
+  r = e.check({0, side::ask, 9'949, 10}, 5);
+  assert(r == price_collar);
+  r = e.check({0, side::bid, 10'051, 10}, 6);
+  assert(r == price_collar);
+  // Position is 1010 long: a 1000 buy would make it 2010.
+  r = e.check({0, side::bid, 10'000, 1000}, 7);
+  assert(r == position_limit);
+  assert(e.limits(0).position == 1010 && "a reject must not move the position");
+  // Two failures at once, both reported.
+  r = e.check({0, side::ask, 20'000, 1001}, 8);
+  assert(r == (max_qty | price_collar));
+  r = e.check({9, side::bid, 10'000, 10}, 9);
+  assert(r == (unknown_symbol | max_qty | price_collar | position_limit | rate_limit));
+
+  // Sells count against the same limit on the short side.
+  e.release(0, side::bid, 1010);
+  assert(e.limits(0).position == 0);
+  r = e.check({0, side::ask, 10'000, 1000}, 10);
+  assert(r == accepted);
+  r = e.check({0, side::ask, 10'000, 1000}, 11);
+  assert(r == accepted);
+  r = e.check({0, side::ask, 10'000, 1}, 12);
+  assert(r == position_limit);
+
+  // Collar follows the reference price.
+  [[maybe_unused]] const bool moved = e.set_reference_price(0, 20'000);
+  assert(moved);
+  r = e.check({0, side::bid, 20'000, 10}, 13);
+  assert(r == accepted);
+  assert(std::string_view{to_string(price_collar)} == "price_collar");
+  std::println("test_risk_check_reasons PASSED");
+}
+
+inline void test_token_bucket() {
+  std::println("--- test_risk_check_token_bucket ---");
+  engine e{1};
+  limits_config cfg = TEST_LIMITS;
+  cfg.max_position = 1'000'000;
+  const std::uint64_t t0 = 1'000'000'000;
+  e.set_limits(0, cfg, t0);
+  const order o{0, side::bid, 10'000, 1};
+  [[maybe_unused]] std::uint32_t r = accepted;
+  for (int i = 0; i < 5; ++i) {
+    r = e.check(o, t0);
+    assert(r == accepted && "the full burst goes out at once");
+  }
+  r = e.check(o, t0);
+  assert(r == rate_limit);
+  // 1000 msgs/s: one token per ms.
+  r = e.check(o, t0 + 999'000);
+  assert(r == rate_limit);
+  r = e.check(o, t0 + 1'000'000);
+  assert(r == accepted);
+  r = e.check(o, t0 + 1'000'001);
+  assert(r == rate_limit);
+  // A long pause refills to `burst`, no further.
+  std::uint64_t t = t0 + 60'000'000'000;
+  for (int i = 0; i < 5; ++i) {
+    r = e.check(o, t);
+    assert(r == accepted);
+  }
+  r = e.check(o, t);
+  assert(r == rate_limit);
+  // Sustained rate over 1 s of one order every 100 us: ~1000 go out (+ the 0 left in hand).
+  int sent = 0;
+  for (int i = 1; i <= 10'000; ++i) {
+    sent += e.check(o, t + static_cast<std::uint64_t>(i) * 100'000) == accepted;
+  }
+  assert(sent >= 999 && sent <= 1001);
+
+  // A slow bucket: 50 orders at 10/s takes 5 s to refill, and must get all of it back.
+  cfg.msgs_per_sec = 10.0;
+  cfg.burst = 50;
+  e.set_limits(0, cfg, t0);
+  for (int i = 0; i < 50; ++i) {
+    r = e.check(o, t0);
+    assert(r == accepted);
+  }
+  r = e.check(o, t0);
+  assert(r == rate_limit);
+  t = t0 + 5'000'000'000;
+  for (int i = 0; i < 50; ++i) {
+    r = e.check(o, t);
+    assert(r == accepted && "a pause longer than 2^31 ns refills in full");
+  }
+  r = e.check(o, t);
+  assert(r == rate_limit);
+  // 4.9 s after that, 49 tokens; and a pause of years saturates instead of wrapping.
+  t += 4'900'000'000;
+  for (int i = 0; i < 49; ++i) {
+    r = e.check(o, t);
+    assert(r == accepted);
+  }
+  r = e.check(o, t);
+  assert(r == rate_limit);
+  t += std::uint64_t{1} << 62;
+  for (int i = 0; i < 50; ++i) {
+    r = e.check(o, t);
+    assert(r == accepted);
+  }
+  r = e.check(o, t);
+  assert(r == rate_limit);
+  std::println("test_risk_check_token_bucket PASSED");
+}
+
+// --- Order stream -----------------------------------------------------------------------
+// Limits are TEST_LIMITS with a rate and position loose enough that most orders pass; the
+// stream then mixes in oversize orders, off-collar prices and unknown symbols, and leaves
+// the rate and position checks to reject on their own as buckets drain and positions wander.
+
+constexpr std::uint64_t STREAM_STEP_NS = 20; // one order every 20 ns across all symbols
+
+inline limits_config stream_limits() {
+  limits_config cfg = TEST_LIMITS;
+  cfg.max_position = 20'000;
+  cfg.msgs_per_sec = 50'000.0;
+  cfg.burst = 16;
+  return cfg;
+}
+
+inline std::vector<order> make_orders(std::uint32_t symbols, std::size_t n, std::uint64_t seed) {
+  std::mt19937_64 rng{seed};
+  std::vector<order> orders(n);
+  for (auto &o : orders) {
+    const auto r = rng() % 1000;
+    o.symbol = static_cast<std::uint32_t>(rng() % symbols) + (r < 5 ? symbols : 0);
+    o.s = rng() & 1 ? side::bid : side::ask;
+    o.price = 10'000 + static_cast<price_t>(rng() % 81) - 40 + (r >= 5 && r < 15 ? 100 : 0);
+    o.qty = 1 + static_cast<std::uint32_t>(rng() % 1000) + (r >= 15 && r < 25 ? 1000 : 0);
+  }
+  return orders;
+}
+
+template <class Engine> Engine make_engine(std::uint32_t symbols) {
+  Engine e{symbols};
+  for (std::uint32_t s = 0; s < symbols; ++s) {
+    e.set_limits(s, stream_limits(), 0);
+  }
+  return e;
+}
+
+inline void test_against_branchy() {
+  std::println("--- test_risk_check_against_branchy ---");
+  constexpr std::uint32_t SYMBOLS = 64;
+  auto fast = make_engine<engine>(SYMBOLS);
+  auto slow = make_engine<branchy_engine>(SYMBOLS);
+  const auto orders = make_orders(SYMBOLS, 1'000'000, 3);
+  std::array<std::size_t, 5> by_reason{};
+  std::uint64_t now = 0;
+  for (const auto &o : orders) {
+    now += STREAM_STEP_NS;
+    const std::uint32_t mask = fast.check(o, now);
+    assert(mask == slow.check(o, now));
+    for (std::size_t b = 0; b < by_reason.size(); ++b) {
+      by_reason[b] += mask >> b & 1;
+    }
+  }
+  for (std::uint32_t s = 0; s < SYMBOLS; ++s) {
+    assert(fast.limits(s).position == slow.limits(s).position);
+    assert(fast.limits(s).tokens == slow.limits(s).tokens);
+  }
+  assert(std::ranges::all_of(by_reason, [](std::size_t c) { return c > 0; }) &&
+         "the stream must exercise every reason");
+  std::println("test_risk_check_against_branchy PASSED");
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// 1M pre-generated orders over range(0) symbols, one every STREAM_STEP_NS of simulated time;
+// the engine is rebuilt (untimed) before each pass so every pass sees the same rejects.
+
+inline constexpr std::size_t BENCH_ORDERS = 1'000'000;
+
+template <class Engine> void run_throughput(benchmark::State &state) {
+  const auto symbols = static_cast<std::uint32_t>(state.range(0));
+  const auto orders = make_orders(symbols, BENCH_ORDERS, 7);
+  const auto fresh = make_engine<Engine>(symbols);
+  std::size_t rejects = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Engine e = fresh;
+    rejects = 0;
+    state.ResumeTiming();
+    std::uint64_t now = 0;
+    for (const auto &o : orders) {
+      now += STREAM_STEP_NS;
+      rejects += e.check(o, now) != accepted;
+    }
+    benchmark::DoNotOptimize(rejects);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BENCH_ORDERS));
+  state.counters["reject_rate"] = static_cast<double>(rejects) / BENCH_ORDERS;
+}
+
+/**
+ * Per-order latency: each check bracketed by read_tsc(), percentiles over the 1M orders.
+ * steady_clock::now() costs more than the check itself, hence the TSC; the cost of an empty
+ * bracket is reported as tsc_overhead_ns and included in the percentiles.
+ */
+template <class Engine> void run_latency(benchmark::State &state) {
+  using tsc::read_tsc;
+  const auto symbols = static_cast<std::uint32_t>(state.range(0));
+  const auto orders = make_orders(symbols, BENCH_ORDERS, 7);
+  const double ticks_per_ns = tsc::calibrate_ticks_per_ns();
+  std::vector<std::uint64_t> ticks(BENCH_ORDERS);
+  for (auto _ : state) {
+    Engine e = make_engine<Engine>(symbols);
+    std::uint64_t now = 0;
+    for (std::size_t i = 0; i < BENCH_ORDERS; ++i) {
+      now += STREAM_STEP_NS;
+      const std::uint64_t t0 = read_tsc();
+      benchmark::DoNotOptimize(e.check(orders[i], now));
+      ticks[i] = read_tsc() - t0;
+    }
+  }
+  std::vector<std::uint64_t> empty(10'000);
+  for (auto &t : empty) {
+    const std::uint64_t t0 = read_tsc();
+    benchmark::ClobberMemory();
+    t = read_tsc() - t0;
+  }
+  std::ranges::sort(ticks);
+  std::ranges::sort(empty);
+  auto ns = [&](std::uint64_t t) { return static_cast<double>(t) / ticks_per_ns; };
+  auto at = [&](double q) { return ns(percentile::nearest_rank(ticks, q)); };
+  state.counters["p50_ns"] = at(0.50);
+  state.counters["p99_ns"] = at(0.99);
+  state.counters["p99.9_ns"] = at(0.999);
+  state.counters["max_ns"] = ns(ticks.back());
+  state.counters["tsc_overhead_ns"] = ns(empty[empty.size() / 2]);
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BENCH_ORDERS));
+}
+
+inline void BM_RiskCheckBranchFree(benchmark::State &state) { run_throughput<engine>(state); }
+inline void BM_RiskCheckBranchy(benchmark::State &state) {
+  run_throughput<branchy_engine>(state);
+}
+inline void BM_RiskCheckLatencyBranchFree(benchmark::State &state) {
+  run_latency<engine>(state);
+}
+inline void BM_RiskCheckLatencyBranchy(benchmark::State &state) {
+  run_latency<branchy_engine>(state);
+}
+
+inline void test() {
+  test_reject_reasons();
+  test_token_bucket();
+  test_against_branchy();
+  // Args = {symbols}: 1024 rows are 64 KiB of limits, about an L1 and a half.
+  BENCHMARK(BM_RiskCheckBranchFree)->Arg(1024);
+  BENCHMARK(BM_RiskCheckBranchy)->Arg(1024);
+  BENCHMARK(BM_RiskCheckLatencyBranchFree)->Iterations(1)->Arg(1024);
+  BENCHMARK(BM_RiskCheckLatencyBranchy)->Iterations(1)->Arg(1024);
+}
+
+} // namespace risk_check
@@ -0,0 +1,141 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  seqlock.hpp — single-writer snapshot of a small value, for "latest state" fan-out
+// =====================================================================================
+//
+// The SPMC ring delivers EVERY message to every consumer, which is right for an order flow
+// but wasteful for state such as the top of book: a strategy that wakes up wants the current
+// best bid/offer, not the thousand updates it missed. A sequence lock publishes just the
+// latest value:
+//
+//  - the writer bumps a sequence counter to ODD, writes the value, and bumps it to EVEN
+//    again. It never waits for readers - a slow reader cannot back-pressure the feed.
+//  - a reader loads the counter, copies the value, and loads the counter again. If the two
+//    loads are equal and even, no write overlapped the copy and the snapshot is consistent;
+//    otherwise it copies again. Readers never write shared memory, so any number of them
+//    read-share the line without bouncing it between each other.
+//  - one attempt is a bounded, wait-free sequence of loads (try_load); a reader only retries
+//    when the writer was mid-store, which for a value of a few words is a window of
+//    nanoseconds.
+//
+// The value is held as an array of relaxed std::atomic words, copied in and out word by word,
+// so the racing copy is well defined (no data race on a plain T) while still compiling to
+// ordinary moves. Counter and value share one cache line (a reader gets both in one transfer)
+// and the whole object is padded to CACHE_LINE_SIZE so it shares no line with its neighbours.
+//
+// T must be trivially copyable and default constructible. There must be exactly one writer
+// thread.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace seqlock {
+
+template <class T> class alignas(CACHE_LINE_SIZE) seqlock {
+  static_assert(std::is_trivially_copyable_v<T>, "seqlock copies T as raw bytes");
+  static_assert(std::is_default_constructible_v<T>);
+
+  using word = std::uint64_t;
+  static constexpr std::size_t WORDS = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+
+public:
+  seqlock() noexcept : seqlock(T{}) {}
+  explicit seqlock(const T &initial) noexcept { write_words(initial); }
+
+  // Writer only. Never blocks; readers that overlap this store retry.
+  void store(const T &value) noexcept {
+    const std::uint64_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed); // odd: write in progress
+    // The odd counter must be visible before any word of the new value.
+    std::atomic_thread_fence(std::memory_order_release);
+    write_words(value);
+    seq_.store(s + 2, std::memory_order_release); // even: publishes the words above
+  }
+
+  // One read attempt: the value, or std::nullopt if a store overlapped it.
+  std::optional<T> try_load() const noexcept {
+    const std::uint64_t s0 = seq_.load(std::memory_order_acquire);
+    if (s0 & 1) {
+      return std::nullopt;
+    }
+    const T v = read_words();
+    // Orders the word loads above before the re-check below.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != s0) {
+      return std::nullopt;
+    }
+    return v;
+  }
+
+  // The latest consistent value, retrying torn reads.
+  T load() const noexcept {
+    for (;;) {
+      if (auto v = try_load()) {
+        return *v;
+      }
+      fast_queue_spsc::spin_pause();
+    }
+  }
+
+  /**
+   * The latest value if it is newer than version `seen` (then `seen` is updated), or
+   * std::nullopt when nothing was stored since. Lets a poller skip unchanged state cheaply:
+   * the common "no change" case is a single load of the counter.
+   */
+  std::optional<T> load_newer(std::uint64_t &seen) const noexcept {
+    for (;;) {
+      const std::uint64_t s0 = seq_.load(std::memory_order_acquire);
+      if (s0 / 2 == seen && !(s0 & 1)) {
+        return std::nullopt;
+      }
+      if (!(s0 & 1)) {
+        const T v = read_words();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == s0) {
+          seen = s0 / 2;
+          return v;
+        }
+      }
+      fast_queue_spsc::spin_pause();
+    }
+  }
+
+  // Number of completed stores.
+  std::uint64_t version() const noexcept { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+  void write_words(const T &value) noexcept {
+    std::array<word, WORDS> buf{};
+    std::memcpy(buf.data(), &value, sizeof(T));
+    for (std::size_t i = 0; i < WORDS; ++i) {
+      words_[i].store(buf[i], std::memory_order_relaxed);
+    }
+  }
+
+  T read_words() const noexcept {
+    std::array<word, WORDS> buf;
+    for (std::size_t i = 0; i < WORDS; ++i) {
+      buf[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    T v;
+    std::memcpy(&v, buf.data(), sizeof(T));
+    return v;
+  }
+
+  std::atomic<std::uint64_t> seq_{0}; // even: stable, odd: store in progress
+  std::array<std::atomic<word>, WORDS> words_{};
+};
+
+} // namespace seqlock
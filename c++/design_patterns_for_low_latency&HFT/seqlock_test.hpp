@@ -0,0 +1,211 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for seqlock.hpp: versioning and load_newer on one thread, torn-read
+// detection under a concurrent writer (every snapshot must be internally consistent and no
+// older than the previous one), and top-of-book fan-out to three readers that only need the
+// latest value - through a seqlock against the same updates broadcast over spmc_queue_t.
+//
+
+#pragma once
+
+#include "fast_queue_SPMC.hpp"
+#include "seqlock.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <print>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace seqlock {
+
+// Top of book as a strategy consumes it. Every field is derived from `seq`, so a reader can
+// tell a consistent snapshot from one mixing two updates.
+struct bbo {
+  std::uint64_t seq;
+  std::int64_t bid;
+  std::int64_t ask;
+  std::int64_t bid_qty;
+  std::int64_t ask_qty;
+};
+
+inline bbo make_bbo(std::uint64_t seq) {
+  const auto s = static_cast<std::int64_t>(seq);
+  return bbo{seq, 10'000 + s % 97, 10'001 + s % 97, 100 + s % 13, 200 + s % 11};
+}
+
+inline bool consistent(const bbo &b) {
+  const bbo want = make_bbo(b.seq);
+  return std::memcmp(&b, &want, sizeof(bbo)) == 0;
+}
+
+inline void test_seqlock_basic() {
+  std::println("--- test_seqlock_basic ---");
+  static_assert(sizeof(seqlock<bbo>) == CACHE_LINE_SIZE &&
+                alignof(seqlock<bbo>) == CACHE_LINE_SIZE);
+  seqlock<bbo> s{make_bbo(0)};
+  std::uint64_t seen = 0;
+  assert(s.version() == 0 && !s.load_newer(seen) && s.load().seq == 0);
+  s.store(make_bbo(1));
+  s.store(make_bbo(2));
+  [[maybe_unused]] const auto latest = s.load_newer(seen);
+  assert(latest && latest->seq == 2 && seen == 2 && "load_newer skips straight to the latest");
+  assert(!s.load_newer(seen) && s.try_load()->seq == 2);
+  std::println("test_seqlock_basic PASSED");
+}
+
+inline void test_seqlock_concurrent() {
+  std::println("--- test_seqlock_concurrent ---");
+  constexpr std::uint64_t N = 1'000'000;
+  constexpr std::size_t READERS = 2;
+  seqlock<bbo> s{make_bbo(0)};
+  std::atomic<bool> done{false};
+  std::array<std::uint64_t, READERS> snapshots{};
+  std::array<std::uint64_t, READERS> torn{};
+
+  std::vector<std::thread> readers;
+  for (std::size_t r = 0; r < READERS; ++r) {
+    readers.emplace_back([&, r] {
+      [[maybe_unused]] std::uint64_t last = 0;
+      while (!done.load(std::memory_order_acquire)) {
+        const auto v = s.try_load();
+        if (!v) {
+          ++torn[r];
+          continue;
+        }
+        assert(consistent(*v) && "seqlock returned a torn snapshot");
+        assert(v->seq >= last && "seqlock went back in time");
+        last = v->seq;
+        ++snapshots[r];
+      }
+      assert(s.load().seq == N);
+    });
+  }
+  for (std::uint64_t k = 1; k <= N; ++k) {
+    s.store(make_bbo(k));
+  }
+  done.store(true, std::memory_order_release);
+  for (auto &t : readers) {
+    t.join();
+  }
+  std::println("test_seqlock_concurrent PASSED ({} snapshots, {} torn reads retried)",
+               snapshots[0] + snapshots[1], torn[0] + torn[1]);
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// One writer publishes N top-of-book updates as fast as it can; three readers each want the
+// latest value and stop once they have seen update N. Manual time runs from the start signal
+// until the last reader holds update N. Through the seqlock readers skip whatever they missed
+// and the writer never waits; through spmc_queue_t every reader must consume every update and
+// the slowest one gates the writer. Args: range(0) = N updates.
+
+constexpr std::size_t FANOUT_READERS = 3;
+
+template <class Publish, class Reader>
+void run_fanout(benchmark::State &state, Publish &&publish, Reader &&make_reader) {
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  std::uint64_t observed = 0;
+  for (auto _ : state) {
+    std::atomic<bool> go{false};
+    std::atomic<std::size_t> finished{0};
+    std::chrono::steady_clock::time_point t_end;
+    std::array<std::uint64_t, FANOUT_READERS> seen{};
+
+    std::vector<std::thread> readers;
+    for (std::size_t r = 0; r < FANOUT_READERS; ++r) {
+      readers.emplace_back([&, r] {
+        auto next = make_reader(r); // returns the next bbo observed, or std::nullopt
+        while (!go.load(std::memory_order_acquire)) {
+          fast_queue_spsc::spin_pause();
+        }
+        std::uint64_t count = 0; // local: a shared array slot would false-share
+        for (;;) {
+          const auto v = next();
+          if (!v) {
+            fast_queue_spsc::spin_pause();
+            continue;
+          }
+          ++count;
+          if (v->seq == n) {
+            break;
+          }
+        }
+        seen[r] = count;
+        if (finished.fetch_add(1, std::memory_order_acq_rel) + 1 == FANOUT_READERS) {
+          t_end = std::chrono::steady_clock::now();
+        }
+      });
+    }
+    const auto t_begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::uint64_t k = 1; k <= n; ++k) {
+      publish(make_bbo(k));
+    }
+    for (auto &t : readers) {
+      t.join();
+    }
+    state.SetIterationTime(std::chrono::duration<double>(t_end - t_begin).count());
+    observed = seen[0] + seen[1] + seen[2];
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  // Fraction of the updates each reader actually had to process (1.0 for the queue).
+  state.counters["processed_per_update"] =
+      static_cast<double>(observed) / static_cast<double>(FANOUT_READERS * n);
+}
+
+inline void BM_SeqlockFanout(benchmark::State &state) {
+  auto s = std::make_unique<seqlock<bbo>>(make_bbo(0));
+  run_fanout(
+      state, [&](const bbo &b) { s->store(b); },
+      [&](std::size_t) {
+        return [&s, seen = std::uint64_t{0}]() mutable { return s->load_newer(seen); };
+      });
+}
+
+inline void BM_SpmcFanout(benchmark::State &state) {
+  using queue = fast_queue_spmc::spmc_queue_t<std::size_t{1} << 20, FANOUT_READERS>;
+  auto q = std::make_unique<queue>();
+  fast_queue_spmc::producer prod;
+  std::array<fast_queue_spmc::consumer, FANOUT_READERS> cons{fast_queue_spmc::consumer{0},
+                                                             fast_queue_spmc::consumer{1},
+                                                             fast_queue_spmc::consumer{2}};
+  run_fanout(
+      state,
+      [&](const bbo &b) {
+        const std::span<const std::byte> bytes{reinterpret_cast<const std::byte *>(&b),
+                                               sizeof(bbo)};
+        while (!prod.try_write(*q, bytes)) {
+          fast_queue_spsc::spin_pause(); // slowest reader gates the writer
+        }
+      },
+      [&](std::size_t r) {
+        return [&q, &c = cons[r]]() -> std::optional<bbo> {
+          std::array<std::byte, sizeof(bbo)> buf;
+          if (!c.try_read(*q, buf)) {
+            return std::nullopt;
+          }
+          bbo b;
+          std::memcpy(&b, buf.data(), sizeof(bbo));
+          return b;
+        };
+      });
+}
+
+inline void test() {
+  test_seqlock_basic();
+  test_seqlock_concurrent();
+  BENCHMARK(BM_SeqlockFanout)->UseManualTime()->Iterations(1)->Arg(10'000'000);
+  BENCHMARK(BM_SpmcFanout)->UseManualTime()->Iterations(1)->Arg(10'000'000);
+}
+
+} // namespace seqlock
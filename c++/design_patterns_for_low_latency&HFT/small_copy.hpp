@@ -0,0 +1,139 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  small_copy.hpp — size-class copy kernels for short ring records
+// =====================================================================================
+//
+// The queue's payload copies have a runtime length: a record is 4 bytes of header plus
+// whatever the producer sent, 12..48 bytes in run_full_ring. std::memcpy with a runtime n
+// is an out-of-line call into libc. libc then picks a size class before it moves a byte,
+// and that is a lot of code for a copy of two or three cache-line fragments.
+//
+// `copy` picks the size class inline and does the copy with at most four loads and four
+// stores. The trick that removes the tail loop is the OVERLAPPING pair: any n in [W, 2W]
+// is one W-byte load from the start and one from the end (`n - W`). When n < 2W the two
+// windows overlap and the middle bytes are written twice, with the same value:
+//
+//      n = 24, W = 16:   [0 ............ 16)
+//                                [8 ............ 24)
+//
+// Both loads are done before either store, so the kernel is correct for any n in the class
+// and branches only on the class, never on the exact length:
+//
+//      1         one byte
+//      2..3      two overlapping 2-byte moves
+//      4..7      two overlapping 4-byte moves
+//      8..16     two overlapping 8-byte moves
+//      17..32    two overlapping 16-byte SSE moves
+//      33..64    two overlapping 32-byte AVX2 moves (four 16-byte SSE moves without AVX2)
+//      > 64      std::memcpy: there libc's bulk loops win
+//
+// The vector paths use unaligned loads and stores; the ring's records sit at any offset.
+// They are chosen at compile time from the target flags (-mavx2, or the ENABLE_AVX2 CMake
+// option), not by a CPUID check at run time: a dispatch through a function pointer would
+// cost what the kernel saves. Without SSE2 (e.g. on ARM) the same shape is built from
+// fixed-size memcpy, which the compiler turns into plain vector loads and stores.
+//
+// `libc` and `simd` wrap the two ways of copying as policies, so fast_queue_t can take
+// either as a template parameter. A benchmark can then compare them on the same ring.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace small_copy {
+
+namespace detail {
+
+// W-byte move from the start and from the end of [0, n), both loaded before either store.
+// n must be in [W, 2W].
+template <std::size_t W>
+inline void overlapping_pair(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+  std::byte head[W];
+  std::byte tail[W];
+  std::memcpy(head, src, W);
+  std::memcpy(tail, src + n - W, W);
+  std::memcpy(dst, head, W);
+  std::memcpy(dst + n - W, tail, W);
+}
+
+#if defined(__SSE2__)
+template <>
+inline void overlapping_pair<16>(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+  const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+  const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + n - 16));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), head);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + n - 16), tail);
+}
+#endif
+
+#if defined(__AVX2__)
+template <>
+inline void overlapping_pair<32>(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+  const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+  const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + n - 32));
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), head);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + n - 32), tail);
+}
+#endif
+
+// 33..64 bytes.
+inline void copy_33_64(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+#if defined(__AVX2__)
+  overlapping_pair<32>(dst, src, n);
+#else
+  // Two 16-byte pairs: [0, 32) from the front, [n - 32, n) from the back.
+  std::byte head[32];
+  std::byte tail[32];
+  std::memcpy(head, src, 32);
+  std::memcpy(tail, src + n - 32, 32);
+  std::memcpy(dst, head, 32);
+  std::memcpy(dst + n - 32, tail, 32);
+#endif
+}
+
+} // namespace detail
+
+// Copy n bytes between non-overlapping buffers (the same contract as std::memcpy).
+inline void copy(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+  if (n <= 16) {
+    if (n >= 8) {
+      detail::overlapping_pair<8>(dst, src, n);
+    } else if (n >= 4) {
+      detail::overlapping_pair<4>(dst, src, n);
+    } else if (n >= 2) {
+      detail::overlapping_pair<2>(dst, src, n);
+    } else if (n == 1) {
+      *dst = *src;
+    }
+  } else if (n <= 32) {
+    detail::overlapping_pair<16>(dst, src, n);
+  } else if (n <= 64) {
+    detail::copy_33_64(dst, src, n);
+  } else {
+    std::memcpy(dst, src, n);
+  }
+}
+
+// Copy policies for fast_queue_spsc::fast_queue_t.
+struct libc {
+  static void copy(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+    std::memcpy(dst, src, n);
+  }
+};
+
+struct simd {
+  static void copy(std::byte *dst, const std::byte *src, std::size_t n) noexcept {
+    small_copy::copy(dst, src, n);
+  }
+};
+
+} // namespace small_copy
@@ -0,0 +1,217 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  strategy_pipeline.hpp — handler chains composed at compile time
+// =====================================================================================
+//
+// compile_time_dispatch.hpp measures one call through a Base* against one direct call. A
+// strategy thread makes several per message: decode -> filter -> update the book -> compute a
+// signal. Written as std::vector<handler_base *> that is one indirect call per stage per
+// message, and every stage has to take a lowest-common-denominator event and re-switch on its
+// type. Here the chain is a TYPE instead:
+//
+//  - pipeline<Stages...> stores its stages in a std::tuple. Feeding it an event calls the
+//    first stage's on(event, next); `next` is a tiny callable bound to the following stage,
+//    so a stage passes an event on by calling next(e) - zero, one or several times, and with
+//    a different event type if it transforms the message.
+//  - every call is to a statically known function, so the compiler inlines the whole chain
+//    FOR EACH EVENT TYPE: the decoder's jump table lands in a separate, fully inlined
+//    filter -> book -> signal path per ITCH message type. No virtual call, no std::function,
+//    no re-dispatch on a type tag inside the later stages.
+//  - a stage with no on() for an event type is skipped for it (the event flows past), so a
+//    signal stage only ever sees top-of-book events and needs no default case.
+//
+// The stages below are the market-data path of this module: itch_decoder (market_data.hpp),
+// locate_filter, book_updater (order_book.hpp) and momentum_signal.
+//
+
+#pragma once
+
+#include "market_data.hpp"
+#include "order_book.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace strategy_pipeline {
+
+// A stage handles an event when it has on(const Event &, Next) for it.
+template <class Stage, class Event, class Next>
+concept handles = requires(Stage &s, const Event &e, Next n) { s.on(e, n); };
+
+template <class... Stages> class pipeline {
+public:
+  pipeline() = default;
+  explicit pipeline(Stages... stages) : stages_{std::move(stages)...} {}
+
+  // Push one event into the first stage that handles it.
+  template <class Event> void operator()(const Event &e) { dispatch<0>(e); }
+
+  template <std::size_t I> auto &stage() noexcept { return std::get<I>(stages_); }
+  template <std::size_t I> const auto &stage() const noexcept { return std::get<I>(stages_); }
+
+private:
+  // Continuation handed to stage I - 1: forwards to stage I (or drops past the last one).
+  template <std::size_t I> struct next_t {
+    pipeline *p;
+    template <class Event> void operator()(const Event &e) const { p->template dispatch<I>(e); }
+  };
+
+  template <std::size_t I, class Event> void dispatch(const Event &e) {
+    if constexpr (I < sizeof...(Stages)) {
+      using stage_t = std::tuple_element_t<I, std::tuple<Stages...>>;
+      if constexpr (handles<stage_t, Event, next_t<I + 1>>) {
+        std::get<I>(stages_).on(e, next_t<I + 1>{this});
+      } else {
+        dispatch<I + 1>(e); // not for this stage: flows past
+      }
+    }
+  }
+
+  std::tuple<Stages...> stages_;
+};
+
+// --- Market-data stages ----------------------------------------------------------------
+
+// Raw ITCH bytes -> market_data::message<Schema>, through the compile-time jump table. Each
+// table entry instantiates the rest of the pipeline for its own message type.
+struct itch_decoder {
+  std::uint64_t rejected = 0; // unknown or truncated messages
+
+  template <class Next> struct handler {
+    Next next;
+    itch_decoder *self;
+    template <class S> void on(market_data::message<S> m) { next(m); }
+    void on_unknown(char) { ++self->rejected; }
+    void on_truncated(char, std::size_t) { ++self->rejected; }
+  };
+
+  template <class Next> void on(std::span<const std::byte> bytes, Next next) {
+    handler<Next> h{next, this};
+    market_data::decode(h, bytes);
+  }
+  template <class Next> void on(const fast_queue_spsc::read_view &v, Next next) {
+    handler<Next> h{next, this};
+    market_data::decode(h, v);
+  }
+};
+
+// Passes only the messages of one instrument (ITCH stock locate code).
+struct locate_filter {
+  std::uint16_t locate;
+
+  template <class S, class Next> void on(market_data::message<S> m, Next next) const {
+    if (m.template get<market_data::itch::stock_locate>() == locate) {
+      next(m);
+    }
+  }
+};
+
+// Emitted by book_updater whenever the best bid or ask price changes.
+struct top_of_book {
+  std::optional<order_book::price_t> bid;
+  std::optional<order_book::price_t> ask;
+};
+
+// Applies ITCH order messages to an L3 book and emits top_of_book on best-price changes.
+struct book_updater {
+  explicit book_updater(const order_book::book_config &cfg) : book{cfg} {}
+
+  template <class Next> void on(market_data::message<market_data::itch::add_order> m, Next next) {
+    using s = market_data::itch::add_order;
+    const auto side = m.get<s::side>() == 'B' ? order_book::side::bid : order_book::side::ask;
+    count(book.add(m.get<market_data::itch::order_ref>(), side, m.get<s::price>(),
+                   m.get<s::shares>()));
+    publish(next);
+  }
+  template <class Next>
+  void on(market_data::message<market_data::itch::order_executed> m, Next next) {
+    count(book.execute(m.get<market_data::itch::order_ref>(),
+                       m.get<market_data::itch::order_executed::executed_shares>()));
+    publish(next);
+  }
+  template <class Next>
+  void on(market_data::message<market_data::itch::order_cancel> m, Next next) {
+    const auto id = m.get<market_data::itch::order_ref>();
+    const order_book::order *o = book.find(id);
+    const auto cancelled = m.get<market_data::itch::order_cancel::cancelled_shares>();
+    if (o == nullptr || cancelled >= o->qty) {
+      count(book.cancel(id));
+    } else {
+      count(book.modify(id, o->price, o->qty - cancelled)); // shrink keeps priority
+    }
+    publish(next);
+  }
+  template <class Next>
+  void on(market_data::message<market_data::itch::order_delete> m, Next next) {
+    count(book.cancel(m.get<market_data::itch::order_ref>()));
+    publish(next);
+  }
+  template <class Next>
+  void on(market_data::message<market_data::itch::order_replace> m, Next next) {
+    using s = market_data::itch::order_replace;
+    const auto id = m.get<s::original_ref>();
+    const order_book::order *o = book.find(id);
+    if (o == nullptr) {
+      count(order_book::status::unknown_order);
+      return;
+    }
+    const auto side = o->s;
+    count(book.cancel(id)); // a replace loses priority, like cancel + add
+    count(book.add(m.get<s::new_ref>(), side, m.get<s::price>(), m.get<s::shares>()));
+    publish(next);
+  }
+
+  order_book::book book;
+  std::uint64_t errors = 0;
+
+private:
+  void count(order_book::status st) noexcept { errors += st != order_book::status::ok; }
+
+  template <class Next> void publish(Next &next) {
+    const top_of_book now{book.best_bid(), book.best_ask()};
+    if (now.bid != last_.bid || now.ask != last_.ask) {
+      last_ = now;
+      next(now);
+    }
+  }
+
+  top_of_book last_{};
+};
+
+// Emitted by momentum_signal: the mid moved by at least `threshold` ticks.
+struct signal {
+  int direction; // +1 up, -1 down
+  order_book::price_t mid2; // bid + ask (twice the mid, so it stays an integer)
+};
+
+// Signals when the mid of a two-sided book has moved `threshold` ticks since the last signal.
+struct momentum_signal {
+  order_book::price_t threshold;
+  order_book::price_t anchor2 = 0; // mid2 at the last signal (0 = none yet)
+  std::uint64_t signals = 0;
+
+  template <class Next> void on(const top_of_book &t, Next next) {
+    if (!t.bid || !t.ask) {
+      return;
+    }
+    const order_book::price_t mid2 = *t.bid + *t.ask;
+    if (anchor2 == 0) {
+      anchor2 = mid2;
+      return;
+    }
+    const order_book::price_t moved2 = mid2 - anchor2;
+    if (moved2 >= 2 * threshold || moved2 <= -2 * threshold) {
+      anchor2 = mid2;
+      ++signals;
+      next(signal{moved2 > 0 ? 1 : -1, mid2});
+    }
+  }
+};
+
+} // namespace strategy_pipeline
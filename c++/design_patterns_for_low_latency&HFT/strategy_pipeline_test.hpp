@@ -0,0 +1,364 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for strategy_pipeline.hpp: stages that do not handle an event let it
+// flow past, the composed decode -> filter -> book -> signal chain ends in exactly the state
+// of an equivalent virtual chain, and the cost per message of both over an ITCH encoding of
+// the order_book test feed interleaved with another instrument's traffic.
+//
+
+#pragma once
+
+#include "market_data_test.hpp"
+#include "order_book_test.hpp"
+#include "strategy_pipeline.hpp"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <print>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace strategy_pipeline {
+
+constexpr std::uint16_t TRADED_LOCATE = 1; // the instrument the strategy trades
+constexpr std::uint16_t OTHER_LOCATE = 2;  // traffic the filter must drop
+constexpr order_book::price_t SIGNAL_TICKS = 1;
+
+// The order_book test feed as ITCH wire messages, with one message of another instrument
+// after every third message of ours.
+struct itch_stream {
+  std::vector<std::byte> bytes;
+  std::vector<std::span<const std::byte>> msgs;
+  order_book::book_config config;
+};
+
+inline itch_stream make_itch_stream(std::size_t n) {
+  using namespace market_data;
+  const order_book::feed &f = order_book::cached_feed(n);
+  itch_stream s;
+  s.config = order_book::feed_config(f);
+  s.bytes.resize((f.msgs.size() + f.msgs.size() / 3 + 1) * itch::MAX_MESSAGE_SIZE);
+  std::vector<std::size_t> lengths;
+  std::size_t at = 0;
+  auto emit = [&](std::size_t len) {
+    lengths.push_back(len);
+    at += len;
+  };
+  for (std::size_t i = 0; i < f.msgs.size(); ++i) {
+    const order_book::book_msg &m = f.msgs[i];
+    std::byte *p = s.bytes.data() + at;
+    const auto qty = static_cast<std::uint32_t>(m.qty);
+    const auto price = static_cast<std::uint32_t>(m.price);
+    switch (m.type) {
+    case order_book::msg_type::add:
+      emit(encode_add(p, m.id, m.s == order_book::side::bid ? 'B' : 'S', qty, "SPY", price, i));
+      break;
+    case order_book::msg_type::modify:
+      emit(encode_replace(p, m.id, m.id, qty, price)); // re-uses the ref: same id in the book
+      break;
+    case order_book::msg_type::cancel:
+      emit(encode_delete(p, m.id));
+      break;
+    case order_book::msg_type::execute:
+      emit(encode_executed(p, m.id, qty, i));
+      break;
+    }
+    if (i % 3 == 2) {
+      std::byte *q = s.bytes.data() + at;
+      const std::size_t len = encode_add(q, m.id, 'B', 100, "QQQ", 1, i);
+      itch::stock_locate::put(q, OTHER_LOCATE);
+      emit(len);
+    }
+  }
+  at = 0;
+  for (const std::size_t len : lengths) {
+    s.msgs.emplace_back(s.bytes.data() + at, len);
+    at += len;
+  }
+  return s;
+}
+
+inline const itch_stream &cached_stream(std::size_t n) {
+  static std::map<std::size_t, itch_stream> streams;
+  auto it = streams.find(n);
+  if (it == streams.end()) {
+    it = streams.emplace(n, make_itch_stream(n)).first;
+  }
+  return it->second;
+}
+
+using compiled_chain = pipeline<itch_decoder, locate_filter, book_updater, momentum_signal>;
+
+inline std::unique_ptr<compiled_chain> make_compiled(const order_book::book_config &cfg) {
+  return std::make_unique<compiled_chain>(itch_decoder{}, locate_filter{TRADED_LOCATE},
+                                          book_updater{cfg}, momentum_signal{SIGNAL_TICKS});
+}
+
+// --- The same chain as std::vector<handler_base *> ------------------------------------
+// One event type for every stage (the decoder fills the fields of whichever message it saw)
+// and a bool return to stop the chain, as a runtime-composed handler list has to do it.
+
+struct decoded_event {
+  std::span<const std::byte> raw;
+  char type = 0;
+  std::uint16_t locate = 0;
+  std::uint64_t ref = 0;
+  std::uint64_t new_ref = 0;
+  char side = 0;
+  std::uint32_t shares = 0;
+  std::uint32_t price = 0;
+  top_of_book tob{};
+};
+
+class handler_base {
+public:
+  virtual ~handler_base() = default;
+  virtual bool on(decoded_event &e) = 0; // false: stop here
+};
+
+class virtual_decoder final : public handler_base {
+public:
+  bool on(decoded_event &e) override {
+    using namespace market_data;
+    if (e.raw.empty()) {
+      return false;
+    }
+    const std::byte *p = e.raw.data();
+    e.type = static_cast<char>(p[0]);
+    e.locate = itch::stock_locate::get(p);
+    switch (e.type) {
+    case 'A':
+      if (e.raw.size() < itch::add_order::size) {
+        return false;
+      }
+      e.ref = itch::order_ref::get(p);
+      e.side = itch::add_order::side::get(p);
+      e.shares = itch::add_order::shares::get(p);
+      e.price = itch::add_order::price::get(p);
+      return true;
+    case 'E':
+      if (e.raw.size() < itch::order_executed::size) {
+        return false;
+      }
+      e.ref = itch::order_ref::get(p);
+      e.shares = itch::order_executed::executed_shares::get(p);
+      return true;
+    case 'X':
+      if (e.raw.size() < itch::order_cancel::size) {
+        return false;
+      }
+      e.ref = itch::order_ref::get(p);
+      e.shares = itch::order_cancel::cancelled_shares::get(p);
+      return true;
+    case 'D':
+      if (e.raw.size() < itch::order_delete::size) {
+        return false;
+      }
+      e.ref = itch::order_ref::get(p);
+      return true;
+    case 'U':
+      if (e.raw.size() < itch::order_replace::size) {
+        return false;
+      }
+      e.ref = itch::order_replace::original_ref::get(p);
+      e.new_ref = itch::order_replace::new_ref::get(p);
+      e.shares = itch::order_replace::shares::get(p);
+      e.price = itch::order_replace::price::get(p);
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+class virtual_filter final : public handler_base {
+public:
+  explicit virtual_filter(std::uint16_t locate) : locate_{locate} {}
+  bool on(decoded_event &e) override { return e.locate == locate_; }
+
+private:
+  std::uint16_t locate_;
+};
+
+class virtual_book final : public handler_base {
+public:
+  explicit virtual_book(const order_book::book_config &cfg) : book{cfg} {}
+
+  bool on(decoded_event &e) override {
+    using order_book::side;
+    switch (e.type) {
+    case 'A':
+      count(book.add(e.ref, e.side == 'B' ? side::bid : side::ask, e.price, e.shares));
+      break;
+    case 'E':
+      count(book.execute(e.ref, e.shares));
+      break;
+    case 'X': {
+      const order_book::order *o = book.find(e.ref);
+      count(o == nullptr || e.shares >= o->qty ? book.cancel(e.ref)
+                                               : book.modify(e.ref, o->price, o->qty - e.shares));
+      break;
+    }
+    case 'D':
+      count(book.cancel(e.ref));
+      break;
+    case 'U': {
+      const order_book::order *o = book.find(e.ref);
+      if (o == nullptr) {
+        count(order_book::status::unknown_order);
+        return false;
+      }
+      const side s = o->s;
+      count(book.cancel(e.ref));
+      count(book.add(e.new_ref, s, e.price, e.shares));
+      break;
+    }
+    default:
+      return false;
+    }
+    const top_of_book now{book.best_bid(), book.best_ask()};
+    if (now.bid == last_.bid && now.ask == last_.ask) {
+      return false;
+    }
+    last_ = now;
+    e.tob = now;
+    return true;
+  }
+
+  order_book::book book;
+  std::uint64_t errors = 0;
+
+private:
+  void count(order_book::status st) noexcept { errors += st != order_book::status::ok; }
+  top_of_book last_{};
+};
+
+class virtual_signal final : public handler_base {
+public:
+  explicit virtual_signal(order_book::price_t threshold) : signal_{threshold} {}
+  bool on(decoded_event &e) override {
+    const std::uint64_t before = signal_.signals;
+    signal_.on(e.tob, [](const signal &) {});
+    return signal_.signals != before;
+  }
+  std::uint64_t signals() const noexcept { return signal_.signals; }
+
+private:
+  momentum_signal signal_;
+};
+
+struct virtual_chain {
+  explicit virtual_chain(const order_book::book_config &cfg) {
+    owned.push_back(std::make_unique<virtual_decoder>());
+    owned.push_back(std::make_unique<virtual_filter>(TRADED_LOCATE));
+    owned.push_back(std::make_unique<virtual_book>(cfg));
+    owned.push_back(std::make_unique<virtual_signal>(SIGNAL_TICKS));
+    for (const auto &h : owned) {
+      chain.push_back(h.get());
+    }
+  }
+  void operator()(std::span<const std::byte> raw) {
+    decoded_event e{raw};
+    for (handler_base *h : chain) {
+      if (!h->on(e)) {
+        break;
+      }
+    }
+  }
+  const virtual_book &book() const { return static_cast<const virtual_book &>(*owned[2]); }
+  std::uint64_t signals() const { return static_cast<const virtual_signal &>(*owned[3]).signals(); }
+
+  std::vector<std::unique_ptr<handler_base>> owned;
+  std::vector<handler_base *> chain;
+};
+
+// --- Tests ---------------------------------------------------------------------------
+
+// Records what reaches the end of a chain.
+struct recorder {
+  std::uint64_t messages = 0;
+  std::uint64_t signals = 0;
+  template <class S, class Next> void on(market_data::message<S>, Next) { ++messages; }
+  template <class Next> void on(const signal &, Next) { ++signals; }
+};
+
+inline void test_pass_through() {
+  std::println("--- test_pipeline_pass_through ---");
+  // The filter handles messages only: a signal fed in at the front flows past it.
+  pipeline<locate_filter, recorder> p{locate_filter{TRADED_LOCATE}, recorder{}};
+  std::array<std::byte, market_data::itch::MAX_MESSAGE_SIZE> buf{};
+  market_data::encode_delete(buf.data(), 7);
+  p(market_data::message<market_data::itch::order_delete>{buf.data()});
+  market_data::itch::stock_locate::put(buf.data(), OTHER_LOCATE);
+  p(market_data::message<market_data::itch::order_delete>{buf.data()});
+  p(signal{1, 100});
+  assert(p.stage<1>().messages == 1 && p.stage<1>().signals == 1);
+  std::println("test_pipeline_pass_through PASSED");
+}
+
+inline void test_matches_virtual_chain() {
+  std::println("--- test_pipeline_matches_virtual ---");
+  const itch_stream &s = cached_stream(200'000);
+  auto compiled = make_compiled(s.config);
+  auto virt = std::make_unique<virtual_chain>(s.config);
+  for (const auto &m : s.msgs) {
+    (*compiled)(m);
+    (*virt)(m);
+  }
+  [[maybe_unused]] const order_book::book &a = compiled->stage<2>().book;
+  [[maybe_unused]] const order_book::book &b = virt->book().book;
+  assert(compiled->stage<0>().rejected == 0 && compiled->stage<2>().errors == 0);
+  assert(virt->book().errors == 0);
+  assert(a.size() == b.size() && a.best_bid() == b.best_bid() && a.best_ask() == b.best_ask());
+  assert(compiled->stage<3>().signals == virt->signals() && virt->signals() > 0);
+  std::println("test_pipeline_matches_virtual PASSED ({} messages, {} signals)", s.msgs.size(),
+               virt->signals());
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// Replay the ITCH stream through each chain; a fresh book per iteration, built outside the
+// timed region. Args: range(0) = messages of the traded instrument per iteration.
+
+template <class MakeChain> void run_chain(benchmark::State &state, MakeChain &&make_chain) {
+  const itch_stream &s = cached_stream(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto chain = make_chain(s.config);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const auto &m : s.msgs) {
+      (*chain)(m);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    benchmark::DoNotOptimize(chain.get());
+    state.SetIterationTime(std::chrono::duration<double>(t1 - t0).count());
+  }
+  state.counters["ns_per_msg"] = benchmark::Counter(
+      static_cast<double>(s.msgs.size()),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+inline void BM_PipelineCompiled(benchmark::State &state) {
+  run_chain(state, [](const order_book::book_config &cfg) { return make_compiled(cfg); });
+}
+
+inline void BM_PipelineVirtual(benchmark::State &state) {
+  run_chain(state, [](const order_book::book_config &cfg) {
+    return std::make_unique<virtual_chain>(cfg);
+  });
+}
+
+inline void test() {
+  test_pass_through();
+  test_matches_virtual_chain();
+  BENCHMARK(BM_PipelineCompiled)->UseManualTime()->Arg(1'000'000);
+  BENCHMARK(BM_PipelineVirtual)->UseManualTime()->Arg(1'000'000);
+}
+
+} // namespace strategy_pipeline
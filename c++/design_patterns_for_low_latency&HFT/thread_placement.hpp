@@ -0,0 +1,402 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  thread_placement.hpp — CPU pinning, SCHED_FIFO and topology-aware core selection
+// =====================================================================================
+//
+// The queue benchmarks spawn a producer and one or more consumers. Left to the OS those
+// threads float: they migrate between cores mid-run, land on SMT siblings of each other
+// (sharing L1/L2 and the pipeline) or on different sockets (every cache-line transfer
+// crosses the interconnect). Each of those is a *different* experiment, and mixing them
+// run-to-run is why unpinned numbers jump around. This header makes the placement an
+// explicit, reproducible input:
+//
+//  - topology   : WHERE the threads go relative to each other (same CPU, SMT siblings,
+//                 distinct physical cores on one socket, or across sockets).
+//  - select_cpus: turns a topology into concrete CPU ids, derived from Linux sysfs
+//                 (/sys/devices/system/cpu/cpuN/topology/{core_id,physical_package_id}),
+//                 restricted to the CPUs this process may run on and preferring the
+//                 kernel's isolated CPUs (isolcpus=) when there are any.
+//  - apply      : called by each thread on itself - pins it to its CPU and optionally
+//                 switches it to SCHED_FIFO at the given real-time priority.
+//
+// Placement is thread 0 = producer, threads 1.. = consumers; thread 0's CPU is the anchor
+// the others are chosen relative to. Anything that cannot be honoured on this host (no SMT,
+// a single socket, too few cores) is reported as std::nullopt rather than silently
+// degraded - a "cross-socket" number measured on one socket would be a lie.
+//
+// Pinning and SCHED_FIFO are Linux-only. On other platforms (e.g. macOS, which has no
+// thread-affinity API) only `floating` is available and apply() is a no-op that reports
+// failure for any real request.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace thread_placement {
+
+// How the benchmark threads are placed relative to the anchor (producer) thread. The values
+// are the benchmark argument encoding, so they must stay stable.
+enum class topology : std::int64_t {
+  floating = 0,     // no pinning: the OS scheduler decides (the historical behaviour)
+  same_core = 1,    // every thread on the SAME logical CPU (time-sliced)
+  smt_sibling = 2,  // hyper-thread siblings: same physical core, different logical CPUs
+  cross_core = 3,   // distinct physical cores on the same socket
+  cross_socket = 4, // consumers on a different socket than the producer
+};
+
+inline constexpr std::array<topology, 5> all_topologies{
+    topology::floating, topology::same_core, topology::smt_sibling, topology::cross_core,
+    topology::cross_socket};
+
+inline constexpr std::string_view to_string(topology t) noexcept {
+  switch (t) {
+  case topology::floating:
+    return "floating";
+  case topology::same_core:
+    return "same_core";
+  case topology::smt_sibling:
+    return "smt_sibling";
+  case topology::cross_core:
+    return "cross_core";
+  case topology::cross_socket:
+    return "cross_socket";
+  }
+  return "unknown";
+}
+
+// The placements the queue benchmarks sweep. By default only floating and cross_core: under
+// same_core two busy-spinning threads share one CPU, so every handoff over a small ring waits
+// for a time slice and the 1e9-message runs take hours; smt_sibling and cross_socket are
+// extra passes over the whole suite. Configure with -DENABLE_ALL_PLACEMENTS=ON (defines
+// FAST_QUEUE_ALL_PLACEMENTS) to sweep all of them.
+#if defined(FAST_QUEUE_ALL_PLACEMENTS)
+inline constexpr std::array<topology, 5> queue_topologies = all_topologies;
+#else
+inline constexpr std::array<topology, 2> queue_topologies{topology::floating,
+                                                          topology::cross_core};
+#endif
+
+// Topology values as benchmark arguments, for ->ArgsProduct({..., topology_args(), ...}).
+inline std::vector<std::int64_t> topology_args(std::span<const topology> ts = all_topologies) {
+  std::vector<std::int64_t> args;
+  for (const auto t : ts) {
+    args.push_back(static_cast<std::int64_t>(t));
+  }
+  return args;
+}
+
+// One logical CPU as described by sysfs.
+struct cpu_info {
+  int cpu;        // logical CPU id (the N in cpuN)
+  int core_id;    // physical core id, unique only WITHIN a package
+  int package_id; // socket
+};
+
+// Parse a kernel cpu-list string such as "0-3,8,10-11\n" into {0,1,2,3,8,10,11}.
+// Malformed pieces are skipped.
+inline std::vector<int> parse_cpu_list(std::string_view s) {
+  std::vector<int> cpus;
+  while (!s.empty()) {
+    const auto comma = s.find(',');
+    std::string_view item = s.substr(0, comma);
+    s = comma == std::string_view::npos ? std::string_view{} : s.substr(comma + 1);
+    while (!item.empty() && (item.back() == '\n' || item.back() == ' ')) {
+      item.remove_suffix(1);
+    }
+    if (item.empty()) {
+      continue;
+    }
+    int lo = 0;
+    int hi = 0;
+    const auto dash = item.find('-');
+    const auto lo_str = item.substr(0, dash);
+    if (std::from_chars(lo_str.data(), lo_str.data() + lo_str.size(), lo).ec != std::errc{}) {
+      continue;
+    }
+    hi = lo;
+    if (dash != std::string_view::npos) {
+      const auto hi_str = item.substr(dash + 1);
+      if (std::from_chars(hi_str.data(), hi_str.data() + hi_str.size(), hi).ec != std::errc{}) {
+        continue;
+      }
+    }
+    for (int c = lo; c <= hi; ++c) {
+      cpus.push_back(c);
+    }
+  }
+  return cpus;
+}
+
+namespace detail {
+inline std::optional<std::string> read_sysfs(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    return std::nullopt;
+  }
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+inline std::optional<int> read_sysfs_int(const std::string &path) {
+  const auto s = read_sysfs(path);
+  int v = 0;
+  if (!s || std::from_chars(s->data(), s->data() + s->size(), v).ec != std::errc{}) {
+    return std::nullopt;
+  }
+  return v;
+}
+} // namespace detail
+
+/**
+ * The logical CPUs this process is allowed to run on (its affinity mask, so taskset/cgroup
+ * restrictions are respected), with their core and package ids from sysfs. Sorted by cpu id.
+ * Empty on platforms without sysfs/affinity support.
+ */
+inline std::vector<cpu_info> read_cpu_topology() {
+  std::vector<cpu_info> cpus;
+#if defined(__linux__)
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &allowed)) {
+      continue;
+    }
+    const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+    // A missing topology directory (offline CPU, exotic kernel) degrades to "every CPU is its
+    // own core on package 0" - still correct for same_core/cross_core, never fakes SMT.
+    const int core = detail::read_sysfs_int(base + "core_id").value_or(cpu);
+    const int package = detail::read_sysfs_int(base + "physical_package_id").value_or(0);
+    cpus.push_back({cpu, core, package});
+  }
+#endif
+  return cpus;
+}
+
+// CPUs the kernel keeps the general scheduler off (isolcpus=). Preferred as the anchor.
+inline std::vector<int> read_isolated_cpus() {
+  const auto s = detail::read_sysfs("/sys/devices/system/cpu/isolated");
+  return s ? parse_cpu_list(*s) : std::vector<int>{};
+}
+
+/**
+ * Pick `n` CPUs for `t`: element 0 is the anchor (producer), elements 1.. are placed relative
+ * to it. Every element is -1 for `floating`. Returns std::nullopt when this host cannot
+ * provide the requested relationship for all n threads.
+ */
+inline std::optional<std::vector<int>> select_cpus(topology t, std::size_t n,
+                                                   const std::vector<cpu_info> &cpus,
+                                                   const std::vector<int> &isolated = {}) {
+  if (t == topology::floating) {
+    return std::vector<int>(n, -1);
+  }
+  if (cpus.empty() || n == 0) {
+    return std::nullopt;
+  }
+
+  const auto same_core = [](const cpu_info &a, const cpu_info &b) {
+    return a.package_id == b.package_id && a.core_id == b.core_id;
+  };
+  // One representative logical CPU per physical core, so cross_core/cross_socket never hand
+  // two threads a pair of SMT siblings by accident.
+  const auto distinct_cores = [&](auto &&pred) {
+    std::vector<cpu_info> out;
+    for (const auto &c : cpus) {
+      if (pred(c) && std::none_of(out.begin(), out.end(),
+                                  [&](const cpu_info &o) { return same_core(o, c); })) {
+        out.push_back(c);
+      }
+    }
+    return out;
+  };
+
+  // Anchor candidates: isolated CPUs first (they are quiet), then the rest in id order.
+  std::vector<cpu_info> anchors;
+  for (const auto &c : cpus) {
+    if (std::find(isolated.begin(), isolated.end(), c.cpu) != isolated.end()) {
+      anchors.push_back(c);
+    }
+  }
+  for (const auto &c : cpus) {
+    if (std::find(isolated.begin(), isolated.end(), c.cpu) == isolated.end()) {
+      anchors.push_back(c);
+    }
+  }
+
+  for (const auto &anchor : anchors) {
+    std::vector<cpu_info> peers;
+    switch (t) {
+    case topology::floating:
+      break;
+    case topology::same_core:
+      peers.assign(n - 1, anchor);
+      break;
+    case topology::smt_sibling:
+      for (const auto &c : cpus) {
+        if (c.cpu != anchor.cpu && same_core(c, anchor)) {
+          peers.push_back(c);
+        }
+      }
+      // Usually 2-way SMT: several consumers then share the single sibling, which is still
+      // the relationship asked for (none of them is on a different physical core).
+      if (!peers.empty()) {
+        for (std::size_t i = peers.size(); i < n - 1; ++i) {
+          peers.push_back(peers[i % peers.size()]);
+        }
+      }
+      break;
+    case topology::cross_core:
+      peers = distinct_cores([&](const cpu_info &c) {
+        return c.package_id == anchor.package_id && !same_core(c, anchor);
+      });
+      break;
+    case topology::cross_socket:
+      peers = distinct_cores([&](const cpu_info &c) { return c.package_id != anchor.package_id; });
+      break;
+    }
+    if (peers.size() + 1 < n) {
+      continue; // this anchor cannot host the placement; try the next one
+    }
+    std::vector<int> out{anchor.cpu};
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+      out.push_back(peers[i].cpu);
+    }
+    return out;
+  }
+  return std::nullopt;
+}
+
+// What one thread applies to itself on start-up. cpu < 0 = leave the affinity alone;
+// fifo_priority <= 0 = keep the default (SCHED_OTHER) policy.
+struct thread_config {
+  int cpu{-1};
+  int fifo_priority{0};
+};
+
+/**
+ * Concrete placement for a set of benchmark threads: threads[0] is the producer,
+ * threads[1..] the consumers.
+ */
+struct placement_plan {
+  topology topo{topology::floating};
+  std::vector<thread_config> threads;
+
+  // Human-readable summary for benchmark labels, e.g. "cross_core cpus=2,4 fifo=80".
+  std::string describe() const {
+    std::string s{to_string(topo)};
+    if (topo != topology::floating) {
+      s += " cpus=";
+      for (std::size_t i = 0; i < threads.size(); ++i) {
+        s += (i ? "," : "") + std::to_string(threads[i].cpu);
+      }
+    }
+    if (!threads.empty() && threads.front().fifo_priority > 0) {
+      s += " fifo=" + std::to_string(threads.front().fifo_priority);
+    }
+    return s;
+  }
+};
+
+/**
+ * Build a plan for `n` threads, or std::nullopt if the topology is unavailable here.
+ * SCHED_FIFO together with same_core is refused: two busy-spinning FIFO threads on one CPU
+ * never preempt each other, so the peer would starve until the RT throttle kicks in.
+ */
+inline std::optional<placement_plan> make_plan(topology t, std::size_t n, int fifo_priority = 0) {
+  if (fifo_priority > 0 && t == topology::same_core) {
+    return std::nullopt;
+  }
+  const auto cpus = select_cpus(t, n, read_cpu_topology(), read_isolated_cpus());
+  if (!cpus) {
+    return std::nullopt;
+  }
+  placement_plan plan{t, {}};
+  for (const int cpu : *cpus) {
+    plan.threads.push_back({cpu, fifo_priority});
+  }
+  return plan;
+}
+
+// Pin the calling thread to one logical CPU. Returns false if the OS refused (or cannot pin).
+inline bool pin_current_thread(int cpu) noexcept {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+// Switch the calling thread to SCHED_FIFO at `priority` (1..99). Needs CAP_SYS_NICE or an
+// RLIMIT_RTPRIO allowance; returns false when that is missing.
+inline bool set_current_thread_fifo(int priority) noexcept {
+#if defined(__linux__)
+  sched_param param{};
+  param.sched_priority = priority;
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+  (void)priority;
+  return false;
+#endif
+}
+
+// Apply a thread_config to the calling thread. Returns false if any requested part failed;
+// the thread still runs (unpinned / default policy), so callers decide whether that matters.
+inline bool apply(const thread_config &cfg) noexcept {
+  bool ok = true;
+  if (cfg.cpu >= 0) {
+    ok = pin_current_thread(cfg.cpu) && ok;
+  }
+  if (cfg.fifo_priority > 0) {
+    ok = set_current_thread_fifo(cfg.fifo_priority) && ok;
+  }
+  return ok;
+}
+
+/**
+ * Benchmark glue, duck-typed on benchmark::State so this header does not depend on Google
+ * Benchmark: reads the topology from state.range(first_arg) and the SCHED_FIFO priority from
+ * state.range(first_arg + 1), builds a plan for `n` threads and labels the run with it. When
+ * the placement is unavailable the benchmark is skipped with an error and nullopt is returned
+ * - the caller must then return before entering the timing loop.
+ */
+template <class State>
+std::optional<placement_plan> plan_from_benchmark(State &state, std::size_t n, int first_arg = 1) {
+  const auto t = static_cast<topology>(state.range(first_arg));
+  const auto fifo = static_cast<int>(state.range(first_arg + 1));
+  auto plan = make_plan(t, n, fifo);
+  if (!plan) {
+    const std::string msg =
+        "thread placement '" + std::string{to_string(t)} + "' unavailable on this host";
+    state.SkipWithError(msg.c_str());
+    return std::nullopt;
+  }
+  state.SetLabel(plan->describe().c_str());
+  return plan;
+}
+
+} // namespace thread_placement
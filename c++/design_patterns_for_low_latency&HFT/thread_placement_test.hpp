@@ -0,0 +1,73 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests for thread_placement.hpp. The CPU selection is checked against a synthetic topology
+// (so it is deterministic on any host), then the real host topology is printed together with
+// the placements it can provide - the same list the queue benchmarks will run or skip.
+//
+
+#pragma once
+
+#include "thread_placement.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <print>
+#include <vector>
+
+namespace thread_placement {
+
+inline void test_parse_cpu_list() {
+  std::println("--- test_parse_cpu_list ---");
+  assert((parse_cpu_list("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  assert((parse_cpu_list("5") == std::vector<int>{5}));
+  assert(parse_cpu_list("").empty());
+  assert(parse_cpu_list("\n").empty());
+  std::println("test_parse_cpu_list PASSED");
+}
+
+// 2 sockets x 2 cores x 2 SMT threads, numbered the way Linux usually does it: the first
+// hyper-thread of every core first (cpu 0-3), then their siblings (cpu 4-7).
+inline void test_select_cpus() {
+  std::println("--- test_select_cpus ---");
+  const std::vector<cpu_info> cpus{
+      {0, 0, 0}, {1, 1, 0}, {2, 0, 1}, {3, 1, 1}, {4, 0, 0}, {5, 1, 0}, {6, 0, 1}, {7, 1, 1},
+  };
+
+  assert((*select_cpus(topology::floating, 2, cpus) == std::vector<int>{-1, -1}));
+  assert((*select_cpus(topology::same_core, 3, cpus) == std::vector<int>{0, 0, 0}));
+  assert((*select_cpus(topology::smt_sibling, 2, cpus) == std::vector<int>{0, 4}));
+  assert((*select_cpus(topology::cross_core, 2, cpus) == std::vector<int>{0, 1}));
+  assert((*select_cpus(topology::cross_socket, 3, cpus) == std::vector<int>{0, 2, 3}));
+  // Only one other physical core per socket: a producer plus 3 cross-core consumers won't fit.
+  assert(!select_cpus(topology::cross_core, 4, cpus));
+  // An isolated CPU becomes the anchor.
+  assert((*select_cpus(topology::smt_sibling, 2, cpus, {5}) == std::vector<int>{5, 1}));
+
+  // Single socket without SMT: only floating / same_core / cross_core are possible.
+  const std::vector<cpu_info> flat{{0, 0, 0}, {1, 1, 0}};
+  assert(!select_cpus(topology::smt_sibling, 2, flat));
+  assert(!select_cpus(topology::cross_socket, 2, flat));
+  assert((*select_cpus(topology::cross_core, 2, flat) == std::vector<int>{0, 1}));
+  std::println("test_select_cpus PASSED");
+}
+
+inline void print_host_topology() {
+  std::println("--- host topology ---");
+  const auto cpus = read_cpu_topology();
+  for (const auto &c : cpus) {
+    std::println("cpu {:3} core {:3} package {}", c.cpu, c.core_id, c.package_id);
+  }
+  for (const auto t : all_topologies) {
+    const auto plan = make_plan(t, 2);
+    std::println("{:13}: {}", to_string(t), plan ? plan->describe() : "unavailable");
+  }
+}
+
+inline void test() {
+  test_parse_cpu_list();
+  test_select_cpus();
+  print_host_topology();
+}
+
+} // namespace thread_placement
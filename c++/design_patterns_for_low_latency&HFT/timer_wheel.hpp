@@ -0,0 +1,301 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// =====================================================================================
+//  timer_wheel.hpp — allocation-free hierarchical timing wheel
+// =====================================================================================
+//
+// Order expiries, heartbeats and throttles need thousands of timers per core, most of them
+// cancelled before they fire. A std::priority_queue or std::multimap pays O(log n) and an
+// allocation per timer, and a heap cannot cancel at all without lazy tombstones. A timing
+// wheel makes schedule and cancel O(1):
+//
+//  - time is an integer TICK (any resolution; tsc_tick_source turns the calibrated TSC into
+//    ticks). The wheel has LEVELS levels of 256 slots; level l covers deadlines that differ
+//    from `now` only in byte l and below, and a timer sits in the slot given by byte l of
+//    its deadline. Four levels span 2^32 ticks; farther deadlines park in an overflow list
+//    that is re-filed each time the low 32 bits of `now` wrap.
+//  - advancing the clock expires level-0 slots as `now` reaches them. Every 256 ticks the
+//    next level-1 slot CASCADES - its timers are re-filed one level down - and so on up the
+//    hierarchy, so each timer moves at most LEVELS times in its life.
+//  - timers are nodes in a pool preallocated at construction, linked into their slot by
+//    32-bit indices (intrusive doubly linked list), so schedule/cancel/expiry never allocate.
+//    A handle carries the node's generation, so cancelling a timer that already fired (and
+//    whose node was reused) is detected and harmless.
+//  - one 256-bit occupancy bitmap per level lets advance() jump over empty slots instead
+//    of visiting every tick.
+//
+// Expiry is batched: advance() hands the callback every payload of one slot at once, as a
+// span, so e.g. all orders expiring on the same tick are processed together.
+//
+
+#pragma once
+
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace timer_wheel {
+
+using tick_t = std::uint64_t;
+
+constexpr std::size_t LEVELS = 4;
+constexpr std::size_t SLOT_BITS = 8;
+constexpr std::size_t SLOTS = std::size_t{1} << SLOT_BITS; // per level
+constexpr tick_t SLOT_MASK = SLOTS - 1;
+
+// "no node" / end of list, for 32-bit pool indices.
+constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+
+struct timer_handle {
+  std::uint32_t index;
+  std::uint32_t generation;
+};
+
+/**
+ * Converts the calibrated TSC (tsc::read_tsc) into wheel ticks of `resolution`.
+ * Calibrates once at construction (~20 ms).
+ */
+class tsc_tick_source {
+public:
+  explicit tsc_tick_source(std::chrono::nanoseconds resolution = std::chrono::microseconds(1))
+      : tsc0_{tsc::read_tsc()},
+        ticks_per_tsc_{1.0 / (tsc::calibrate_ticks_per_ns() *
+                              static_cast<double>(resolution.count()))} {}
+
+  tick_t now() const noexcept {
+    return static_cast<tick_t>(static_cast<double>(tsc::read_tsc() - tsc0_) *
+                               ticks_per_tsc_);
+  }
+
+private:
+  std::uint64_t tsc0_;
+  double ticks_per_tsc_; // wheel ticks per TSC tick
+};
+
+class wheel {
+public:
+  // `capacity` timers can be pending at once; nothing is allocated after construction.
+  explicit wheel(std::size_t capacity, tick_t now = 0) : nodes_(capacity), now_{now} {
+    assert(capacity < NIL && "pool indices are 32-bit");
+    heads_.fill(NIL);
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+      nodes_[i].next = i + 1 < nodes_.size() ? static_cast<std::uint32_t>(i + 1) : NIL;
+    }
+    free_ = nodes_.empty() ? NIL : 0;
+    batch_.reserve(capacity);
+  }
+
+  /**
+   * Fire `payload` once the clock reaches `deadline`. A deadline at or before now() fires on
+   * the next tick. Returns std::nullopt when `capacity` timers are already pending.
+   */
+  std::optional<timer_handle> schedule(tick_t deadline, std::uint64_t payload) noexcept {
+    if (free_ == NIL) [[unlikely]] {
+      return std::nullopt;
+    }
+    const std::uint32_t i = free_;
+    node &n = nodes_[i];
+    free_ = n.next;
+    n.deadline = std::max(deadline, now_ + 1);
+    n.payload = payload;
+    file(i);
+    ++size_;
+    return timer_handle{i, n.generation};
+  }
+
+  std::optional<timer_handle> schedule_after(tick_t delay, std::uint64_t payload) noexcept {
+    return schedule(now_ + delay, payload);
+  }
+
+  // Returns false when the timer already fired or was cancelled.
+  bool cancel(timer_handle h) noexcept {
+    if (h.index >= nodes_.size()) {
+      return false;
+    }
+    node &n = nodes_[h.index];
+    if (n.generation != h.generation || n.bucket == NIL) {
+      return false;
+    }
+    unlink(h.index);
+    release(h.index);
+    return true;
+  }
+
+  /**
+   * Move the clock to `target`, calling on_expire(std::span<const std::uint64_t>) once per
+   * expiring slot with the payloads of all its timers. The callback may schedule and cancel.
+   * Returns the number of timers fired.
+   */
+  template <class F> std::size_t advance_to(tick_t target, F &&on_expire) {
+    std::size_t fired = 0;
+    while (now_ < target) {
+      if (size_ == 0) {
+        now_ = target; // nothing pending: no slot can need attention
+        break;
+      }
+      // Expire occupied level-0 slots up to the next 256-tick boundary (or the target).
+      const tick_t boundary = (now_ | SLOT_MASK) + 1;
+      const tick_t last = std::min(target, boundary - 1);
+      for (std::size_t s = next_occupied(0, (now_ & SLOT_MASK) + 1); s <= (last & SLOT_MASK);
+           s = next_occupied(0, s + 1)) {
+        now_ = (now_ & ~SLOT_MASK) | s;
+        fired += expire(bucket_of(0, s), on_expire);
+      }
+      if (last == target) {
+        now_ = target;
+        break;
+      }
+      // Cross the boundary: cascade the upper levels, then expire slot 0.
+      now_ = boundary;
+      cascade();
+      fired += expire(bucket_of(0, 0), on_expire);
+    }
+    return fired;
+  }
+
+  template <class Source, class F> std::size_t poll(const Source &clock, F &&on_expire) {
+    return advance_to(clock.now(), on_expire);
+  }
+
+  tick_t now() const noexcept { return now_; }
+  std::size_t size() const noexcept { return size_; }
+  std::size_t capacity() const noexcept { return nodes_.size(); }
+
+private:
+  struct node {
+    tick_t deadline{0};
+    std::uint64_t payload{0};
+    std::uint32_t prev{NIL};
+    std::uint32_t next{NIL}; // also chains the free list
+    std::uint32_t bucket{NIL}; // level * SLOTS + slot; NIL when not pending
+    std::uint32_t generation{0};
+  };
+
+  // Timers due in a later 2^32-tick span than now_; cascaded when the low 32 bits wrap.
+  static constexpr std::uint32_t OVERFLOW = LEVELS * SLOTS;
+
+  static constexpr std::uint32_t bucket_of(std::size_t level, std::size_t slot) noexcept {
+    return static_cast<std::uint32_t>(level * SLOTS + slot);
+  }
+
+  // Put a pending node into the slot its deadline maps to, relative to now_.
+  void file(std::uint32_t i) noexcept {
+    node &n = nodes_[i];
+    const tick_t diff = n.deadline ^ now_;
+    std::uint32_t b;
+    if (diff >> (LEVELS * SLOT_BITS) != 0) {
+      b = OVERFLOW; // beyond the wheel's span: re-filed when the span rolls over
+    } else {
+      const std::size_t level =
+          diff < SLOTS ? 0 : (static_cast<std::size_t>(std::bit_width(diff)) - 1) / SLOT_BITS;
+      b = bucket_of(level, (n.deadline >> (level * SLOT_BITS)) & SLOT_MASK);
+    }
+    n.bucket = b;
+    n.prev = NIL;
+    n.next = heads_[b];
+    if (n.next != NIL) {
+      nodes_[n.next].prev = i;
+    }
+    heads_[b] = i;
+    occupied_[b / 64] |= std::uint64_t{1} << (b % 64);
+  }
+
+  void unlink(std::uint32_t i) noexcept {
+    node &n = nodes_[i];
+    (n.prev != NIL ? nodes_[n.prev].next : heads_[n.bucket]) = n.next;
+    if (n.next != NIL) {
+      nodes_[n.next].prev = n.prev;
+    }
+    if (heads_[n.bucket] == NIL) {
+      occupied_[n.bucket / 64] &= ~(std::uint64_t{1} << (n.bucket % 64));
+    }
+    n.bucket = NIL;
+  }
+
+  void release(std::uint32_t i) noexcept {
+    node &n = nodes_[i];
+    ++n.generation; // outstanding handles to this node go stale
+    n.next = free_;
+    free_ = i;
+    --size_;
+  }
+
+  // First occupied slot >= from on `level`, or SLOTS.
+  std::size_t next_occupied(std::size_t level, std::size_t from) const noexcept {
+    for (std::size_t s = from; s < SLOTS;) {
+      const std::size_t b = level * SLOTS + s;
+      const std::uint64_t word = occupied_[b / 64] >> (b % 64);
+      if (word != 0) {
+        return s + static_cast<std::size_t>(std::countr_zero(word));
+      }
+      s += 64 - b % 64;
+    }
+    return SLOTS;
+  }
+
+  // now_ just reached a multiple of 256: re-file the slots of every level whose lower bytes
+  // all rolled over, highest level first so its timers can fall all the way down.
+  void cascade() noexcept {
+    if ((now_ & ((tick_t{1} << (LEVELS * SLOT_BITS)) - 1)) == 0) {
+      refile(OVERFLOW);
+    }
+    for (std::size_t level = LEVELS - 1; level >= 1; --level) {
+      if ((now_ & ((tick_t{1} << (level * SLOT_BITS)) - 1)) == 0) {
+        refile(bucket_of(level, (now_ >> (level * SLOT_BITS)) & SLOT_MASK));
+      }
+    }
+  }
+
+  void refile(std::uint32_t b) noexcept {
+    std::uint32_t i = heads_[b];
+    heads_[b] = NIL;
+    occupied_[b / 64] &= ~(std::uint64_t{1} << (b % 64));
+    while (i != NIL) {
+      const std::uint32_t next = nodes_[i].next;
+      file(i);
+      i = next;
+    }
+  }
+
+  template <class F> std::size_t expire(std::uint32_t b, F &on_expire) {
+    std::uint32_t i = heads_[b];
+    if (i == NIL) {
+      return 0;
+    }
+    heads_[b] = NIL;
+    occupied_[b / 64] &= ~(std::uint64_t{1} << (b % 64));
+    batch_.clear();
+    while (i != NIL) {
+      node &n = nodes_[i];
+      const std::uint32_t next = n.next;
+      batch_.push_back(n.payload); // capacity reserved up front: never allocates
+      n.bucket = NIL;
+      release(i);
+      i = next;
+    }
+    const std::size_t fired = batch_.size();
+    on_expire(std::span<const std::uint64_t>{batch_});
+    return fired;
+  }
+
+  std::vector<node> nodes_;
+  std::array<std::uint32_t, LEVELS * SLOTS + 1> heads_{}; // + OVERFLOW
+  std::array<std::uint64_t, LEVELS * SLOTS / 64 + 1> occupied_{};
+  std::vector<std::uint64_t> batch_; // payloads of the slot being expired
+  std::uint32_t free_{NIL};
+  std::size_t size_{0};
+  tick_t now_;
+};
+
+} // namespace timer_wheel
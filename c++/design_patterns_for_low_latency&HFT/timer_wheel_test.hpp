@@ -0,0 +1,280 @@
+//
+// Created by Nicolae Popescu on 18/10/2026.
+//
+// Tests and benchmarks for timer_wheel.hpp: exact firing ticks across every level and beyond
+// the wheel's span, cancellation and stale handles, a randomized run against a std::multimap
+// reference, and the steady-state cost per timer against std::priority_queue and
+// std::multimap at 1k, 100k and 1M pending timers.
+//
+
+#pragma once
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <print>
+#include <queue>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace timer_wheel {
+
+inline void test_exact_deadlines() {
+  std::println("--- test_timer_wheel_deadlines ---");
+  // One deadline per interesting distance: same slot rotation, each level, slot boundaries,
+  // and far beyond the 2^32-tick span.
+  const std::vector<tick_t> deadlines{1,       2,         255,           256,
+                                      257,     511,       65'535,        65'536,
+                                      65'537,  1 << 20,   (1 << 24) + 7, tick_t{1} << 32,
+                                      (tick_t{1} << 33) + 12345};
+  wheel w{64, /*now=*/0};
+  for (std::size_t i = 0; i < deadlines.size(); ++i) {
+    [[maybe_unused]] const auto h = w.schedule(deadlines[i], i);
+    assert(h);
+  }
+  std::vector<bool> fired(deadlines.size(), false);
+  std::size_t batches = 0;
+  auto on_expire = [&](std::span<const std::uint64_t> payloads) {
+    ++batches;
+    for (const auto p : payloads) {
+      assert(w.now() == deadlines[p] && "timer fired at the wrong tick");
+      fired[p] = true;
+    }
+  };
+  // Advance in uneven steps so expiries land inside steps, on step ends and on boundaries.
+  std::mt19937_64 rng{3};
+  while (w.size() > 0) {
+    w.advance_to(w.now() + 1 + rng() % 100'000'000, on_expire);
+  }
+  for ([[maybe_unused]] const bool f : fired) {
+    assert(f);
+  }
+  assert(batches == deadlines.size());
+
+  // Timers on the same tick fire together, in one batch.
+  wheel same{8, 1000};
+  for (std::uint64_t p = 0; p < 5; ++p) {
+    same.schedule(1100, p);
+  }
+  std::size_t batch_size = 0;
+  same.advance_to(2000, [&](std::span<const std::uint64_t> b) { batch_size = b.size(); });
+  assert(batch_size == 5);
+  std::println("test_timer_wheel_deadlines PASSED");
+}
+
+inline void test_cancel_and_capacity() {
+  std::println("--- test_timer_wheel_cancel ---");
+  wheel w{2};
+  [[maybe_unused]] const auto a = w.schedule(10, 1);
+  [[maybe_unused]] const auto b = w.schedule(20'000, 2);
+  [[maybe_unused]] const auto full = w.schedule(30, 3);
+  assert(a && b && !full && "capacity exhausted");
+  [[maybe_unused]] const bool cancelled = w.cancel(*b);
+  [[maybe_unused]] const bool cancelled_twice = w.cancel(*b);
+  assert(cancelled && !cancelled_twice && "double cancel must be rejected");
+
+  [[maybe_unused]] const auto c = w.schedule(5, 4); // reuses b's node
+  [[maybe_unused]] const bool stale_cancelled = w.cancel(*b);
+  assert(c && c->index == b->index && !stale_cancelled && "stale handle must not cancel c");
+  std::vector<std::uint64_t> fired;
+  w.advance_to(100, [&](std::span<const std::uint64_t> p) {
+    fired.insert(fired.end(), p.begin(), p.end());
+  });
+  assert((fired == std::vector<std::uint64_t>{4, 1}));
+  [[maybe_unused]] const bool fired_cancelled = w.cancel(*a);
+  assert(!fired_cancelled && "fired timer cannot be cancelled");
+
+  // A deadline in the past fires on the next tick.
+  [[maybe_unused]] const auto late = w.schedule(50, 5);
+  assert(late);
+  std::size_t n = 0;
+  w.advance_to(101, [&](std::span<const std::uint64_t> p) { n += p.size(); });
+  assert(n == 1);
+  std::println("test_timer_wheel_cancel PASSED");
+}
+
+// Random schedule / cancel / advance against a multimap holding the same timers.
+inline void test_against_reference() {
+  std::println("--- test_timer_wheel_reference ---");
+  constexpr std::size_t CAP = 4096;
+  wheel w{CAP, 12345};
+  std::multimap<tick_t, std::uint64_t> ref;
+  std::vector<std::pair<timer_handle, std::multimap<tick_t, std::uint64_t>::iterator>> live;
+  std::mt19937_64 rng{11};
+  std::uint64_t next_payload = 0;
+  std::size_t total_fired = 0;
+
+  for (int step = 0; step < 20'000; ++step) {
+    const auto roll = rng() % 10;
+    if (roll < 5 && w.size() < CAP) {
+      // Mostly near deadlines, some across levels, a few past the span.
+      const tick_t delay = roll == 0 ? rng() % (tick_t{1} << 34) : 1 + rng() % (1 << (roll * 4));
+      const auto h = w.schedule_after(delay, next_payload);
+      assert(h);
+      live.emplace_back(*h, ref.emplace(w.now() + delay, next_payload));
+      ++next_payload;
+    } else if (roll < 7 && !live.empty()) {
+      const std::size_t k = rng() % live.size();
+      const bool cancelled = w.cancel(live[k].first);
+      assert(cancelled == (live[k].second != ref.end()));
+      if (cancelled) {
+        ref.erase(live[k].second);
+      }
+      live[k] = live.back();
+      live.pop_back();
+    } else {
+      const tick_t target = w.now() + 1 + rng() % (1 << 12);
+      std::vector<std::uint64_t> got;
+      w.advance_to(target, [&](std::span<const std::uint64_t> p) {
+        got.insert(got.end(), p.begin(), p.end());
+      });
+      std::vector<std::uint64_t> want;
+      while (!ref.empty() && ref.begin()->first <= target) {
+        want.push_back(ref.begin()->second);
+        // Mark the handle as fired so a later cancel is expected to fail.
+        for (auto &[h, it] : live) {
+          if (it == ref.begin()) {
+            it = ref.end();
+          }
+        }
+        ref.erase(ref.begin());
+      }
+      std::sort(got.begin(), got.end());
+      std::sort(want.begin(), want.end());
+      assert(got == want && "wheel and reference disagree on what fired");
+      total_fired += got.size();
+    }
+    assert(w.size() == ref.size());
+  }
+  std::println("test_timer_wheel_reference PASSED ({} timers fired)", total_fired);
+}
+
+// --- Benchmarks ------------------------------------------------------------------------
+// Steady state with ~N timers pending. Each operation schedules a timer with a random delay in
+// [1, 2N] ticks, cancels a random recent timer half of the time (order timeouts are mostly
+// cancelled), and advances the clock by one tick, firing whatever is due. The heap cancels
+// lazily (a tombstone checked when the entry reaches the top); the multimap erases by
+// iterator. All three share the same driver overhead (RNG, handle bookkeeping).
+// Args: range(0) = N pending timers.
+
+struct wheel_timers {
+  explicit wheel_timers(std::size_t n) : w{2 * n + 1024} {}
+  std::uint64_t schedule(tick_t delay, std::uint64_t id) {
+    handles.push_back(*w.schedule_after(delay, id));
+    return handles.size() - 1;
+  }
+  void cancel(std::uint64_t id) { w.cancel(handles[id]); }
+  std::size_t tick() {
+    return w.advance_to(w.now() + 1, [](std::span<const std::uint64_t> p) {
+      benchmark::DoNotOptimize(p.data());
+    });
+  }
+  wheel w;
+  std::vector<timer_handle> handles;
+};
+
+struct heap_timers {
+  explicit heap_timers(std::size_t) {}
+  using entry = std::pair<tick_t, std::uint64_t>;
+  std::uint64_t schedule(tick_t delay, std::uint64_t id) {
+    heap.emplace(now + delay, id);
+    cancelled.push_back(false);
+    return id;
+  }
+  void cancel(std::uint64_t id) { cancelled[id] = true; }
+  std::size_t tick() {
+    ++now;
+    std::size_t fired = 0;
+    while (!heap.empty() && heap.top().first <= now) {
+      const auto id = heap.top().second;
+      heap.pop();
+      if (!cancelled[id]) {
+        benchmark::DoNotOptimize(id);
+        ++fired;
+      }
+    }
+    return fired;
+  }
+  tick_t now = 0;
+  std::priority_queue<entry, std::vector<entry>, std::greater<>> heap;
+  std::vector<bool> cancelled;
+};
+
+struct map_timers {
+  explicit map_timers(std::size_t) {}
+  using map_t = std::multimap<tick_t, std::uint64_t>;
+  std::uint64_t schedule(tick_t delay, std::uint64_t id) {
+    iters.push_back(timers.emplace(now + delay, id));
+    alive.push_back(true);
+    return id;
+  }
+  void cancel(std::uint64_t id) {
+    if (alive[id]) {
+      timers.erase(iters[id]);
+      alive[id] = false;
+    }
+  }
+  std::size_t tick() {
+    ++now;
+    std::size_t fired = 0;
+    while (!timers.empty() && timers.begin()->first <= now) {
+      alive[timers.begin()->second] = false;
+      benchmark::DoNotOptimize(timers.begin()->second);
+      timers.erase(timers.begin());
+      ++fired;
+    }
+    return fired;
+  }
+  tick_t now = 0;
+  map_t timers;
+  std::vector<map_t::iterator> iters;
+  std::vector<bool> alive;
+};
+
+template <class Timers> void run_timers(benchmark::State &state) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  Timers t{n};
+  std::mt19937_64 rng{5};
+  std::uint64_t next_id = 0;
+  // Warm up to the steady state before timing.
+  for (std::size_t i = 0; i < n; ++i) {
+    t.schedule(1 + rng() % (2 * n), next_id++);
+  }
+  std::size_t fired = 0;
+  for (auto _ : state) {
+    t.schedule(1 + rng() % (2 * n), next_id++);
+    if (rng() & 1) {
+      // A random timer among the most recent N: still pending more often than not.
+      t.cancel(next_id - 1 - rng() % std::min<std::uint64_t>(next_id, n));
+    }
+    fired += t.tick();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["fired_per_op"] =
+      static_cast<double>(fired) / static_cast<double>(state.iterations());
+}
+
+inline void BM_TimerWheel(benchmark::State &state) { run_timers<wheel_timers>(state); }
+inline void BM_TimerPriorityQueue(benchmark::State &state) { run_timers<heap_timers>(state); }
+inline void BM_TimerMultimap(benchmark::State &state) { run_timers<map_timers>(state); }
+
+inline void test() {
+  test_exact_deadlines();
+  test_cancel_and_capacity();
+  test_against_reference();
+  BENCHMARK(BM_TimerWheel)->Arg(1'000)->Arg(100'000)->Arg(1'000'000);
+  BENCHMARK(BM_TimerPriorityQueue)->Arg(1'000)->Arg(100'000)->Arg(1'000'000);
+  BENCHMARK(BM_TimerMultimap)->Arg(1'000)->Arg(100'000)->Arg(1'000'000);
+}
+
+} // namespace timer_wheel
@@ -0,0 +1,54 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  tsc.hpp — the raw cycle counter every timestamp in the tree is taken from
+// =====================================================================================
+//
+// The flight recorder, the async logger, the timer wheel and the latency benchmarks all stamp
+// with the same counter and convert it to time off the hot path. read_tsc() is one instruction
+// (rdtsc on x86, a read of cntvct_el0 on AArch64); calibrate_ticks_per_ns() measures its rate
+// against steady_clock once, at start-up.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace tsc {
+
+// Raw cycle counter: invariant TSC on x86, the virtual counter on AArch64, steady_clock
+// nanoseconds elsewhere. Converted to time only at dump/convert time.
+inline std::uint64_t read_tsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  std::uint64_t v;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+#endif
+}
+
+// Ticks of read_tsc() per nanosecond, measured against steady_clock over `window`.
+inline double calibrate_ticks_per_ns(
+    std::chrono::nanoseconds window = std::chrono::milliseconds(20)) {
+  const auto t0 = std::chrono::steady_clock::now();
+  const std::uint64_t c0 = read_tsc();
+  while (std::chrono::steady_clock::now() - t0 < window) {
+  }
+  const std::uint64_t c1 = read_tsc();
+  const auto elapsed = std::chrono::steady_clock::now() - t0;
+  return static_cast<double>(c1 - c0) /
+         static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+} // namespace tsc
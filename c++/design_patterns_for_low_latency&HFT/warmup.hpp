@@ -0,0 +1,73 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// =====================================================================================
+//  warmup.hpp — keeping the order path cache-resident while the market is quiet
+// =====================================================================================
+//
+// cache_warming.hpp shows what a cold cache costs. On a trading thread the cost lands on the
+// worst possible message: after a quiet spell the caches, TLB and branch predictors have been
+// taken over by whatever else ran on the core (the kernel, a logger, the other hyperthread),
+// and the first order after the gap - the one reacting to the market waking up - pays for
+// re-fetching the book levels, the risk row, the queue slots and the code that touches them.
+//
+// The fix is to keep running the order path while there is nothing to send. `warmer` is the
+// scheduling half of that:
+//
+//  - it runs ON THE TRADING THREAD, from its poll loop. The caches worth warming are that
+//    core's L1/L2 and that thread's predictor state; a helper thread would warm its own core.
+//  - the poll loop calls on_activity(now) after real work and on_idle(now) when it found
+//    none. on_idle runs the dry-run pass once `cadence` has passed since the last real or
+//    warm-up pass, so busy periods cost nothing and quiet ones cost one pass per cadence.
+//  - the pass is a callable supplied by the path: its real send code run with a dry-run flag
+//    on synthetic input. The flag must be a RUNTIME argument threaded down to the last step
+//    (risk_check::engine::check's `dry_run`, fast_queue_spsc::producer::cancel_reserve
+//    instead of commit_write) - a template parameter would warm a different instantiation of
+//    the code, not the one the real order runs.
+//
+// The cadence trades CPU for residency: it has to be shorter than the time the rest of the
+// system takes to evict the path. warmup_test.hpp measures first-order latency after a gap
+// for a few cadences.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace warmup {
+
+template <class DryRun> class warmer {
+public:
+  warmer(DryRun dry_run, std::chrono::nanoseconds cadence)
+      : dry_run_{std::move(dry_run)}, cadence_ns_{static_cast<std::uint64_t>(cadence.count())} {}
+
+  // Called by the poll loop when it found nothing to do. Runs a dry-run pass if `cadence`
+  // has passed since the last real or warm-up pass; returns whether it did.
+  bool on_idle(std::uint64_t now_ns) {
+    if (now_ns - last_ns_ < cadence_ns_) {
+      return false;
+    }
+    dry_run_();
+    last_ns_ = now_ns;
+    ++passes_;
+    return true;
+  }
+
+  // Called after real work: the path was just exercised, so the next pass can wait.
+  void on_activity(std::uint64_t now_ns) noexcept { last_ns_ = now_ns; }
+
+  void set_cadence(std::chrono::nanoseconds cadence) noexcept {
+    cadence_ns_ = static_cast<std::uint64_t>(cadence.count());
+  }
+  std::uint64_t passes() const noexcept { return passes_; }
+
+private:
+  DryRun dry_run_;
+  std::uint64_t cadence_ns_;
+  std::uint64_t last_ns_ = 0;
+  std::uint64_t passes_ = 0;
+};
+
+} // namespace warmup
@@ -0,0 +1,280 @@
+//
+// Created by Nicolae Popescu on 19/10/2026.
+//
+// Tests and benchmarks for warmup.hpp, on a small but real order path: price off the L3 book,
+// pre-trade risk check, encode into the outbound SPSC ring. The tests check the warmer's
+// cadence and that dry-run passes leave the path's output and state exactly as without them.
+// The benchmark measures what warming is for: the latency of the FIRST order after an idle
+// gap during which the core's caches are overwritten, with warming off and at two cadences.
+//
+
+#pragma once
+
+#include "fast_queue_SPSC.hpp"
+#include "order_book.hpp"
+#include "percentile.hpp"
+#include "risk_check.hpp"
+#include "tsc.hpp"
+#include "warmup.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <print>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace warmup {
+
+using order_book::price_t;
+using order_book::side;
+
+// Not a risk reason: the outbound ring had no room.
+constexpr std::uint32_t QUEUE_FULL = 1u << 31;
+
+// What goes to the order gateway. The tail padding is an explicit, zeroed field: the whole
+// struct is copied into the ring, and the test compares what went out byte for byte.
+struct wire_order {
+  std::uint64_t client_id;
+  price_t price;
+  std::uint32_t symbol;
+  std::uint32_t qty;
+  side s;
+  std::array<std::uint8_t, 7> reserved{};
+};
+static_assert(std::has_unique_object_representations_v<wire_order>, "no implicit padding");
+
+/**
+ * The order path: join the best price on our side of the book, run the risk checks, encode
+ * into the outbound ring. `dry_run` is threaded through to the risk check and turns the final
+ * commit into cancel_reserve, so a dry run executes every step but publishes nothing.
+ */
+template <class Q> struct order_path {
+  order_book::book &book;
+  risk_check::engine &risk;
+  Q &out;
+  fast_queue_spsc::producer prod{};
+  std::uint64_t next_id = 1;
+
+  std::uint32_t send(std::uint32_t symbol, side s, std::uint32_t qty, std::uint64_t now_ns,
+                     bool dry_run) {
+    const auto best = s == side::bid ? book.best_bid() : book.best_ask();
+    price_t px = best.value_or(risk.limits(symbol).ref_price);
+    // A long queue at the touch will not fill soon: improve by a tick instead.
+    if (book.depth(s, px) > 10 * static_cast<order_book::qty_t>(qty)) {
+      px += s == side::bid ? 1 : -1;
+    }
+    const std::uint32_t mask = risk.check({symbol, s, px, qty}, now_ns, dry_run);
+    if (mask != risk_check::accepted) {
+      return mask;
+    }
+    const auto v = prod.try_reserve(out, sizeof(wire_order));
+    if (!v) {
+      risk.release(symbol, s, qty);
+      return QUEUE_FULL;
+    }
+    const wire_order w{next_id, px, symbol, qty, s};
+    const auto *bytes = reinterpret_cast<const std::byte *>(&w);
+    std::memcpy(v->first.data(), bytes, v->first.size());
+    if (v->wrapped()) {
+      std::memcpy(v->second.data(), bytes + v->first.size(), v->second.size());
+    }
+    if (dry_run) {
+      prod.cancel_reserve();
+    } else {
+      prod.commit_write(out);
+      ++next_id;
+    }
+    return mask;
+  }
+};
+
+// Synthetic input for the warm-up pass: one small order per side at the touch.
+template <class Q> auto make_dry_run(order_path<Q> &path, std::uint32_t symbol,
+                                     const std::uint64_t &now_ns) {
+  return [&path, symbol, &now_ns] {
+    path.send(symbol, side::bid, 1, now_ns, true);
+    path.send(symbol, side::ask, 1, now_ns, true);
+  };
+}
+
+constexpr order_book::book_config PATH_BOOK{
+    .min_price = 8'000, .num_levels = 1 << 12, .max_orders = 1 << 14, .max_order_id = 1 << 16};
+
+inline void fill_book(order_book::book &b, std::uint64_t seed) {
+  std::mt19937_64 rng{seed};
+  for (order_book::order_id id = 1; id <= 4000; ++id) {
+    const bool bid = rng() & 1;
+    const auto off = static_cast<price_t>(rng() % 200);
+    b.add(id, bid ? side::bid : side::ask, bid ? 9'999 - off : 10'001 + off,
+          1 + static_cast<order_book::qty_t>(rng() % 500));
+  }
+}
+
+inline risk_check::limits_config path_limits() {
+  return {.max_qty = 1000,
+          .ref_price = 10'000,
+          .collar = 100,
+          .max_position = 1'000'000,
+          .msgs_per_sec = 1'000'000.0,
+          .burst = 64};
+}
+
+inline void test_warmer_cadence() {
+  std::println("--- test_warmer_cadence ---");
+  int runs = 0;
+  warmer w{[&] { ++runs; }, std::chrono::nanoseconds{1000}};
+  assert(!w.on_idle(500) && runs == 0);
+  assert(w.on_idle(1000) && runs == 1);
+  assert(!w.on_idle(1999));
+  w.on_activity(1500); // real work defers the next pass
+  assert(!w.on_idle(2000) && w.on_idle(2500) && runs == 2);
+  w.set_cadence(std::chrono::nanoseconds{100});
+  assert(w.on_idle(2600) && w.passes() == 3);
+  std::println("test_warmer_cadence PASSED");
+}
+
+// Two identical paths get the same real orders; one also runs a dry-run pass before each.
+// Both must accept and reject the same orders and emit byte-identical output.
+inline void test_dry_run_no_side_effects() {
+  std::println("--- test_warmer_dry_run_no_side_effects ---");
+  using queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 12>;
+  struct setup {
+    order_book::book book{PATH_BOOK};
+    risk_check::engine risk{4};
+    std::unique_ptr<queue> q = std::make_unique<queue>();
+    fast_queue_spsc::consumer cons{};
+  };
+  std::array<setup, 2> s;
+  std::array<std::unique_ptr<order_path<queue>>, 2> p;
+  for (std::size_t k = 0; k < 2; ++k) {
+    fill_book(s[k].book, 1);
+    for (std::uint32_t sym = 0; sym < 4; ++sym) {
+      s[k].risk.set_limits(sym, path_limits(), 0);
+    }
+    p[k] = std::make_unique<order_path<queue>>(order_path<queue>{s[k].book, s[k].risk, *s[k].q});
+  }
+
+  std::mt19937_64 rng{9};
+  std::uint64_t now = 0;
+  std::size_t accepted = 0;
+  for (int i = 0; i < 20'000; ++i) {
+    now += 200 + rng() % 800; // bursts drain the bucket now and then
+    const auto sym = static_cast<std::uint32_t>(rng() % 5); // 4 is unknown
+    const side sd = rng() & 1 ? side::bid : side::ask;
+    const auto qty = static_cast<std::uint32_t>(rng() % 1100); // some over max_qty
+    make_dry_run(*p[1], sym, now)();
+    const std::uint32_t m0 = p[0]->send(sym, sd, qty, now, false);
+    [[maybe_unused]] const std::uint32_t m1 = p[1]->send(sym, sd, qty, now, false);
+    assert(m0 == m1);
+    accepted += m0 == risk_check::accepted;
+    for (std::size_t k = 0; i % 64 == 63 && k < 2; ++k) {
+      s[k].book.add(5'000 + static_cast<std::uint64_t>(i / 64), sd, 10'000, 5);
+    }
+    // Drain both rings in lockstep and compare what went out.
+    std::array<std::byte, sizeof(wire_order)> a, b;
+    for (;;) {
+      const auto na = s[0].cons.try_read(*s[0].q, a);
+      [[maybe_unused]] const auto nb = s[1].cons.try_read(*s[1].q, b);
+      assert(na == nb);
+      if (!na) {
+        break;
+      }
+      assert(std::memcmp(a.data(), b.data(), sizeof(wire_order)) == 0);
+    }
+  }
+  for (std::uint32_t sym = 0; sym < 4; ++sym) {
+    assert(s[0].risk.limits(sym).position == s[1].risk.limits(sym).position);
+    assert(s[0].risk.limits(sym).tokens == s[1].risk.limits(sym).tokens);
+  }
+  assert(accepted > 10'000 && accepted < 20'000);
+  std::println("test_warmer_dry_run_no_side_effects PASSED");
+}
+
+// --- Benchmark -------------------------------------------------------------------------
+// GAPS idle gaps of 5 ms simulated time each. During a gap the core streams writes through a
+// 64 MiB buffer, 256 KiB per 100 us step (what other work on the core does to its L1/L2), and
+// the poll loop calls on_idle after each step. Then one real order goes out, timed with
+// read_tsc, and an untimed opposite order flattens the position again.
+// Args: range(0) = cadence in us, 0 = warming off.
+
+constexpr int GAPS = 300;
+constexpr std::size_t GAP_STEPS = 50;
+constexpr std::uint64_t STEP_NS = 100'000;
+constexpr std::size_t POLLUTE_BYTES = std::size_t{256} << 10;
+constexpr std::size_t POLLUTER_SIZE = std::size_t{64} << 20;
+
+inline void BM_FirstOrderAfterIdle(benchmark::State &state) {
+  using tsc::read_tsc;
+  using queue = fast_queue_spsc::fast_queue_t<std::size_t{1} << 16>;
+  const auto cadence = std::chrono::microseconds{state.range(0)};
+  order_book::book book{PATH_BOOK};
+  fill_book(book, 1);
+  risk_check::engine risk{1024};
+  for (std::uint32_t sym = 0; sym < 1024; ++sym) {
+    risk.set_limits(sym, path_limits(), 0);
+  }
+  auto q = std::make_unique<queue>();
+  fast_queue_spsc::consumer cons;
+  order_path<queue> path{book, risk, *q};
+  constexpr std::uint32_t SYMBOL = 517;
+  std::uint64_t now = 0;
+  warmer w{make_dry_run(path, SYMBOL, now), cadence};
+  std::vector<std::byte> polluter(POLLUTER_SIZE);
+  std::size_t pollute_at = 0;
+  const double ticks_per_ns = tsc::calibrate_ticks_per_ns();
+
+  std::vector<std::uint64_t> first(GAPS);
+  for (auto _ : state) {
+    for (int g = 0; g < GAPS; ++g) {
+      for (std::size_t step = 0; step < GAP_STEPS; ++step) {
+        std::memset(polluter.data() + pollute_at, g + static_cast<int>(step), POLLUTE_BYTES);
+        pollute_at = (pollute_at + POLLUTE_BYTES) % POLLUTER_SIZE;
+        benchmark::ClobberMemory();
+        now += STEP_NS;
+        if (cadence.count() != 0) {
+          w.on_idle(now);
+        }
+      }
+      const side sd = g & 1 ? side::bid : side::ask;
+      const std::uint64_t t0 = read_tsc();
+      benchmark::DoNotOptimize(path.send(SYMBOL, sd, 10, now, false));
+      first[static_cast<std::size_t>(g)] = read_tsc() - t0;
+      benchmark::DoNotOptimize(path.send(SYMBOL, sd == side::bid ? side::ask : side::bid, 10,
+                                         now, false)); // flat again
+      w.on_activity(now);
+      std::array<std::byte, sizeof(wire_order)> buf;
+      while (cons.try_read(*q, buf)) {
+      }
+    }
+  }
+  std::ranges::sort(first);
+  auto ns = [&](std::uint64_t t) { return static_cast<double>(t) / ticks_per_ns; };
+  state.counters["first_p50_ns"] = ns(percentile::nearest_rank(first, 0.50));
+  state.counters["first_p99_ns"] = ns(percentile::nearest_rank(first, 0.99));
+  state.counters["first_max_ns"] = ns(first.back());
+  state.counters["warm_passes_per_gap"] =
+      static_cast<double>(w.passes()) / static_cast<double>(state.iterations() * GAPS);
+}
+
+inline void test() {
+  test_warmer_cadence();
+  test_dry_run_no_side_effects();
+  BENCHMARK(BM_FirstOrderAfterIdle)
+      ->Iterations(1)
+      ->Arg(0)
+      ->Arg(1000)
+      ->Arg(100)
+      ->ArgName("cadence_us")
+      ->UseRealTime();
+}
+
+} // namespace warmup